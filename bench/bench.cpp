@@ -0,0 +1,723 @@
+/**@addtogroup Bench Host-side benchmark for the filter rules.
+ * @{@file
+ *
+ * This application runs the same rule matching that the filter hooks do for
+ * connections, DNS lookups and HTTP requests, but in an ordinary process and
+ * against a recorded trace rather than inside Steam, so that changes to the
+ * rules engine can be measured before they go out.
+ *
+ * A trace is a text file with one event per line, "connect a.b.c.d:port",
+ * "dns name" or "http request", where the request is the raw buffer Steam
+ * sent with C-style escapes for the CR/LF pairs and anything else unprintable;
+ * blank lines and lines starting with '#' are ignored. The rules are given as
+ * a file holding the same text as a profile's filter setting, with any line
+ * breaks treated as separators.
+ *
+ * With no rules or trace given, it runs some built-in scenarios instead; a
+ * large rulebase of the kind the ISP rule sets are growing towards, and some
+ * glob patterns of the kind that would be expensive for a naive matcher.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define BENCH_NO_HOOKS  1
+#include "benchhook.h"
+
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "../steamfilter/filterrule.h"
+#include "../steamfilter/httpscan.h"
+#include "../steamfilter/ratelimit.h"
+
+/**
+ * Cliche for measuring array lengths, to avoid mistakes with sizeof ().
+ */
+
+#define ARRAY_LENGTH(x) (sizeof (x) / sizeof (* (x)))
+
+/**@{
+ * Defaults for the runs; each event in a trace is replayed this many times,
+ * and the built-in large rulebase has this many rules.
+ */
+
+#define BENCH_ITERATIONS        10000
+#define BENCH_RULES             1000
+#define BENCH_TEXT              65536
+
+/**@}*/
+
+/**
+ * The counts of what the filter code does, via the redirections in the hook
+ * header; the bench is single-threaded, so these are simple counters.
+ */
+
+volatile LONG   g_benchAllocs;
+volatile LONG   g_benchLocks;
+
+void * benchMalloc (size_t size) {
+        ++ g_benchAllocs;
+        return malloc (size);
+}
+
+void benchFree (void * mem) {
+        free (mem);
+}
+
+void * benchRealloc (void * mem, size_t size) {
+        ++ g_benchAllocs;
+        return realloc (mem, size);
+}
+
+void * benchHeapAlloc (HANDLE heap, DWORD flags, SIZE_T size) {
+        ++ g_benchAllocs;
+        return HeapAlloc (heap, flags, size);
+}
+
+char * benchStrdup (const char * str) {
+        ++ g_benchAllocs;
+        return _strdup (str);
+}
+
+wchar_t * benchWcsdup (const wchar_t * str) {
+        ++ g_benchAllocs;
+        return _wcsdup (str);
+}
+
+/**
+ * Stand in for the filter's own global new and delete, which it leaves out
+ * when built for the bench; like those, these don't throw.
+ */
+
+void * operator new (size_t size) throw () {
+        ++ g_benchAllocs;
+        return malloc (size);
+}
+
+void * operator new [] (size_t size) throw () {
+        ++ g_benchAllocs;
+        return malloc (size);
+}
+
+void operator delete (void * mem) {
+        free (mem);
+}
+
+void operator delete [] (void * mem) {
+        free (mem);
+}
+
+void benchEnter (CRITICAL_SECTION * lock) {
+        ++ g_benchLocks;
+        EnterCriticalSection (lock);
+}
+
+BOOL benchTryEnter (CRITICAL_SECTION * lock) {
+        if (! TryEnterCriticalSection (lock))
+                return FALSE;
+
+        ++ g_benchLocks;
+        return TRUE;
+}
+
+/**
+ * Stand in for the system resolver when the rules look up their targets.
+ *
+ * Numeric targets are converted as normal, but names are never sent to DNS;
+ * they all resolve to an address from the documentation range instead, so a
+ * run never touches the network and always sees the same rules.
+ */
+
+static int WSAAPI l_resolve (const wchar_t * node, const wchar_t * service,
+                             const ADDRINFOW * hints, ADDRINFOW ** result) {
+        ADDRINFOW       numeric = { 0 };
+        if (hints != 0)
+                numeric = * hints;
+        numeric.ai_flags |= AI_NUMERICHOST;
+
+        if (node != 0 && GetAddrInfoW (node, service, & numeric, result) == 0)
+                return 0;
+
+        return GetAddrInfoW (L"192.0.2.1", service, & numeric, result);
+}
+
+/**
+ * The kinds of event a trace holds, one for each kind of hook.
+ */
+
+enum EventKind {
+        EVENT_CONNECT,
+        EVENT_DNS,
+        EVENT_HTTP,
+        EVENT_KINDS
+};
+
+static  const char    * l_kindNames [EVENT_KINDS] = {
+        "connect", "dns", "http"
+};
+
+struct TraceEvent {
+        EventKind       m_kind;
+        sockaddr_in     m_address;
+        char          * m_text;
+        size_t          m_length;
+};
+
+struct Trace {
+        TraceEvent    * m_events;
+        unsigned long   m_count;
+        unsigned long   m_size;
+};
+
+/**
+ * Decode the escapes in the text of an event, returning the decoded length.
+ */
+
+static size_t l_unescape (char * dest, const char * from, const char * to) {
+        char          * start = dest;
+        while (from < to) {
+                char            ch = * from ++;
+                if (ch != '\\' || from == to) {
+                        * dest ++ = ch;
+                        continue;
+                }
+
+                ch = * from ++;
+                switch (ch) {
+                case 'r':       ch = '\r';     break;
+                case 'n':       ch = '\n';     break;
+                case 't':       ch = '\t';     break;
+                case '0':       ch = 0;         break;
+                case 'x': {
+                        unsigned int    value = 0;
+                        int             digits = 0;
+                        for (; digits < 2 && from < to ; ++ digits, ++ from) {
+                                char            hex = * from;
+                                if (hex >= '0' && hex <= '9') {
+                                        value = value * 16 + hex - '0';
+                                } else if ((hex | 0x20) >= 'a' &&
+                                           (hex | 0x20) <= 'f') {
+                                        value = value * 16 + (hex | 0x20) -
+                                                'a' + 10;
+                                } else
+                                        break;
+                        }
+
+                        ch = (char) value;
+                        break;
+                    }
+
+                default:
+                        break;
+                }
+
+                * dest ++ = ch;
+        }
+
+        * dest = 0;
+        return dest - start;
+}
+
+/**
+ * Add an event to a trace, given its kind and its text.
+ */
+
+static bool l_addEvent (Trace & trace, EventKind kind, const char * from,
+                        const char * to) {
+        if (trace.m_count == trace.m_size) {
+                unsigned long   size = trace.m_size ? trace.m_size * 2 : 64;
+                void          * grown;
+                grown = realloc (trace.m_events, size * sizeof (TraceEvent));
+                if (grown == 0)
+                        return false;
+
+                trace.m_events = (TraceEvent *) grown;
+                trace.m_size = size;
+        }
+
+        TraceEvent    & event = trace.m_events [trace.m_count];
+        memset (& event, 0, sizeof (event));
+        event.m_kind = kind;
+
+        event.m_text = (char *) malloc (to - from + 1);
+        if (event.m_text == 0)
+                return false;
+
+        event.m_length = l_unescape (event.m_text, from, to);
+
+        if (kind == EVENT_CONNECT) {
+                unsigned int    a, b, c, d, port;
+                if (sscanf (event.m_text, "%u.%u.%u.%u:%u",
+                            & a, & b, & c, & d, & port) != 5 ||
+                    a > 255 || b > 255 || c > 255 || d > 255 || port > 65535)
+                        return false;
+
+                event.m_address.sin_family = AF_INET;
+                event.m_address.sin_port = htons ((unsigned short) port);
+                event.m_address.sin_addr.S_un.S_addr =
+                        htonl ((a << 24) | (b << 16) | (c << 8) | d);
+        }
+
+        ++ trace.m_count;
+        return true;
+}
+
+/**
+ * Read a whole file into memory, null-terminated.
+ */
+
+static char * l_readFile (const wchar_t * path) {
+        FILE          * file = _wfopen (path, L"rb");
+        if (file == 0)
+                return 0;
+
+        fseek (file, 0, SEEK_END);
+        long            size = ftell (file);
+        fseek (file, 0, SEEK_SET);
+
+        char          * text = size < 0 ? 0 : (char *) malloc (size + 1);
+        if (text != 0) {
+                size = (long) fread (text, 1, size, file);
+                text [size] = 0;
+        }
+
+        fclose (file);
+        return text;
+}
+
+/**
+ * Load a trace file.
+ */
+
+static bool l_loadTrace (const wchar_t * path, Trace & trace) {
+        char          * text = l_readFile (path);
+        if (text == 0)
+                return false;
+
+        unsigned long   line = 0;
+        char          * scan = text;
+        while (* scan != 0) {
+                char          * start = scan;
+                char          * end = strchr (scan, '\n');
+                if (end == 0)
+                        end = scan + strlen (scan);
+
+                scan = * end == 0 ? end : end + 1;
+                ++ line;
+
+                if (end > start && end [- 1] == '\r')
+                        -- end;
+
+                if (start == end || * start == '#')
+                        continue;
+
+                char          * space;
+                space = (char *) memchr (start, ' ', end - start);
+                size_t          length = (space ? space : end) - start;
+
+                unsigned long   kind = 0;
+                for (; kind < EVENT_KINDS ; ++ kind)
+                        if (strlen (l_kindNames [kind]) == length &&
+                            memcmp (l_kindNames [kind], start, length) == 0)
+                                break;
+
+                if (space == 0 || kind == EVENT_KINDS ||
+                    ! l_addEvent (trace, (EventKind) kind, space + 1, end)) {
+                        fprintf (stderr, "%ls(%lu): bad trace event\n", path,
+                                 line);
+                        free (text);
+                        return false;
+                }
+        }
+
+        free (text);
+        return true;
+}
+
+/**
+ * Load a rulebase file, turning line breaks into rule separators.
+ */
+
+static wchar_t * l_loadRules (const wchar_t * path) {
+        char          * text = l_readFile (path);
+        if (text == 0)
+                return 0;
+
+        int             length = (int) strlen (text);
+        wchar_t       * rules = (wchar_t *) malloc ((length + 1) *
+                                                    sizeof (wchar_t));
+        if (rules == 0) {
+                free (text);
+                return 0;
+        }
+
+        length = MultiByteToWideChar (CP_ACP, 0, text, length, rules, length);
+        free (text);
+
+        wchar_t       * dest = rules;
+        int             i;
+        for (i = 0 ; i < length ; ++ i) {
+                wchar_t         ch = rules [i];
+                if (ch == '\r' || ch == '\n') {
+                        if (dest == rules || dest [- 1] == ';')
+                                continue;
+                        ch = ';';
+                }
+
+                * dest ++ = ch;
+        }
+
+        while (dest > rules && dest [- 1] == ';')
+                -- dest;
+
+        * dest = 0;
+        return rules;
+}
+
+/**
+ * Append formatted text to the end of a buffer being built up.
+ */
+
+static void l_append (wchar_t * dest, size_t size, const wchar_t * format,
+                      unsigned long first, unsigned long second = 0,
+                      unsigned long third = 0) {
+        size_t          used = wcslen (dest);
+        if (used + 1 >= size)
+                return;
+
+        _snwprintf (dest + used, size - used - 1, format, first, second, third);
+        dest [size - 1] = 0;
+}
+
+static void l_appendEvent (Trace & trace, EventKind kind, const char * text) {
+        l_addEvent (trace, kind, text, text + strlen (text));
+}
+
+/**
+ * Build the large rulebase scenario.
+ *
+ * The rules are an even mix of DNS rules, numeric network rules, glob rules
+ * for connections and host rules for HTTP requests; the trace hits rules from
+ * near the front and the back of the list, and misses everything too, since
+ * most of what Steam does matches nothing at all.
+ */
+
+static wchar_t * l_largeScenario (unsigned long count, Trace & trace) {
+        wchar_t       * rules = (wchar_t *) calloc (BENCH_TEXT * 2,
+                                                    sizeof (wchar_t));
+        if (rules == 0)
+                return 0;
+
+        unsigned long   i;
+        for (i = 0 ; i < count ; ++ i) {
+                unsigned long   n = i / 4;
+                switch (i % 4) {
+                case 0:
+                        l_append (rules, BENCH_TEXT * 2,
+                                  L"cdn%lu.example.net=192.0.2.%lu;", n,
+                                  n % 254 + 1);
+                        break;
+                case 1:
+                        l_append (rules, BENCH_TEXT * 2,
+                                  L"10.%lu.%lu.0/24:27030=192.0.2.%lu;",
+                                  n / 256, n % 256, n % 254 + 1);
+                        break;
+                case 2:
+                        l_append (rules, BENCH_TEXT * 2,
+                                  L"*.mirror%lu.example.org:80=192.0.2.%lu;",
+                                  n, n % 254 + 1);
+                        break;
+                default:
+                        l_append (rules, BENCH_TEXT * 2,
+                                  L"//content%lu.example.com/depot/*=;", n);
+                        break;
+                }
+        }
+
+        unsigned long   first = 0;
+        unsigned long   last = count / 4 - 1;
+        char            text [256];
+
+        unsigned long   pick [] = { first, last, count };
+        for (i = 0 ; i < ARRAY_LENGTH (pick) ; ++ i) {
+                unsigned long   n = pick [i];
+
+                sprintf (text, "cdn%lu.example.net", n);
+                l_appendEvent (trace, EVENT_DNS, text);
+
+                sprintf (text, "10.%lu.%lu.7:27030", n / 256, n % 256);
+                l_appendEvent (trace, EVENT_CONNECT, text);
+
+                sprintf (text, "198.51.100.%lu:27030", n % 256);
+                l_appendEvent (trace, EVENT_CONNECT, text);
+
+                sprintf (text, "GET /depot/%lu/chunk/0123456789abcdef HTTP/1.1"
+                         "\\r\\nHost: content%lu.example.com\\r\\n"
+                         "Accept: text/html,*/*\\r\\n\\r\\n", n, n);
+                l_appendEvent (trace, EVENT_HTTP, text);
+        }
+
+        return rules;
+}
+
+/**
+ * Build the pathological glob scenario.
+ *
+ * Patterns with many stars against long examples which almost match are what
+ * makes a backtracking matcher go exponential; the glob matcher here should
+ * stay linear in the length of the example, and this is to make sure it does.
+ */
+
+static wchar_t * l_globScenario (Trace & trace) {
+        wchar_t       * rules;
+        rules = _wcsdup (L"*a*a*a*a*a*a*a*a*a*a*a*a*a*a*a*ab=192.0.2.1;"
+                         L"*a?a?a?a?a?a?a?a?a?a?a?a?c.example.net=192.0.2.2;"
+                         L"*x*x*x*x*x*x*x*x*x*x*x*x*y.example.com:80=;"
+                         L"//*.*.*.*.*.*.*.*.*.*.*.*.*.z/*=;"
+                         L"/*/*/*/*/*/*/*/*/*/*/*/*/*/*/*/*/end=");
+        if (rules == 0)
+                return 0;
+
+        char            text [1024];
+        char          * dest = text;
+        int             i;
+        for (i = 0 ; i < 200 ; ++ i)
+                * dest ++ = 'a';
+        strcpy (dest, ".example.net");
+        l_appendEvent (trace, EVENT_DNS, text);
+
+        l_appendEvent (trace, EVENT_CONNECT, "203.0.113.9:80");
+
+        strcpy (text, "GET ");
+        dest = text + 4;
+        for (i = 0 ; i < 40 ; ++ i) {
+                memcpy (dest, "/x", 2);
+                dest += 2;
+        }
+        strcpy (dest, " HTTP/1.1\\r\\nHost: a.b.c.d.e.f.g.h.i.j.k.l.m"
+                "\\r\\n\\r\\n");
+        l_appendEvent (trace, EVENT_HTTP, text);
+
+        return rules;
+}
+
+/**
+ * Replay one connect, the way the connect hook asks the rules about it.
+ */
+
+static void l_connect (FilterRules & rules, const TraceEvent & event) {
+        sockaddr_in   * replace;
+        TargetStats   * target;
+        RateLimit     * limit;
+        rules.matchIp (& event.m_address, 0, & replace, & target, & limit);
+
+        if (target != 0)
+                target->release ();
+        if (limit != 0)
+                limit->release ();
+}
+
+static void l_lookup (FilterRules & rules, const TraceEvent & event) {
+        sockaddr_in   * replace;
+        rules.matchDns (event.m_text, & replace);
+}
+
+/**
+ * Replay one HTTP request, the way the send hook scans it and then matches
+ * the host and URL against the rules (which filterHttpUrl () does through the
+ * same matchRequest () call).
+ */
+
+static void l_request (FilterRules & rules, const TraceEvent & event) {
+        HttpScan :: Request request;
+        if (! HttpScan :: parse (event.m_text, event.m_length, request))
+                return;
+
+        RuleGuard       reading;
+        RequestMatch    match;
+        rules.matchRequest (event.m_text, request.m_verb, request.m_url,
+                            request.m_host, request.m_hostLength, match);
+}
+
+typedef void (* ReplayFunc) (FilterRules & rules, const TraceEvent & event);
+
+static  ReplayFunc      l_replay [EVENT_KINDS] = {
+        l_connect, l_lookup, l_request
+};
+
+/**
+ * Print one line of results.
+ */
+
+static void l_report (const char * scenario, const char * hook,
+                      unsigned long ops, LONGLONG ticks, LONG allocs,
+                      LONG locks) {
+        LARGE_INTEGER   frequency;
+        QueryPerformanceFrequency (& frequency);
+
+        double          ns = ticks * 1e9 / frequency.QuadPart;
+        printf ("%-10s %-8s %10lu %12.1f %10.2f %10.2f\n", scenario, hook,
+                ops, ns / ops, (double) allocs / ops, (double) locks / ops);
+}
+
+/**
+ * Install a rulebase, and run each kind of event in a trace against it.
+ */
+
+static bool l_run (const char * scenario, const wchar_t * text,
+                   const Trace & trace, unsigned long iterations) {
+        FilterRules     rules (27030);
+        LARGE_INTEGER   start;
+        LARGE_INTEGER   end;
+
+        LONG            allocs = g_benchAllocs;
+        LONG            locks = g_benchLocks;
+        QueryPerformanceCounter (& start);
+        bool            installed = rules.install (text);
+        QueryPerformanceCounter (& end);
+
+        if (! installed) {
+                fprintf (stderr, "%s: the rules didn't install\n", scenario);
+                return false;
+        }
+
+        l_report (scenario, "install", 1, end.QuadPart - start.QuadPart,
+                  g_benchAllocs - allocs, g_benchLocks - locks);
+
+        unsigned long   kind = 0;
+        for (; kind < EVENT_KINDS ; ++ kind) {
+                ReplayFunc      replay = l_replay [kind];
+                unsigned long   count = 0;
+                unsigned long   i;
+
+                /*
+                 * One pass first to warm things up, which also counts how many
+                 * events there are of this kind.
+                 */
+
+                for (i = 0 ; i < trace.m_count ; ++ i) {
+                        if (trace.m_events [i].m_kind != kind)
+                                continue;
+
+                        replay (rules, trace.m_events [i]);
+                        ++ count;
+                }
+
+                if (count == 0)
+                        continue;
+
+                allocs = g_benchAllocs;
+                locks = g_benchLocks;
+                QueryPerformanceCounter (& start);
+
+                unsigned long   pass = 0;
+                for (; pass < iterations ; ++ pass)
+                        for (i = 0 ; i < trace.m_count ; ++ i)
+                                if (trace.m_events [i].m_kind == kind)
+                                        replay (rules, trace.m_events [i]);
+
+                QueryPerformanceCounter (& end);
+                l_report (scenario, l_kindNames [kind], count * iterations,
+                          end.QuadPart - start.QuadPart,
+                          g_benchAllocs - allocs, g_benchLocks - locks);
+        }
+
+        return true;
+}
+
+/**
+ * Usage: bench [-rules <file>] [-trace <file>] [-iterations <count>]
+ *
+ * Given a trace, the events in it are run against the given rules (or no
+ * rules at all); with neither, the built-in scenarios are run instead. The
+ * result is 0 if everything ran, 1 if any of the rules failed to install, and
+ * 2 for any problem with the arguments or files.
+ */
+
+int wmain (int argc, wchar_t ** argv) {
+        const wchar_t * rulesPath = 0;
+        const wchar_t * tracePath = 0;
+        unsigned long   iterations = BENCH_ITERATIONS;
+
+        int             i;
+        for (i = 1 ; i + 1 < argc ; i += 2) {
+                if (wcscmp (argv [i], L"-rules") == 0) {
+                        rulesPath = argv [i + 1];
+                } else if (wcscmp (argv [i], L"-trace") == 0) {
+                        tracePath = argv [i + 1];
+                } else if (wcscmp (argv [i], L"-iterations") == 0) {
+                        iterations = wcstoul (argv [i + 1], 0, 10);
+                } else
+                        break;
+        }
+
+        if (i < argc || iterations == 0) {
+                fprintf (stderr, "usage: bench [-rules <file>] "
+                         "[-trace <file>] [-iterations <count>]\n");
+                return 2;
+        }
+
+        WSADATA         wsaData;
+        if (WSAStartup (MAKEWORD (2, 2), & wsaData) != 0)
+                return 2;
+
+        FilterRules :: resolver ((void *) l_resolve);
+
+        wchar_t       * rules = 0;
+        Trace           trace = { 0 };
+        if (rulesPath != 0 || tracePath != 0) {
+                rules = rulesPath ? l_loadRules (rulesPath) : _wcsdup (L"");
+                if (rules == 0 ||
+                    (tracePath != 0 && ! l_loadTrace (tracePath, trace)))
+                        return 2;
+        }
+
+        printf ("%-10s %-8s %10s %12s %10s %10s\n", "scenario", "hook", "ops",
+                "ns/op", "allocs/op", "locks/op");
+
+        bool            ok = true;
+        if (rules != 0) {
+                ok = l_run ("trace", rules, trace, iterations);
+        } else {
+                Trace           large = { 0 };
+                Trace           glob = { 0 };
+
+                rules = l_largeScenario (BENCH_RULES, large);
+                ok = rules != 0 && l_run ("large", rules, large, iterations);
+
+                rules = l_globScenario (glob);
+                ok = rules != 0 && l_run ("glob", rules, glob, iterations) &&
+                     ok;
+        }
+
+        return ok ? 0 : 1;
+}
+
+/**@}*/
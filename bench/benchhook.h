@@ -0,0 +1,95 @@
+#ifndef BENCHHOOK_H
+#define BENCHHOOK_H             1
+
+/**@addtogroup Bench Host-side benchmark for the filter rules.
+ * @{@file
+ *
+ * This is included ahead of everything else in the filter sources the bench
+ * builds, so that it can count the allocations and lock acquisitions they
+ * make without those sources having to know; the names are just redirected
+ * to counting versions defined by the bench itself.
+ *
+ * The global operator new and delete can't be redirected like that, so the
+ * bench replaces them outright, and the filter's own replacements for them
+ * step aside when they see BENCH_REPLACES_NEW.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <winsock2.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <string.h>
+#include <wchar.h>
+
+#define BENCH_REPLACES_NEW      1
+
+/**
+ * The counts, which the bench reads before and after each run.
+ */
+
+extern volatile LONG    g_benchAllocs;
+extern volatile LONG    g_benchLocks;
+
+void          * benchMalloc (size_t size);
+void            benchFree (void * mem);
+void          * benchRealloc (void * mem, size_t size);
+void          * benchHeapAlloc (HANDLE heap, DWORD flags, SIZE_T size);
+char          * benchStrdup (const char * str);
+wchar_t       * benchWcsdup (const wchar_t * str);
+void            benchEnter (CRITICAL_SECTION * lock);
+BOOL            benchTryEnter (CRITICAL_SECTION * lock);
+
+/**
+ * The rules have a two-argument wcsdup () of their own as a static member,
+ * which makes a function-like macro for wcsdup () impossible; this renames
+ * that member along with the global, so it has to apply to the bench too for
+ * the rule classes to read the same everywhere.
+ */
+
+#define wcsdup                  benchWcsdup
+
+#if     ! defined (BENCH_NO_HOOKS)
+
+#define malloc(size)            benchMalloc (size)
+#define free(mem)               benchFree (mem)
+#define realloc(mem, size)      benchRealloc (mem, size)
+#define HeapAlloc(heap, flags, size) \
+                                benchHeapAlloc (heap, flags, size)
+#define strdup(str)             benchStrdup (str)
+#define _strdup(str)            benchStrdup (str)
+#define _wcsdup(str)            benchWcsdup (str)
+#define EnterCriticalSection(lock) \
+                                benchEnter (lock)
+#define TryEnterCriticalSection(lock) \
+                                benchTryEnter (lock)
+
+#endif  /* ! defined (BENCH_NO_HOOKS) */
+
+/**@}*/
+#endif  /* ! defined (BENCHHOOK_H) */
@@ -120,6 +120,24 @@ wchar_t * split (wchar_t * args) {
         return args;
 }
 
+/**
+ * Strip the quotes from around the last argument, which split () leaves be
+ * since there's no space after it for it to find.
+ */
+
+wchar_t * unquote (wchar_t * arg) {
+        if (arg == 0 || * arg != '"')
+                return arg;
+
+        wchar_t       * from = arg;
+        wchar_t       * to = arg;
+        while (* ++ from != 0 && * from != '"')
+                * to ++ = * from;
+
+        * to = 0;
+        return arg;
+}
+
 /**
  * If we're asked to probe for an NTTP port, then sometimes we have to deal
  * with local proxies.
@@ -211,10 +229,12 @@ static  char            head [] = "HEAD /favicon.ico HTTP/1.0\n\n";
  * Address query.
  *
  * Note that this leaks memory, intentionally since the hosting process is
- * ephemeral rather than long-running.
+ * ephemeral rather than long-running; except that the ranking, which batch
+ * mode can run many of in one process, asks for the whole list back so that
+ * it can free it.
  */
 
-ADDRINFOW * getIpv4 (wchar_t * host, wchar_t * port) {
+ADDRINFOW * getIpv4 (wchar_t * host, wchar_t * port, ADDRINFOW ** list = 0) {
         /*
          * Look up the hostname and convert the port number into numeric form,
          * all handily in one function.
@@ -224,6 +244,9 @@ ADDRINFOW * getIpv4 (wchar_t * host, wchar_t * port) {
         if (GetAddrInfoW (host, port, 0, & address) != 0)
                 return 0;
 
+        if (list != 0)
+                * list = address;
+
         /*
          * Ensure that we only connect via IPv4, having made an IPv4 socket
          * already (yes, I could do things in a different order, but for my
@@ -308,8 +331,16 @@ int probe (wchar_t * host, wchar_t * port, HANDLE show) {
 
 #include <iphlpapi.h>
 #include <icmpapi.h>
+#include <stdlib.h>
 #include "../steamfilter/glob.h"
 
+/**
+ * The number of hops the traceroute looks at; the echo requests for all of
+ * them go out together.
+ */
+
+#define TRACE_HOPS      7
+
 /*
  * As an alternative to probing for a host, do a traceroute and permit glob
  * matches against the hostnames.
@@ -335,6 +366,17 @@ int trace (wchar_t * host, wchar_t * pattern, HANDLE err) {
         sockaddr_in   * addr = (sockaddr_in *) address->ai_addr;
         IPAddr          dest = addr->sin_addr.s_addr;
 
+        /*
+         * Compile the pattern up front, the same way the filter does.
+         */
+
+        GlobMatcher   * glob = 0;
+        if (pattern != 0 && * pattern != 0) {
+                glob = GlobMatcher :: compile (pattern);
+                if (glob == 0)
+                        return 2;
+        }
+
         /*
          * The timeouts in this loop are tighter than they are in general kinds
          * of traceroute applications since we are generally probing for things
@@ -345,26 +387,71 @@ int trace (wchar_t * host, wchar_t * pattern, HANDLE err) {
          * ICMP echo on their Steam servers (e.g. TelstraClear, who also keep
          * port 80 firewalled) so there's no point searching too hard since the
          * route will stall after only 2 or so hops.
+         *
+         * Rather than wait out each hop in turn, the echo requests for all the
+         * TTLs go out at once and the replies are then walked in hop order, so
+         * the whole trace costs about one timeout rather than one per hop.
          */
 
+        unsigned char   replies [TRACE_HOPS] [128];
+        HANDLE          events [TRACE_HOPS];
+        unsigned long   sent = 0;
+        for (; sent < TRACE_HOPS ; ++ sent) {
+                IP_OPTION_INFORMATION info = { (UCHAR) (sent + 1) };
+
+                HANDLE          event = CreateEventW (0, TRUE, FALSE, 0);
+                if (event == 0)
+                        break;
+
+                events [sent] = event;
+
+                DWORD           echo;
+                echo = IcmpSendEcho2 (icmp, event, 0, 0, dest, 0, 0, & info,
+                                      replies [sent], sizeof (replies [sent]),
+                                      50);
+                if (echo != 0) {
+                        SetEvent (event);
+                } else if (GetLastError () != ERROR_IO_PENDING) {
+                        CloseHandle (event);
+                        break;
+                }
+        }
+
+        /*
+         * The system writes the replies into our buffers as they arrive, so if
+         * the requests haven't all completed (which they should have, given
+         * the timeout on each) then don't look at any of them.
+         */
+
+        if (sent > 0 &&
+            WaitForMultipleObjects (sent, events, TRUE, 200) != WAIT_OBJECT_0)
+                sent = 0;
+
+        int             result = 1;
+
         unsigned short  ttl = 1;
-        for (; ttl < 8 ; ++ ttl) {
+        for (; ttl <= TRACE_HOPS ; ++ ttl) {
                 unsigned char   buf [128];
 
                 /*
-                 * Part the first; send an echo request.
+                 * Part the first; pick up the reply to our echo request.
                  */
 
                 IP_OPTION_INFORMATION info = { ttl };
 
-                DWORD           echo;
-                echo = IcmpSendEcho (icmp, dest, 0, 0, & info, buf,
-                                     sizeof (buf), 50);
+                unsigned char * data = buf;
+                DWORD           echo = 0;
+                if (ttl <= sent) {
+                        data = replies [ttl - 1];
+                        echo = IcmpParseReplies (data, sizeof (replies [0]));
+                }
+
                 if (echo < 1) {
                         /*
                          * Allow one retry, "just in case".
                          */
 
+                        data = buf;
                         echo = IcmpSendEcho (icmp, dest, 0, 0, & info, buf,
                                              sizeof (buf), 50);
                         if (echo < 1)
@@ -376,9 +463,9 @@ int trace (wchar_t * host, wchar_t * pattern, HANDLE err) {
                  * to find the intermediate systems.
                  */
 
-                ICMP_ECHO_REPLY * reply = (ICMP_ECHO_REPLY *) buf;
+                ICMP_ECHO_REPLY * reply = (ICMP_ECHO_REPLY *) data;
                 if (reply->Status != IP_TTL_EXPIRED_TRANSIT && reply->Status != 0)
-                        return 1;
+                        break;
 
                 /* 
                  * Part the second; protocol-independent reverse name lookup.
@@ -418,7 +505,7 @@ int trace (wchar_t * host, wchar_t * pattern, HANDLE err) {
                  * If the pattern is empty, we're just printing results.
                  */
 
-                if (pattern == 0 || * pattern == 0)
+                if (glob == 0)
                         continue;
 
                 /*
@@ -427,10 +514,12 @@ int trace (wchar_t * host, wchar_t * pattern, HANDLE err) {
                  * name we resolve wins.
                  */
 
-                return globMatch (name, pattern) ? 0 : 1;
+                result = glob->match (name) ? 0 : 1;
+                break;
         }
 
-        return 1;
+        free (glob);
+        return result;
 }
 
 /**
@@ -513,24 +602,518 @@ int pings (wchar_t * host, wchar_t * other, HANDLE err) {
         return pingTime (host, err) <= pingTime (other, err) ? 0 : 1;
 }
 
+/**@{
+ * Limits for the ranking mode. The host count is bounded by the number of
+ * handles WaitForMultipleObjects () will take, since every host can have an
+ * echo request and a socket outstanding at the same time.
+ */
+
+#define RANK_HOSTS      16
+#define RANK_ROUNDS     4
+#define RANK_ECHO       500
+#define RANK_TIMEOUT    1000
+
+/**@}*/
+
+/**
+ * The kinds of measurement the ranking mode takes, in order of how closely
+ * they resemble what a real client of the host will see.
+ */
+
+enum RankMeasure {
+        RANK_ICMP,
+        RANK_TCP,
+        RANK_HTTP,
+        RANK_MEASURES
+};
+
+/**
+ * Per-host state for the ranking mode; samples are kept in microseconds.
+ */
+
+struct RankHost {
+        wchar_t       * m_spec;
+        wchar_t         m_name [128];
+        IPAddr          m_address;
+        sockaddr_in     m_connect;
+        char            m_request [384];
+
+        HANDLE          m_echoEvent;
+        unsigned char   m_reply [128];
+
+        HANDLE          m_socketEvent;
+        SOCKET          m_socket;
+        LONGLONG        m_start;
+
+        unsigned long   m_samples [RANK_MEASURES] [RANK_ROUNDS];
+        unsigned long   m_count [RANK_MEASURES];
+        unsigned long   m_median [RANK_MEASURES];
+        unsigned long   m_jitter;
+        int             m_measure;
+};
+
+/**
+ * Convert a performance-counter interval to microseconds.
+ */
+
+unsigned long rankMicros (LONGLONG ticks) {
+        LARGE_INTEGER   frequency;
+        QueryPerformanceFrequency (& frequency);
+        return (unsigned long) (ticks * 1000000 / frequency.QuadPart);
+}
+
+LONGLONG rankNow (void) {
+        LARGE_INTEGER   now;
+        QueryPerformanceCounter (& now);
+        return now.QuadPart;
+}
+
+void rankSample (RankHost * host, int measure, unsigned long micros) {
+        unsigned long   count = host->m_count [measure];
+        if (count >= RANK_ROUNDS)
+                return;
+
+        host->m_samples [measure] [count] = micros;
+        host->m_count [measure] = count + 1;
+}
+
 /**
- * This is intended as a "naked" WinMain without the Visual C++ run-time
- * at all (not just avoiding the broken locale machinery).
+ * Work out what to measure for a host from its specification; a plain name
+ * gets ICMP echo only, "name:port" adds the TCP connect time, and a URL of
+ * the form "http://name[:port]/path" adds the time to the first byte of the
+ * response to a GET of the path.
  */
 
-int CALLBACK myWinMain (void) {
-        HANDLE          err = GetStdHandle (STD_ERROR_HANDLE);
-        unsigned long   written = 0;
+bool rankParse (RankHost * host, wchar_t * spec) {
+        host->m_spec = spec;
+        host->m_measure = -1;
+
+        wchar_t       * scan = spec;
+        bool            http = wcsncmp (scan, L"http://", 7) == 0;
+        if (http)
+                scan += 7;
+
+        wchar_t       * path = L"/";
+        wchar_t       * port = http ? L"80" : 0;
+        bool            colon = false;
+        unsigned long   length = 0;
+        for (;; ++ scan) {
+                wchar_t         ch = * scan;
+                if (ch == 0)
+                        break;
+
+                if (ch == '/') {
+                        path = scan;
+                        break;
+                }
+
+                if (length >= ARRAY_LENGTH (host->m_name) - 1)
+                        return false;
+
+                if (ch == ':' && ! colon) {
+                        host->m_name [length ++] = 0;
+                        port = host->m_name + length;
+                        colon = true;
+                        continue;
+                }
+
+                host->m_name [length ++] = ch;
+        }
+
+        host->m_name [length] = 0;
+        if (host->m_name [0] == 0)
+                return false;
 
         /*
-         * Since we're not using the regular C machinery, get and split the
-         * command line by hand. The CommandLineToArgvW () routine would do the
-         * normal conversion to C style for us, but that depends on SHELL32.DLL
-         * and we shouldn't need it.
+         * Resolve the name (and port, if any) using the same IPv4 lookup as
+         * the other tests do.
          */
 
-        wchar_t       * base = GetCommandLineW ();
-        wchar_t       * name = split (base);
+        ADDRINFOW     * list = 0;
+        ADDRINFOW     * address = getIpv4 (host->m_name, port, & list);
+        if (address != 0) {
+                sockaddr_in   * addr = (sockaddr_in *) address->ai_addr;
+                host->m_address = addr->sin_addr.s_addr;
+                if (port != 0)
+                        host->m_connect = * addr;
+        }
+
+        if (list != 0)
+                FreeAddrInfoW (list);
+        if (address == 0)
+                return false;
+
+        if (http)
+                wsprintfA (host->m_request,
+                           "GET %.200ls HTTP/1.0\r\nHost: %.100ls\r\n\r\n",
+                           path, host->m_name);
+
+        host->m_echoEvent = CreateEventW (0, TRUE, FALSE, 0);
+        host->m_socketEvent = WSACreateEvent ();
+        host->m_socket = INVALID_SOCKET;
+
+        return host->m_echoEvent != 0 && host->m_socketEvent != 0;
+}
+
+/**
+ * Start a non-blocking connect to a host, with the progress of the socket
+ * signalled through the host's event.
+ */
+
+bool rankConnect (RankHost * host) {
+        SOCKET          s = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET)
+                return false;
+
+        WSAResetEvent (host->m_socketEvent);
+        if (WSAEventSelect (s, host->m_socketEvent,
+                            FD_CONNECT | FD_READ | FD_CLOSE) != 0) {
+                closesocket (s);
+                return false;
+        }
+
+        host->m_start = rankNow ();
+        if (connect (s, (SOCKADDR *) & host->m_connect,
+                     sizeof (host->m_connect)) != 0 &&
+            WSAGetLastError () != WSAEWOULDBLOCK) {
+                closesocket (s);
+                return false;
+        }
+
+        host->m_socket = s;
+        return true;
+}
+
+bool rankClose (RankHost * host) {
+        closesocket (host->m_socket);
+        host->m_socket = INVALID_SOCKET;
+        return true;
+}
+
+/**
+ * Deal with a signal on a host's socket, returning true once the socket is
+ * finished with for this round.
+ */
+
+bool rankSocket (RankHost * host) {
+        WSANETWORKEVENTS events;
+        if (WSAEnumNetworkEvents (host->m_socket, host->m_socketEvent,
+                                  & events) != 0)
+                return rankClose (host);
+
+        LONGLONG        now = rankNow ();
+        long            network = events.lNetworkEvents;
+
+        if ((network & FD_CONNECT) != 0) {
+                if (events.iErrorCode [FD_CONNECT_BIT] != 0)
+                        return rankClose (host);
+
+                rankSample (host, RANK_TCP, rankMicros (now - host->m_start));
+                if (host->m_request [0] == 0)
+                        return rankClose (host);
+
+                /*
+                 * Send the request and time from here to the first part of
+                 * the response arriving.
+                 */
+
+                int             length = strlen (host->m_request);
+                host->m_start = rankNow ();
+                if (send (host->m_socket, host->m_request, length, 0) < length)
+                        return rankClose (host);
+
+                return false;
+        }
+
+        if ((network & FD_READ) != 0) {
+                rankSample (host, RANK_HTTP, rankMicros (now - host->m_start));
+                return rankClose (host);
+        }
+
+        return (network & FD_CLOSE) != 0 ? rankClose (host) : false;
+}
+
+void rankEcho (RankHost * host) {
+        if (IcmpParseReplies (host->m_reply, sizeof (host->m_reply)) < 1)
+                return;
+
+        ICMP_ECHO_REPLY * reply = (ICMP_ECHO_REPLY *) host->m_reply;
+        if (reply->Status != 0)
+                return;
+
+        rankSample (host, RANK_ICMP, reply->RoundTripTime * 1000UL);
+}
+
+/**
+ * Run one round of measurements against all the hosts at once, so that the
+ * whole round costs as much as the slowest host rather than the sum of them.
+ */
+
+void rankRound (HANDLE icmp, RankHost * hosts, unsigned long count) {
+        HANDLE          events [RANK_HOSTS * 2];
+        RankHost      * owners [RANK_HOSTS * 2];
+        unsigned long   waiting = 0;
+        unsigned long   i;
+
+        for (i = 0 ; i < count ; ++ i) {
+                RankHost      * host = hosts + i;
+                if (host->m_address == 0)
+                        continue;
+
+                ResetEvent (host->m_echoEvent);
+
+                DWORD           echo;
+                echo = IcmpSendEcho2 (icmp, host->m_echoEvent, 0, 0,
+                                      host->m_address, 0, 0, 0,
+                                      host->m_reply, sizeof (host->m_reply),
+                                      RANK_ECHO);
+                if (echo != 0) {
+                        rankEcho (host);
+                } else if (GetLastError () == ERROR_IO_PENDING) {
+                        events [waiting] = host->m_echoEvent;
+                        owners [waiting ++] = host;
+                }
+
+                if (host->m_connect.sin_port == 0 || ! rankConnect (host))
+                        continue;
+
+                events [waiting] = host->m_socketEvent;
+                owners [waiting ++] = host;
+        }
+
+        /*
+         * Gather the results as they come in, until everything has answered
+         * or the round's time is up.
+         */
+
+        DWORD           start = GetTickCount ();
+        while (waiting > 0) {
+                DWORD           elapsed = GetTickCount () - start;
+                if (elapsed >= RANK_TIMEOUT)
+                        break;
+
+                DWORD           wait;
+                wait = WaitForMultipleObjects (waiting, events, FALSE,
+                                               RANK_TIMEOUT - elapsed);
+                if (wait >= WAIT_OBJECT_0 + waiting)
+                        break;
+
+                unsigned long   index = wait - WAIT_OBJECT_0;
+                RankHost      * host = owners [index];
+                if (events [index] == host->m_echoEvent) {
+                        rankEcho (host);
+                } else if (! rankSocket (host))
+                        continue;
+
+                -- waiting;
+                events [index] = events [waiting];
+                owners [index] = owners [waiting];
+        }
+
+        /*
+         * Anything left over is abandoned; the echo requests carry their own
+         * (shorter) timeout, but since the system writes into the reply buffer
+         * wait for them anyway before we reuse it.
+         */
+
+        for (i = 0 ; i < waiting ; ++ i) {
+                if (events [i] == owners [i]->m_echoEvent) {
+                        WaitForSingleObject (events [i], RANK_TIMEOUT);
+                } else
+                        rankClose (owners [i]);
+        }
+}
+
+/**
+ * Summarise the samples for a host; it's ranked by the median of the most
+ * client-like measure it answered, with the mean difference between
+ * successive samples of that measure as the jitter.
+ */
+
+void rankSummary (RankHost * host) {
+        int             measure = RANK_MEASURES;
+        while (measure > 0 && host->m_count [measure - 1] == 0)
+                -- measure;
+
+        host->m_measure = measure - 1;
+        if (measure > 0) {
+                unsigned long * samples = host->m_samples [measure - 1];
+                unsigned long   count = host->m_count [measure - 1];
+                unsigned long   total = 0;
+                unsigned long   i;
+                for (i = 1 ; i < count ; ++ i)
+                        total += samples [i] > samples [i - 1] ?
+                                 samples [i] - samples [i - 1] :
+                                 samples [i - 1] - samples [i];
+
+                host->m_jitter = count > 1 ? total / (count - 1) : 0;
+        }
+
+        for (measure = 0 ; measure < RANK_MEASURES ; ++ measure) {
+                unsigned long * samples = host->m_samples [measure];
+                unsigned long   count = host->m_count [measure];
+                if (count == 0)
+                        continue;
+
+                unsigned long   i;
+                for (i = 1 ; i < count ; ++ i) {
+                        unsigned long   value = samples [i];
+                        unsigned long   j = i;
+                        for (; j > 0 && samples [j - 1] > value ; -- j)
+                                samples [j] = samples [j - 1];
+
+                        samples [j] = value;
+                }
+
+                host->m_median [measure] = (count & 1) != 0 ?
+                        samples [count / 2] :
+                        (samples [count / 2 - 1] + samples [count / 2]) / 2;
+        }
+}
+
+bool rankBetter (RankHost * left, RankHost * right) {
+        if (left->m_measure < 0)
+                return false;
+        if (right->m_measure < 0)
+                return true;
+
+        unsigned long   leftTime = left->m_median [left->m_measure];
+        unsigned long   rightTime = right->m_median [right->m_measure];
+        if (leftTime != rightTime)
+                return leftTime < rightTime;
+
+        return left->m_jitter < right->m_jitter;
+}
+
+/**
+ * Format a time in microseconds as milliseconds to one decimal place, since
+ * wsprintf () doesn't do floating-point.
+ */
+
+char * rankFormat (char * buf, unsigned long micros, bool valid) {
+        if (! valid)
+                return "-";
+
+        wsprintfA (buf, "%lu.%lu", micros / 1000, micros / 100 % 10);
+        return buf;
+}
+
+/**
+ * Let go of everything the ranking holds, since batch mode can run a lot of
+ * them in the one process.
+ */
+
+int rankFree (RankHost * hosts, unsigned long count, HANDLE icmp,
+              int result) {
+        if (icmp != INVALID_HANDLE_VALUE)
+                IcmpCloseHandle (icmp);
+
+        if (hosts == 0)
+                return result;
+
+        unsigned long   i;
+        for (i = 0 ; i < count ; ++ i) {
+                RankHost      * host = hosts + i;
+                if (host->m_echoEvent != 0)
+                        CloseHandle (host->m_echoEvent);
+                if (host->m_socketEvent != 0)
+                        WSACloseEvent (host->m_socketEvent);
+        }
+
+        HeapFree (GetProcessHeap (), 0, hosts);
+        return result;
+}
+
+/**
+ * Rank a list of hosts by measuring them all concurrently for a few rounds,
+ * writing the ranking out one host per line.
+ *
+ * The result is the position of the best host in the list given, or the
+ * number of hosts if none of them answered at all, so that scripts can use
+ * the result to index the choices they passed in.
+ */
+
+int rank (wchar_t ** specs, unsigned long count, HANDLE out) {
+        unsigned long   order [RANK_HOSTS];
+        unsigned long   i;
+
+        /*
+         * The host state is a bit large for the stack, and since batch mode
+         * can run several rankings at once it can't be static either.
+         */
+
+        RankHost      * hosts;
+        hosts = (RankHost *) HeapAlloc (GetProcessHeap (), HEAP_ZERO_MEMORY,
+                                        sizeof (RankHost) * RANK_HOSTS);
+        HANDLE          icmp = IcmpCreateFile ();
+        if (hosts == 0 || icmp == INVALID_HANDLE_VALUE)
+                return rankFree (hosts, count, icmp, count);
+
+        for (i = 0 ; i < count ; ++ i)
+                if (! rankParse (hosts + i, specs [i]))
+                        hosts [i].m_address = 0;
+
+        unsigned long   round = 0;
+        for (; round < RANK_ROUNDS ; ++ round)
+                rankRound (icmp, hosts, count);
+
+        /*
+         * Summarise and order the hosts, best first.
+         */
+
+        for (i = 0 ; i < count ; ++ i) {
+                rankSummary (hosts + i);
+
+                unsigned long   j = i;
+                for (; j > 0 && rankBetter (hosts + i, hosts + order [j - 1]) ;
+                     -- j)
+                        order [j] = order [j - 1];
+
+                order [j] = i;
+        }
+
+static  const char      head [] = "rank\thost\tmedian\tjitter\t"
+                                  "icmp\ttcp\thttp\r\n";
+        unsigned long   written = 0;
+        WriteFile (out, head, strlen (head), & written, 0);
+
+        for (i = 0 ; i < count ; ++ i) {
+                RankHost      * host = hosts + order [i];
+                bool            valid = host->m_measure >= 0;
+                unsigned long   median = 0;
+                if (valid)
+                        median = host->m_median [host->m_measure];
+
+                char            times [5] [16];
+                char            text [300];
+                wsprintfA (text, "%lu\t%.200ls\t%s\t%s\t%s\t%s\t%s\r\n", i + 1,
+                           host->m_spec,
+                           rankFormat (times [0], median, valid),
+                           rankFormat (times [1], host->m_jitter, valid),
+                           rankFormat (times [2], host->m_median [RANK_ICMP],
+                                       host->m_count [RANK_ICMP] > 0),
+                           rankFormat (times [3], host->m_median [RANK_TCP],
+                                       host->m_count [RANK_TCP] > 0),
+                           rankFormat (times [4], host->m_median [RANK_HTTP],
+                                       host->m_count [RANK_HTTP] > 0));
+                WriteFile (out, text, strlen (text), & written, 0);
+        }
+
+        int             best = hosts [order [0]].m_measure >= 0 ? order [0] :
+                               count;
+        return rankFree (hosts, count, icmp, best);
+}
+
+/**
+ * Run a single test, given its arguments as they would appear on the command
+ * line. This is shared between the normal single-test invocation and batch
+ * mode, which suppresses all the output since several tests run at once.
+ */
+
+int runTest (wchar_t * name, bool batch) {
+        HANDLE          err = GetStdHandle (STD_ERROR_HANDLE);
+        unsigned long   written = 0;
+
         wchar_t       * port = split (name);
         wchar_t       * find = split (port);
         wchar_t       * extra = split (find);
@@ -538,9 +1121,26 @@ int CALLBACK myWinMain (void) {
         if (port == 0)
                 return 2;
 
-        WSADATA         wsaData;
-        if (WSAStartup (MAKEWORD (2, 2), & wsaData) != 0)
-                return 2;
+        if (wcscmp (port, L"rank") == 0) {
+                /*
+                 * Rank a whole list of hosts; since this takes any number of
+                 * arguments it doesn't fit the form of the other tests, and
+                 * the ranking itself goes to the standard output.
+                 */
+
+                wchar_t       * specs [RANK_HOSTS] = { name };
+                unsigned long   count = 1;
+                wchar_t       * scan = find;
+                wchar_t       * next = extra;
+                while (scan != 0 && * scan != 0 && count < RANK_HOSTS) {
+                        specs [count ++] = scan;
+                        scan = next;
+                        next = split (next);
+                }
+
+                HANDLE          out = GetStdHandle (STD_OUTPUT_HANDLE);
+                return rank (specs, count, batch ? INVALID_HANDLE_VALUE : out);
+        }
 
 typedef int          (* Func) (wchar_t * left, wchar_t * right, HANDLE out);
         Func            func;
@@ -578,12 +1178,12 @@ typedef int          (* Func) (wchar_t * left, wchar_t * right, HANDLE out);
                 func = probe;
         }
 
-        if (extra == 0)
+        if (extra == 0 || batch)
                 err = INVALID_HANDLE_VALUE;
         result = (* func) (name, find, err);
 
-        if (extra == 0)
-                ExitProcess (result);
+        if (extra == 0 || batch)
+                return result;
 
 static  const char      text [] = "Probe result: ";
         WriteFile (err, text, strlen (text), & written, 0);
@@ -591,5 +1191,214 @@ static  const char      text [] = "Probe result: ";
         char            buf [2] = { '0' + result };
         WriteFile (err, buf, 1, & written, 0);
 
-        ExitProcess (result);
+        return result;
+}
+
+/**@{
+ * Limits for the batch mode; the test list is small text, so a fixed-size
+ * buffer for it is plenty.
+ */
+
+#define BATCH_TESTS     64
+#define BATCH_TEXT      32768
+
+/**@}*/
+
+/**
+ * Per-test state for the batch mode.
+ */
+
+struct BatchTest {
+        wchar_t       * m_args;
+        int             m_result;
+        volatile LONG * m_pending;
+        HANDLE          m_done;
+};
+
+/**
+ * Thread-pool entry point for a batch test.
+ */
+
+DWORD WINAPI batchWorker (void * param) {
+        BatchTest     * test = (BatchTest *) param;
+        test->m_result = runTest (test->m_args, true);
+
+        if (InterlockedDecrement (test->m_pending) == 0)
+                SetEvent (test->m_done);
+
+        return 0;
+}
+
+/**
+ * Read the test list for batch mode, where a path of "-" means the standard
+ * input.
+ */
+
+unsigned long batchRead (wchar_t * path, char * text, unsigned long size) {
+        HANDLE          input = GetStdHandle (STD_INPUT_HANDLE);
+        bool            opened = wcscmp (path, L"-") != 0;
+        if (opened)
+                input = CreateFileW (path, GENERIC_READ, FILE_SHARE_READ, 0,
+                                     OPEN_EXISTING, 0, 0);
+
+        if (input == INVALID_HANDLE_VALUE)
+                return 0;
+
+        unsigned long   total = 0;
+        while (total < size) {
+                unsigned long   got = 0;
+                if (! ReadFile (input, text + total, size - total, & got, 0) ||
+                    got == 0)
+                        break;
+
+                total += got;
+        }
+
+        if (opened)
+                CloseHandle (input);
+
+        return total;
+}
+
+/**
+ * Run a whole list of tests, one per line, at once and write out the result
+ * of each on a line of its own in the same order (blank lines are skipped,
+ * and don't get a result).
+ *
+ * Each line is just the arguments for a single test as they'd be given on
+ * the command line; this lets a script that has many tests to run pay for a
+ * single process launch and have the whole run take only about as long as
+ * the slowest test, rather than the sum of them all.
+ */
+
+int batch (wchar_t * args) {
+        wchar_t       * output = split (args);
+        if (args == 0 || * args == 0)
+                return 2;
+
+        if (output == 0)
+                unquote (args);
+        else
+                unquote (output);
+
+        HANDLE          heap = GetProcessHeap ();
+        char          * text = (char *) HeapAlloc (heap, 0, BATCH_TEXT);
+        wchar_t       * wide;
+        wide = (wchar_t *) HeapAlloc (heap, 0, BATCH_TEXT * sizeof (wchar_t));
+        HANDLE          done = CreateEventW (0, TRUE, FALSE, 0);
+        if (text == 0 || wide == 0 || done == 0)
+                return 2;
+
+        unsigned long   length = batchRead (args, text, BATCH_TEXT);
+        int             chars = 0;
+        if (length > 0)
+                chars = MultiByteToWideChar (CP_ACP, 0, text, length, wide,
+                                             BATCH_TEXT - 1);
+        wide [chars] = 0;
+
+        /*
+         * Split the text into lines and queue each test as we go; the pending
+         * count starts biased by one so that it can't reach zero until all the
+         * tests have been queued.
+         */
+
+        BatchTest       tests [BATCH_TESTS];
+        unsigned long   count = 0;
+        volatile LONG   pending = 1;
+
+        wchar_t       * scan = wide;
+        while (* scan != 0 && count < BATCH_TESTS) {
+                wchar_t       * line = scan;
+                while (* scan != 0 && * scan != '\r' && * scan != '\n')
+                        ++ scan;
+
+                if (* scan != 0)
+                        * scan ++ = 0;
+
+                while (* line == ' ' || * line == '\t')
+                        ++ line;
+
+                if (* line == 0)
+                        continue;
+
+                BatchTest     * test = tests + count ++;
+                test->m_args = line;
+                test->m_result = 2;
+                test->m_pending = & pending;
+                test->m_done = done;
+
+                InterlockedIncrement (& pending);
+                if (QueueUserWorkItem (batchWorker, test,
+                                       WT_EXECUTELONGFUNCTION))
+                        continue;
+
+                /*
+                 * If the thread pool won't take it, just run it here.
+                 */
+
+                InterlockedDecrement (& pending);
+                test->m_result = runTest (line, true);
+        }
+
+        if (InterlockedDecrement (& pending) != 0)
+                WaitForSingleObject (done, INFINITE);
+
+        /*
+         * Write out the results, to a file if we were given one.
+         */
+
+        HANDLE          out = GetStdHandle (STD_OUTPUT_HANDLE);
+        bool            opened = output != 0 && * output != 0;
+        if (opened)
+                out = CreateFileW (output, GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL, 0);
+
+        if (out == INVALID_HANDLE_VALUE)
+                return 2;
+
+        unsigned long   i;
+        for (i = 0 ; i < count ; ++ i) {
+                char            result [16];
+                unsigned long   written = 0;
+                wsprintfA (result, "%d\r\n", tests [i].m_result);
+                WriteFile (out, result, strlen (result), & written, 0);
+        }
+
+        if (opened)
+                CloseHandle (out);
+
+        return 0;
+}
+
+/**
+ * This is intended as a "naked" WinMain without the Visual C++ run-time
+ * at all (not just avoiding the broken locale machinery).
+ */
+
+int CALLBACK myWinMain (void) {
+        /*
+         * Since we're not using the regular C machinery, get and split the
+         * command line by hand. The CommandLineToArgvW () routine would do the
+         * normal conversion to C style for us, but that depends on SHELL32.DLL
+         * and we shouldn't need it.
+         */
+
+        wchar_t       * base = GetCommandLineW ();
+        wchar_t       * name = split (base);
+        if (name == 0)
+                return 2;
+
+        WSADATA         wsaData;
+        if (WSAStartup (MAKEWORD (2, 2), & wsaData) != 0)
+                return 2;
+
+        /*
+         * A list of tests to run all at once, rather than a single test.
+         */
+
+        if (wcsncmp (name, L"-batch", 6) == 0 &&
+            (name [6] == ' ' || name [6] == 0))
+                ExitProcess (batch (split (name)));
+
+        ExitProcess (runTest (name, false));
 }
@@ -82,14 +82,21 @@ version = version + '(WScript ' + WScript.Version + ')';
 /**
  * Simple wrapper for using the XHR object synchronously to get data from the
  * GAE service (or elsewhere, if an explicit path is present)
+ *
+ * If we're given an ETag then the request is made conditional on it, so the
+ * caller needs to be ready for a 304 response. The "gzip" in the user-agent
+ * string is what App Engine looks for (with the Accept-Encoding header that
+ * the XHR object sends anyway) before it will compress the response.
  */
 
-function simpleGet (path) {
+function simpleGet (path, tag) {
     if (path.substr (0, 7) !== "http://")
         path = base + path;
 
     xhr.open ("GET", path, false);
-    xhr.setRequestHeader ("User-Agent", "steam-limiter/" + version);
+    xhr.setRequestHeader ("User-Agent", "steam-limiter/" + version + " (gzip)");
+    if (tag)
+        xhr.setRequestHeader ("If-None-Match", tag);
 
     try {
         xhr.send ();
@@ -267,14 +274,101 @@ if (hasArg ("upload")) {
  * Get all the data in a bundle; when developing the webservice I kept all the
  * services separate (and it's still handy that way so anyone interested can
  * poke at it by hand), but for now it's better to grab it all in one go.
+ *
+ * The last whole bundle we were sent is kept in the registry with its ETag, so
+ * that most of the time the webservice can just tell us nothing has changed.
+ * When something has, we ask for a delta against the revision of that stored
+ * bundle; deltas are always relative to that same base, so only the latest is
+ * kept, until the webservice next decides to send a whole bundle.
  */
 
-var getData = simpleGet ("all?cb&v=1");
-if (! getData || getData.status != 200)
-    WScript.Quit (4)
+var response = "null";
+
+function readCache (name) {
+    try {
+        return shell.RegRead (regPath + name);
+    } catch (e) {
+        return "";
+    }
+}
+
+/**
+ * Apply a delta to a bundle; a null value in the delta means the item has gone
+ * away, and the delta's own revision bookkeeping doesn't belong in the result.
+ */
+
+function mergeDelta (bundle, delta) {
+    var item;
+    for (item in delta) {
+        if (item === "since")
+            continue;
+
+        if (delta [item] === null)
+            delete bundle [item];
+        else
+            bundle [item] = delta [item];
+    }
+
+    return bundle;
+}
+
+function fetchBundle () {
+    var text = readCache ("BundleText");
+    var cached = text && fromJson (text);
+    var extra = cached && readCache ("BundleDelta");
+    var tag = cached && readCache ("BundleTag");
+
+    var query = "all?cb&v=1";
+    if (cached && cached.revision)
+        query += "&since=" + cached.revision;
+
+    var getData = simpleGet (query, tag);
+    if (getData && getData.status == 304 && cached) {
+        var delta = extra && fromJson (extra);
+        response = extra || text;
+        return delta ? mergeDelta (cached, delta) : cached;
+    }
+
+    if (! getData || getData.status != 200)
+        return null;
+
+    response = getData.responseText || "null";
+    var bundle = fromJson (response);
+    if (bundle && bundle.since !== undefined) {
+        /*
+         * A delta is only any use if it's against the bundle we have, and
+         * we're still with the same ISP; otherwise, start over.
+         */
+
+        if (cached && bundle.since == cached.revision &&
+            bundle.ispname === cached.ispname) {
+            shell.RegWrite (regPath + "BundleDelta", response);
+            shell.RegWrite (regPath + "BundleTag",
+                            getData.getResponseHeader ("ETag") || "");
+            return mergeDelta (cached, bundle);
+        }
 
-var response = (getData && getData.responseText) || "null";
-var bundle = fromJson (response);
+        getData = simpleGet ("all?cb&v=1");
+        if (! getData || getData.status != 200)
+            return null;
+
+        response = getData.responseText || "null";
+        bundle = fromJson (response);
+    }
+
+    if (bundle) {
+        shell.RegWrite (regPath + "BundleText", response);
+        shell.RegWrite (regPath + "BundleDelta", "");
+        shell.RegWrite (regPath + "BundleTag",
+                        getData.getResponseHeader ("ETag") || "");
+    }
+
+    return bundle;
+}
+
+var bundle = fetchBundle ();
+if (bundle === null)
+    WScript.Quit (4)
 
 if (hasArg ("show"))
     WScript.Echo (response);
@@ -363,18 +457,74 @@ shell.RegWrite (regPath + "NextVersion", bundle.latest);
  * able to tell me whether (or when, as time goes on) their provider enables
  * this, one of the few things I could potentially do is request that this be
  * probed.
+ *
+ * A test can also be a ranking, as in " host rank other another ..." which
+ * measures all the hosts at once and returns the position of the fastest in
+ * that list (or the number of hosts, if none answered), so the choices for a
+ * ranking test are simply indexed by which of the candidates won.
+ */
+
+/**
+ * Run all the tests in a single probe invocation, which runs them all at once
+ * so that the whole set takes about as long as the slowest test. This hands
+ * back an object mapping each test to its result, or null if the batch run
+ * didn't work out, in which case the tests get run one at a time instead.
  */
 
+function batchTests (probe, tests) {
+    var fso = WScript.CreateObject ("Scripting.FileSystemObject");
+    var temp = fso.GetSpecialFolder (2) + "\\" + fso.GetTempName ();
+    var input = temp + ".in";
+    var output = temp + ".out";
+    var results = {};
+    var test;
+
+    try {
+        var names = [];
+        var file = fso.CreateTextFile (input, true);
+        for (test in tests) {
+            file.WriteLine (test);
+            names.push (test);
+        }
+        file.Close ();
+
+        var status = shell.run (probe + ' -batch "' + input + '" "' +
+                                output + '"', 0, true);
+        if (status != 0)
+            throw status;
+
+        var lines = [];
+        file = fso.OpenTextFile (output, 1);
+        while (! file.AtEndOfStream)
+            lines.push (file.ReadLine ());
+        file.Close ();
+
+        if (lines.length < names.length)
+            throw lines.length;
+
+        for (var i = 0 ; i < names.length ; ++ i)
+            results [names [i]] = parseInt (lines [i], 10);
+    } catch (e) {
+        results = null;
+    }
+
+    deleteFile (input);
+    deleteFile (output);
+    return results;
+}
+
 function probeTests (bundle) {
     var test;
     var result;
     var probe = '"' + scriptDir + 'probe"';
+    var results = batchTests (probe, bundle.test);
 
     for (test in bundle.test) {
         var choices = bundle.test [test];
         var result;
         try {
-            result = shell.run (probe + test, 0, true);
+            result = results ? results [test] :
+                     shell.run (probe + test, 0, true);
         } catch (e) {
             return;
         }
@@ -0,0 +1,225 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This implements a small lock-free cache of DNS answers, along with the
+ * per-thread state the resolver hooks need.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define WIN32_LEAN_AND_MEAN     1
+#include <windows.h>
+#include <winsock2.h>
+
+#include "dnscache.h"
+
+/**
+ * Simple constructor; every slot starts out empty.
+ */
+
+DnsCache :: DnsCache () {
+        memset (m_slots, 0, sizeof (m_slots));
+}
+
+/**
+ * Make the key for a name, by folding it to lower case into the destination
+ * buffer and hashing it (with FNV-1a, which is plenty for this).
+ *
+ * If the name is too long to hold in a slot this returns 0, which is never
+ * used as a hash value for a real name.
+ */
+
+/* static */
+unsigned long DnsCache :: key (const char * name, char * dest) {
+        unsigned long   hash = 2166136261UL;
+        size_t          length = 0;
+
+        for (;; ++ length) {
+                if (length == MAX_NAME)
+                        return 0;
+
+                char            ch = name [length];
+                if (ch >= 'A' && ch <= 'Z')
+                        ch += 'a' - 'A';
+
+                dest [length] = ch;
+                if (ch == 0)
+                        break;
+
+                hash = (hash ^ (unsigned char) ch) * 16777619UL;
+        }
+
+        return hash != 0 ? hash : 1;
+}
+
+/**
+ * Look for a cached answer for a name, copying out the addresses.
+ *
+ * Answers which came from a lookup that also returned non-IPv4 addresses are
+ * flagged as not complete, and if the caller needs a complete answer (because
+ * it asked for any kind of address) those won't do.
+ *
+ * If a slot is being written as we look at it, that's just a miss.
+ */
+
+unsigned long DnsCache :: find (const char * name, bool complete,
+                                unsigned long * addrs) {
+        char            text [MAX_NAME];
+        unsigned long   hash = key (name, text);
+        if (hash == 0)
+                return 0;
+
+        Entry         * entry = m_slots + hash % SLOTS;
+
+        LONG            version = entry->m_version;
+        if ((version & 1) != 0 || entry->m_hash != hash)
+                return 0;
+
+        unsigned long   count = entry->m_count;
+        unsigned long   expires = entry->m_expires;
+        bool            whole = entry->m_complete;
+        bool            same = strncmp (entry->m_name, text, MAX_NAME) == 0;
+
+        if (count > MAX_ADDRS)
+                count = MAX_ADDRS;
+
+        memcpy (addrs, entry->m_addrs, count * sizeof (unsigned long));
+
+        /*
+         * Make sure all of the above is read before checking that the slot
+         * wasn't changed under us.
+         */
+
+        MemoryBarrier ();
+        if (entry->m_version != version || ! same)
+                return 0;
+
+        if ((LONG) (expires - GetTickCount ()) <= 0)
+                return 0;
+
+        if (complete && ! whole)
+                return 0;
+
+        return count;
+}
+
+/**
+ * Add an answer to the cache, replacing whatever was in the slot.
+ */
+
+void DnsCache :: add (const char * name, const unsigned long * addrs,
+                      unsigned long count, bool complete) {
+        if (count == 0)
+                return;
+        if (count > MAX_ADDRS)
+                count = MAX_ADDRS;
+
+        char            text [MAX_NAME];
+        unsigned long   hash = key (name, text);
+        if (hash == 0)
+                return;
+
+        Entry         * entry = m_slots + hash % SLOTS;
+
+        LONG            version = entry->m_version;
+        if ((version & 1) != 0 ||
+            InterlockedCompareExchange (& entry->m_version, version + 1,
+                                        version) != version) {
+                return;
+        }
+
+        entry->m_hash = hash;
+        entry->m_expires = GetTickCount () + TTL;
+        entry->m_count = count;
+        entry->m_complete = complete;
+        strcpy (entry->m_name, text);
+        memcpy (entry->m_addrs, addrs, count * sizeof (unsigned long));
+
+        InterlockedExchange (& entry->m_version, version + 2);
+}
+
+/**
+ * The thread-local storage slot for the resolver hook state.
+ */
+
+static unsigned long    l_stateSlot = TLS_OUT_OF_INDEXES;
+
+/**
+ * Set up the thread-local storage for the resolver hooks.
+ */
+
+void g_initResolveState (void) {
+        if (l_stateSlot == TLS_OUT_OF_INDEXES)
+                l_stateSlot = TlsAlloc ();
+}
+
+/**
+ * Get the resolver hook state for the calling thread, creating it if need be.
+ */
+
+ResolveState * g_resolveState (void) {
+        if (l_stateSlot == TLS_OUT_OF_INDEXES)
+                return 0;
+
+        ResolveState  * state = (ResolveState *) TlsGetValue (l_stateSlot);
+        if (state != 0)
+                return state;
+
+        HANDLE          heap = GetProcessHeap ();
+        state = (ResolveState *) HeapAlloc (heap, HEAP_ZERO_MEMORY,
+                                            sizeof (ResolveState));
+        if (state == 0)
+                return 0;
+
+        state->m_host.h_name = "remapped.local";
+        state->m_host.h_aliases = state->m_aliases;
+        state->m_host.h_addrtype = AF_INET;
+        state->m_host.h_length = sizeof (state->m_addrs [0]);
+        state->m_host.h_addr_list = state->m_addrList;
+
+        TlsSetValue (l_stateSlot, state);
+        return state;
+}
+
+/**
+ * Release the resolver hook state for the calling thread, as it exits.
+ */
+
+void g_freeResolveState (void) {
+        if (l_stateSlot == TLS_OUT_OF_INDEXES)
+                return;
+
+        ResolveState  * state = (ResolveState *) TlsGetValue (l_stateSlot);
+        if (state == 0)
+                return;
+
+        TlsSetValue (l_stateSlot, 0);
+        HeapFree (GetProcessHeap (), 0, state);
+}
+
+/**@}*/
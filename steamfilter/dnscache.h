@@ -0,0 +1,117 @@
+#ifndef DNSCACHE_H
+#define DNSCACHE_H              1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares a small cache of DNS answers, and the per-thread state used
+ * by the resolver hooks.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <winsock2.h>
+
+/**
+ * A cache of DNS answers for names the rules let through to the resolver.
+ *
+ * The point of this is that Steam and its helper processes look the same CDN
+ * names up over and over, and each such lookup normally goes all the way out
+ * to the system resolver. Names the rules rewrite don't need this, since the
+ * answer comes straight from the rule.
+ *
+ * Lookups happen on any number of threads at once, so the table is a fixed
+ * array of slots each guarded by a sequence count; readers never block, they
+ * just copy a slot out and check the count didn't change while they did so,
+ * and writers claim a slot with a compare-and-swap and simply give up if
+ * another thread beat them to it. Since the slots hold everything by value
+ * there is never any memory to reclaim.
+ *
+ * The system resolver doesn't tell us the real DNS TTL, so every answer is
+ * only kept for a fixed time.
+ */
+
+class DnsCache {
+public:
+        enum {
+                SLOTS = 256,
+                MAX_NAME = 96,
+                MAX_ADDRS = 8,
+                TTL = 60 * 1000
+        };
+
+private:
+        struct Entry {
+                volatile LONG   m_version;
+                unsigned long   m_hash;
+                unsigned long   m_expires;
+                unsigned long   m_count;
+                bool            m_complete;
+                char            m_name [MAX_NAME];
+                unsigned long   m_addrs [MAX_ADDRS];
+        };
+
+        Entry           m_slots [SLOTS];
+
+static  unsigned long   key (const char * name, char * dest);
+
+public:
+                        DnsCache ();
+
+        unsigned long   find (const char * name, bool complete,
+                              unsigned long * addrs);
+        void            add (const char * name, const unsigned long * addrs,
+                             unsigned long count, bool complete);
+};
+
+/**
+ * Per-thread state for the resolver hooks.
+ *
+ * The classic gethostbyname () returns a pointer to storage which belongs to
+ * the calling thread and stays valid until that thread's next call, so when we
+ * make up an answer for it we do the same thing. This also tracks whether the
+ * thread is already inside one of the resolver hooks, since the system's own
+ * resolver functions call each other and only the outermost call should have
+ * the rules applied.
+ */
+
+struct ResolveState {
+        unsigned long   m_depth;
+
+        hostent         m_host;
+        char          * m_aliases [1];
+        char          * m_addrList [DnsCache :: MAX_ADDRS + 1];
+        unsigned long   m_addrs [DnsCache :: MAX_ADDRS];
+};
+
+void            g_initResolveState (void);
+ResolveState  * g_resolveState (void);
+void            g_freeResolveState (void);
+
+/**@}*/
+#endif  /* ! defined (DNSCACHE_H) */
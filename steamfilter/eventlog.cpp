@@ -0,0 +1,201 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * Recording what the filter does for the monitor to pass on to DbgView.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <windows.h>
+
+#include "eventlog.h"
+
+/**
+ * The section holding the ring, and our view of it.
+ */
+
+static HANDLE           l_section;
+static LogBlock       * volatile l_block;
+
+/**
+ * The level of detail at which each event is recorded.
+ */
+
+static const unsigned char l_levels [LOG_EVENTS] = {
+        LOG_DATA,               /* LOG_CONTINUE */
+        LOG_TRACE,              /* LOG_PASSTHROUGH */
+        LOG_ACTIONS,            /* LOG_CONNECT_REFUSED */
+        LOG_ACTIONS,            /* LOG_CONNECT_REDIRECTED */
+        LOG_ACTIONS,            /* LOG_LOOKUP_RULE */
+        LOG_TRACE,              /* LOG_LOOKUP_CACHED */
+        LOG_TRACE,              /* LOG_LOOKUP_RESOLVED */
+        LOG_ACTIONS,            /* LOG_LOOKUP_REFUSED */
+        LOG_TRACE,              /* LOG_LOOKUP_FAILED */
+        LOG_TRACE,              /* LOG_REQUEST */
+        LOG_ACTIONS,            /* LOG_REQUEST_SUBSTITUTED */
+        LOG_ACTIONS,            /* LOG_RESPONSE_SUBSTITUTED */
+        LOG_ACTIONS,            /* LOG_REPLACEMENT_MISSING */
+        LOG_ACTIONS,            /* LOG_HOST_REJECTED */
+        LOG_ACTIONS,            /* LOG_HOST_REPLACED */
+        LOG_ACTIONS,            /* LOG_HOST_TOO_LONG */
+        LOG_ACTIONS,            /* LOG_HOST_URL_REJECTED */
+        LOG_ACTIONS,            /* LOG_URL_REJECTED */
+        LOG_ACTIONS,            /* LOG_URL_TOO_LONG */
+        LOG_ACTIONS,            /* LOG_STATUS_FAILED */
+        LOG_DATA,               /* LOG_SEND */
+        LOG_DATA                /* LOG_WSASEND */
+};
+
+/**
+ * Create the ring for this process.
+ *
+ * As with the telemetry, the section is named for the process and created
+ * with the default security for the process; it starts off at the default
+ * level, until the monitor says otherwise.
+ */
+
+bool g_initLog (void) {
+        if (l_block != 0)
+                return true;
+
+        wchar_t         name [64];
+        wsprintfW (name, LOG_NAME, GetCurrentProcessId ());
+
+        HANDLE          section;
+        section = CreateFileMappingW (INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+                                      0, sizeof (LogBlock), name);
+        if (section == 0)
+                return false;
+
+        LogBlock      * block;
+        block = (LogBlock *) MapViewOfFile (section, FILE_MAP_WRITE, 0, 0,
+                                            sizeof (LogBlock));
+        if (block == 0) {
+                CloseHandle (section);
+                return false;
+        }
+
+        /*
+         * If the monitor still has the ring from an earlier load mapped, it
+         * sees the ticket count go backwards and starts again from the top.
+         */
+
+        memset (block, 0, sizeof (LogBlock));
+        block->m_version = LOG_VERSION;
+        block->m_size = sizeof (LogBlock);
+        block->m_processId = GetCurrentProcessId ();
+        block->m_level = LOG_ACTIONS;
+
+        MemoryBarrier ();
+        block->m_magic = LOG_MAGIC;
+
+        l_section = section;
+        l_block = block;
+        return true;
+}
+
+/**
+ * Release the ring; as with the telemetry, this is only done once the hooks
+ * are all gone.
+ */
+
+void g_unloadLog (void) {
+        LogBlock      * block = l_block;
+        l_block = 0;
+
+        if (block != 0)
+                UnmapViewOfFile (block);
+        if (l_section != 0)
+                CloseHandle (l_section);
+
+        l_section = 0;
+}
+
+/**
+ * Say whether an event would be recorded, for callers who have work to do to
+ * gather up what goes in it.
+ */
+
+bool g_logging (LogEvent event) {
+        LogBlock      * block = l_block;
+        return block != 0 && l_levels [event] <= block->m_level;
+}
+
+/**
+ * Record an event.
+ *
+ * Nothing here touches the last-error value, so this can be used anywhere in
+ * the hooks; and nothing waits, so if the ring wraps while a writer is slow
+ * to fill in its record (which takes the best part of a thousand events in
+ * the meantime), the reader just sees a record that didn't turn out right.
+ */
+
+void g_log (LogEvent event, unsigned long from, unsigned long to,
+            unsigned long value, const char * text, size_t length) {
+        LogBlock      * block = l_block;
+        if (block == 0 || l_levels [event] > block->m_level)
+                return;
+
+        if (text == 0 || length > LOG_MAX_TEXT)
+                length = text == 0 ? 0 : LOG_MAX_TEXT;
+
+        unsigned long   time = GetTickCount ();
+        unsigned long   thread = GetCurrentThreadId ();
+
+        do {
+                LONG            ticket;
+                ticket = InterlockedIncrement (& block->m_next) - 1;
+
+                LogRecord     * record;
+                record = block->m_records + (ticket & (LOG_RECORDS - 1));
+                InterlockedExchange (& record->m_sequence, ticket);
+
+                size_t          some = length;
+                if (some > LOG_TEXT)
+                        some = LOG_TEXT;
+
+                record->m_event = (unsigned short) event;
+                record->m_length = (unsigned short) some;
+                record->m_time = time;
+                record->m_thread = thread;
+                record->m_from = from;
+                record->m_to = to;
+                record->m_value = value;
+                if (some > 0)
+                        memcpy (record->m_text, text, some);
+
+                InterlockedExchange (& record->m_sequence, ticket + 1);
+
+                text += some;
+                length -= some;
+                event = LOG_CONTINUE;
+        } while (length > 0);
+}
+
+/**@}*/
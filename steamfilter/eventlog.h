@@ -0,0 +1,164 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H              1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares the layout of the ring of event records which the filter DLL
+ * writes in place of sending text to DbgView, and the filter's functions for
+ * adding to it.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+
+/**
+ * The event ring the filter shares with the monitor.
+ *
+ * The filter used to describe everything it did with OutputDebugString (),
+ * which is fine when nothing is listening but when DbgView is running each
+ * call waits for the debugger to collect the text; from inside a hook that
+ * holds up Steam's networking. So now the hooks just fill in a small binary
+ * record in a ring held in a named section, and the monitor collects them
+ * on its regular poll, formats them and sends them to DbgView itself.
+ *
+ * Writers take a ticket from m_next with an interlocked increment, which
+ * picks the record to use; the record's sequence is set to the ticket while
+ * it's being filled in, and to the ticket plus one once it's complete. So a
+ * reader wanting the record for a ticket knows it has it if the sequence
+ * matches both before and after it takes a copy; a smaller value means the
+ * writer isn't done yet, and a larger one means the ring has wrapped and the
+ * record is gone (which happens if the reader falls behind, since writers
+ * never wait).
+ *
+ * The level is set by the monitor, and the filter records only the events at
+ * that level of detail or less; writing a record is cheap, but the data level
+ * copies everything Steam sends so it's only for debugging.
+ */
+
+enum {
+        LOG_MAGIC = 0x474c4c53,
+        LOG_VERSION = 1,
+
+        LOG_RECORDS = 1024,
+        LOG_TEXT = 36,
+        LOG_MAX_TEXT = LOG_TEXT * 32
+};
+
+#define LOG_NAME                L"Local\\SteamLimitLog.%lx"
+
+/**
+ * How much detail to record; the default is what the filter always used to
+ * describe to DbgView, which is what it does to connections and requests.
+ */
+
+enum LogLevel {
+        LOG_OFF = -1,
+        LOG_ACTIONS,
+        LOG_TRACE,
+        LOG_DATA
+};
+
+/**
+ * The events the filter records.
+ *
+ * Which of the addresses (in network order) and the value are used depends on
+ * the event; the text is names, URLs or data, and text longer than will fit in
+ * one record carries on in LOG_CONTINUE records from the same thread.
+ */
+
+enum LogEvent {
+        LOG_CONTINUE,
+        LOG_PASSTHROUGH,
+        LOG_CONNECT_REFUSED,
+        LOG_CONNECT_REDIRECTED,
+        LOG_LOOKUP_RULE,
+        LOG_LOOKUP_CACHED,
+        LOG_LOOKUP_RESOLVED,
+        LOG_LOOKUP_REFUSED,
+        LOG_LOOKUP_FAILED,
+        LOG_REQUEST,
+        LOG_REQUEST_SUBSTITUTED,
+        LOG_RESPONSE_SUBSTITUTED,
+        LOG_REPLACEMENT_MISSING,
+        LOG_HOST_REJECTED,
+        LOG_HOST_REPLACED,
+        LOG_HOST_TOO_LONG,
+        LOG_HOST_URL_REJECTED,
+        LOG_URL_REJECTED,
+        LOG_URL_TOO_LONG,
+        LOG_STATUS_FAILED,
+        LOG_SEND,
+        LOG_WSASEND,
+        LOG_EVENTS
+};
+
+/**
+ * One record in the ring; this is 64 bytes, so records don't share cache
+ * lines with each other.
+ */
+
+struct LogRecord {
+        volatile LONG   m_sequence;
+        unsigned short  m_event;
+        unsigned short  m_length;
+        unsigned long   m_time;
+        unsigned long   m_thread;
+        unsigned long   m_from;
+        unsigned long   m_to;
+        unsigned long   m_value;
+        char            m_text [LOG_TEXT];
+};
+
+/**
+ * The block itself; the header is padded out to the size of a record, so the
+ * records are lined up on cache lines too.
+ */
+
+struct LogBlock {
+        unsigned long   m_magic;
+        unsigned long   m_version;
+        unsigned long   m_size;
+        unsigned long   m_processId;
+
+        volatile LONG   m_level;
+        volatile LONG   m_next;
+        unsigned long   m_spare [10];
+
+        LogRecord       m_records [LOG_RECORDS];
+};
+
+/**
+ * The filter's side of the log.
+ */
+
+bool            g_initLog (void);
+void            g_unloadLog (void);
+
+bool            g_logging (LogEvent event);
+void            g_log (LogEvent event, unsigned long from = 0,
+                       unsigned long to = 0, unsigned long value = 0,
+                       const char * text = 0, size_t length = 0);
+
+/**@}*/
+#endif  /* ! defined (EVENTLOG_H) */
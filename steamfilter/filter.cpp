@@ -43,10 +43,19 @@
 #include "../limitver.h"
 
 #include <winsock2.h>
+#include <ws2tcpip.h>
 
 #include "glob.h"
 #include "filterrule.h"
 #include "replace.h"
+#include "dnscache.h"
+#include "httpscan.h"
+#include "ratelimit.h"
+#include "telemetry.h"
+#include "eventlog.h"
+#include "rulebase.h"
+#include "readers.h"
+#include "heap.h"
 
 /**
  * For declaring exported callable functions from the injection shim.
@@ -85,6 +94,34 @@ typedef int (WSAAPI * ConnectFunc) (SOCKET s, const sockaddr * name, int namelen
 
 typedef struct hostent * (WSAAPI * GetHostFunc) (const char * name);
 
+/**
+ * Prototypes of the modern resolver functions.
+ *
+ * Newer code, including the embedded browser Steam uses for its store and
+ * community pages, resolves names through these rather than gethostbyname ()
+ * so they need the DNS rules applied as well.
+ */
+
+typedef int   (WSAAPI * GetAddrInfoFunc) (const char * name,
+                                          const char * service,
+                                          const addrinfo * hints,
+                                          addrinfo ** result);
+typedef int   (WSAAPI * GetAddrInfoWFunc) (const wchar_t * name,
+                                           const wchar_t * service,
+                                           const ADDRINFOW * hints,
+                                           ADDRINFOW ** result);
+typedef int   (WSAAPI * GetAddrInfoExWFunc) (const wchar_t * name,
+                                             const wchar_t * service,
+                                             unsigned long nameSpace,
+                                             GUID * provider,
+                                             const ADDRINFOEXW * hints,
+                                             ADDRINFOEXW ** result,
+                                             timeval * timeout,
+                                             OVERLAPPED * overlapped,
+                                             LPLOOKUPSERVICE_COMPLETION_ROUTINE
+                                                     handler,
+                                             HANDLE * cancel);
+
 /**
  * Prototype of the legacy sockets recv () function.
  */
@@ -186,12 +223,48 @@ typedef int   (WSAAPI * WSAEnumNetworkEventsFunc) (SOCKET s, WSAEVENT event,
 
 typedef int   (WSAAPI * getpeernameFunc) (SOCKET s, sockaddr * addr, int * length);
 
+/**
+ * Prototype for getsockopt (), which we also don't hook.
+ */
+
+typedef int   (WSAAPI * getsockoptFunc) (SOCKET s, int level, int name,
+                                         char * value, int * length);
+
+/**
+ * Prototypes for socket () and ioctlsocket (), for the extra connections made
+ * to race a rule's targets; ioctlsocket () is also hooked, to see which sockets
+ * are put in non-blocking mode.
+ */
+
+typedef SOCKET (WSAAPI * socketFunc) (int family, int type, int protocol);
+typedef int   (WSAAPI * ioctlsocketFunc) (SOCKET s, long command,
+                                          u_long * value);
+
+/**
+ * Prototype for shutdown (), for failing a connection whose request can't be
+ * sent whole.
+ */
+
+typedef int   (WSAAPI * shutdownFunc) (SOCKET s, int how);
+
 /**
  * Prototype for closesocket (), to detect when to release tracking data.
  */
 
 typedef int   (WSAAPI * closesocketFunc) (SOCKET s);
 
+/**
+ * Prototype for CreateIoCompletionPort (), to see which sockets are associated
+ * with a completion port.
+ *
+ * This lives in KERNEL32.DLL rather than Winsock, since sockets are just file
+ * handles as far as completion ports go.
+ */
+
+typedef HANDLE (WINAPI * CreateIoPortFunc) (HANDLE file, HANDLE port,
+                                            ULONG_PTR key,
+                                            unsigned long threads);
+
 /**
  * Simple equivalent to ntohs.
  *
@@ -215,6 +288,7 @@ struct ApiHook {
         FARPROC         m_original;
         FARPROC         m_resume;
         FARPROC         m_hook;
+        bool            m_enabled;
         unsigned char   m_save [8];
         unsigned char   m_thunk [16];
 
@@ -226,6 +300,7 @@ struct ApiHook {
 
         FARPROC         makeThunk (unsigned char * data, size_t length);
         void            unhook (void);
+        void            enable (bool on);
 
         bool            attach (void * address, FARPROC hook);
         bool            attach (void * hook, HMODULE lib, const char * name);
@@ -251,6 +326,9 @@ struct Hook : public ApiHook {
 
 Hook<ConnectFunc>       g_connectHook;
 Hook<GetHostFunc>       g_gethostHook;
+Hook<GetAddrInfoFunc>   g_getaddrinfoHook;
+Hook<GetAddrInfoWFunc>  g_getAddrInfoWHook;
+Hook<GetAddrInfoExWFunc> g_getAddrInfoExWHook;
 Hook<RecvFunc>          g_recvHook;
 Hook<RecvFromFunc>      g_recvfromHook;
 Hook<WSARecvFunc>       g_wsaRecvHook;
@@ -261,25 +339,48 @@ Hook<WSAEventSelectFunc> g_wsaEventSelectHook;
 Hook<WSAEnumNetworkEventsFunc> g_wsaEnumNetworkEventsHook;
 Hook<WSASendFunc>       g_wsaSendHook;
 Hook<closesocketFunc>   g_closesocket_Hook;
+Hook<ioctlsocketFunc>   g_ioctlsocketHook;
+Hook<CreateIoPortFunc>  g_createIoPortHook;
 
 getpeernameFunc         g_getpeername;
+getsockoptFunc          g_getsockopt;
+socketFunc              g_socket;
+ioctlsocketFunc         g_ioctlsocket;
+shutdownFunc            g_shutdown;
 
 /**@}*/
 
 /**
- * As a safety thing to prevent crashes on unload, set a global counter when
+ * As a safety thing to prevent crashes on unload, count the threads that are
  * inside a hooked function - particularly the emulation of select (), since
  * that has a timeout; because of the timeout we could be inside the wrapped
  * version of the function in one thread while another thread is trying to
  * unload all the hook functions.
+ *
+ * This used to be one global counter, but since every socket call from every
+ * thread came through here that counter's cache line was fought over all the
+ * time; so each thread counts in its own reader slot instead, and the unload
+ * scans them all.
+ *
+ * A thread can stay inside the original select () or recv () for as long as
+ * it likes, so the unload only waits for so long before giving up.
  */
 
 class InHook {
+private:
+        volatile LONG * m_count;
+
 public:
-static  LONG            g_hookCount;
+        enum { UNLOAD_TIMEOUT = 5000, APC_TIMEOUT = 500 };
+
+                        InHook () : m_count (g_readerSlot () + READER_HOOKS) {
+                InterlockedIncrement (m_count);
+        }
+                      ~ InHook () { InterlockedDecrement (m_count); }
 
-                        InHook () { InterlockedIncrement (& g_hookCount); }
-                      ~ InHook () { InterlockedDecrement (& g_hookCount); }
+static  bool            quiesce (unsigned long timeout) {
+                return g_waitReaders (READER_HOOKS, timeout);
+        }
 };
 
 /**
@@ -317,6 +418,328 @@ FilterRules     g_rules (27030);
 
 bool            g_passthrough = true;
 
+/**
+ * The hooks on the busiest paths, and what they are there for.
+ *
+ * Every read, write and wait Steam does would otherwise go through our hooks
+ * even when the rules don't do anything that needs them, so these are only
+ * switched on while something needs them: the send hooks while there are URL
+ * or host rules, the read hooks while data has to be metered out or measured
+ * for a rule or the monitor is watching the telemetry, and the read and wait
+ * hooks both while there's a substitute response to deliver. The rest are
+ * called rarely enough to just leave alone.
+ */
+
+enum {
+        HOOKS_SEND = FilterRules :: NEED_SEND,
+        HOOKS_READ = FilterRules :: NEED_READ,
+        HOOKS_REPLACE = 4
+};
+
+struct HookGroup {
+        ApiHook       * m_hook;
+        unsigned long   m_groups;
+};
+
+static const HookGroup  l_hookGroups [] = {
+        { & g_sendHook, HOOKS_SEND },
+        { & g_wsaSendHook, HOOKS_SEND },
+        { & g_recvHook, HOOKS_READ | HOOKS_REPLACE },
+        { & g_recvfromHook, HOOKS_READ },
+        { & g_wsaRecvHook, HOOKS_READ | HOOKS_REPLACE },
+        { & g_wsaGetOverlappedHook, HOOKS_READ | HOOKS_REPLACE },
+        { & g_select_Hook, HOOKS_REPLACE },
+        { & g_wsaEnumNetworkEventsHook, HOOKS_REPLACE }
+};
+
+static CRITICAL_SECTION l_hookLock;
+static volatile LONG    l_hooksOn = ~ 0L;
+static volatile LONG    l_unhooking;
+
+/**
+ * Work out which groups of hooks are needed now.
+ */
+
+static unsigned long l_hooksWanted (void) {
+        unsigned long   want = g_rules.needs ();
+        if (g_replacing ())
+                want |= HOOKS_REPLACE;
+        if (g_telemetryWatched ())
+                want |= HOOKS_READ;
+
+        return want;
+}
+
+/**
+ * Bring the set of active hooks in line with what's needed now.
+ *
+ * This is called whenever that might have changed; when rules are installed,
+ * as soon as a substitute response has been set up (before the request that
+ * it answers is seen to have been sent, so the caller can't read ahead of the
+ * read hooks) and as sockets close, which is when the responses are done. The
+ * rulebase thread also calls it every second or so, to follow the monitor
+ * starting and stopping watching the telemetry.
+ */
+
+static void l_updateHooks (void) {
+        if (g_connectHook == 0)
+                return;
+
+        unsigned long   want = l_hooksWanted ();
+        if ((unsigned long) l_hooksOn == want)
+                return;
+
+        EnterCriticalSection (& l_hookLock);
+
+        /*
+         * Once the hooks are coming out, leave them be; otherwise look again
+         * with the lock held, since another thread could have just made a
+         * change which this one doesn't know about.
+         */
+
+        if (l_unhooking != 0) {
+                LeaveCriticalSection (& l_hookLock);
+                return;
+        }
+
+        want = l_hooksWanted ();
+
+        for (unsigned long i = 0 ; i < ARRAY_LENGTH (l_hookGroups) ; ++ i) {
+                const HookGroup & group = l_hookGroups [i];
+                group.m_hook->enable ((group.m_groups & want) != 0);
+        }
+
+        InterlockedExchange (& l_hooksOn, want);
+        LeaveCriticalSection (& l_hookLock);
+}
+
+/**
+ * Pass a connect on to the original, letting the telemetry know where it went
+ * and how it went.
+ */
+
+static int l_connect (SOCKET s, const sockaddr * name, int namelen) {
+        unsigned long   start = GetTickCount ();
+        int             result;
+        result = (* g_connectHook) (s, name, namelen);
+        if (name->sa_family != AF_INET)
+                return result;
+
+        unsigned long   error = GetLastError ();
+        g_telemetryConnect (s, (const sockaddr_in *) name, start, result,
+                            error);
+
+        SetLastError (error);
+        return result;
+}
+
+/**
+ * Work out where a connection redirected to a target actually goes; a target
+ * with no address or port keeps the one the caller asked for.
+ */
+
+static void l_redirect (sockaddr_in & temp, const sockaddr_in * base,
+                        const sockaddr_in * replace) {
+        temp.sin_family = base->sin_family;
+        temp.sin_port = replace->sin_port != 0 ? replace->sin_port :
+                        base->sin_port;
+        temp.sin_addr = replace->sin_addr.S_un.S_addr != 0 ?
+                        replace->sin_addr : base->sin_addr;
+        memset (temp.sin_zero, 0, sizeof (temp.sin_zero));
+}
+
+/**
+ * Start one of the connections for a race, returning the socket for it or
+ * INVALID_SOCKET if it couldn't be started.
+ *
+ * A connection which is refused straight away counts as a failure for the
+ * target; one which can't be started for local reasons isn't the target's
+ * fault, so it doesn't count for anything.
+ */
+
+static SOCKET l_raceStart (const sockaddr_in & addr, TargetStats * target,
+                           bool & connected) {
+        connected = false;
+
+        SOCKET          s = (* g_socket) (AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET)
+                return s;
+
+        u_long          nonBlocking = 1;
+        if ((* g_ioctlsocket) (s, FIONBIO, & nonBlocking) != 0) {
+                (* g_closesocket_Hook) (s);
+                return INVALID_SOCKET;
+        }
+
+        if ((* g_connectHook) (s, (const sockaddr *) & addr,
+                               sizeof (addr)) == 0) {
+                connected = true;
+                return s;
+        }
+
+        if (GetLastError () == WSAEWOULDBLOCK)
+                return s;
+
+        if (target != 0)
+                target->failed ();
+
+        (* g_closesocket_Hook) (s);
+        return INVALID_SOCKET;
+}
+
+/**
+ * Race connections to the candidate targets for a rule, returning the index of
+ * the winner.
+ *
+ * The caller's own socket can only be connected once, so the race is run with
+ * connections of our own; one to the first candidate at once, and one to each
+ * of the others a little after the last, with the first to be accepted being
+ * the winning target for the caller's socket. This costs an extra round trip
+ * against one connection to a target that's working, but against a target
+ * which silently drops connections it bounds the wait to about one round trip
+ * to the next candidate, where otherwise it would be the whole TCP timeout.
+ *
+ * The hook has to wait for the race even for a non-blocking socket, so the
+ * wait is bounded; if nothing has answered by then, or the race can't be run
+ * at all, the first candidate wins by default as it would without a race.
+ * What is learned along the way goes into the target statistics, so the
+ * selection avoids the losers in future; the caller is told whether the
+ * winner's connect time went in, so as not to count the same target twice
+ * when its own connect goes through.
+ */
+
+static unsigned long l_race (RaceTargets & race, const sockaddr_in * base,
+                             bool & measured) {
+        measured = false;
+        if (g_socket == 0 || g_ioctlsocket == 0)
+                return 0;
+
+        SOCKET          probes [RaceTargets :: RACE_TARGETS];
+        unsigned long   started [RaceTargets :: RACE_TARGETS];
+        unsigned long   count = race.m_count;
+        unsigned long   launched = 0;
+        unsigned long   winner = count;
+        unsigned long   start = GetTickCount ();
+        unsigned long   next = start;
+        unsigned long   i;
+
+        for (i = 0 ; i < count ; ++ i)
+                probes [i] = INVALID_SOCKET;
+
+        for (;;) {
+                /*
+                 * Start any attempts which are now due; an attempt which fails
+                 * makes the next one due straight away.
+                 */
+
+                unsigned long   now = GetTickCount ();
+                while (launched < count && winner == count &&
+                       (LONG) (now - next) >= 0) {
+                        sockaddr_in     addr;
+                        bool            connected;
+                        l_redirect (addr, base, race.m_address + launched);
+
+                        SOCKET          probe;
+                        probe = l_raceStart (addr, race.m_target [launched],
+                                             connected);
+                        if (connected)
+                                winner = launched;
+
+                        next = probe == INVALID_SOCKET ? now :
+                               now + race.m_stagger;
+                        started [launched] = now;
+                        probes [launched ++] = probe;
+                }
+
+                unsigned long   elapsed = now - start;
+                if (winner < count || elapsed >= RaceTargets :: RACE_WAIT)
+                        break;
+
+                fd_set          write [1];
+                fd_set          error [1];
+                FD_ZERO (write);
+                FD_ZERO (error);
+
+                for (i = 0 ; i < launched ; ++ i) {
+                        if (probes [i] == INVALID_SOCKET)
+                                continue;
+
+                        FD_SET (probes [i], write);
+                        FD_SET (probes [i], error);
+                }
+
+                /*
+                 * Wait until the next attempt is due, or the race is over.
+                 */
+
+                unsigned long   wait = RaceTargets :: RACE_WAIT - elapsed;
+                if (launched < count && next - now < wait)
+                        wait = next - now;
+
+                if (write->fd_count == 0)
+                        break;
+
+                timeval         timeout;
+                timeout.tv_sec = wait / 1000;
+                timeout.tv_usec = (wait % 1000) * 1000;
+
+                if ((* g_select_Hook) (0, 0, write, error, & timeout) ==
+                    SOCKET_ERROR)
+                        break;
+
+                /*
+                 * With a non-blocking connect, failure shows up in the error
+                 * set and success in the write set.
+                 */
+
+                now = GetTickCount ();
+                for (i = 0 ; i < launched ; ++ i) {
+                        SOCKET          s = probes [i];
+                        if (s == INVALID_SOCKET)
+                                continue;
+
+                        unsigned long   j;
+                        for (j = 0 ; j < error->fd_count ; ++ j)
+                                if (error->fd_array [j] == s)
+                                        break;
+
+                        if (j < error->fd_count) {
+                                if (race.m_target [i] != 0)
+                                        race.m_target [i]->failed ();
+
+                                (* g_closesocket_Hook) (s);
+                                probes [i] = INVALID_SOCKET;
+                                next = now;
+                                continue;
+                        }
+
+                        for (j = 0 ; j < write->fd_count ; ++ j)
+                                if (write->fd_array [j] == s)
+                                        break;
+
+                        if (j < write->fd_count && winner == count)
+                                winner = i;
+                }
+        }
+
+        /*
+         * The winner's statistics get its connect time; the attempts still
+         * going when the race ended don't count, as nothing was learned.
+         */
+
+        if (winner < count && race.m_target [winner] != 0) {
+                race.m_target [winner]->connected (GetTickCount () -
+                                                   started [winner]);
+                measured = true;
+        }
+
+        for (i = 0 ; i < launched ; ++ i)
+                if (probes [i] != INVALID_SOCKET)
+                        (* g_closesocket_Hook) (probes [i]);
+
+        return winner < count ? winner : 0;
+}
+
 /**
  * Hook for the connect () function; check if we want to rework it, or just
  * continue on to the original.
@@ -346,10 +769,31 @@ int WSAAPI connectHook (SOCKET s, const sockaddr * name, int namelen) {
 #endif
 
         const sockaddr_in * old = (const sockaddr_in *) name;
+        sockaddr_in     chosen;
         sockaddr_in   * replace = 0;
-        
-        if (g_passthrough || name->sa_family != AF_INET ||
-            ! g_rules.matchIp (old, module, & replace)) {
+        TargetStats   * target = 0;
+        RateLimit     * limit = 0;
+        RaceTargets     race;
+        bool            matched = false;
+
+        /*
+         * The rule data is only needed until the chosen target has been copied
+         * out; it mustn't be held any longer than that, since a connect or a
+         * race can take a while and installing new rules waits for all the
+         * readers.
+         */
+
+        if (! g_passthrough && name->sa_family == AF_INET) {
+                RuleGuard       reading;
+                matched = g_rules.matchIp (old, module, & replace, & target,
+                                           & limit, & race);
+                if (replace != 0) {
+                        chosen = * replace;
+                        replace = & chosen;
+                }
+        }
+
+        if (! matched) {
                 /*
                  * Just forward on to the original. The 'passthrough' case is
                  * for when Steam starts up and does an auth interchange over
@@ -365,9 +809,9 @@ int WSAAPI connectHook (SOCKET s, const sockaddr * name, int namelen) {
                  */
 
                 if (g_passthrough)
-                        OutputDebugStringA ("passthrough\r\n");
+                        g_log (LOG_PASSTHROUGH);
 
-                return (* g_connectHook) (s, name, namelen);
+                return l_connect (s, name, namelen);
         }
 
         /*
@@ -377,209 +821,996 @@ int WSAAPI connectHook (SOCKET s, const sockaddr * name, int namelen) {
          */
 
         if (replace == 0 || replace->sin_addr.S_un.S_addr == INADDR_NONE) {
-                OutputDebugStringA ("Connect refused\r\n");
+                if (target != 0)
+                        target->release ();
+                if (limit != 0)
+                        limit->release ();
+
+                race.release ();
+
+                g_log (LOG_CONNECT_REFUSED, old->sin_addr.S_un.S_addr, 0,
+                       ntohs (old->sin_port));
+                g_telemetryCount (TELEMETRY_CONNECTS);
+                g_telemetryCount (TELEMETRY_REFUSED);
                 SetLastError (WSAECONNREFUSED);
                 return SOCKET_ERROR;
         }
 
+        /*
+         * If the rule races its targets, find out which answers first and use
+         * that one; the caller gets its statistics in place of the ones for
+         * the target the selection chose.
+         */
+
+        bool            measured = false;
+        if (race.m_count > 1) {
+                unsigned long   winner = l_race (race, old, measured);
+                chosen = race.m_address [winner];
+
+                if (target != 0)
+                        target->release ();
+
+                target = race.m_target [winner];
+                race.m_target [winner] = 0;
+        }
+
+        race.release ();
+
         /*
          * Redirect the connection; put the rewritten address into a temporary
          * so the change isn't visible to the caller (Steam doesn't appear to
          * care either way, but it's best to be careful).
          */
 
-        sockaddr_in   * base = (sockaddr_in *) name;
         sockaddr_in     temp;
-        temp.sin_family = base->sin_family;
-        temp.sin_port = replace->sin_port != 0 ? replace->sin_port :
-                        base->sin_port;
-        temp.sin_addr = replace->sin_addr.S_un.S_addr != 0 ?
-                        replace->sin_addr : base->sin_addr;
+        l_redirect (temp, old, replace);
+
+        /*
+         * Record the redirection for the benefit of DbgView; the monitor does
+         * the formatting.
+         */
+
+        g_log (LOG_CONNECT_REDIRECTED, old->sin_addr.S_un.S_addr,
+               temp.sin_addr.S_un.S_addr, ntohs (temp.sin_port));
+        g_telemetryCount (TELEMETRY_REDIRECTED);
+
+        if (target == 0 && limit == 0)
+                return l_connect (s, (sockaddr *) & temp, sizeof (temp));
 
         /*
-         * Describe the redirection for the benefit of DbgView
+         * Where the rule chose between several targets, let the statistics
+         * for the chosen one know how this connection fares; and where the
+         * rule puts a rate limit on its connections, apply it to this one.
+         *
+         * If a race already measured the connect time, this connection only
+         * goes on to count its transfer rate.
          */
 
-        char            show [128];
-        unsigned char * bytes = & temp.sin_addr.S_un.S_un_b.s_b1;
-        const unsigned char * prev = & old->sin_addr.S_un.S_un_b.s_b1;
-        wsprintfA (show, "Connect redirected %d.%d.%d.%d to %d.%d.%d.%d:%d\r\n",
-                   prev [0], prev [1], prev [2], prev [3],
-                   bytes [0], bytes [1], bytes [2], bytes [3],
-                   ntohs (temp.sin_port));
+        unsigned long   start = GetTickCount ();
+        int             result;
+        result = l_connect (s, (sockaddr *) & temp, sizeof (temp));
+
+        unsigned long   error = GetLastError ();
+        if (limit != 0) {
+                if (result == 0 || error == WSAEWOULDBLOCK)
+                        g_addLimit (s, limit);
+
+                limit->release ();
+        }
+
+        if (target != 0) {
+                if (result == 0) {
+                        if (! measured)
+                                target->connected (GetTickCount () - start);
+
+                        g_addTransfer (s, target, true);
+                } else if (error == WSAEWOULDBLOCK) {
+                        g_addTransfer (s, target, measured);
+                } else
+                        target->failed ();
 
-        OutputDebugStringA (show);
-                
-        return (* g_connectHook) (s, (sockaddr *) & temp, sizeof (temp));
+                target->release ();
+        }
+
+        SetLastError (error);
+        return result;
 }
 
 /**
- * Hook for the gethostbyname () Sockets address-resolution function.
+ * The ways the resolver hooks can deal with a lookup.
  */
 
-struct hostent * WSAAPI gethostHook (const char * name) {
-        InHook          hooking;
+enum LookupAction {
+        LOOKUP_FORWARD,
+        LOOKUP_ANSWER,
+        LOOKUP_REFUSE
+};
+
+/**
+ * The cache of answers for the names we let through to the system resolver.
+ */
+
+DnsCache        g_dnsCache;
+
+/**
+ * Record what happened to a lookup for the benefit of DbgView.
+ */
+
+static void l_showLookup (LogEvent event, const char * name,
+                          unsigned long address = 0) {
+        if (g_logging (event))
+                g_log (event, 0, address, 0, name, strlen (name));
+}
+
+/**
+ * Apply the DNS rules, and then the answer cache, to a name being looked up.
+ *
+ * The family is the kind of address the caller asked for; a rule only ever
+ * gives an IPv4 address, so if the caller can't take one of those then for a
+ * rewritten name the answer is that there's no such host, rather than letting
+ * the original name through unfiltered.
+ *
+ * The cache only holds addresses, so callers who want more than that from the
+ * resolver (such as the canonical name) can ask to skip it.
+ *
+ * An answer is a list of up to DnsCache :: MAX_ADDRS addresses, the way the
+ * resolver gives them, so that the caller can fall back on the later ones if
+ * the first doesn't work out.
+ */
 
+static LookupAction l_lookupName (const char * name, int family,
+                                  bool useCache, unsigned long * addrs,
+                                  unsigned long & count) {
         /*
          * Disable the temporary pass-through mode once we see a DNS query.
          */
 
         g_passthrough = false;
 
+        sockaddr_in     chosen;
         sockaddr_in   * replace = 0;
+        bool            matched;
 
-        if (! g_rules.matchDns (name, & replace)) {
-                /*
-                 * No matching rule, silently forward onward.
-                 */
-
-                return (* g_gethostHook) (name);
-        }
+        /*
+         * As with connect, only hold on to the rules while copying out the
+         * answer, since a lookup our caller forwards can take a long time.
+         */
 
-        if (replace == 0 || replace->sin_addr.S_un.S_addr == INADDR_NONE) {
-                /*
-                 * On Windows, WSAGetLastError () and WSASetLastError () are
-                 * just thin wrappers around GetLastError ()/SetLastError (),
-                 * so we can use SetLastError ().
-                 *
-                 * Set up the right error number for a nonexistent host, since
-                 * this classic BSD sockets API doesn't have a proper error
-                 * reporting mechanism and that's what most code looks for to
-                 * see what went wrong.
-                 */
+        count = DnsCache :: MAX_ADDRS;
 
-                char            show [128];
-                wsprintfA (show, "lookup %.50s refused\r\n", name);
-                OutputDebugStringA (show);
-                SetLastError (WSAHOST_NOT_FOUND);
-                return 0;
+        {
+                RuleGuard       reading;
+                matched = g_rules.matchDns (name, & replace, addrs, & count);
+                if (replace != 0) {
+                        chosen = * replace;
+                        replace = & chosen;
+                }
         }
 
-        /*
-         * Replacing a DNS result raises the question of storage, which for
-         * base Windows sockets is per-thread; we could also choose to use a
-         * non-thread-safe global like most UNIX implementations.
-         *
-         * One obvious trick would be to let the underlying call return the
-         * structure which we modify, but the tradeoff there is that if it
-         * fails we don't have a pointer.
-         *
-         * So for now, cheese out and use a global; also, copy the address
-         * rather than point at the replacement.
-         */
+        if (matched) {
+                if (replace == 0 ||
+                    replace->sin_addr.S_un.S_addr == INADDR_NONE) {
+                        l_showLookup (LOG_LOOKUP_REFUSED, name);
+                        g_telemetryCount (TELEMETRY_LOOKUP_REFUSED);
+                        return LOOKUP_REFUSE;
+                }
 
-        hostent       * result = 0;
-        if (replace != 0 && replace->sin_addr.S_un.S_addr == INADDR_ANY) {
                 /*
-                 * If the matching rule is a passthrough, then wrap it but do
-                 * still log the result.
+                 * A passthrough rule is treated just as if there was no rule.
                  */
 
-                result = (* g_gethostHook) (name);
-        } else {
-static  hostent         storage;
-static  unsigned long   addr;
-static  unsigned long * addrList [2] = { & addr };
+                if (replace->sin_addr.S_un.S_addr != INADDR_ANY) {
+                        if (family != AF_INET && family != AF_UNSPEC) {
+                                g_telemetryCount (TELEMETRY_LOOKUP_REFUSED);
+                                return LOOKUP_REFUSE;
+                        }
 
-                addr = replace->sin_addr.S_un.S_addr;
-                storage.h_addrtype = AF_INET;
-                storage.h_addr_list = (char **) addrList;
-                storage.h_aliases = 0;
-                storage.h_length = sizeof (addr);
-                storage.h_name = "remapped.local";
-                result = & storage;
+                        l_showLookup (LOG_LOOKUP_RULE, name, * addrs);
+                        g_telemetryCount (TELEMETRY_LOOKUP_ANSWERED);
+                        return LOOKUP_ANSWER;
+                }
         }
 
-        char            show [128];
-        if (result == 0) {
-                wsprintfA (show, "lookup %.50s failed\r\n", name);
-                OutputDebugStringA (show);
-                return 0;
-        }
+        if (! useCache || (family != AF_INET && family != AF_UNSPEC))
+                return LOOKUP_FORWARD;
 
-        unsigned char * bytes = (unsigned char *) * result->h_addr_list;
-        wsprintfA (show, "lookup %.50s as %d.%d.%d.%d\r\n",
-                   name, bytes [0], bytes [1], bytes [2], bytes [3]);
-        OutputDebugStringA (show);
+        unsigned long   cached [DnsCache :: MAX_ADDRS];
+        count = g_dnsCache.find (name, family == AF_UNSPEC, cached);
+        if (count == 0)
+                return LOOKUP_FORWARD;
 
-        return result;
+        /*
+         * Hand out the cached addresses with a different one first each time,
+         * as a DNS server doing round robin would, but keep the whole list so
+         * the caller still has the rest to fall back on.
+         */
+
+static  volatile LONG   rotate;
+        unsigned long   pick = (unsigned long) InterlockedIncrement (& rotate);
+
+        for (unsigned long i = 0 ; i < count ; ++ i)
+                addrs [i] = cached [(pick + i) % count];
+
+        l_showLookup (LOG_LOOKUP_CACHED, name, * addrs);
+        return LOOKUP_ANSWER;
 }
 
 /**
- * For measuring bandwidth.
+ * Remember the IPv4 addresses from an answer given by the system resolver.
+ *
+ * If the caller asked for any kind of address, and all the answer held was
+ * IPv4 addresses, then the cached answer is complete and can be used for any
+ * later lookup; otherwise it's only any use to lookups for IPv4 addresses.
  */
 
-class Meter {
-public:
-typedef CRITICAL_SECTION        Mutex;
+template <class T>
+void l_cacheResult (const char * name, int family, const T * result) {
+        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+        unsigned long   count = 0;
+        bool            complete = family == AF_UNSPEC;
 
-private:
-        Mutex           m_lock;
-        unsigned long   m_now;
-        unsigned long   m_currentBytes;
+        for (; result != 0 ; result = result->ai_next) {
+                if (result->ai_family != AF_INET || result->ai_addr == 0) {
+                        complete = false;
+                        continue;
+                }
 
-        unsigned long   m_last;
-        long long       m_total;
+                const sockaddr_in * addr;
+                addr = (const sockaddr_in *) result->ai_addr;
 
-        void            newTick (unsigned long now);
+                /*
+                 * There is usually an entry per socket type for each address,
+                 * so skip over the repeats.
+                 */
 
-public:
-                        Meter ();
+                unsigned long   i = 0;
+                while (i < count && addrs [i] != addr->sin_addr.S_un.S_addr)
+                        ++ i;
 
-        void            operator += (int bytes);
-};
+                if (i == count && count < ARRAY_LENGTH (addrs))
+                        addrs [count ++] = addr->sin_addr.S_un.S_addr;
+        }
 
-Meter :: Meter () : m_now (GetTickCount ()), m_currentBytes (0),
-                m_last (0), m_total (0) {
-        InitializeCriticalSection (& m_lock);
+        g_dnsCache.add (name, addrs, count, complete);
 }
 
-void Meter :: newTick (unsigned long now) {
-        unsigned long   delta = now - m_now;
-        if (delta < 1)
-                return;
+/**
+ * Set up the hints for answering a lookup with a fixed address.
+ *
+ * The answer to a lookup is handed back in memory which the caller will free
+ * with the matching system function, and so the memory can really only come
+ * from the system; the simple way to get that is to have the matching lookup
+ * function parse the address in numeric form, which also takes care of the
+ * details like the service name and socket types asked for in the hints.
+ */
+
+template <class T>
+void l_numericHints (T & temp, const T * hints) {
+        memset (& temp, 0, sizeof (temp));
+        if (hints != 0) {
+                temp.ai_flags = hints->ai_flags;
+                temp.ai_socktype = hints->ai_socktype;
+                temp.ai_protocol = hints->ai_protocol;
+        }
+
+        temp.ai_flags |= AI_NUMERICHOST;
+        temp.ai_family = AF_INET;
+}
+
+/**
+ * Put an address into the numeric form for answering a lookup with.
+ */
+
+static void l_numericText (char * text, unsigned long address) {
+        unsigned char * bytes = (unsigned char *) & address;
+        wsprintfA (text, "%d.%d.%d.%d",
+                   bytes [0], bytes [1], bytes [2], bytes [3]);
+}
+
+static void l_numericText (wchar_t * text, unsigned long address) {
+        unsigned char * bytes = (unsigned char *) & address;
+        wsprintfW (text, L"%d.%d.%d.%d",
+                   bytes [0], bytes [1], bytes [2], bytes [3]);
+}
+
+/**
+ * Find the end of an answer, so the answer for the next address in a list can
+ * be chained on after it.
+ *
+ * The system's functions for freeing an answer release each entry in the list
+ * on its own, so answers made by separate calls can be handed back as one.
+ */
+
+template <class T>
+T ** l_answerTail (T ** tail) {
+        while (* tail != 0)
+                tail = & (* tail)->ai_next;
+
+        return tail;
+}
 
-        unsigned long   bytes = m_currentBytes;
-        m_currentBytes = 0;
+/**
+ * Hook for the gethostbyname () Sockets address-resolution function.
+ */
+
+struct hostent * WSAAPI gethostHook (const char * name) {
+        InHook          hooking;
+
+        /*
+         * If this is a nested call from inside the system resolver, or for
+         * some reason there's no per-thread state, leave it alone.
+         */
+
+        ResolveState  * state = g_resolveState ();
+        if (state == 0 || state->m_depth > 0 || name == 0)
+                return (* g_gethostHook) (name);
+
+        ++ state->m_depth;
+
+        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+        unsigned long   count;
+        LookupAction    action;
+        action = l_lookupName (name, AF_INET, true, addrs, count);
+
+        hostent       * result = 0;
+        if (action == LOOKUP_FORWARD) {
+                result = (* g_gethostHook) (name);
+
+                /*
+                 * This only ever gives IPv4 addresses, so what it says isn't
+                 * a complete answer for someone who asks for any kind.
+                 */
+
+                if (result != 0 && result->h_addrtype == AF_INET &&
+                    result->h_length == sizeof (unsigned long)) {
+                        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+                        unsigned long   count = 0;
+                        char         ** scan = result->h_addr_list;
+                        for (; * scan != 0 && count < ARRAY_LENGTH (addrs) ;
+                             ++ scan) {
+                                addrs [count ++] = * (unsigned long *) * scan;
+                        }
+
+                        g_dnsCache.add (name, addrs, count, false);
+
+                        if (count > 0)
+                                l_showLookup (LOG_LOOKUP_RESOLVED, name,
+                                              * addrs);
+                }
+        } else if (action == LOOKUP_ANSWER) {
+                /*
+                 * Replacing a DNS result raises the question of storage, which
+                 * for base Windows sockets is per-thread, so we do the same.
+                 */
+
+                for (unsigned long i = 0 ; i < count ; ++ i) {
+                        state->m_addrs [i] = addrs [i];
+                        state->m_addrList [i] = (char *) (state->m_addrs + i);
+                }
+
+                state->m_addrList [count] = 0;
+                result = & state->m_host;
+        }
+
+        -- state->m_depth;
+
+        if (action == LOOKUP_REFUSE) {
+                /*
+                 * On Windows, WSAGetLastError () and WSASetLastError () are
+                 * just thin wrappers around GetLastError ()/SetLastError (),
+                 * so we can use SetLastError ().
+                 *
+                 * Set up the right error number for a nonexistent host, since
+                 * this classic BSD sockets API doesn't have a proper error
+                 * reporting mechanism and that's what most code looks for to
+                 * see what went wrong.
+                 */
+
+                SetLastError (WSAHOST_NOT_FOUND);
+                return 0;
+        }
+
+        if (result == 0)
+                l_showLookup (LOG_LOOKUP_FAILED, name);
+
+        return result;
+}
+
+/**
+ * Hook for the getaddrinfo () resolver function.
+ *
+ * This and the other modern resolver hooks follow the same pattern as the
+ * gethostbyname () one, except that answers have to be made by the system
+ * function itself, as described for l_numericHints ().
+ */
+
+int WSAAPI getaddrinfoHook (const char * name, const char * service,
+                            const addrinfo * hints, addrinfo ** result) {
+        InHook          hooking;
+
+        int             flags = hints != 0 ? hints->ai_flags : 0;
+        int             family = hints != 0 ? hints->ai_family : AF_UNSPEC;
+
+        ResolveState  * state = g_resolveState ();
+        if (state == 0 || state->m_depth > 0 || name == 0 ||
+            (flags & AI_NUMERICHOST) != 0) {
+                return (* g_getaddrinfoHook) (name, service, hints, result);
+        }
+
+        ++ state->m_depth;
+
+        bool            useCache = (flags & AI_CANONNAME) == 0;
+        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+        unsigned long   count;
+        LookupAction    action;
+        action = l_lookupName (name, family, useCache, addrs, count);
+
+        int             error = WSAHOST_NOT_FOUND;
+        if (action == LOOKUP_ANSWER) {
+                addrinfo        temp;
+                l_numericHints (temp, hints);
+
+                addrinfo     ** tail = result;
+                * tail = 0;
+                for (unsigned long i = 0 ; i < count ; ++ i) {
+                        char            text [20];
+                        l_numericText (text, addrs [i]);
+
+                        int             status;
+                        status = (* g_getaddrinfoHook) (text, service, & temp,
+                                                        tail);
+                        if (status == 0) {
+                                error = 0;
+                                tail = l_answerTail (tail);
+                        } else {
+                                * tail = 0;
+                                if (error != 0)
+                                        error = status;
+                        }
+                }
+        } else if (action == LOOKUP_FORWARD) {
+                error = (* g_getaddrinfoHook) (name, service, hints, result);
+                if (error == 0 && useCache)
+                        l_cacheResult (name, family, * result);
+        } else
+                * result = 0;
+
+        -- state->m_depth;
+
+        SetLastError (error);
+        return error;
+}
+
+/**
+ * Hook for the GetAddrInfoW () resolver function.
+ *
+ * The rules and the cache work with narrow names, so the name is converted to
+ * UTF-8 for them; a name which is too long for that gets no special treatment.
+ */
+
+int WSAAPI getAddrInfoWHook (const wchar_t * name, const wchar_t * service,
+                             const ADDRINFOW * hints, ADDRINFOW ** result) {
+        InHook          hooking;
+
+        int             flags = hints != 0 ? hints->ai_flags : 0;
+        int             family = hints != 0 ? hints->ai_family : AF_UNSPEC;
+
+        char            narrow [256];
+        ResolveState  * state = g_resolveState ();
+        if (state == 0 || state->m_depth > 0 || name == 0 ||
+            (flags & AI_NUMERICHOST) != 0 ||
+            WideCharToMultiByte (CP_UTF8, 0, name, - 1, narrow,
+                                 sizeof (narrow), 0, 0) == 0) {
+                return (* g_getAddrInfoWHook) (name, service, hints, result);
+        }
+
+        ++ state->m_depth;
+
+        bool            useCache = (flags & AI_CANONNAME) == 0;
+        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+        unsigned long   count;
+        LookupAction    action;
+        action = l_lookupName (narrow, family, useCache, addrs, count);
+
+        int             error = WSAHOST_NOT_FOUND;
+        if (action == LOOKUP_ANSWER) {
+                ADDRINFOW       temp;
+                l_numericHints (temp, hints);
+
+                ADDRINFOW    ** tail = result;
+                * tail = 0;
+                for (unsigned long i = 0 ; i < count ; ++ i) {
+                        wchar_t         text [20];
+                        l_numericText (text, addrs [i]);
+
+                        int             status;
+                        status = (* g_getAddrInfoWHook) (text, service, & temp,
+                                                         tail);
+                        if (status == 0) {
+                                error = 0;
+                                tail = l_answerTail (tail);
+                        } else {
+                                * tail = 0;
+                                if (error != 0)
+                                        error = status;
+                        }
+                }
+        } else if (action == LOOKUP_FORWARD) {
+                error = (* g_getAddrInfoWHook) (name, service, hints, result);
+                if (error == 0 && useCache)
+                        l_cacheResult (narrow, family, * result);
+        } else
+                * result = 0;
+
+        -- state->m_depth;
+
+        SetLastError (error);
+        return error;
+}
+
+/**
+ * Hook for the GetAddrInfoExW () resolver function.
+ *
+ * This has a lot more options than the others; the rules are only applied to
+ * plain synchronous lookups in the default namespaces, since the asynchronous
+ * form would need us to fake up the completion as well, and in practice the
+ * callers we care about don't use it.
+ */
+
+int WSAAPI getAddrInfoExWHook (const wchar_t * name, const wchar_t * service,
+                               unsigned long nameSpace, GUID * provider,
+                               const ADDRINFOEXW * hints,
+                               ADDRINFOEXW ** result, timeval * timeout,
+                               OVERLAPPED * overlapped,
+                               LPLOOKUPSERVICE_COMPLETION_ROUTINE handler,
+                               HANDLE * cancel) {
+        InHook          hooking;
+
+        int             flags = hints != 0 ? hints->ai_flags : 0;
+        int             family = hints != 0 ? hints->ai_family : AF_UNSPEC;
+
+        char            narrow [256];
+        ResolveState  * state = g_resolveState ();
+        if (state == 0 || state->m_depth > 0 || name == 0 ||
+            (flags & AI_NUMERICHOST) != 0 || overlapped != 0 ||
+            provider != 0 || (nameSpace != NS_ALL && nameSpace != NS_DNS) ||
+            WideCharToMultiByte (CP_UTF8, 0, name, - 1, narrow,
+                                 sizeof (narrow), 0, 0) == 0) {
+                return (* g_getAddrInfoExWHook) (name, service, nameSpace,
+                                                 provider, hints, result,
+                                                 timeout, overlapped, handler,
+                                                 cancel);
+        }
+
+        ++ state->m_depth;
+
+        bool            useCache = (flags & AI_CANONNAME) == 0;
+        unsigned long   addrs [DnsCache :: MAX_ADDRS];
+        unsigned long   count;
+        LookupAction    action;
+        action = l_lookupName (narrow, family, useCache, addrs, count);
+
+        int             error = WSAHOST_NOT_FOUND;
+        if (action == LOOKUP_ANSWER) {
+                ADDRINFOEXW     temp;
+                l_numericHints (temp, hints);
+
+                ADDRINFOEXW  ** tail = result;
+                * tail = 0;
+                for (unsigned long i = 0 ; i < count ; ++ i) {
+                        wchar_t         text [20];
+                        l_numericText (text, addrs [i]);
+
+                        int             status;
+                        status = (* g_getAddrInfoExWHook) (text, service,
+                                                           nameSpace, 0,
+                                                           & temp, tail,
+                                                           timeout, 0, 0, 0);
+                        if (status == 0) {
+                                error = 0;
+                                tail = l_answerTail (tail);
+                        } else {
+                                * tail = 0;
+                                if (error != 0)
+                                        error = status;
+                        }
+                }
+        } else if (action == LOOKUP_FORWARD) {
+                error = (* g_getAddrInfoExWHook) (name, service, nameSpace, 0,
+                                                  hints, result, timeout, 0,
+                                                  0, cancel);
+                if (error == 0 && useCache)
+                        l_cacheResult (narrow, family, * result);
+        } else
+                * result = 0;
+
+        -- state->m_depth;
+
+        SetLastError (error);
+        return error;
+}
+
+/**
+ * For measuring bandwidth.
+ *
+ * Originally every read took a lock here and looked at the tick count, and
+ * since every one of Steam's download threads comes through here for every
+ * read, they all lined up on the one lock (and the one cache line) for no good
+ * reason. So now each read just adds to a counter in one of a small set of
+ * slots, each in its own cache line, picked by the thread ID so that threads
+ * mostly stay out of each other's way; the adds are interlocked, since two
+ * threads can still share a slot, but there's no lock and no clock involved.
+ *
+ * Every so often a read folds the new counts into a rolling series of one
+ * second buckets, timed with the performance counter; this only happens if no
+ * other thread is already doing it, and anyone who wants the rates folds the
+ * counts in first as well, so quiet periods still come out right.
+ *
+ * Since the read hooks are only switched on when the rules need them, this
+ * only sees the traffic while they are.
+ */
+
+class Meter {
+public:
+        enum {
+                SLOTS = 16,
+                FOLD_READS = 64,
+                BUCKETS = TELEMETRY_SERIES,
+                BUCKET_MS = TELEMETRY_BUCKET_MS
+        };
+
+private:
+        struct __declspec (align (64)) Slot {
+                volatile LONG   m_bytes;
+                volatile LONG   m_reads;
+        };
+
+        Slot            m_slots [SLOTS];
+
+        CRITICAL_SECTION m_lock;
+        LONGLONG        m_frequency;
+        LONGLONG        m_start;
+        LONGLONG        m_folded;
+        unsigned long   m_seen [SLOTS];
+        unsigned long   m_buckets [BUCKETS];
+        unsigned long   m_current;
+        unsigned long   m_filled;
+        long long       m_total;
+
+        void            fold (void);
+        bool            advance (unsigned long bytes);
+        unsigned long   rate (unsigned long seconds) const;
+
+public:
+                        Meter ();
+
+        void            operator += (int bytes);
+        void            report (RuleReportFunc func, void * context);
+};
+
+Meter :: Meter () : m_frequency (0), m_start (0), m_folded (0),
+                m_current (0), m_filled (0), m_total (0) {
+        InitializeCriticalSection (& m_lock);
+
+        memset ((void *) m_slots, 0, sizeof (m_slots));
+        memset (m_seen, 0, sizeof (m_seen));
+        memset (m_buckets, 0, sizeof (m_buckets));
+
+        LARGE_INTEGER   value;
+        if (QueryPerformanceFrequency (& value))
+                m_frequency = value.QuadPart;
+
+        QueryPerformanceCounter (& value);
+        m_start = value.QuadPart;
+        m_folded = m_start;
+}
+
+/**
+ * Fold the slot counts into the time series, with the lock held.
+ *
+ * Whatever has come in since the last fold is shared out over the buckets
+ * that time covers, as the series moves on to the current one. The result is
+ * copied out to the telemetry block for the monitor to pick up, along with the
+ * rule hits once a bucket is done.
+ */
+
+void Meter :: fold (void) {
+        unsigned long   bytes = 0;
+        for (unsigned long i = 0 ; i < SLOTS ; ++ i) {
+                unsigned long   count = m_slots [i].m_bytes;
+                bytes += count - m_seen [i];
+                m_seen [i] = count;
+        }
 
         m_total += bytes;
 
-        unsigned long   delta2 = m_now - m_last;
+        bool            moved = advance (bytes);
+        g_telemetrySeries (m_buckets, m_current, m_filled, m_total);
 
-#if     0
-        char            buf [80];
-        wsprintfA (buf, "%d %d %d %X\r\n",
-                   delta, bytes, delta2,
-                   (unsigned long) m_total);
-        OutputDebugStringA (buf);
-#endif
+        TelemetryBlock * block = g_telemetry ();
+        if (! moved || block == 0)
+                return;
+
+        block->m_rules = g_rules.hitCounts (block->m_ruleHits,
+                                            TELEMETRY_RULES);
+}
+
+/**
+ * Move the series on to the current bucket, with the lock held, sharing out
+ * the bytes which came in since the last fold; this returns whether any
+ * buckets were completed.
+ *
+ * There's no telling exactly when within that time the bytes came in, so each
+ * bucket gets the part of them that matches its part of the time; a quiet
+ * gap longer than the whole series just drops the share from before the
+ * oldest bucket, although it still counts in the total.
+ */
+
+bool Meter :: advance (unsigned long bytes) {
+        if (m_frequency == 0) {
+                m_buckets [m_current] += bytes;
+                return false;
+        }
+
+        LARGE_INTEGER   now;
+        QueryPerformanceCounter (& now);
+
+        LONGLONG        span = m_frequency * BUCKET_MS / 1000;
+        LONGLONG        steps = (now.QuadPart - m_start) / span;
+        LONGLONG        from = m_folded;
+        double          elapsed = (double) (now.QuadPart - from);
+
+        m_folded = now.QuadPart;
+        if (steps <= 0 || elapsed <= 0) {
+                m_buckets [m_current] += bytes;
+                return steps > 0;
+        }
+
+        if (steps > BUCKETS) {
+                m_start += (steps - BUCKETS) * span;
+                steps = BUCKETS;
+
+                if (from < m_start) {
+                        bytes -= (unsigned long) (bytes *
+                                                  (double) (m_start - from) /
+                                                  elapsed);
+                        elapsed = (double) (now.QuadPart - m_start);
+                        from = m_start;
+                }
+        }
 
-        m_last = m_now;
-        m_now = now;
+        for (; steps > 0 ; -- steps) {
+                LONGLONG        end = m_start + span;
+                unsigned long   share;
+                share = (unsigned long) (bytes * (double) (end - from) /
+                                         elapsed);
+
+                m_buckets [m_current] += share;
+                bytes -= share;
+                elapsed -= (double) (end - from);
+                from = end;
+                m_start = end;
+
+                m_current = (m_current + 1) % BUCKETS;
+                m_buckets [m_current] = 0;
+
+                if (m_filled < BUCKETS - 1)
+                        ++ m_filled;
+        }
+
+        m_buckets [m_current] += bytes;
+        return true;
+}
+
+/**
+ * Work out the average rate in bytes per second over the most recent complete
+ * buckets, with the lock held.
+ */
+
+unsigned long Meter :: rate (unsigned long seconds) const {
+        unsigned long   count = seconds * 1000 / BUCKET_MS;
+        if (count > m_filled)
+                count = m_filled;
+        if (count == 0)
+                return 0;
+
+        unsigned long long total = 0;
+        for (unsigned long i = 1 ; i <= count ; ++ i)
+                total += m_buckets [(m_current + BUCKETS - i) % BUCKETS];
+
+        return (unsigned long) (total * 1000 / (count * BUCKET_MS));
 }
 
 void Meter :: operator += (int bytes) {
-        if (bytes == SOCKET_ERROR)
-                bytes = 0;
+        if (bytes <= 0)
+                return;
+
+        Slot          & slot = m_slots [(GetCurrentThreadId () >> 2) &
+                                        (SLOTS - 1)];
+        InterlockedExchangeAdd (& slot.m_bytes, bytes);
+
+        if ((InterlockedIncrement (& slot.m_reads) & (FOLD_READS - 1)) != 0)
+                return;
+
+        if (! TryEnterCriticalSection (& m_lock))
+                return;
+
+        fold ();
+        LeaveCriticalSection (& m_lock);
+}
+
+/**
+ * Describe the received data, for the statistics report.
+ */
 
+void Meter :: report (RuleReportFunc func, void * context) {
         EnterCriticalSection (& m_lock);
 
-        unsigned long   now = GetTickCount ();
-        newTick (now);
+        fold ();
 
-        m_currentBytes += bytes;
+        char            line [160];
+        wsprintfA (line, "received %luKB, %luB/s over 10s, %luB/s over %lus"
+                   "\r\n", (unsigned long) (m_total >> 10), rate (10),
+                   rate (BUCKETS), m_filled * BUCKET_MS / 1000);
 
         LeaveCriticalSection (& m_lock);
+
+        (* func) (context, line);
 }
 
 Meter           g_meter;
 
+/**
+ * The rate limits which apply to a read from a socket.
+ *
+ * There can be a global limit from the rules as well as one from the rule that
+ * the connection matched, and a read has to fit inside both. Waiting for the
+ * limits is just done by sleeping in the thread which asked for the read; that
+ * holds the reader up for as long as the data is being held back, which is
+ * the effect we want, and once the socket's receive window fills up TCP flow
+ * control pushes the backlog back to the sender.
+ *
+ * A socket in non-blocking mode mustn't be slept on, though, since whatever is
+ * driving it will be looking after other sockets as well; reads from those are
+ * turned away with WSAEWOULDBLOCK until the limits allow more data, and the
+ * owner is told when that is in the same way Winsock would tell it.
+ *
+ * The global limit is meant for downloads, so it only applies to streams; a
+ * datagram socket (as DNS and voice chat use) only answers to a limit from a
+ * rule it matched.
+ */
+
+class ReadLimit {
+private:
+        RateLimit     * m_global;
+        RateLimit     * m_local;
+        bool            m_stream;
+
+public:
+                        ReadLimit (SOCKET s);
+                      ~ ReadLimit ();
+
+        bool            active () const {
+                return m_global != 0 || m_local != 0;
+        }
+        bool            stream () const { return m_stream; }
+        RateLimit     * global () const { return m_global; }
+        RateLimit     * local () const { return m_local; }
+
+        bool            defer (SOCKET s);
+        unsigned long   wait (unsigned long want);
+        void            charge (unsigned long bytes);
+};
+
+ReadLimit :: ReadLimit (SOCKET s) : m_global (g_rules.rateLimit ()),
+                m_local (g_findLimit (s)), m_stream (true) {
+        if (! active () || g_getsockopt == 0)
+                return;
+
+        int             type;
+        int             length = sizeof (type);
+        if ((* g_getsockopt) (s, SOL_SOCKET, SO_TYPE, (char *) & type,
+                              & length) != 0 || type == SOCK_STREAM) {
+                return;
+        }
+
+        m_stream = false;
+        if (m_global != 0) {
+                m_global->release ();
+                m_global = 0;
+        }
+}
+
+ReadLimit :: ~ ReadLimit () {
+        if (m_global != 0)
+                m_global->release ();
+}
+
+/**
+ * Tell the owner of a socket that it can read again, after a read was turned
+ * away.
+ *
+ * Winsock only reports data waiting on a socket again once the owner has read
+ * from it, so this reads on the owner's behalf by peeking; if there is data,
+ * the owner's event is set (or its window message posted) as usual. The resume
+ * point is read once, since the hook might be taken down at the same time; it
+ * is inside WS2_32.DLL, so it stays good even then.
+ */
+
+static void l_wakeReader (SOCKET s) {
+        RecvFunc        peek = * g_recvHook;
+        if (peek == 0)
+                return;
+
+        char            data;
+        (* peek) (s, & data, 1, MSG_PEEK);
+}
+
+/**
+ * Have the owner of a non-blocking socket come back for its read later, if any
+ * of the limits is in debt; this says whether the read should be turned away.
+ */
+
+bool ReadLimit :: defer (SOCKET s) {
+        RateLimit     * limits [2] = { m_global, m_local };
+
+        unsigned long   delay = 0;
+        for (unsigned long i = 0 ; i < 2 ; ++ i) {
+                unsigned long   wait;
+                if (limits [i] != 0 && (wait = limits [i]->delay ()) > delay)
+                        delay = wait;
+        }
+
+        if (delay == 0 || ! g_isNonBlocking (s))
+                return false;
+
+        return g_deferRead (s, delay, l_wakeReader);
+}
+
+/**
+ * Wait until each of the limits is out of debt, and return how much of a read
+ * of the given size they will allow.
+ */
+
+unsigned long ReadLimit :: wait (unsigned long want) {
+        RateLimit     * limits [2] = { m_global, m_local };
+
+        for (unsigned long i = 0 ; i < 2 ; ++ i) {
+                RateLimit     * limit = limits [i];
+                if (limit == 0)
+                        continue;
+
+                unsigned long   delay;
+                while ((delay = limit->delay ()) != 0)
+                        Sleep (delay);
+
+                want = limit->allow (want);
+        }
+
+        return want;
+}
+
+/**
+ * Charge data received against each of the limits.
+ */
+
+void ReadLimit :: charge (unsigned long bytes) {
+        if (m_global != 0)
+                m_global->charge (bytes);
+        if (m_local != 0)
+                m_local->charge (bytes);
+}
+
 /**
  * Hook the recv () API, to measure received bandwidth.
  *
  * Most of the time the underlying socket will probably be in non-blocking mode
  * as any use of this API will be from old code which has had to struggle with
  * the broken original UNIX sockets API design.
+ *
+ * Where a rate limit applies, the read is held up until the limit allows more
+ * data and cut down to what the limit will take; peeking doesn't consume any
+ * data, so that is left alone.
  */
 
 int WSAAPI recvHook (SOCKET s, char * buf, int len, int flags) {
@@ -588,7 +1819,7 @@ int WSAAPI recvHook (SOCKET s, char * buf, int len, int flags) {
         Replacement   * replace;
         replace = g_findReplacement (s);
         if (replace != 0) {
-                OutputDebugStringA ("Substituting HTTP response\r\n");
+                g_log (LOG_RESPONSE_SUBSTITUTED);
 
                 unsigned long   count = 0;
                 bool            ok;
@@ -599,20 +1830,240 @@ int WSAAPI recvHook (SOCKET s, char * buf, int len, int flags) {
                 return ok ? count : - 1;
         }
 
+        ReadLimit       limit (s);
+        bool            paced;
+        paced = limit.active () && len > 0 && (flags & MSG_PEEK) == 0;
+        if (paced) {
+                if (limit.defer (s)) {
+                        SetLastError (WSAEWOULDBLOCK);
+                        return SOCKET_ERROR;
+                }
+
+                unsigned long   allowed = limit.wait (len);
+                if (limit.stream ())
+                        len = (int) allowed;
+        }
+
         int             result;
         result = (* g_recvHook) (s, buf, len, flags);
         g_meter += result;
+
+        if (result > 0 && paced)
+                limit.charge (result);
+
+        if (result > 0 && (flags & MSG_PEEK) == 0) {
+                g_countTransfer (s, result);
+                g_telemetryReceive (s, result);
+        }
+        return result;
+}
+
+/**
+ * Hook the recvfrom () API, to measure received bandwidth.
+ *
+ * Datagrams can't be cut down to fit a rate limit (the rest of the datagram is
+ * just lost), so a limited read is only held up, never made shorter.
+ */
+
+int WSAAPI recvfromHook (SOCKET s, char * buf, int len, int flags,
+                         sockaddr * from, int * fromLen) {
+        InHook          hooking;
+
+        ReadLimit       limit (s);
+        bool            paced = limit.active () && (flags & MSG_PEEK) == 0;
+        if (paced) {
+                if (limit.defer (s)) {
+                        SetLastError (WSAEWOULDBLOCK);
+                        return SOCKET_ERROR;
+                }
+
+                limit.wait (0);
+        }
+
+        int             result;
+        result = (* g_recvfromHook) (s, buf, len, flags, from, fromLen);
+        g_meter += result;
+
+        if (result > 0 && paced)
+                limit.charge (result);
+        return result;
+}
+
+/**
+ * Hook CreateIoCompletionPort () so we know where to post completions for the
+ * overlapped operations we complete ourselves.
+ *
+ * This gets used for all kinds of file handles, so only remember the ones that
+ * are actually sockets; since sockets are closed with closesocket () we can
+ * rely on the binding being removed when the handle goes away.
+ */
+
+HANDLE WINAPI createIoPortHook (HANDLE file, HANDLE port, ULONG_PTR key,
+                                unsigned long threads) {
+        InHook          hooking;
+
+        HANDLE          result;
+        result = (* g_createIoPortHook) (file, port, key, threads);
+        if (result == 0 || file == INVALID_HANDLE_VALUE || g_getsockopt == 0)
+                return result;
+
+        unsigned long   error = GetLastError ();
+
+        int             type;
+        int             length = sizeof (type);
+        if ((* g_getsockopt) ((SOCKET) file, SOL_SOCKET, SO_TYPE,
+                              (char *) & type, & length) == 0) {
+                g_bindPort ((SOCKET) file, result, key);
+        }
+
+        SetLastError (error);
         return result;
 }
 
-int WSAAPI recvfromHook (SOCKET s, char * buf, int len, int flags,
-                         sockaddr * from, int * fromLen) {
-        InHook          hooking;
+/**
+ * Context for calling a completion routine from an APC.
+ */
+
+struct CompletionApc {
+        LPWSAOVERLAPPED_COMPLETION_ROUTINE m_handler;
+        OVERLAPPED    * m_overlapped;
+        unsigned long   m_count;
+        unsigned long   m_flags;
+        volatile LONG * m_pending;
+};
+
+/**
+ * Call a completion routine for an operation we completed ourselves.
+ *
+ * A queued APC is counted as pending in its thread's reader slot until it
+ * runs, so the unload knows there's still code of ours waiting to be called;
+ * since the thread may never wait alertably, the unload doesn't wait on these
+ * for long, and pins the DLL in place for any that are left instead. So this
+ * mustn't touch anything the unload tears down.
+ */
+
+void CALLBACK completionApc (ULONG_PTR param) {
+        CompletionApc * apc = (CompletionApc *) param;
+
+        (* apc->m_handler) (0, apc->m_count, apc->m_overlapped, apc->m_flags);
+
+        volatile LONG * pending = apc->m_pending;
+        HeapFree (GetProcessHeap (), 0, apc);
+        InterlockedDecrement (pending);
+}
+
+/**
+ * Complete an operation we've done ourselves on the caller's behalf, such as
+ * handing over part of a replacement document, in whichever of the ways the
+ * caller asked for.
+ *
+ * For a synchronous call there's nothing to it. For overlapped calls Winsock
+ * delivers completions in one of three ways; if a completion routine is given
+ * it is queued as an APC, otherwise the event handle in the OVERLAPPED is set
+ * and, if the socket has been associated with a completion port, a packet is
+ * posted there (unless the low bit of the event handle is set, which is the
+ * documented way to ask for that not to happen).
+ *
+ * For the APC and completion port cases we report the operation as pending,
+ * even though it's all done; that's always a legitimate answer, and it means
+ * the caller gets exactly one completion whether or not it has asked for the
+ * port to be skipped for operations which succeed at once. Either way the
+ * result is also kept for WSAGetOverlappedResult () to give back.
+ *
+ * One thing we can't know is the port for a socket which was associated with
+ * one before we were attached; those get synchronous success, as before.
+ */
+
+int completeOverlapped (SOCKET s, unsigned long count, unsigned long flags,
+                        OVERLAPPED * overlapped,
+                        LPWSAOVERLAPPED_COMPLETION_ROUTINE handler,
+                        unsigned long * transferred) {
+        if (overlapped == 0) {
+                if (transferred != 0)
+                        * transferred = count;
+                return 0;
+        }
+
+        overlapped->Internal = 0;
+        overlapped->InternalHigh = count;
+
+        g_addCompletion (s, overlapped, count, flags);
+
+        if (handler != 0) {
+                CompletionApc * apc;
+                apc = (CompletionApc *) HeapAlloc (GetProcessHeap (), 0,
+                                                   sizeof (CompletionApc));
+                if (apc != 0) {
+                        apc->m_handler = handler;
+                        apc->m_overlapped = overlapped;
+                        apc->m_count = count;
+                        apc->m_flags = flags;
+                        apc->m_pending = g_readerSlot () + READER_APCS;
+
+                        InterlockedIncrement (apc->m_pending);
+                        if (QueueUserAPC (completionApc, GetCurrentThread (),
+                                          (ULONG_PTR) apc)) {
+                                SetLastError (WSA_IO_PENDING);
+                                return SOCKET_ERROR;
+                        }
+
+                        InterlockedDecrement (apc->m_pending);
+                        HeapFree (GetProcessHeap (), 0, apc);
+                }
+
+                /*
+                 * If the APC can't be queued, calling the routine directly is
+                 * the next best thing.
+                 */
+
+                (* handler) (0, count, overlapped, flags);
+
+                if (transferred != 0)
+                        * transferred = count;
+                return 0;
+        }
+
+        ULONG_PTR       event = (ULONG_PTR) overlapped->hEvent;
+        if ((event & ~ 1) != 0)
+                SetEvent ((HANDLE) (event & ~ 1));
+
+        HANDLE          port = 0;
+        ULONG_PTR       key = 0;
+        if ((event & 1) == 0)
+                port = g_findPort (s, & key);
+
+        if (port != 0 &&
+            PostQueuedCompletionStatus (port, count, key, overlapped)) {
+                SetLastError (WSA_IO_PENDING);
+                return SOCKET_ERROR;
+        }
+
+        if (transferred != 0)
+                * transferred = count;
+        return 0;
+}
+
+/**
+ * Cut a list of buffers down to a total length, into a copy; this gives back
+ * the number of buffers in the copy, or 0 if the list is too long to copy.
+ */
 
-        int             result;
-        result = (* g_recvfromHook) (s, buf, len, flags, from, fromLen);
-        g_meter += result;
-        return result;
+static unsigned long l_clampBuffers (LPWSABUF buffers, unsigned long count,
+                                     unsigned long length, WSABUF * dest,
+                                     unsigned long limit) {
+        if (count > limit)
+                return 0;
+
+        unsigned long   i = 0;
+        for (; i < count && length > 0 ; ++ i) {
+                dest [i] = buffers [i];
+                if (dest [i].len > length)
+                        dest [i].len = length;
+
+                length -= dest [i].len;
+        }
+
+        return i;
 }
 
 /**
@@ -627,8 +2078,16 @@ int WSAAPI recvfromHook (SOCKET s, char * buf, int len, int flags,
  * To deal with capturing overlapped completions fully, we need to also hook
  * WSAGetOverlappedResult () and probably WSAWaitForMultipleObjects (), which
  * will give us the option of slicing the end-user's original I/O up using a
- * custom OVERLAPPED buffer of our own in the slices (useful when we get to
- * trying to apply a bandwidth limit).
+ * custom OVERLAPPED buffer of our own in the slices.
+ *
+ * For applying a rate limit, though, there's no need to go that far; reads
+ * are held up before they're issued, and the buffers (which Winsock copies
+ * the description of before returning, so a copy on our stack is fine) are cut
+ * down to what the limit allows. What an overlapped read will end up getting
+ * isn't known until it completes, so it's charged for everything it asked for
+ * up front and given back the difference when the real count turns up, which
+ * is either via WSAGetOverlappedResult (), or when the caller reuses the same
+ * OVERLAPPED for its next read (which it can only do once the first is done).
  */
 
 int WSAAPI wsaRecvHook (SOCKET s, LPWSABUF buffers, unsigned long bytes,
@@ -640,39 +2099,73 @@ int WSAAPI wsaRecvHook (SOCKET s, LPWSABUF buffers, unsigned long bytes,
         Replacement   * replace;
         replace = g_findReplacement (s);
         if (replace != 0) {
-                OutputDebugStringA ("Substituting HTTP response\r\n");
+                g_log (LOG_RESPONSE_SUBSTITUTED);
 
                 unsigned long   count = 0;
-                bool            ok;
-                ok = g_consumeReplacement (replace, buffers->len, buffers->buf,
-                                           & count);
-                unsigned long   result = ok ? ERROR_SUCCESS : WSAEINVAL;
-                SetLastError (result);
+                if (! g_consumeReplacement (replace, buffers->len,
+                                            buffers->buf, & count)) {
+                        SetLastError (WSAEINVAL);
+                        return SOCKET_ERROR;
+                }
 
-                if (overlapped != 0) {
-                        overlapped->Internal = result;
-                        overlapped->InternalHigh = count;
+                /*
+                 * For now I don't support MSG_PEEK or MSG_WAITALL in the flags.
+                 */
 
-                        HANDLE          event = overlapped->hEvent;
-                        event = (HANDLE) ((unsigned long) event & ~ 1);
-                        if (event != 0)
-                                SetEvent (event);
-                }
+                if (flags != 0)
+                        * flags = 0;
 
-                if (received != 0)
-                        * received = count;
+                return completeOverlapped (s, count, 0, overlapped, handler,
+                                           received);
+        }
+
+        bool            ignore;
+        ignore = flags != 0 && (* flags & MSG_PEEK) != 0;
 
-                if (handler != 0)
-                        (* handler) (result, count, overlapped, 0);
+        /*
+         * Hold the read up, and cut it down, if there's a rate limit.
+         */
 
+        ReadLimit       limit (s);
+        WSABUF          clamped [16];
+        unsigned long   allowed = 0;
+        bool            paced = limit.active () && ! ignore;
+        if (paced) {
                 /*
-                 * For now I don't support MSG_PEEK or MSG_WAITALL in the flags.
+                 * If this OVERLAPPED was last used for a read we charged in
+                 * advance, settle that first; plenty of callers clear the
+                 * structure out before reusing it, and in that case we can't
+                 * tell what the read got, so it keeps the whole charge.
                  */
 
-                return result;
+                if (overlapped != 0) {
+                        unsigned long   done = overlapped->InternalHigh;
+                        g_settlePacing (s, overlapped,
+                                        done != 0 ? done : ~ 0UL);
+                } else if (handler == 0 && limit.defer (s)) {
+                        SetLastError (WSAEWOULDBLOCK);
+                        return SOCKET_ERROR;
+                }
+
+                unsigned long   total = 0;
+                for (unsigned long i = 0 ; i < bytes ; ++ i)
+                        total += buffers [i].len;
+
+                allowed = limit.wait (total);
+
+                unsigned long   count;
+                if (allowed < total && limit.stream () &&
+                    (count = l_clampBuffers (buffers, bytes, allowed, clamped,
+                                             ARRAY_LENGTH (clamped))) > 0) {
+                        buffers = clamped;
+                        bytes = count;
+                } else
+                        allowed = total;
         }
 
         if (overlapped != 0 || handler != 0) {
+                g_dropCompletion (s, overlapped);
+
                 int             result;
                 result = (* g_wsaRecvHook) (s, buffers, bytes, received, flags,
                                               overlapped, handler);
@@ -683,18 +2176,31 @@ int WSAAPI wsaRecvHook (SOCKET s, LPWSABUF buffers, unsigned long bytes,
                          */
 
                         g_meter += overlapped->InternalHigh;
+                        g_countTransfer (s, overlapped->InternalHigh);
+                        g_telemetryReceive (s, overlapped->InternalHigh);
+
+                        if (paced)
+                                limit.charge (overlapped->InternalHigh);
+                } else if (paced && GetLastError () == WSA_IO_PENDING) {
+                        limit.charge (allowed);
+                        g_addPacing (s, overlapped, limit.global (),
+                                     limit.local (), allowed);
+                        SetLastError (WSA_IO_PENDING);
                 }
                 return result;
         }
 
-        bool            ignore;
-        ignore = flags != 0 && (* flags & MSG_PEEK) != 0;
-
         int             result;
         result = (* g_wsaRecvHook) (s, buffers, bytes, received, flags,
                                     overlapped, handler);
-        if (result != SOCKET_ERROR && ! ignore)
+        if (result != SOCKET_ERROR && ! ignore) {
                 g_meter += * received;
+                g_countTransfer (s, * received);
+                g_telemetryReceive (s, * received);
+
+                if (paced)
+                        limit.charge (* received);
+        }
         return result;
 }
 
@@ -710,6 +2216,22 @@ int WSAAPI wsaEventSelectHook (SOCKET s, WSAEVENT event, long mask) {
         return (* g_wsaEventSelectHook) (s, event, mask);
 }
 
+/**
+ * Hook for ioctlsocket (), to see which sockets are put in non-blocking mode;
+ * reads from those mustn't be held up by sleeping.
+ */
+
+int WSAAPI ioctlsocketHook (SOCKET s, long command, u_long * value) {
+        InHook          hooking;
+
+        int             result;
+        result = (* g_ioctlsocketHook) (s, command, value);
+        if (result == 0 && command == FIONBIO && value != 0)
+                g_setNonBlocking (s, * value != 0);
+
+        return result;
+}
+
 /**
  * Hook for socket close, mainly to handle event deregistration in our tracking
  * data.
@@ -719,6 +2241,7 @@ int WSAAPI closesocket_Hook (SOCKET s) {
         InHook          hooking;
 
         g_removeTracking (s);
+        l_updateHooks ();
 
         return (* g_closesocket_Hook) (s);
 }
@@ -802,8 +2325,12 @@ int WSAAPI select_Hook (int count, fd_set * read, fd_set * write,
 }
 
 /**
- * Experimental hook for WSAGetOverlapped () in case we find a client doing
+ * Hook for WSAGetOverlappedResult (), in case we find a client doing
  * high-performance I/O through it.
+ *
+ * For operations we completed ourselves the underlying provider has never
+ * seen the OVERLAPPED, so the result we recorded when completing it is what
+ * gets returned.
  */
 
 BOOL WSAAPI wsaGetOverlappedHook (SOCKET s, OVERLAPPED * overlapped,
@@ -811,111 +2338,172 @@ BOOL WSAAPI wsaGetOverlappedHook (SOCKET s, OVERLAPPED * overlapped,
                                   unsigned long * flags) {
         InHook          hooking;
 
+        if (overlapped != 0 &&
+            g_takeCompletion (s, overlapped, length, flags)) {
+                return TRUE;
+        }
+
         BOOL            result;
         result = (* g_wsaGetOverlappedHook) (s, overlapped, length, wait, flags);
 
+        if (result && overlapped != 0 && length != 0) {
+                unsigned long   error = GetLastError ();
+                g_settlePacing (s, overlapped, * length);
+                SetLastError (error);
+        }
+
         return result;
 }
 
 /**
- * Sort-of equivalent to memicmp () for comparing HTTP header strings.
+ * Helper for filterHttpUrl () in cases where I want to actually rewrite a URL
+ * (or more likely a host: header), splicing a replacement string over an old
+ * one.
+ *
+ * This used to take a copy of the whole request with the new text spliced into
+ * it (and a second copy, if both host and URL were rewritten). Since the new
+ * text is tiny compared to the request, what we build instead is a gather list
+ * of the parts of the caller's buffer we keep with the new text interleaved,
+ * which WSASend () can send in one go without anything being copied.
  *
- * Not using actual memicmp () just because of the broken locale machinery in
- * the VC++ RTL; this only cares about the C locale (i.e., ASCII).
+ * The replacement text itself does get copied, into a small buffer here; it
+ * comes from the rules, which can be replaced once filterHttpUrl () stops
+ * holding its RuleGuard.
  */
 
-int c_memicmp (const void * leftBuf, const void * rightBuf, size_t length) {
-typedef const unsigned char   * Str;
-        Str             left = (Str) leftBuf;
-        Str             right = (Str) rightBuf;
+class Gather {
+public:
+        enum { EDITS = 2, TEXT = 1024, PARTS = 32 };
+
+private:
+        struct Edit {
+                const char    * m_from;
+                const char    * m_to;
+                unsigned long   m_text;
+                unsigned long   m_length;
+        };
+
+        Edit            m_edits [EDITS];
+        unsigned long   m_count;
+        char            m_text [TEXT];
+        unsigned long   m_used;
+
+        unsigned long   m_total;
+        unsigned long   m_last;
+
+static  void            add (WSABUF * parts, unsigned long & count,
+                             const char * buf, size_t length);
+
+public:
+                        Gather () : m_count (0), m_used (0), m_total (0),
+                                m_last (0) { }
+
+        bool            rewritten (void) const { return m_count > 0; }
 
-        while (length > 0) {
-                unsigned char   lChar = * left;
-                if (lChar > 'a' && lChar <= 'z')
-                        lChar -= 32;
-                unsigned char   rChar = * right;
-                if (rChar > 'a' && rChar <= 'z')
-                        rChar -= 32;
+        bool            splice (const char * from, const char * to,
+                                const char * replace, const char * concat = "");
+        unsigned long   build (const char * base, size_t length,
+                               WSABUF * parts);
+        unsigned long   total (void) const { return m_total; }
+        unsigned long   consumed (unsigned long actual, unsigned long original);
+};
+
+/**
+ * Record a region of the caller's buffer to be replaced.
+ *
+ * The host: and URL rewrites never overlap, but the host gets done first even
+ * though it comes later in the request, so keep the edits in order.
+ */
+
+bool Gather :: splice (const char * from, const char * to,
+                       const char * replace, const char * concat) {
+        size_t          subst = strlen (replace);
+        size_t          subst2 = concat == 0 ? 0 : strlen (concat);
 
-                if (lChar != rChar)
-                        return lChar < rChar ? - 1 : 1;
+        if (to < from || m_count == EDITS || subst + subst2 > TEXT - m_used)
+                return false;
 
-                ++ left;
-                ++ right;
-                -- length;
+        unsigned long   index = m_count;
+        while (index > 0 && m_edits [index - 1].m_from > from) {
+                m_edits [index] = m_edits [index - 1];
+                -- index;
         }
 
-        return 0;
+        Edit          & edit = m_edits [index];
+        edit.m_from = from;
+        edit.m_to = to;
+        edit.m_text = m_used;
+        edit.m_length = subst + subst2;
+
+        memcpy (m_text + m_used, replace, subst);
+        m_used += subst;
+        memcpy (m_text + m_used, concat, subst2);
+        m_used += subst2;
+
+        ++ m_count;
+        return true;
+}
+
+/* static */
+void Gather :: add (WSABUF * parts, unsigned long & count, const char * buf,
+                    size_t length) {
+        if (length == 0)
+                return;
+
+        parts [count].buf = (char *) buf;
+        parts [count].len = length;
+        ++ count;
 }
 
 /**
- * Sort-of equivalent to strstr () for a HTTP header buffer.
+ * Build the gather list for the rewritten request, returning the number of
+ * buffers used; there are at most 2 * EDITS + 1 of them.
  */
 
-const char * c_memifind (const char * buf, const char * find, size_t length) {
-        size_t          need = strlen (find);
-        while (length >= need) {
-                if (c_memicmp (buf, find, need) == 0)
-                        return buf + need;
+unsigned long Gather :: build (const char * base, size_t length,
+                               WSABUF * parts) {
+        unsigned long   count = 0;
+        const char    * done = base;
+        unsigned long   total = 0;
 
-                /*
-                 * Just slide one; fancier string matching algorithms like KMP
-                 * or Boyer-Moore get their acceleration by doing clever things
-                 * particularly with sliding (including matching from the
-                 * rightmost edge of the pattern first, so they can slide the
-                 * furthest amount).
-                 */
+        for (unsigned long i = 0 ; i < m_count ; ++ i) {
+                Edit          & edit = m_edits [i];
+                add (parts, count, done, edit.m_from - done);
+                add (parts, count, m_text + edit.m_text, edit.m_length);
 
-                -- length;
-                ++ buf;
+                total += (edit.m_from - done) + edit.m_length;
+                done = edit.m_to;
         }
 
-        return 0;
+        m_last = total;
+
+        add (parts, count, done, base + length - done);
+        m_total = total + (base + length - done);
+        return count;
 }
 
 /**
- * Helper for filterHttpUrl () in cases where I want to actually rewrite a URL
- * (or more likely a host: header), splicing a replacement string over an old
- * one.
+ * Given how much of the rewritten request went out, work out how much of the
+ * caller's request to say was sent, hiding the difference in length.
+ *
+ * The original length is that of the caller's buffer holding the request, to
+ * match the rewritten total; anything sent past the end of the rewrite comes
+ * from the caller's later buffers, which are counted as they are.
  *
- * Take an incoming buffer with a region in the middle to splice and take a
- * copy with the bit in the middle replaced.
+ * If the send was cut short before the end of the last piece of new text then
+ * there isn't a sensible answer, so as before we just claim nothing was sent;
+ * for the blocking sends Steam does, that doesn't ever happen.
  */
 
-char * splice (const char * base, const char * from, const char * to,
-               size_t & length, const char * replace, const char * concat = "") {
-        size_t          first = from - base;
-        size_t          subst = strlen (replace);
-        size_t          subst2 = concat == 0 ? 0 : strlen (concat);
-        size_t          rest = base + length - to;
-        size_t          total = first + subst + subst2 + rest;
-        char          * copy = (char *) HeapAlloc (GetProcessHeap (), 0, total + 1);
-
-        char          * out = copy;
-        if (first > 0) {
-                memcpy (out, base, first);
-                out += first;
-        }
-        if (subst > 0) {
-                memcpy (out, replace, subst);
-                out += subst;
-        }
-        if (subst2 > 0) {
-                memcpy (out, concat, subst2);
-                out += subst2;
-        }
-        if (rest > 0) {
-                memcpy (out, to, rest);
-                out += rest;
-        }
+unsigned long Gather :: consumed (unsigned long actual,
+                                  unsigned long original) {
+        if (actual < m_last)
+                return 0;
 
-        * out = 0;
-        length = total;
+        if (actual > m_total)
+                return original + (actual - m_total);
 
-#if     0
-        OutputDebugStringA (out);
-#endif
-        return copy;
+        return original - (m_total - actual);
 }
 
 /*
@@ -951,163 +2539,92 @@ unsigned long l_getStatus (const char * & replace) {
  *
  * The return value here is generally one of: length == 0 and result == 0
  * implies silent success, length > 0 and result == 0 implies an error should
- * be returned. Other results indicate that the returned buffer should be sent,
- * whether it's the caller's original or not.
+ * be returned. Other results indicate that the caller's buffer should be sent,
+ * rewritten as per the gather list if any edits have been made to it.
+ *
+ * The headers have already been found by the request scanner, so all that's
+ * needed here is the result of that.
  */
 
-const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length) {
-        if (length < 10)
-                return buf;
-
-        /*
-         * Match the verb text first, so we can only hook GET and POST.
-         */
-
-        size_t          verb = 0;
-        if (c_memicmp (buf, "GET /", 5) == 0) {
-                verb = 4;
-        } else if (c_memicmp (buf, "POST /", 6) == 0)
-                verb = 5;
-
-        if (verb == 0)
-                return buf;
+const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length,
+                            const HttpScan :: Request & request,
+                            Gather & gather) {
 
         /*
-         * Measure the URL before extracting a temporary copy for the filter
-         * process.
+         * The replacement text from the rules is used throughout, so keep the
+         * current rule snapshot alive until we're done with it.
          */
 
-        const char    * end = (const char *) memchr (buf + verb, ' ', length);
-        size_t          tempLen = end == 0 ? 0 : end - buf;
-        char            temp [256];
-
-        if (tempLen == 0)
-                return buf;
+        RuleGuard       reading;
 
         /*
-         * To make filters more selective, find the host: header if supplied.
+         * Only GET and POST get filtered, which the scanner has checked for
+         * us along with measuring the URL.
+         *
+         * To make filters more selective, the host: header is used if it was
+         * supplied; to allow substituting the content of POST operations, we
+         * also need the content-length being sent.
          *
          * Header parsing in HTTP is like header parsing in SMTP, and that is
          * way more complex than I want to bother with here. Since I'm just
          * faking out some simple hand-writter HTTP client code in STEAM rather
-         * than doing a full filter, just look for the simple case. In reality,
-         * for security purposes against a hostile target you do need to go the
-         * whole way with a spec-compliant parser.
+         * than doing a full filter, the scanner just looks for the simple case.
+         * In reality, for security purposes against a hostile target you do
+         * need to go the whole way with a spec-compliant parser.
+         *
+         * The rules do all their matching up front, the same way the bench
+         * does it, and the rest of this works out what the matches mean.
          */
 
-        const char    * host = c_memifind (buf + tempLen, "host: ", length - tempLen);
-        size_t          hostLength = 0;
-        if (host != 0) {
-                const char    * hostEnd;
-                hostEnd = (const char *) memchr (host, '\r', buf + length - host);
-                if (hostEnd != 0)
-                        hostLength = hostEnd - host + 2;
-        }
-
-        char          * dest = temp;
-
-        /*
-         * To allow substituting the content of POST operations, parse out the
-         * content-length being sent.
-         */
+        size_t          verb = request.m_verb;
+        const char    * host = request.m_host;
+        size_t          hostLength = request.m_hostLength;
+        unsigned long   contentLength = request.m_contentLength;
 
-        const char    * lengthHeader;
-        unsigned long   contentLength = 0;
-        lengthHeader = c_memifind (buf, "content-length: ", length);
-        if (lengthHeader != 0) {
-                /*
-                 * Parse out the content length using a function not intended
-                 * for that purpose, since I'm being cheap and nasty.
-                 */
+        RequestMatch    match;
+        if (! g_rules.matchRequest (buf, verb, request.m_url, host,
+                                    hostLength, match))
+                return buf;
 
-                contentLength = l_getStatus (lengthHeader);
-        }
+        const char    * temp = match.m_temp;
+        const char    * dest = match.m_end;
+        const char    * urlPart = match.m_urlPart;
+        size_t          tempLen = match.m_url;
+        const char    * newHost = match.m_newHost;
 
         /*
          * Use getPeerName () so I can show the actual target IP in the debug
-         * output, to contrast against the Host: value.
+         * output, to contrast against the Host: value; but only if it is going
+         * to be shown, since it's a trip into the kernel.
          */
 
-        sockaddr_storage addr;
-        int             addrLen = sizeof (addr);
-        if (g_getpeername (s, (sockaddr *) & addr, & addrLen) == 0 &&
-            addr.ss_family == AF_INET) {
+        if (g_logging (LOG_REQUEST)) {
+                sockaddr_storage addr;
+                int             addrLen = sizeof (addr);
                 sockaddr_in   & in4 = (sockaddr_in &) addr;
-                unsigned char * bytes = & in4.sin_addr.S_un.S_un_b.s_b1;
-                wsprintfA (dest, "%d.%d.%d.%d:%d ",
-                           bytes [0], bytes [1], bytes [2], bytes [3],
-                           ntohs (in4.sin_port));
-
-                dest += strlen (dest);
-        }
-
-        /*
-         * If the requested URL is excessively large, truncate it (it gets big
-         * because of useless query parameters Valve attach for debug/tracking,
-         * that don't factor into what we care about).
-         */
-
-        size_t          avail = temp + sizeof (temp) - dest;
-
-        if (tempLen + hostLength + 3 > avail) {
-                if (hostLength + 3 > avail)
-                        return buf;
-
-                tempLen = avail - hostLength - 3;
-        }
-
-        memcpy (dest, buf, verb);
-        dest += verb;
-
-        bool            matchHost = false;
-        const char    * newHost = 0;
-        const char    * hostPart = 0;
-
-        if (hostLength > 0) {
-                /*
-                 * Extract a copy of the host name, originally for the purpose
-                 * of just printing it but now for matching it as well, using
-                 * the '//' sigil at the front of the pattern (similar to how
-                 * the URL patterns use a '/' sigil).
-                 */
-
-                hostPart = dest;
-                dest [1] = dest [0] = '/';
-                memcpy (dest + 2, host, hostLength - 2);
-                dest [hostLength] = 0;
-
-                matchHost = g_rules.matchHost (dest, & newHost);
-
-                /*
-                 * Now format the temp copy for printing and having the request
-                 * URL glued to it.
-                 */
+                if (g_getpeername (s, (sockaddr *) & addr, & addrLen) != 0 ||
+                    addr.ss_family != AF_INET) {
+                        in4.sin_addr.S_un.S_addr = 0;
+                        in4.sin_port = 0;
+                }
 
-                dest += hostLength;
+                g_log (LOG_REQUEST, 0, in4.sin_addr.S_un.S_addr,
+                       ntohs (in4.sin_port), temp, dest - temp);
         }
 
-        const char    * urlPart = dest;
-        memcpy (dest, buf + verb, tempLen - verb);
-        dest += tempLen - verb;
-
-        strcpy (dest, "\r\n");
-
-        OutputDebugStringA (temp);
-        * dest = 0;
-
         /*
          * Before we do the URL processing, perform a host replacement if it is
          * indicated; since that leaves the URL part in the same offset in the
          * copied buffer, it is easier to replace first before matching the URL.
          */
 
-        while (matchHost) {
+        while (match.m_matchHost) {
                 /*
                  * An empty host means block.
                  */
 
                 if (newHost == 0 || * newHost == 0) {
-                        OutputDebugStringA ("Rejected host\r\n");
+                        g_log (LOG_HOST_REJECTED);
                         return 0;
                 }
 
@@ -1129,43 +2646,39 @@ const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length) {
                  * continue with the URL matching.
                  */
 
-                buf = splice (buf, host, host + hostLength, length,
-                              newHost, "\r\n");
+                if (! gather.splice (host, host + hostLength, newHost,
+                                     "\r\n")) {
+                        g_log (LOG_HOST_TOO_LONG);
+                        return 0;
+                }
 
-                OutputDebugStringA ("Replaced host\r\n");
+                g_log (LOG_HOST_REPLACED);
                 break;
         }
 
         /*
-         * Now run the match against the URL (in the copy of the URL in the
+         * Now look at the match against the URL (in the copy of the URL in the
          * stack).
          */
 
-        const char    * replace = 0;
-        if (! g_rules.matchUrl (urlPart, & replace)) {
-                if (matchHost || hostPart == 0)
-                        return buf;
-
+        const char    * replace = match.m_replace;
+        if (! match.m_matchUrl) {
                 /*
-                 * As a final attempt to decide, we can match the host+URL as a
-                 * pair, although here all we do is succeed or fail - don't try
-                 * to handle replacing.
-                 *
-                 * The aim here is to allow a pattern which matches the prefix
-                 * of the URL to have a catch-all pattern for certain URLs that
-                 * applies **if and only if** it hasn't been permitted by an
-                 * earlier positive match.
+                 * As a final attempt to decide, the host+URL may have matched
+                 * as a pair, although here all we do is succeed or fail - don't
+                 * try to handle replacing.
                  */
 
-                if (! g_rules.matchHost (hostPart, & newHost))
+                if (! match.m_matchPair)
                         return buf;
 
                 /*
                  * Pass it or fail it?
                  */
 
+                newHost = match.m_newHost;
                 if (newHost == 0 || * newHost == 0) {
-                        OutputDebugStringA ("Rejected host+url\r\n");
+                        g_log (LOG_HOST_URL_REJECTED);
                         return 0;
                 }
 
@@ -1177,7 +2690,7 @@ const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length) {
          */
 
         if (replace == 0 || * replace == 0) {
-                OutputDebugStringA ("Rejected URL\r\n");
+                g_log (LOG_URL_REJECTED);
                 return 0;
         }
 
@@ -1232,7 +2745,7 @@ const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length) {
                         return 0;
                 }
 
-                OutputDebugStringA ("Failed to replace status\r\n");
+                g_log (LOG_STATUS_FAILED);
                 return 0;
         }
 
@@ -1249,64 +2762,334 @@ const char * filterHttpUrl (SOCKET s, const char * buf, size_t & length) {
         while (replace [0] == '/')
                 ++ replace;
 
-        if (replace [0] == '*' && replace [1] == 0)
-                return buf;
+        if (replace [0] == '*' && replace [1] == 0)
+                return buf;
+
+        /*
+         * OK, what about more exotic cases? In principle I can replace the
+         * original data block with our URL in place of the original.
+         */
+
+        if (! gather.splice (buf + verb, buf + tempLen, replace)) {
+                g_log (LOG_URL_TOO_LONG);
+                return 0;
+        }
+
+        return buf;
+}
+
+/**
+ * Send a rewritten request, plus any further buffers the caller supplied after
+ * the one with the request in it, in a single gathering WSASend () call.
+ *
+ * The count of bytes sent is translated back to the caller's terms here, so
+ * both the send hooks get the same answer.
+ */
+
+int l_sendRewrite (SOCKET s, Gather & gather, const char * buf, size_t len,
+                   LPWSABUF more, unsigned long moreCount, unsigned long flags,
+                   unsigned long * sent) {
+        WSABUF          parts [Gather :: PARTS];
+        unsigned long   count = gather.build (buf, len, parts);
+
+        if (moreCount > ARRAY_LENGTH (parts) - count) {
+                SetLastError (WSAENOBUFS);
+                return SOCKET_ERROR;
+        }
+
+        unsigned long   original = len;
+        unsigned long   total = gather.total ();
+        for (unsigned long i = 0 ; i < moreCount ; ++ i) {
+                parts [count] = more [i];
+                ++ count;
+
+                original += more [i].len;
+                total += more [i].len;
+        }
+
+        int             result;
+        unsigned long   actual = 0;
+        result = (* g_wsaSendHook) (s, parts, count, & actual, flags, 0, 0);
+        if (result != 0)
+                return result;
+
+        if (actual == total) {
+                * sent = original;
+        } else
+                * sent = gather.consumed (actual, len);
+
+        return 0;
+}
+
+/**
+ * Send what's left of the caller's buffers after the first few bytes, which
+ * are being discarded, in a single gathering WSASend () call.
+ *
+ * Like a rewritten request this goes out synchronously, and the caller's own
+ * operation is then completed for it.
+ */
+
+int l_sendSkipping (SOCKET s, LPWSABUF buffers, unsigned long count,
+                    unsigned long skip, unsigned long flags,
+                    unsigned long * sent) {
+        WSABUF          parts [Gather :: PARTS];
+        unsigned long   used = 0;
+
+        for (unsigned long i = 0 ; i < count ; ++ i) {
+                WSABUF          part = buffers [i];
+                if (part.len <= skip) {
+                        skip -= part.len;
+                        continue;
+                }
+
+                part.buf += skip;
+                part.len -= skip;
+                skip = 0;
+
+                if (used == ARRAY_LENGTH (parts)) {
+                        SetLastError (WSAENOBUFS);
+                        return SOCKET_ERROR;
+                }
+
+                parts [used] = part;
+                ++ used;
+        }
+
+        * sent = 0;
+        if (used == 0)
+                return 0;
+
+        return (* g_wsaSendHook) (s, parts, used, sent, flags, 0, 0);
+}
+
+/**
+ * Fail a connection outright, when held headers which the caller has already
+ * been told were sent can't go out whole; the server would otherwise see a
+ * request with a piece missing from it.
+ */
+
+void l_dropConnection (SOCKET s, HttpScan * scan) {
+        scan->giveUp ();
+        scan->release ();
+
+        if (g_shutdown != 0)
+                (* g_shutdown) (s, SD_BOTH);
+
+        SetLastError (WSAECONNRESET);
+}
+
+/**
+ * Work out what to do about a failed send of held headers.
+ *
+ * If nothing went out because the socket would block, the held part is kept
+ * as it was before this send and the caller gets the error, so that it sends
+ * again; anything else means the earlier parts are lost, so the connection is
+ * failed.
+ */
+
+void l_heldFailed (SOCKET s, HttpScan * scan, size_t prior) {
+        if (GetLastError () == WSAEWOULDBLOCK) {
+                scan->unhold (prior);
+        } else
+                l_dropConnection (s, scan);
+}
+
+/**
+ * What the send hooks should do with a send once it's been filtered; either
+ * pass it through untouched, report to the caller that it's been dealt with,
+ * or fail it (the error having been set already).
+ */
+
+enum SendAction {
+        SEND_PASS,
+        SEND_DONE,
+        SEND_FAIL
+};
+
+/**
+ * Filter a send for both the send hooks.
+ *
+ * Only sends at the start of a request get filtered; the request scanner
+ * kept for the connection knows where those are, so the bodies of requests
+ * are counted off without looking at them, and a connection that turns out
+ * not to be HTTP is passed straight through from then on.
+ *
+ * Where the headers of a request are split over several sends, the caller is
+ * told the earlier parts were sent but we actually hold on to them until the
+ * headers are complete; then the whole request can be filtered as one, and
+ * sent off in a single gathering send. The count for the caller of what went
+ * out in that final send leaves out what it was already told about.
+ */
+
+SendAction l_filterSend (SOCKET s, LPWSABUF buffers, unsigned long count,
+                         unsigned long flags, unsigned long * sent) {
+        unsigned long   original = 0;
+        for (unsigned long i = 0 ; i < count ; ++ i)
+                original += buffers [i].len;
+
+        HttpScan      * scan = g_requestState (s);
+        if (scan == 0 || scan->opaque ())
+                return SEND_PASS;
+
+        if (scan->inBody ()) {
+                if (scan->skipBody (original) < original)
+                        scan->giveUp ();
+
+                return SEND_PASS;
+        }
+
+        const char    * head = buffers [0].buf;
+        size_t          headLength = buffers [0].len;
+        LPWSABUF        more = buffers + 1;
+        unsigned long   moreCount = count - 1;
+        size_t          prior = 0;
+
+        HttpScan :: Request request;
+        bool            complete = false;
+
+        if (scan->holding ()) {
+                prior = scan->heldLength ();
+        } else if (! HttpScan :: isRequest (head, headLength)) {
+                scan->giveUp ();
+                return SEND_PASS;
+        } else
+                complete = HttpScan :: parse (head, headLength, request);
+
+        Gather          gather;
+        unsigned long   actual;
+
+        if (! complete) {
+                /*
+                 * If the headers are too big to hold, give up on filtering the
+                 * connection and send whatever we were holding along with this
+                 * send, as it stands.
+                 */
+
+                if (original > HttpScan :: HOLD_LIMIT - prior) {
+                        if (prior == 0) {
+                                scan->giveUp ();
+                                return SEND_PASS;
+                        }
+
+                        const char    * held = scan->held ();
+                        int             result;
+                        result = l_sendRewrite (s, gather, held, prior, buffers,
+                                                count, flags, & actual);
+                        if (result != 0) {
+                                l_heldFailed (s, scan, prior);
+                                return SEND_FAIL;
+                        }
+
+                        if (actual < prior) {
+                                l_dropConnection (s, scan);
+                                return SEND_FAIL;
+                        }
+
+                        scan->giveUp ();
+                        scan->release ();
+                        * sent = actual - prior;
+                        return SEND_DONE;
+                }
+
+                for (unsigned long i = 0 ; i < count ; ++ i)
+                        if (! scan->hold (buffers [i].buf, buffers [i].len)) {
+                                if (prior > 0) {
+                                        l_dropConnection (s, scan);
+                                        return SEND_FAIL;
+                                }
+
+                                scan->giveUp ();
+                                scan->release ();
+                                SetLastError (WSAENOBUFS);
+                                return SEND_FAIL;
+                        }
+
+                head = scan->held ();
+                headLength = scan->heldLength ();
+                more = 0;
+                moreCount = 0;
+
+                if (! HttpScan :: parse (head, headLength, request)) {
+                        * sent = original;
+                        return SEND_DONE;
+                }
+        }
+
+        size_t          length = headLength;
+        const char    * result;
+        result = filterHttpUrl (s, head, length, request, gather);
+
+        if (length == 0) {
+                g_log (LOG_REQUEST_SUBSTITUTED);
+                g_telemetryCount (TELEMETRY_REQUEST_SUBSTITUTED);
+                l_updateHooks ();
+                scan->restart ();
+
+                * sent = original;
+                return SEND_DONE;
+        }
+
+        if (result == 0) {
+                g_telemetryCount (TELEMETRY_REQUEST_BLOCKED);
+                scan->giveUp ();
+                scan->release ();
+
+                SetLastError (WSAECONNRESET);
+                return SEND_FAIL;
+        }
+
+        size_t          body = headLength - request.m_length;
+        for (unsigned long i = 0 ; i < moreCount ; ++ i)
+                body += more [i].len;
 
         /*
-         * OK, what about more exotic cases? In principle I can replace the
-         * original data block with our URL in place of the original.
+         * Pass-through is the simple case; that includes a request we only
+         * held on to during this one send.
          */
 
-        char          * copy;
-        copy = splice (buf, buf + verb, buf + tempLen, length, replace);
+        if (prior == 0 && ! gather.rewritten ()) {
+                scan->started (request, body);
+                scan->release ();
+                return SEND_PASS;
+        }
 
         /*
-         * If we already built a temporary request due to replacing the host as
-         * well as replacing the URL, free the buffer for the host copy.
+         * The complexity with replacing is mainly in the return value to hide
+         * the extra length we inserted.
          */
 
-        if (newHost != 0)
-                HeapFree (GetProcessHeap (), 0, (LPVOID) buf);
-
-        return copy;
-
-}
-
-/**
- * Helper for WSASend () etc to optionally log raw sends to OutputDebugString.
- *
- * Since the output function requires a NUL terminator, break up the output
- * into segments (copying into a staging buffer).
- */
-
-void debugWrite (const char * func, const char * buf, size_t len) {
-        char            temp [128];
-        wsprintfA (temp, "%s: %d bytes\r\n", func, len);
-        OutputDebugStringA (temp);
+        if (gather.rewritten ())
+                g_telemetryCount (TELEMETRY_REQUEST_REWRITTEN);
 
-        while (len > 0) {
-                size_t          some = ARRAY_LENGTH (temp) - 1;
-                if (len < some)
-                        some = len;
+        /*
+         * The scanner only moves on to the body once the send has gone out;
+         * if it fails, a retry by the caller has to be filtered again, and
+         * any held part of it has to go out with it.
+         */
 
-                memcpy (temp, buf, some);
-                temp [some] = 0;
+        int             error;
+        error = l_sendRewrite (s, gather, head, headLength, more, moreCount,
+                               flags, & actual);
+        if (error != 0) {
+                if (prior == 0) {
+                        scan->release ();
+                } else
+                        l_heldFailed (s, scan, prior);
 
-                OutputDebugStringA (temp);
+                return SEND_FAIL;
+        }
 
-                buf += some;
-                len -= some;
+        if (actual < prior) {
+                l_dropConnection (s, scan);
+                return SEND_FAIL;
         }
-}
 
-/**
- * Flag whether to write raw data to OutputDebugString ().
- *
- * This is mainly for debugging; if needed I'll create a registry setting to
- * let people enable it in the field.
- */
+        scan->started (request, body);
+        scan->release ();
 
-bool            g_debugSend = false;
+        * sent = actual - prior;
+        return SEND_DONE;
+}
 
 /**
  * Hook the legacy BSD sockets Send () function.
@@ -1328,53 +3111,28 @@ int WSAAPI sendHook (SOCKET s, const char * buf, int len, int flags) {
                 unsigned long   skip = 0;
                 g_consumeDiscard (discard, len, & skip);
                 if (len > skip) {
-                        int             sent;
                         len = (* g_sendHook) (s, buf + skip, len - skip, flags);
+                        if (len == SOCKET_ERROR)
+                                return len;
                 } else
                         len = 0;
                 return len + skip;
         }
 
-        if (g_debugSend)
-                debugWrite ("send", buf, len);
+        g_log (LOG_SEND, 0, 0, len, buf, len);
 
-        size_t          length = len;
-        const char    * replace = buf;
-        replace = filterHttpUrl (s, replace, length);
+        WSABUF          buffer = { len, (char *) buf };
+        unsigned long   sent;
+        switch (l_filterSend (s, & buffer, 1, flags, & sent)) {
+        case SEND_PASS:
+                return (* g_sendHook) (s, buf, len, flags);
 
-        if (length == 0) {
-                OutputDebugStringA ("Substituting HTTP request\r\n");
-                return len;
-        }
+        case SEND_DONE:
+                return (int) sent;
 
-        if (replace == 0) {
-                SetLastError (WSAECONNRESET);
+        default:
                 return SOCKET_ERROR;
         }
-
-        /*
-         * Pass-through is the simple case.
-         */
-
-        if (replace == buf)
-                return (* g_sendHook) (s, buf, len, flags);
-
-        /*
-         * The complexity with replacing is mainly in the return value to hide
-         * the extra length we inserted.
-         */
-
-        int             result;
-        result = (* g_sendHook) (s, replace, (int) length, flags);
-
-        HeapFree (GetProcessHeap (), 0, (LPVOID) replace);
-
-        if (result == length)
-                return len;
-        if (result < 0)
-                return result;
-
-        return 0;
 }
 
 /**
@@ -1386,9 +3144,10 @@ int WSAAPI sendHook (SOCKET s, const char * buf, int len, int flags) {
  * stack, we can extract and inspect the requested URL pretty simply.
  *
  * Now, in the most general case we'd also want to do connection tracking so we
- * only really worry about this when it's the first thing sent on a socket. But
- * since the amount of originated traffic is so small here, we can afford to
- * just look for the HTTP verbs on every write for now.
+ * only really worry about this when it's the first thing sent on a socket, and
+ * that's what the request scanner in l_filterSend () now does; it follows each
+ * connection from one request to the next, so only the starts of requests get
+ * looked at.
  */
 
 int WSAAPI wsaSendHook (SOCKET s, LPWSABUF buffers, unsigned long count,
@@ -1405,55 +3164,30 @@ int WSAAPI wsaSendHook (SOCKET s, LPWSABUF buffers, unsigned long count,
                 return SOCKET_ERROR;
         }
 
+        /*
+         * The body of a substituted POST is thrown away, but the caller still
+         * gets its operation completed the way it asked for, as with a request
+         * which was rewritten.
+         */
+
         Discarding    * discard = g_findDiscard (s);
         if (discard != 0) {
-                unsigned long   skip = 0;
-                g_consumeDiscard (discard, len, & skip);
-                if (len > skip) {
-                        int             sent;
-                        len = (* g_sendHook) (s, buf + skip, len - skip, flags);
-                } else
-                        len = 0;
-                return len + skip;
-        }
-
-        if (g_debugSend)
-                debugWrite ("WSASend", buf, len);
-
-        buf = filterHttpUrl (s, buf, len);
-
-        if (len == 0) {
-                len = buffers [0].len;
-
-                OutputDebugStringA ("Substituting HTTP request\r\n");
-                if (overlapped != 0) {
-                        overlapped->Internal = ERROR_SUCCESS;
-                        overlapped->InternalHigh = len;
+                unsigned long   total = 0;
+                for (unsigned long i = 0 ; i < count ; ++ i)
+                        total += buffers [i].len;
 
-                        HANDLE          event = overlapped->hEvent;
-                        event = (HANDLE) ((unsigned long) event & ~ 1);
-                        if (event != 0)
-                                SetEvent (event);
-                }
-
-                if (sent != 0)
-                        * sent = len;
-                return 0;
-        }
-
-        if (buf == 0) {
-                SetLastError (WSAECONNRESET);
-                return SOCKET_ERROR;
+                unsigned long   skip = 0;
+                unsigned long   actual = 0;
+                g_consumeDiscard (discard, total, & skip);
+                if (l_sendSkipping (s, buffers, count, skip, flags,
+                                    & actual) != 0)
+                        return SOCKET_ERROR;
+
+                return completeOverlapped (s, skip + actual, 0, overlapped,
+                                           handler, sent);
         }
 
-        /*
-         * Pass-through is the simple case.
-         */
-
-        if (buf == buffers [0].buf) {
-                return (* g_wsaSendHook) (s, buffers, count, sent, flags,
-                                          overlapped, handler);
-        }
+        g_log (LOG_WSASEND, 0, 0, len, buf, len);
 
         /*
          * If the URL was rewritten, things are complex if we want to mimic the
@@ -1462,32 +3196,33 @@ int WSAAPI wsaSendHook (SOCKET s, LPWSABUF buffers, unsigned long count,
          * ports are involved (they are excellent, just not for what we're in
          * the process of doing here).
          *
-         * If I decide to go for some form of persistent context tracking for
-         * sockets that makes all that easier, especially since we can just do
-         * a synchronous success to the caller and manage the rest in the
-         * background.
+         * Passing the caller's OVERLAPPED down would have the completion say
+         * how long the rewritten request was, and the replacement text would
+         * have to outlive this call; so the rewritten request is always sent
+         * synchronously (which, for the default blocking mode that sockets
+         * used with completion ports are normally left in, just waits for the
+         * data to be buffered), and the caller's operation then completed for
+         * it in the way it asked for with the length it expects. Any number of
+         * buffers is fine, as the rewrite is sent as a gather list anyway.
          *
-         * However, for now since the Steam client does synchronous sends with
-         * just one buffer structure, that's all I'll support.
+         * The same goes for a request being held until its headers are all
+         * there, or a substituted request which never gets sent at all.
          */
 
-        if (overlapped != 0 || handler != 0 || count > 1) {
-                HeapFree (GetProcessHeap (), 0, (LPVOID) buf);
-                SetLastError (WSAEINVAL);
-                return SOCKET_ERROR;
-        }
-
-        WSABUF          temp [1] = { len, (char *) buf };
-        int             result;
         unsigned long   actual;
-        result = (* g_wsaSendHook) (s, temp, 1, & actual, flags, 0, 0);
+        switch (l_filterSend (s, buffers, count, flags, & actual)) {
+        case SEND_PASS:
+                g_dropCompletion (s, overlapped);
+                return (* g_wsaSendHook) (s, buffers, count, sent, flags,
+                                          overlapped, handler);
 
-        HeapFree (GetProcessHeap (), 0, (LPVOID) buf);
-        if (result != 0)
-                return result;
+        case SEND_DONE:
+                return completeOverlapped (s, actual, 0, overlapped, handler,
+                                           sent);
 
-        * sent = buffers [0].len;
-        return 0;
+        default:
+                return SOCKET_ERROR;
+        }
 }
 
 /**
@@ -1544,36 +3279,79 @@ HMODULE         g_instance;
         L"\t\"csid\"\t\t\"99\"~" \
         L"}~"
 
+/*
+ * The black-hole rules which always go on the end of the main rule set, along
+ * with a couple of rules to eliminate any server that hasn't already been
+ * whitelisted.
+ *
+ * Since rules are processed in order, this still allows custom rules to
+ * redirect these DNS lookups to take place, as those will take precedence to
+ * this catch-all; in a rule list, the first rule that matches stops further
+ * search.
+ *
+ * The last two rules here substitute out both of the special URLs used by
+ * "CS"-type servers, which in reality are just normal HTTP servers. We fake up
+ * session data for them so that we can avoid problems inside Steam (leading to
+ * crash bugs) caused by denying them, and allow host rules to trick Steam into
+ * using regular HTTP servers instead.
+ */
+
+#define BUILTIN_RULES \
+        L"//*/depot/*=;" \
+        L"/authdepot/=#200;" \
+        L"/initsession/=#200 " INITSESSION_RESPONSE
+
 /**
- * Set up the address to direct the content server connections to.
+ * Try to install the rules from an image precompiled by the monitor.
+ *
+ * When the monitor has already compiled the rule text, it leaves the image in
+ * a section named for our process and the text, so all we need to do is map
+ * it; if there's no such section, or the image in it doesn't check out, the
+ * caller just parses the text as usual.
  */
 
-int setFilter (wchar_t * address) {
-        bool            result = g_rules.install (address);
-        if (result) {
-                /*
-                 * For now, always append these black-hole rules to the main
-                 * rule set, along with a couple of rules to eliminate any
-                 * server that hasn't already been whitelisted.
-                 *
-                 * Since rules are processed in order, this still allows custom
-                 * rules to redirect these DNS lookups to take place, as those
-                 * will take precedence to this catch-all; in a rule list, the
-                 * first rule that matches stops further search.
-                 *
-                 * The last two rules here substitute out both of the special
-                 * URLs used by "CS"-type servers, which in reality are just
-                 * normal HTTP servers. We fake up session data for them so
-                 * that we can avoid problems inside Steam (leading to crash
-                 * bugs) caused by denying them, and allow host rules to trick
-                 * Steam into using regular HTTP servers instead.
-                 */
+static bool l_installImage (const wchar_t * address) {
+        if (address == 0)
+                return false;
+
+        wchar_t         name [FilterRules :: IMAGE_NAME];
+        FilterRules :: imageName (name, GetCurrentProcessId (), address);
+
+        HANDLE          section;
+        section = OpenFileMappingW (FILE_MAP_READ, FALSE, name);
+        if (section == 0)
+                return false;
+
+        void          * view = MapViewOfFile (section, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle (section);
+
+        if (view == 0)
+                return false;
 
-                g_rules.append (L"//*/depot/*=;"
-                                L"/authdepot/=#200;"
-                                L"/initsession/=#200 " INITSESSION_RESPONSE);
+        MEMORY_BASIC_INFORMATION info;
+        if (VirtualQuery (view, & info, sizeof (info)) == sizeof (info) &&
+            g_rules.install (view, info.RegionSize, address, BUILTIN_RULES)) {
+                OutputDebugStringA ("Installed precompiled rules\r\n");
+                return true;
         }
 
+        UnmapViewOfFile (view);
+        return false;
+}
+
+/**
+ * Set up the address to direct the content server connections to.
+ *
+ * This is called both when we're injected and from the rule block's thread
+ * when the monitor hands us a new set of rules; either way, the new rules and
+ * the built-in ones go in as a single snapshot.
+ */
+
+int setFilter (wchar_t * address) {
+        bool            result = l_installImage (address) ||
+                                 g_rules.install (address, BUILTIN_RULES);
+
+        l_updateHooks ();
         return result ? 1 : 0;
 }
 
@@ -1702,6 +3480,7 @@ bool ApiHook :: attach (void * address, FARPROC hook) {
         writeOffset (data - 4, (unsigned char *) hook - data);
         * (unsigned short *) data = JMP_SHORT_MINUS5;
 
+        m_enabled = true;
         return true;
 }
 
@@ -1743,53 +3522,81 @@ void ApiHook :: unhook (void) {
         if (m_resume == 0)
                 return;
 
+        m_resume = 0;
         __try {
                 memcpy ((unsigned char *) m_original - 5, m_save, 7);
         } __finally {
-                m_original = m_resume = 0;
+                m_original = 0;
+                m_enabled = false;
         }
 }
 
 /**
- * Global counter manipulated by InHook as hook functions are entered to make
- * loading and unloading safer.
+ * Switch an attached hook off or back on again, while it may be in use.
+ *
+ * Only the two-byte branch at the entry point is changed, in one aligned write
+ * as the hot-patch scheme intends, so a thread arriving at the function sees
+ * either the original entry or the branch to the long jump (which is left in
+ * place); the resume point stays valid as well, for any thread already inside
+ * the hook.
  */
 
-/* static */
-LONG            InHook :: g_hookCount;
+void ApiHook :: enable (bool on) {
+        if (m_resume == 0 || m_enabled == on)
+                return;
+
+        unsigned char * data = (unsigned char *) m_original;
+        unsigned long   protect = 0;
+        if (! VirtualProtect (data, 2, PAGE_EXECUTE_READWRITE, & protect))
+                return;
+
+        unsigned short  entry;
+        entry = on ? JMP_SHORT_MINUS5 : * (unsigned short *) (m_save + 5);
+        * (volatile unsigned short *) data = entry;
+
+        FlushInstructionCache (GetCurrentProcess (), data, 2);
+        m_enabled = on;
+}
 
 /**
  * Unhook all the hooked functions.
+ *
+ * This holds the hook lock, and leaves the flag set which tells anyone who
+ * comes for it afterwards not to switch hooks; otherwise a thread in the
+ * middle of l_updateHooks () could put a branch back over restored code.
  */
 
 void unhookAll (void) {
+        EnterCriticalSection (& l_hookLock);
+        InterlockedExchange (& l_unhooking, 1);
+
         g_connectHook.unhook ();
         g_gethostHook.unhook ();
+        g_getaddrinfoHook.unhook ();
+        g_getAddrInfoWHook.unhook ();
+        g_getAddrInfoExWHook.unhook ();
         g_recvHook.unhook ();
         g_recvfromHook.unhook ();
         g_wsaRecvHook.unhook ();
         g_select_Hook.unhook ();
         g_sendHook.unhook ();
         g_closesocket_Hook.unhook ();
+        g_ioctlsocketHook.unhook ();
         g_wsaEventSelectHook.unhook ();
         g_wsaGetOverlappedHook.unhook ();
         g_wsaEnumNetworkEventsHook.unhook ();
         g_wsaSendHook.unhook ();
+        g_createIoPortHook.unhook ();
 
-        /*
-         * Wait until none of the main application threads are inside any of
-         * the hook routines.
-         */
-
-        while (InHook :: g_hookCount > 0)
-                Sleep (1);
+        LeaveCriticalSection (& l_hookLock);
 }
 
 /**
  * Simple default constructor.
  */
 
-ApiHook :: ApiHook () : m_original (0), m_resume (0), m_hook (0) {
+ApiHook :: ApiHook () : m_original (0), m_resume (0), m_hook (0),
+                m_enabled (false) {
 }
 
 /**
@@ -1842,9 +3649,22 @@ STEAMDLL (int) SteamFilter (wchar_t * address, wchar_t * result,
         }
 
         g_initReplacement (rootKey, rootReg);
+        g_initResolveState ();
+        g_initTelemetry ();
+        g_initLog ();
+        g_initRulebase (setFilter, l_updateHooks);
 
+        FilterRules :: preload (g_replacementCache);
         setFilter (address);
 
+        /*
+         * An earlier attempt may have failed and taken its hooks out again,
+         * so start over as far as switching them goes.
+         */
+
+        InterlockedExchange (& l_hooksOn, ~ 0L);
+        InterlockedExchange (& l_unhooking, 0);
+
         bool            success;
         success = g_connectHook.attach (connectHook, ws2, "connect") &&
                   g_gethostHook.attach (gethostHook, ws2, "gethostbyname") &&
@@ -1855,6 +3675,8 @@ STEAMDLL (int) SteamFilter (wchar_t * address, wchar_t * result,
                   g_sendHook.attach (sendHook, ws2, "send") &&
                   g_closesocket_Hook.attach (closesocket_Hook, ws2,
                                              "closesocket") && 
+                  g_ioctlsocketHook.attach (ioctlsocketHook, ws2,
+                                            "ioctlsocket") &&
                   g_wsaEventSelectHook.attach (wsaEventSelectHook, ws2,
                                                "WSAEventSelect") &&
                   g_wsaGetOverlappedHook.attach (wsaGetOverlappedHook,
@@ -1864,12 +3686,50 @@ STEAMDLL (int) SteamFilter (wchar_t * address, wchar_t * result,
                   g_wsaSendHook.attach (wsaSendHook, ws2, "WSASend");
 
         g_getpeername = (getpeernameFunc) GetProcAddress (ws2, "getpeername");
+        g_getsockopt = (getsockoptFunc) GetProcAddress (ws2, "getsockopt");
+        g_socket = (socketFunc) GetProcAddress (ws2, "socket");
+        g_ioctlsocket = (ioctlsocketFunc) GetProcAddress (ws2, "ioctlsocket");
+        g_shutdown = (shutdownFunc) GetProcAddress (ws2, "shutdown");
 
         if (! success) {
                 unhookAll ();
+                InHook :: quiesce (InHook :: UNLOAD_TIMEOUT);
                 return ~ 0UL;
         }
 
+        /*
+         * The modern resolver functions aren't all present in every version of
+         * Windows (GetAddrInfoExW () only arrived with Vista), so those hooks
+         * are optional.
+         *
+         * Once GetAddrInfoW () is hooked, the rule parser has to bypass the
+         * hook to resolve the targets written in rules, otherwise the targets
+         * would themselves be subject to the DNS rules.
+         */
+
+        g_getaddrinfoHook.attach (getaddrinfoHook, ws2, "getaddrinfo");
+        g_getAddrInfoExWHook.attach (getAddrInfoExWHook, ws2,
+                                     "GetAddrInfoExW");
+        if (g_getAddrInfoWHook.attach (getAddrInfoWHook, ws2, "GetAddrInfoW"))
+                FilterRules :: resolver ((void *) * g_getAddrInfoWHook);
+
+        /*
+         * Knowing about completion ports is also optional; without it, any
+         * overlapped operations we complete just complete synchronously.
+         */
+
+        g_createIoPortHook.attach (createIoPortHook,
+                                   GetModuleHandleW (L"KERNEL32.DLL"),
+                                   "CreateIoCompletionPort");
+
+        /*
+         * Everything was attached to check it could be, but only the hooks
+         * the rules actually need are left on.
+         */
+
+        InterlockedExchange (& l_hooksOn, ~ 0L);
+        l_updateHooks ();
+
         OutputDebugStringA ("SteamFilter " VER_PRODUCTVERSION_STR " attached\n");
 
         /*
@@ -1885,21 +3745,71 @@ STEAMDLL (int) SteamFilter (wchar_t * address, wchar_t * result,
         return 1;
 }
 
+/**
+ * Establish the filter in a process that is just starting, called from its
+ * first thread before the program's own code gets going.
+ *
+ * Waiting for WS2_32.DLL to turn up, as SteamFilter () does, would wait for
+ * ever here since the thread that would load it is this one; so load it now
+ * instead. The loader has finished setting up the process by the time this
+ * gets called, so that's safe enough, and it means the hooks are in before
+ * Steam makes its first connection.
+ */
+
+STEAMDLL (int) SteamFilterStart (wchar_t * address, wchar_t * result,
+                                 size_t * resultSize, HKEY rootKey,
+                                 const wchar_t * rootReg,
+                                 const wchar_t * rootDir) {
+        LoadLibraryW (L"WS2_32.DLL");
+        return SteamFilter (address, result, resultSize, rootKey, rootReg,
+                            rootDir);
+}
+
 /**
  * Disable just the current hook.
  *
  * Do critical cleanup. Note that the Winsock DLL might actually have been
  * unloaded when we are called, so guard this with an exception handler in
  * case the hook address can't actually be written any more.
+ *
+ * Once the hooks are off, wait for the threads inside them to leave before
+ * freeing the state they use; if some won't, this returns false and leaves
+ * everything in place for them, and a later call can try again.
+ *
+ * Completion routines still queued as APCs are different, since their threads
+ * may never wait alertably and so the wait could be forever; after a short
+ * while the DLL is pinned in memory so their code stays put, and the unload
+ * carries on without them.
  */
 
-void removeHook (void) {
-        if (g_connectHook == 0)
-                return;
+bool removeHook (void) {
+        g_unloadRulebase ();
+
+        if (g_connectHook != 0) {
+                unhookAll ();
+                OutputDebugStringA ("SteamFilter " VER_PRODUCTVERSION_STR
+                                    " unhooked\n");
+        }
+
+        if (! InHook :: quiesce (InHook :: UNLOAD_TIMEOUT)) {
+                OutputDebugStringA ("SteamFilter still in use\n");
+                return false;
+        }
+
+        if (! g_waitReaders (READER_APCS, InHook :: APC_TIMEOUT)) {
+                HMODULE         self;
+                GetModuleHandleExW (GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                                            GET_MODULE_HANDLE_EX_FLAG_PIN,
+                                    (LPCWSTR) completionApc, & self);
+                OutputDebugStringA ("SteamFilter pinned for queued APCs\n");
+        }
 
-        unhookAll ();
         g_unloadReplacement ();
-        OutputDebugStringA ("SteamFilter " VER_PRODUCTVERSION_STR " unhooked\n");
+        g_unloadTelemetry ();
+        g_unloadLog ();
+        g_unloadHeap ();
+        g_unloadReaders ();
+        return true;
 }
 
 /**
@@ -1914,16 +3824,206 @@ STEAMDLL (int) FilterUnload (void) {
         if (g_instance == 0)
                 return 0;
 
-        removeHook ();
+        /*
+         * If some thread is still inside one of the hooks, keep our reference
+         * so the code stays there for it to come back to.
+         */
+
+        if (! removeHook ())
+                return 0;
+
         FreeLibrary (g_instance);
         g_instance = 0;
         return 1;
 }
 
-BOOL WINAPI DllMain (HINSTANCE instance, unsigned long reason, void *) {
+/**
+ * Export an entry point for compiling rules ahead of time.
+ *
+ * Unlike the other entry points this is meant to be called by the monitor
+ * after loading the DLL into its own process, so the work of parsing the rules
+ * and resolving the replacement targets isn't done inside Steam while it is
+ * trying to start up. The compiled image is left in a section named for the
+ * target process and the rule text, which SteamFilter () looks for; the caller
+ * gets the section handle, which it should close once the filter has been
+ * called (by which time the filter will have its own view of the section).
+ */
+
+typedef int (WSAAPI * StartupFunc) (unsigned short version, WSADATA * data);
+typedef int (WSAAPI * CleanupFunc) (void);
+
+STEAMDLL (HANDLE) FilterCompile (const wchar_t * rules,
+                                 unsigned long processId) {
+        if (rules == 0)
+                return 0;
+
+        /*
+         * The monitor doesn't otherwise use Winsock, so it's up to us to get
+         * it ready for looking up the target names.
+         */
+
+        HMODULE         ws2 = LoadLibraryW (L"WS2_32.DLL");
+        if (ws2 == 0)
+                return 0;
+
+        StartupFunc     startup;
+        CleanupFunc     cleanup;
+        startup = (StartupFunc) GetProcAddress (ws2, "WSAStartup");
+        cleanup = (CleanupFunc) GetProcAddress (ws2, "WSACleanup");
+
+        WSADATA         data;
+        if (startup == 0 || cleanup == 0 || (* startup) (0x202, & data) != 0) {
+                FreeLibrary (ws2);
+                return 0;
+        }
+
+        FilterRules     compiler (27030);
+        unsigned long   size;
+        void          * image = compiler.compile (rules, size);
+
+        /*
+         * The Winsock DLL stays loaded, as the rule code keeps hold of the
+         * address lookup functions; the monitor only keeps us loaded for the
+         * duration of the call anyway.
+         */
+
+        (* cleanup) ();
+
+        if (image == 0)
+                return 0;
+
+        wchar_t         name [FilterRules :: IMAGE_NAME];
+        FilterRules :: imageName (name, processId, rules);
+
+        HANDLE          section;
+        section = CreateFileMappingW (INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+                                      0, size, name);
+
+        /*
+         * If the section already exists, it's from an earlier compile of the
+         * same text, which the filter is quite possibly still using.
+         */
+
+        if (section != 0 && GetLastError () != ERROR_ALREADY_EXISTS) {
+                void          * view;
+                view = MapViewOfFile (section, FILE_MAP_WRITE, 0, 0, size);
+                if (view != 0) {
+                        memcpy (view, image, size);
+                        UnmapViewOfFile (view);
+                } else {
+                        CloseHandle (section);
+                        section = 0;
+                }
+        }
+
+        free (image);
+        return section;
+}
+
+/**
+ * Context for writing out a rule report.
+ */
+
+struct StatsReport {
+        HANDLE          m_file;
+        wchar_t       * m_result;
+        size_t          m_space;
+};
+
+/**
+ * Write one line of a rule report to the report file, if there is one, and as
+ * much of it as will fit into the caller's result buffer.
+ */
+
+static void statsLine (void * context, const char * line) {
+        StatsReport   * report = (StatsReport *) context;
+
+        if (report->m_file != INVALID_HANDLE_VALUE) {
+                unsigned long   written;
+                WriteFile (report->m_file, line, strlen (line), & written, 0);
+        }
+
+        if (report->m_space == 0)
+                return;
+
+        while (* line != 0 && report->m_space > 1) {
+                * report->m_result ++ = (unsigned char) * line ++;
+                -- report->m_space;
+        }
+
+        * report->m_result = 0;
+}
+
+/**
+ * Export an entry point for looking at how the rules are being used.
+ *
+ * This is called through the injection shim just like SteamFilter (); the
+ * parameter is either "reset" to clear the rule statistics, "reorder" to move
+ * the busiest rules up the rule list where that's safe to do, or otherwise
+ * the name of a file to write the full report to. The report, or as much of
+ * it as fits, is also returned in the result buffer; it ends with a summary of
+ * the rate data has been received at.
+ */
+
+STEAMDLL (int) FilterStats (wchar_t * param, wchar_t * result,
+                            size_t * resultSize, HKEY, const wchar_t *,
+                            const wchar_t *) {
+        if (param != 0 && wcscmp (param, L"reset") == 0) {
+                g_rules.resetStats ();
+                return 1;
+        }
+
+        if (param != 0 && wcscmp (param, L"reorder") == 0)
+                return g_rules.reorder () ? 1 : 0;
+
+        StatsReport     report = { INVALID_HANDLE_VALUE, result, 0 };
+        if (result != 0 && resultSize != 0) {
+                report.m_space = * resultSize / sizeof (wchar_t);
+                if (report.m_space > 0)
+                        * result = 0;
+        }
+
+        if (param != 0 && * param != 0) {
+                report.m_file = CreateFileW (param, GENERIC_WRITE,
+                                             FILE_SHARE_READ, 0, CREATE_ALWAYS,
+                                             FILE_ATTRIBUTE_NORMAL, 0);
+                if (report.m_file == INVALID_HANDLE_VALUE)
+                        return 0;
+        }
+
+        g_rules.report (statsLine, & report);
+        g_meter.report (statsLine, & report);
+
+        if (report.m_file != INVALID_HANDLE_VALUE)
+                CloseHandle (report.m_file);
+
+        return 1;
+}
+
+BOOL WINAPI DllMain (HINSTANCE instance, unsigned long reason,
+                     void * reserved) {
+        if (reason == DLL_PROCESS_ATTACH) {
+                InitializeCriticalSection (& l_hookLock);
+                return TRUE;
+        }
+
+        if (reason == DLL_THREAD_DETACH) {
+                g_freeResolveState ();
+                g_releaseReaderSlot ();
+                return TRUE;
+        }
+
         if (reason != DLL_PROCESS_DETACH)
                 return TRUE;
 
+        /*
+         * If the whole process is exiting, the other threads are already gone
+         * (wherever they were), so there's nothing to wait for or clean up.
+         */
+
+        if (reserved != 0)
+                return TRUE;
+
         /*
          * Do critical cleanup. Note that the Winsock DLL might actually have
          * been unloaded when we are called, so we should guard this with an
@@ -34,9 +34,12 @@
 
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <intrin.h>
 
 #include "filterrule.h"
 #include "glob.h"
+#include "ratelimit.h"
+#include "readers.h"
 
 /**
  * Cliche for measuring array lengths, to avoid mistakes with sizeof ().
@@ -47,8 +50,13 @@
 /**
  * Avoid the standard VC++ new and delete since they are throwing, so using
  * them would be insane.
+ *
+ * The bench has its own replacements that count what they do, so these stand
+ * aside there.
  */
 
+#if     ! defined (BENCH_REPLACES_NEW)
+
 /* static */
 void * operator new (size_t size) throw () {
         return malloc (size);
@@ -59,6 +67,8 @@ void operator delete (void * mem) {
         free (mem);
 }
 
+#endif  /* ! defined (BENCH_REPLACES_NEW) */
+
 /**
  * This is an assistant function in WS2_32.DLL we can use to parse a string
  * address.
@@ -85,23 +95,56 @@ typedef void (WSAAPI * FreeAddrInfoWFunc) (ADDRINFOW * mem);
 GetAddrInfoWFunc        g_addrFunc;
 FreeAddrInfoWFunc       g_freeFunc;
 
+/**
+ * What to tell about each replacement document a rule names, if anything.
+ */
+
+RulePreloadFunc         g_preloadFunc;
+
+/**
+ * If a URL rule substitutes a named document, let the filter get that ready
+ * now rather than when the first request for it turns up.
+ */
+
+static void l_preload (const char * rewrite) {
+        RulePreloadFunc preload = g_preloadFunc;
+        if (preload != 0 && rewrite != 0 && rewrite [0] == '<')
+                (* preload) (rewrite + 1);
+}
+
 /**
  * Simple default constructor.
  */
 
-FilterRule :: FilterRule () : m_pattern (0), m_hasPort (false), m_port (0),
-                m_rewrite (0), m_replace (0), m_nextReplace (0), m_next (0) {
+FilterRule :: FilterRule () : m_pattern (0), m_glob (0), m_hasPort (false),
+                m_port (0), m_numeric (false), m_anchored (false),
+                m_portHigh (0), m_prefixLength (0), m_network (0),
+                m_rewrite (0), m_replace (0), m_nextReplace (0), m_targets (0),
+                m_limit (0), m_global (false), m_race (false), m_stagger (0),
+                m_borrowed (false), m_next (0),
+                m_tests (0), m_hits (0), m_samples (0), m_ticks (0) {
 }
 
 /**
  * Clean up memory allocated to the pattern string and addresses.
+ *
+ * For a rule loaded from a rule image, the strings and glob belong to the
+ * image instead.
  */
 
 FilterRule :: ~ FilterRule () {
         freeInfo (m_replace);
 
+        if (m_limit != 0)
+                m_limit->release ();
+
+        if (m_borrowed)
+                return;
+
         if (m_rewrite != 0)
                 free (m_rewrite);
+        if (m_glob != 0)
+                free (m_glob);
         if (m_pattern != 0)
                 free (m_pattern);
 }
@@ -109,18 +152,60 @@ FilterRule :: ~ FilterRule () {
 /**
  * Clean up memory allocated to the address set.
  *
- * This is simplified by virtue of parseReplace () allocating both the info and
- * address structures in the one allocation call.
+ * This is simplified by virtue of parseReplace () allocating the info, address
+ * and statistics structures in the one allocation call; since the statistics
+ * may still be in use by a connection, the block goes when they do.
  */
 
 void FilterRule :: freeInfo (addrinfo * info) {
         addrinfo      * temp;
         while ((temp = info) != 0) {
                 info = temp->ai_next;
-                free (temp);
+                stats (temp)->release ();
         }
 }
 
+/**
+ * Find the statistics for a replacement target, which follow the address in
+ * the block allocated by parseReplace ().
+ */
+
+/* static */
+TargetStats * FilterRule :: stats (addrinfo * info) {
+        return (TargetStats *) ((sockaddr_in *) (info + 1) + 1);
+}
+
+/**
+ * Allocate the block for a replacement target, with the address information
+ * followed by the address and the statistics, linked in front of a list.
+ */
+
+/* static */
+addrinfo * FilterRule :: newTarget (addrinfo * next) {
+        size_t          size = sizeof (addrinfo) + sizeof (sockaddr_in) +
+                               sizeof (TargetStats);
+        void          * mem = malloc (size);
+        if (mem == 0)
+                return 0;
+
+        memset (mem, 0, size);
+
+        addrinfo      * temp = (addrinfo *) mem;
+        sockaddr_in   * addr = (sockaddr_in *) (temp + 1);
+
+        temp->ai_addr = (sockaddr *) addr;
+        temp->ai_addrlen = sizeof (* addr);
+        temp->ai_family = AF_INET;
+        temp->ai_flags = 0;
+        temp->ai_next = next;
+
+        TargetStats   * target = stats (temp);
+        target->m_refs = 1;
+        target->m_block = mem;
+
+        return temp;
+}
+
 /**
  * Basically the same as wcschr (), but aware of glob escapes.
  */
@@ -347,6 +432,143 @@ const wchar_t * FilterRule :: hasPort (const wchar_t * from, const wchar_t * to,
         return to;
 }
 
+/**
+ * Extract a plain decimal number from a boundary pair, as used in numeric
+ * addresses and ports.
+ *
+ * This is deliberately strict; the numeric forms of rules stand in for what
+ * the text forms match against, which is the address and port rendered in
+ * their canonical form, so anything with leading zeros or out of range isn't
+ * accepted.
+ */
+
+/* static */
+const wchar_t * FilterRule :: number (const wchar_t * from, const wchar_t * to,
+                                      unsigned long limit,
+                                      unsigned long & value) {
+        const wchar_t * start = from;
+        value = 0;
+
+        for (; from != to ; ++ from) {
+                wchar_t         ch = * from;
+                if (ch < '0' || ch > '9')
+                        break;
+
+                if (from != start && value == 0)
+                        return 0;
+
+                value = value * 10 + (ch - '0');
+                if (value > limit)
+                        return 0;
+        }
+
+        return from == start ? 0 : from;
+}
+
+/**
+ * See whether a connection rule pattern can be matched numerically.
+ *
+ * The numeric forms are:
+ *      network ::== ('*' | <quad> ['/' <length>]) ':' [<port> ['-' <port>]]
+ *
+ * Plain addresses and '*' with a single port are what the rule sets have
+ * always used, and those are matched as text against the rendered address;
+ * here they are decoded only when the numeric match gives exactly the same
+ * answer as the text one would. The CIDR block and port range forms are new,
+ * and for those an empty or 0 port means any port as it was always intended
+ * to (the text match would not match anything with those at all).
+ *
+ * Anything else, such as a pattern with glob wildcards inside the address,
+ * stays as a text pattern.
+ */
+
+bool FilterRule :: parseNetwork (const wchar_t * from, const wchar_t * to) {
+        const wchar_t * portSpec = lookahead (from, to, ':');
+        if (portSpec == 0)
+                return false;
+
+        unsigned long   network = 0;
+        unsigned long   length = 32;
+        bool            anchored = true;
+        bool            cidr = false;
+        const wchar_t * scan = from;
+
+        if (* scan == '*' && scan + 1 == portSpec) {
+                length = 0;
+                anchored = false;
+                ++ scan;
+        } else {
+                for (int i = 0 ; i < 4 ; ++ i) {
+                        if (i > 0) {
+                                if (scan == portSpec || * scan != '.')
+                                        return false;
+                                ++ scan;
+                        }
+
+                        unsigned long   part;
+                        scan = number (scan, portSpec, 255, part);
+                        if (scan == 0)
+                                return false;
+
+                        network = (network << 8) | part;
+                }
+
+                if (scan != portSpec && * scan == '/') {
+                        scan = number (scan + 1, portSpec, 32, length);
+                        if (scan == 0)
+                                return false;
+
+                        cidr = true;
+                }
+        }
+
+        if (scan != portSpec)
+                return false;
+
+        unsigned long   low = 0;
+        unsigned long   high = 0xFFFF;
+        bool            range = false;
+
+        scan = portSpec + 1;
+        if (scan != to) {
+                scan = number (scan, to, 0xFFFF, low);
+                if (scan == 0)
+                        return false;
+
+                if (scan != to && * scan == '-') {
+                        scan = number (scan + 1, to, 0xFFFF, high);
+                        if (scan == 0 || high < low)
+                                return false;
+
+                        range = true;
+                } else
+                        high = low;
+
+                if (scan != to)
+                        return false;
+        }
+
+        if (low == 0 && ! range) {
+                /*
+                 * A wildcard port is only for the new forms.
+                 */
+
+                if (! cidr)
+                        return false;
+
+                high = 0xFFFF;
+        }
+
+        m_numeric = true;
+        m_anchored = anchored && ! cidr && ! range;
+        m_prefixLength = (unsigned char) length;
+        m_network = length == 0 ? 0 :
+                    network & (0xFFFFFFFFUL << (32 - length));
+        m_port = (unsigned short) low;
+        m_portHigh = (unsigned short) high;
+        return true;
+}
+
 /**
  * Parse one of the a replacement items for a rule.
  *
@@ -366,9 +588,9 @@ const wchar_t * FilterRule :: hasPort (const wchar_t * from, const wchar_t * to,
 
 bool FilterRule :: parseReplace (const wchar_t * from, const wchar_t * to,
                                  addrinfo * & link) {
-        size_t          size = sizeof (addrinfo) + sizeof (sockaddr_in);
-        void          * mem = malloc (size);
-        memset (mem, 0, size);
+        addrinfo      * temp = newTarget (link);
+        if (temp == 0)
+                return false;
 
         /*
          * Allow replacement rules to have comment fields (or indeed, allow
@@ -379,14 +601,9 @@ bool FilterRule :: parseReplace (const wchar_t * from, const wchar_t * to,
         if (comment != 0)
                 to = comment;
 
-        addrinfo      * temp = (addrinfo *) mem;
-        sockaddr_in   * addr = (sockaddr_in *) (temp + 1);
-
-        temp->ai_addr = (sockaddr *) addr;
-        temp->ai_addrlen = sizeof (* addr);
-        temp->ai_family = AF_INET;
-        temp->ai_flags = 0;
-        temp->ai_next = link;
+        void          * mem = temp;
+        sockaddr_in   * addr = (sockaddr_in *) temp->ai_addr;
+        TargetStats   * target = stats (temp);
 
         const wchar_t * port = hasPort (from, to, addr->sin_port);
         if (port == to) {
@@ -510,6 +727,7 @@ bool FilterRule :: parseReplace (const wchar_t * from, const wchar_t * to,
 
         sockaddr_in   * chosen = (sockaddr_in *) choices->ai_addr;
         addr->sin_addr = chosen->sin_addr;
+        target->m_adaptive = true;
 
         char            example [80];
         wsprintfA (example, "%ls=%d.%d.%d.%d\r\n", from,
@@ -527,14 +745,110 @@ bool FilterRule :: parseReplace (const wchar_t * from, const wchar_t * to,
         return true;
 }
 
+/**
+ * See whether an element of a replacement list is a rate limit, written as an
+ * '@' followed by the rate in kilobytes per second, and if so set the limit up
+ * for the rule.
+ *
+ * As with targets which fail to resolve, a malformed rate is just ignored
+ * rather than failing the whole rule set.
+ */
+
+bool FilterRule :: parseRate (const wchar_t * from, const wchar_t * to) {
+        const wchar_t * comment = lookahead (from, to, '#');
+        if (comment != 0)
+                to = comment;
+
+        while (from != to && (* from == ' ' || * from == '\t'))
+                ++ from;
+
+        if (from == to || * from != '@')
+                return false;
+
+        ++ from;
+        while (from != to && (* from == ' ' || * from == '\t'))
+                ++ from;
+
+        /*
+         * The rate is capped at about a gigabyte per second, which is well
+         * past anything a limit is useful for and keeps the token arithmetic
+         * well inside 64 bits.
+         */
+
+        unsigned long   rate;
+        const wchar_t * end = number (from, to, 1000000, rate);
+        while (end != 0 && end != to && (* end == ' ' || * end == '\t' ||
+                                         * end == '\r' || * end == '\n'))
+                ++ end;
+
+        if (end != to || rate == 0) {
+                OutputDebugStringA ("Bad rate limit\r\n");
+                return true;
+        }
+
+        if (m_limit != 0)
+                m_limit->release ();
+
+        m_limit = RateLimit :: create (rate * 1024);
+        return true;
+}
+
+/**
+ * See whether an element of a replacement list asks for the rule's targets to
+ * be raced, written as a '~' optionally followed by the number of milliseconds
+ * to leave between starting each attempt.
+ *
+ * Like a malformed rate, a malformed stagger is ignored.
+ */
+
+bool FilterRule :: parseRace (const wchar_t * from, const wchar_t * to) {
+        const wchar_t * comment = lookahead (from, to, '#');
+        if (comment != 0)
+                to = comment;
+
+        while (from != to && (* from == ' ' || * from == '\t'))
+                ++ from;
+
+        if (from == to || * from != '~')
+                return false;
+
+        ++ from;
+        while (from != to && (* from == ' ' || * from == '\t' ||
+                              * from == '\r' || * from == '\n'))
+                ++ from;
+
+        unsigned long   stagger = RaceTargets :: RACE_STAGGER;
+        if (from != to) {
+                const wchar_t * end;
+                end = number (from, to, RaceTargets :: RACE_STAGGER_MAX,
+                              stagger);
+                while (end != 0 && end != to &&
+                       (* end == ' ' || * end == '\t' ||
+                        * end == '\r' || * end == '\n'))
+                        ++ end;
+
+                if (end != to) {
+                        OutputDebugStringA ("Bad race stagger\r\n");
+                        return true;
+                }
+        }
+
+        m_race = true;
+        m_stagger = (unsigned short) stagger;
+        return true;
+}
+
 /**
  * Parse the specification for an individual rule.
  *
  * The grammar for a rule looks roughly like this:
  *      rule    ::== <replace> (',' <replace>)*
  *      rule    ::== <pattern> '=' [<replace> (',' <replace>)*]
- *      replace ::== <host> [':' <port>]
+ *      rule    ::== <rate>
+ *      replace ::== <host> [':' <port>] | <rate> | <race>
  *      pattern ::== <glob> [':' <port>]
+ *      rate    ::== '@' <kilobytes per second>
+ *      race    ::== '~' [<milliseconds between attempts>]
  */
 
 bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
@@ -552,8 +866,18 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
          *
          * This is supported by the fact rewriting things is more interesting
          * than blocking them, which is indeed how this all got started.
+         *
+         * A rate limit on its own is taken as the global limit, since a rule
+         * which passes everything through with a limit would just shadow all
+         * the rules after it.
          */
 
+        if (* from == '@') {
+                m_global = true;
+                parseRate (from, to);
+                return true;
+        }
+
         bool            url = * from == '/';
         const wchar_t * replace = lookahead (from, to, '=');
         const wchar_t * replaceTo = 0;
@@ -575,6 +899,7 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
          */
 
         m_hasPort = hasPort (from, to, m_port) != to;
+        m_portHigh = m_port;
 
         /*
          * Duplicate the rest of the pattern, if there is one.
@@ -582,6 +907,21 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
 
         m_pattern = from != 0 && * from != 0 ? wcsdup (from, to) : 0;
 
+        /*
+         * Compile the pattern once here, rather than interpreting it on every
+         * match; if that fails, we'll just fall back to matching the text.
+         */
+
+        if (m_pattern != 0)
+                m_glob = GlobMatcher :: compile (m_pattern);
+
+        /*
+         * If it's a connection rule, see if it can be matched numerically.
+         */
+
+        if (m_hasPort && m_pattern != 0)
+                parseNetwork (from, to);
+
         /*
          * If the rule is a URL, just copy it.
          *
@@ -591,6 +931,7 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
 
         if (url) {
                 this->m_rewrite = urldup (replace, replaceTo);
+                l_preload (m_rewrite);
                 return true;
         }
 
@@ -611,8 +952,20 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
                 addrinfo     ** dest = tail == 0 ? & m_replace :
                                        & tail->ai_next;
 
-                parseReplace (replace, next != 0 ? next : replaceTo, * dest);
-                tail = * dest;
+                if (parseRate (replace, next != 0 ? next : replaceTo) ||
+                    parseRace (replace, next != 0 ? next : replaceTo)) {
+                        /*
+                         * Not a target, just a limit or a flag for the rule.
+                         */
+                } else {
+                        parseReplace (replace, next != 0 ? next : replaceTo,
+                                      * dest);
+                }
+
+                if (* dest != 0) {
+                        tail = * dest;
+                        ++ m_targets;
+                }
 
                 if (next == 0)
                         break;
@@ -620,104 +973,1397 @@ bool FilterRule :: parseRule (const wchar_t * from, const wchar_t * to) {
                 replace = next + 1;
         }
 
+        /*
+         * A rule with a rate limit and no targets is meant to limit what it
+         * matches, not to block it, so give it a pass-through target.
+         */
+
+        if (m_limit != 0 && m_targets == 0 &&
+            (m_replace = newTarget (0)) != 0) {
+                ++ m_targets;
+        }
+
         return true;
 }
 
 /**
- * Match a filter rule based on the text string.
+ * Add to a 64-bit tick total shared between threads.
+ *
+ * There's only a 32-bit interlocked add to work with on x86, but there is a
+ * 64-bit compare-and-swap; a torn read of the old value just means the swap
+ * fails and we go around again.
  */
 
-bool FilterRule :: match (const char * example, addrinfo ** replace) {
-        if (m_pattern != 0 && ! globMatch (example, m_pattern, SLASH_NO_MATCH))
-                return false;
+static void l_addTicks (volatile LONGLONG * total, LONGLONG ticks) {
+        LONGLONG        old;
+        do {
+                old = * total;
+        } while (_InterlockedCompareExchange64 (total, old + ticks,
+                                                old) != old);
+}
 
-        /*
-         * OK, a match. If there is no replacement, say so, otherwise return
-         * a suitable replacement and adjust the replacement chain so that the
-         * replacements are rotated through.
-         */
+/**
+ * Keep the statistics for a single test of a rule.
+ *
+ * Every test of a rule is counted, but only one in every SAMPLE_RATE tests is
+ * timed; reading the performance counter costs about as much as many of the
+ * tests themselves, so timing every one would distort what's being measured.
+ * Since any number of hook threads can be testing the same rule at once, all
+ * the counting is done with interlocked operations rather than a lock.
+ */
 
-        addrinfo      * next = m_nextReplace;
-        if (next == 0)
-                next = m_replace;
+class RuleSample {
+public:
+        enum { SAMPLE_RATE = 16 };
 
-        if ((* replace = next) != 0 && (next = next->ai_next) == 0)
-                next = m_replace;
+private:
+        FilterRule    * m_rule;
+        LARGE_INTEGER   m_start;
 
-        m_nextReplace = next;
-        return true;
-}
+public:
+                        RuleSample (FilterRule * rule);
+                      ~ RuleSample ();
 
+        void            hit () { InterlockedIncrement (& m_rule->m_hits); }
+};
 
-/**
- * Match a filter rule based on a URL string or other simple string.
- */
+RuleSample :: RuleSample (FilterRule * rule) : m_rule (rule) {
+        m_start.QuadPart = 0;
 
-bool FilterRule :: match (const char * example, const char ** replace,
-                          int slashMode) {
-        if (m_pattern != 0 && ! globMatch (example, m_pattern, slashMode))
-                return false;
+        LONG            tests = InterlockedIncrement (& rule->m_tests);
+        if ((tests & (SAMPLE_RATE - 1)) == 0)
+                QueryPerformanceCounter (& m_start);
+}
 
-        /*
-         * OK, a match. For URLs, we just return the text to rewrite the URL
-         * with, if any (no rewrite text means to block it outright).
-         */
+RuleSample :: ~ RuleSample () {
+        if (m_start.QuadPart == 0)
+                return;
 
-        if (replace != 0)
-                * replace = m_rewrite;
-        return true;
+        LARGE_INTEGER   end;
+        QueryPerformanceCounter (& end);
+
+        l_addTicks (& m_rule->m_ticks, end.QuadPart - m_start.QuadPart);
+        InterlockedIncrement (& m_rule->m_samples);
 }
 
 /**
- * Lock for controlling access to the list of rules within a rule set, since
- * the list is accessed from multiple threads.
+ * Run the rule pattern over an example string.
  */
 
-CRITICAL_SECTION        l_filterLock [1];
+bool FilterRule :: matchPattern (const char * example, int slashMode) {
+        if (m_glob != 0)
+                return m_glob->match (example, slashMode);
+
+        return globMatch (example, m_pattern, slashMode);
+}
 
 /**
- * Initialise function pointers to the Winsock address-info functions.
+ * Match a filter rule based on the text string.
  */
 
-static bool l_initFuncs (void) {
-        if (g_addrFunc != 0 && g_freeFunc != 0)
-                return true;
+bool FilterRule :: match (const char * example, addrinfo ** replace) {
+        RuleSample      sample (this);
+        if (m_pattern != 0 && ! matchPattern (example, SLASH_NO_MATCH))
+                return false;
 
-        InitializeCriticalSection (l_filterLock);
+        sample.hit ();
+        select (replace);
+        return true;
+}
 
-        HMODULE         ws2 = GetModuleHandle (L"WS2_32.DLL");
-        if (ws2 == 0)
+/**
+ * Match a filter rule based on a numeric address and port.
+ */
+
+bool FilterRule :: match (unsigned long address, unsigned short port,
+                          addrinfo ** replace) {
+        RuleSample      sample (this);
+        if (port < m_port || port > m_portHigh)
                 return false;
 
-        g_addrFunc = (GetAddrInfoWFunc) GetProcAddress (ws2, "GetAddrInfoW");
-        g_freeFunc = (FreeAddrInfoWFunc) GetProcAddress (ws2, "FreeAddrInfoW");
+        if (m_prefixLength > 0 &&
+            ((address ^ m_network) >> (32 - m_prefixLength)) != 0) {
+                return false;
+        }
 
-        return g_addrFunc != 0 && g_freeFunc != 0;
+        sample.hit ();
+        select (replace);
+        return true;
 }
 
 /**
- * Simple constructor for the rule list.
+ * Choose the replacement for a matched rule.
+ *
+ * If there is no replacement, say so, otherwise return a suitable replacement
+ * and adjust the replacement chain so that the replacements are rotated
+ * through.
+ *
+ * Since several threads can be matching the same rule at once, the rotation
+ * is done with a compare-and-swap rather than under a lock.
+ *
+ * Where there are several targets, the one next in the rotation is compared
+ * with another picked at random, and whichever looks the better bet is used;
+ * this "power of two choices" scheme steers most of the traffic to the good
+ * targets while still spreading it around, and keeps giving each target a
+ * look-in so that its statistics stay current.
  */
 
-FilterRules :: FilterRules (unsigned short defaultPort) :
-                m_head (0), m_tail (0),  m_pending (0),
-                m_defaultPort (defaultPort) {
+void FilterRule :: select (addrinfo ** replace) {
+        void * volatile * slot = (void * volatile *) & m_nextReplace;
+        addrinfo      * current;
+        addrinfo      * next;
+        do {
+                current = m_nextReplace;
+                next = current != 0 ? current : m_replace;
+
+                if ((* replace = next) != 0 && (next = next->ai_next) == 0)
+                        next = m_replace;
+        } while (InterlockedCompareExchangePointer (slot, next,
+                                                    current) != current);
+
+        addrinfo      * first = * replace;
+        if (m_targets < 2 || first == 0)
+                return;
+
+static  volatile LONG   choice;
+        unsigned long   pick = (unsigned long) InterlockedIncrement (& choice);
+        pick = ((pick * 2654435761UL) >> 16) % m_targets;
+
+        addrinfo      * other = m_replace;
+        while (pick > 0 && other->ai_next != 0) {
+                other = other->ai_next;
+                -- pick;
+        }
+
+        if (other == first && (other = first->ai_next) == 0)
+                other = m_replace;
+
+        TargetStats   * left = stats (first);
+        TargetStats   * right = stats (other);
+        if (! left->m_adaptive || ! right->m_adaptive)
+                return;
+
+        if (right->better (left, GetTickCount ()))
+                * replace = other;
 }
 
 /**
- * Simple destructor for the rule list.
+ * Fill in the targets to race a connection between, starting with the one the
+ * selection chose and followed by the best of the rest.
+ *
+ * The rest are ranked with the same comparison the selection uses, except that
+ * targets with statistics go ahead of those without (which are the targets
+ * given as '*', and would otherwise always look untried); there are only a
+ * few of them, so a simple selection sort does.
  */
 
-FilterRules :: ~ FilterRules () {
-        freeRules (m_head);
-        free (m_pending);
+void FilterRule :: candidates (addrinfo * first, RaceTargets & race) {
+        addrinfo      * chosen [RaceTargets :: RACE_TARGETS];
+        unsigned long   count = 0;
+        unsigned long   now = GetTickCount ();
+
+        chosen [count ++] = first;
+        while (count < RaceTargets :: RACE_TARGETS) {
+                addrinfo      * best = 0;
+                addrinfo      * scan = m_replace;
+                for (; scan != 0 ; scan = scan->ai_next) {
+                        sockaddr_in   * addr = (sockaddr_in *) scan->ai_addr;
+                        if (addr->sin_addr.S_un.S_addr == INADDR_NONE)
+                                continue;
+
+                        unsigned long   i = 0;
+                        while (i < count && chosen [i] != scan)
+                                ++ i;
+                        if (i < count)
+                                continue;
+
+                        TargetStats   * left = stats (scan);
+                        TargetStats   * right = best != 0 ? stats (best) : 0;
+                        if (right == 0 ||
+                            (left->m_adaptive != right->m_adaptive ?
+                             left->m_adaptive : left->better (right, now)))
+                                best = scan;
+                }
+
+                if (best == 0)
+                        break;
+
+                chosen [count ++] = best;
+        }
+
+        for (unsigned long i = 0 ; i < count ; ++ i) {
+                TargetStats   * target = stats (chosen [i]);
+                if (target->m_adaptive) {
+                        target->addRef ();
+                } else
+                        target = 0;
+
+                race.m_address [i] = * (sockaddr_in *) chosen [i]->ai_addr;
+                race.m_target [i] = target;
+        }
+
+        race.m_count = count;
+        race.m_stagger = m_stagger;
 }
 
 /**
- * Parse a new filter specification.
- *
- * The filter specification is roughly like this:
- *      rules   ::== <rule> (';' <rule>)*
+ * List the addresses a name rule can answer with, starting with the target
+ * the selection chose and then the rest in rotation order, so that whoever
+ * asked has the other targets to fall back on if the first doesn't answer.
+ *
+ * Targets which block, or which pass the name through, aren't addresses that
+ * anyone can connect to, so they're left out.
+ */
+
+unsigned long FilterRule :: failover (addrinfo * first, unsigned long * addrs,
+                                      unsigned long limit) {
+        unsigned long   count = 0;
+        addrinfo      * scan = first;
+        while (scan != 0 && count < limit) {
+                sockaddr_in   * addr = (sockaddr_in *) scan->ai_addr;
+                unsigned long   address = addr->sin_addr.S_un.S_addr;
+                if (address != INADDR_NONE && address != INADDR_ANY)
+                        addrs [count ++] = address;
+
+                if ((scan = scan->ai_next) == 0)
+                        scan = m_replace;
+                if (scan == first)
+                        break;
+        }
+
+        return count;
+}
+
+
+/**
+ * Match a filter rule based on a URL string or other simple string.
+ */
+
+bool FilterRule :: match (const char * example, const char ** replace,
+                          int slashMode) {
+        RuleSample      sample (this);
+        if (m_pattern != 0 && ! matchPattern (example, slashMode))
+                return false;
+
+        sample.hit ();
+
+        /*
+         * OK, a match. For URLs, we just return the text to rewrite the URL
+         * with, if any (no rewrite text means to block it outright).
+         */
+
+        if (replace != 0)
+                * replace = m_rewrite;
+        return true;
+}
+
+/**
+ * Compare the literal text at the front (or the back) of two patterns.
+ *
+ * Anything a pattern matches has to start with the literal text before the
+ * first wildcard in the pattern, and end with the literal text after the last
+ * one; so if the literal text of two patterns differs anywhere before either
+ * runs into a wildcard, no example can be matched by both of them.
+ */
+
+/* static */
+bool FilterRule :: diverge (const wchar_t * left, const wchar_t * right,
+                            bool reverse) {
+        const wchar_t * leftEnd = left + wcslen (left);
+        const wchar_t * rightEnd = right + wcslen (right);
+
+        while (left < leftEnd && right < rightEnd) {
+                wchar_t         leftCh = reverse ? * -- leftEnd : * left ++;
+                wchar_t         rightCh = reverse ? * -- rightEnd : * right ++;
+
+                if (leftCh == '*' || leftCh == '?' ||
+                    rightCh == '*' || rightCh == '?') {
+                        break;
+                }
+
+                if (leftCh != rightCh)
+                        return true;
+        }
+
+        return false;
+}
+
+/**
+ * Decide whether two rules can never both match the same example as text.
+ */
+
+bool FilterRule :: disjointText (const FilterRule * other) const {
+        if (m_pattern == 0 || other->m_pattern == 0)
+                return false;
+
+        return diverge (m_pattern, other->m_pattern, false) ||
+               diverge (m_pattern, other->m_pattern, true);
+}
+
+/**
+ * Say whether a rule is one the URL and host lookups will consider; as with
+ * the URL index table, that's any rule whose literal prefix is empty or starts
+ * with a '/'.
+ */
+
+bool FilterRule :: urlCandidate () const {
+        wchar_t         ch = m_pattern != 0 ? m_pattern [0] : 0;
+        return ch == 0 || ch == '/' || ch == '*' || ch == '?' || ch >= 0x80;
+}
+
+/**
+ * Decide whether two rules are independent of each other, so that swapping
+ * their order can't change which rule is the first to match any lookup.
+ *
+ * The rules have to be disjoint for every kind of lookup that can see both of
+ * them; where a pair of connection rules mixes a numeric rule with a text one
+ * there's no sensible way to compare them, so those are always taken to
+ * overlap, as is any rule without a pattern (since it matches everything).
+ */
+
+bool FilterRule :: disjoint (const FilterRule * other) const {
+        if (m_global || other->m_global)
+                return ! m_global || ! other->m_global;
+
+        if (m_hasPort && other->m_hasPort) {
+                if (m_numeric != other->m_numeric)
+                        return false;
+
+                if (m_numeric) {
+                        unsigned long   length = m_prefixLength;
+                        if (other->m_prefixLength < length)
+                                length = other->m_prefixLength;
+
+                        bool            ports;
+                        ports = m_portHigh < other->m_port ||
+                                other->m_portHigh < m_port;
+
+                        bool            networks = length > 0 &&
+                                ((m_network ^ other->m_network) >>
+                                 (32 - length)) != 0;
+
+                        if (! ports && ! networks)
+                                return false;
+                } else if (! disjointText (other))
+                        return false;
+        } else if (! m_hasPort && ! other->m_hasPort) {
+                if (! disjointText (other))
+                        return false;
+        }
+
+        if (urlCandidate () && other->urlCandidate ())
+                return disjointText (other);
+
+        return true;
+}
+
+/**
+ * The layout of a compiled rule image.
+ *
+ * The image starts with a header, which records a hash of the rule text the
+ * image was compiled from so the filter can check it's been handed the right
+ * one, followed by a record for each rule in rule order. Each record holds the
+ * decoded form of the rule and its replacement targets as plain addresses,
+ * followed by the pattern text, the compiled glob and any URL rewrite text;
+ * anything referred to is located by its offset from the start of the image,
+ * since the image will be mapped at different addresses in each process.
+ *
+ * Everything in the image is kept aligned to 4 bytes, which is all that the
+ * compiled globs need.
+ */
+
+#define IMAGE_ALIGN(x)  (((x) + 3) & ~ 3UL)
+
+enum {
+        IMAGE_MAGIC = 0x42524c53,
+        IMAGE_VERSION = 3,
+
+        IMAGE_HAS_PORT = 1,
+        IMAGE_NUMERIC = 2,
+        IMAGE_ANCHORED = 4,
+        IMAGE_GLOBAL = 8,
+        IMAGE_RACE = 16
+};
+
+struct ImageHeader {
+        unsigned long   m_magic;
+        unsigned long   m_version;
+        unsigned long   m_size;
+        unsigned long   m_hash;
+        unsigned long   m_length;
+        unsigned long   m_count;
+};
+
+struct ImageTarget {
+        unsigned long   m_address;
+        unsigned short  m_port;
+        unsigned short  m_adaptive;
+};
+
+struct ImageRule {
+        unsigned long   m_size;
+        unsigned long   m_pattern;
+        unsigned long   m_glob;
+        unsigned long   m_rewrite;
+        unsigned long   m_network;
+        unsigned long   m_rate;
+        unsigned long   m_stagger;
+        unsigned short  m_port;
+        unsigned short  m_portHigh;
+        unsigned char   m_flags;
+        unsigned char   m_prefixLength;
+        unsigned short  m_targets;
+        ImageTarget     m_target [1];
+};
+
+#define IMAGE_RULE_SIZE(targets) \
+        (sizeof (ImageRule) + (targets) * sizeof (ImageTarget) - \
+         sizeof (ImageTarget))
+
+/**
+ * Hash the source text of a rule image (with FNV-1a), and measure it.
+ */
+
+static unsigned long l_hashText (const wchar_t * text,
+                                 unsigned long & length) {
+        unsigned long   hash = 2166136261UL;
+        length = 0;
+
+        for (; text != 0 && * text != 0 ; ++ text, ++ length)
+                hash = (hash ^ (unsigned short) * text) * 16777619UL;
+
+        return hash;
+}
+
+/**
+ * Check that an offset in a rule image refers to a string which is properly
+ * terminated before the end of the containing record.
+ */
+
+static bool l_imageText (const unsigned char * image, unsigned long offset,
+                         unsigned long end, unsigned long unit) {
+        if (offset >= end || (offset & (unit - 1)) != 0)
+                return false;
+
+        for (; offset + unit <= end ; offset += unit) {
+                if (unit == 1 ? image [offset] == 0 :
+                    * (const wchar_t *) (image + offset) == 0)
+                        return true;
+        }
+
+        return false;
+}
+
+/**
+ * Work out how much space this rule needs in a rule image.
+ */
+
+unsigned long FilterRule :: imageSize () const {
+        unsigned long   size = IMAGE_RULE_SIZE (m_targets);
+
+        if (m_pattern != 0)
+                size += IMAGE_ALIGN ((wcslen (m_pattern) + 1) *
+                                     sizeof (wchar_t));
+        if (m_glob != 0)
+                size += IMAGE_ALIGN (m_glob->size ());
+        if (m_rewrite != 0)
+                size += IMAGE_ALIGN (strlen (m_rewrite) + 1);
+
+        return size;
+}
+
+/**
+ * Write this rule into a rule image at the given offset, which the caller has
+ * made sure has imageSize () bytes of zeroed space.
+ */
+
+void FilterRule :: save (unsigned char * image, unsigned long offset) const {
+        ImageRule     * dest = (ImageRule *) (image + offset);
+        unsigned long   next = offset + IMAGE_RULE_SIZE (m_targets);
+
+        dest->m_network = m_network;
+        dest->m_rate = m_limit != 0 ? m_limit->rate () : 0;
+        dest->m_stagger = m_stagger;
+        dest->m_port = m_port;
+        dest->m_portHigh = m_portHigh;
+        dest->m_prefixLength = m_prefixLength;
+        dest->m_flags = (m_hasPort ? IMAGE_HAS_PORT : 0) |
+                        (m_numeric ? IMAGE_NUMERIC : 0) |
+                        (m_anchored ? IMAGE_ANCHORED : 0) |
+                        (m_global ? IMAGE_GLOBAL : 0) |
+                        (m_race ? IMAGE_RACE : 0);
+
+        addrinfo      * scan = m_replace;
+        for (; scan != 0 && dest->m_targets < m_targets ;
+             scan = scan->ai_next) {
+                ImageTarget   * target = dest->m_target + dest->m_targets ++;
+                sockaddr_in   * addr = (sockaddr_in *) scan->ai_addr;
+
+                target->m_address = addr->sin_addr.S_un.S_addr;
+                target->m_port = addr->sin_port;
+                target->m_adaptive = stats (scan)->m_adaptive ? 1 : 0;
+        }
+
+        if (m_pattern != 0) {
+                size_t          bytes;
+                bytes = (wcslen (m_pattern) + 1) * sizeof (wchar_t);
+                memcpy (image + next, m_pattern, bytes);
+                dest->m_pattern = next;
+                next += IMAGE_ALIGN (bytes);
+        }
+
+        if (m_glob != 0) {
+                memcpy (image + next, m_glob, m_glob->size ());
+                dest->m_glob = next;
+                next += IMAGE_ALIGN (m_glob->size ());
+        }
+
+        if (m_rewrite != 0) {
+                size_t          bytes = strlen (m_rewrite) + 1;
+                memcpy (image + next, m_rewrite, bytes);
+                dest->m_rewrite = next;
+                next += IMAGE_ALIGN (bytes);
+        }
+
+        dest->m_size = next - offset;
+}
+
+/**
+ * Load this rule from the record at the given offset in a rule image, and
+ * advance the offset to the next record.
+ *
+ * The image came from another process, so everything in the record is checked
+ * against the bounds of the image before it's used; the text and glob are
+ * then used in place, and only the replacement targets (which have to carry
+ * live statistics) are allocated.
+ */
+
+bool FilterRule :: load (const unsigned char * image, unsigned long size,
+                         unsigned long & offset) {
+        if (offset > size || size - offset < IMAGE_RULE_SIZE (0))
+                return false;
+
+        const ImageRule * rule = (const ImageRule *) (image + offset);
+        unsigned long   end = offset + rule->m_size;
+        if (rule->m_size > size - offset || (rule->m_size & 3) != 0 ||
+            rule->m_size < IMAGE_RULE_SIZE (rule->m_targets)) {
+                return false;
+        }
+
+        /*
+         * The prefix length feeds a shift count and bounds the walk down the
+         * address trie, so anything past the width of an address is garbage.
+         */
+
+        if (rule->m_prefixLength > 32)
+                return false;
+
+        if (rule->m_pattern != 0 &&
+            ! l_imageText (image, rule->m_pattern, end, sizeof (wchar_t)))
+                return false;
+        if (rule->m_rewrite != 0 &&
+            ! l_imageText (image, rule->m_rewrite, end, 1))
+                return false;
+
+        if (rule->m_glob != 0) {
+                unsigned long   glob = rule->m_glob;
+                if (glob >= end || (glob & 3) != 0)
+                        return false;
+
+                const GlobMatcher * check;
+                check = (const GlobMatcher *) (image + glob);
+                if (! check->valid (end - glob))
+                        return false;
+        }
+
+        m_borrowed = true;
+        m_pattern = rule->m_pattern == 0 ? 0 :
+                    (wchar_t *) (image + rule->m_pattern);
+        m_glob = rule->m_glob == 0 ? 0 :
+                 (GlobMatcher *) (image + rule->m_glob);
+        m_rewrite = rule->m_rewrite == 0 ? 0 :
+                    (char *) (image + rule->m_rewrite);
+        l_preload (m_rewrite);
+
+        m_network = rule->m_network;
+        m_port = rule->m_port;
+        m_portHigh = rule->m_portHigh;
+        m_prefixLength = rule->m_prefixLength;
+        m_hasPort = (rule->m_flags & IMAGE_HAS_PORT) != 0;
+        m_numeric = (rule->m_flags & IMAGE_NUMERIC) != 0;
+        m_anchored = (rule->m_flags & IMAGE_ANCHORED) != 0;
+        m_global = (rule->m_flags & IMAGE_GLOBAL) != 0;
+        m_race = (rule->m_flags & IMAGE_RACE) != 0;
+        m_stagger = rule->m_stagger > RaceTargets :: RACE_STAGGER_MAX ?
+                    RaceTargets :: RACE_STAGGER_MAX :
+                    (unsigned short) rule->m_stagger;
+
+        if (rule->m_rate != 0)
+                m_limit = RateLimit :: create (rule->m_rate);
+
+        /*
+         * Build the target list from the back, so it comes out in order.
+         */
+
+        unsigned long   i = rule->m_targets;
+        while (i > 0) {
+                const ImageTarget * target = rule->m_target + -- i;
+
+                addrinfo      * temp = newTarget (m_replace);
+                if (temp == 0)
+                        return false;
+
+                sockaddr_in   * addr = (sockaddr_in *) temp->ai_addr;
+                addr->sin_addr.S_un.S_addr = target->m_address;
+                addr->sin_port = target->m_port;
+                stats (temp)->m_adaptive = target->m_adaptive != 0;
+
+                m_replace = temp;
+                ++ m_targets;
+        }
+
+        offset = end;
+        return true;
+}
+
+/**
+ * Simple reference counting for target statistics.
+ */
+
+void TargetStats :: addRef () {
+        InterlockedIncrement (& m_refs);
+}
+
+void TargetStats :: release () {
+        if (InterlockedDecrement (& m_refs) == 0)
+                free (m_block);
+}
+
+/**
+ * Say whether a target is being left alone after failing to connect.
+ *
+ * Once the cooldown runs out, the target is eligible again but still counts
+ * as failing until a connection to it actually works.
+ */
+
+bool TargetStats :: cooling (unsigned long now) const {
+        return m_streak > 0 && (LONG) (m_cooldown - now) > 0;
+}
+
+/**
+ * Decide whether a target looks like a better bet for a new connection than
+ * another one.
+ *
+ * Targets that are cooling down lose to any that aren't, and targets nothing
+ * has been tried against yet win, so that they get measured; otherwise, the
+ * share of a target's recent throughput that a new connection would get is
+ * what counts, with the connect latency breaking ties.
+ */
+
+bool TargetStats :: better (const TargetStats * other,
+                            unsigned long now) const {
+        bool            cool = cooling (now);
+        if (cool != other->cooling (now))
+                return ! cool;
+
+        bool            fresh = m_connects == 0 && m_failures == 0;
+        bool            otherFresh = other->m_connects == 0 &&
+                                     other->m_failures == 0;
+        if (fresh != otherFresh)
+                return fresh;
+
+        unsigned long   share = m_rate / (m_active + 1);
+        unsigned long   otherShare = other->m_rate / (other->m_active + 1);
+        if (share != otherShare)
+                return share > otherShare;
+
+        return m_latency < other->m_latency;
+}
+
+/**
+ * Note that a connection to the target has been started.
+ */
+
+void TargetStats :: opened () {
+        InterlockedIncrement (& m_active);
+}
+
+/**
+ * Note a successful connection taking the given number of milliseconds, which
+ * clears any failure streak.
+ */
+
+void TargetStats :: connected (unsigned long elapsed) {
+        LONG            latency = m_latency;
+        if (m_connects > 0)
+                latency += ((LONG) elapsed - latency) / 4;
+        else
+                latency = (LONG) elapsed;
+
+        InterlockedExchange (& m_latency, latency);
+        InterlockedIncrement (& m_connects);
+        InterlockedExchange (& m_streak, 0);
+}
+
+/**
+ * Note a failed connection, and back off from the target for a while; each
+ * failure in a row doubles the time, up to a limit.
+ */
+
+void TargetStats :: failed () {
+        InterlockedIncrement (& m_failures);
+
+        LONG            streak = InterlockedIncrement (& m_streak);
+        if (streak > COOLDOWN_SHIFT + 1)
+                streak = COOLDOWN_SHIFT + 1;
+
+        unsigned long   delay = (unsigned long) COOLDOWN_BASE << (streak - 1);
+        InterlockedExchange (& m_cooldown, GetTickCount () + delay);
+}
+
+/**
+ * Fold a sample of the data delivered by a connection over the given number
+ * of milliseconds into the target's throughput, in bytes per second.
+ *
+ * All these updates are simple smoothed averages; they are updated without a
+ * lock and the occasional lost update from a race just means a sample gets
+ * ignored, which is harmless.
+ */
+
+void TargetStats :: delivered (unsigned long bytes, unsigned long elapsed) {
+        if (elapsed == 0)
+                return;
+
+        LONG            sample;
+        sample = (LONG) ((ULONGLONG) bytes * 1000 / elapsed);
+
+        LONG            rate = m_rate;
+        if (rate != 0)
+                rate += (sample - rate) / 4;
+        else
+                rate = sample;
+
+        InterlockedExchange (& m_rate, rate);
+}
+
+/**
+ * Note that a connection to the target has finished.
+ */
+
+void TargetStats :: closed () {
+        InterlockedDecrement (& m_active);
+}
+
+/**
+ * Let go of the statistics for any race candidates.
+ */
+
+void RaceTargets :: release () {
+        for (unsigned long i = 0 ; i < m_count ; ++ i) {
+                if (m_target [i] != 0)
+                        m_target [i]->release ();
+
+                m_target [i] = 0;
+        }
+
+        m_count = 0;
+}
+
+/**
+ * An entry in a rule table, referring to a rule with the same literal prefix
+ * (or network) as the other entries in the list for a trie node.
+ */
+
+struct RuleEntry {
+        RuleEntry     * m_next;
+        FilterRule    * m_rule;
+        unsigned long   m_order;
+};
+
+/**
+ * A node in the trie for a rule table.
+ *
+ * The children of a node are kept as a simple sibling list; the fan-out at
+ * any level is small enough that anything fancier isn't worth the code.
+ */
+
+struct RuleTable :: Node {
+        Node          * m_child;
+        Node          * m_sibling;
+        RuleEntry     * m_head;
+        RuleEntry     * m_tail;
+        char            m_ch;
+};
+
+/**
+ * Simple constructor for a rule table.
+ */
+
+RuleTable :: RuleTable () : m_root (0) {
+}
+
+/**
+ * Simple destructor for a rule table; the rules belong to the rule list, so
+ * only the index structure itself is released here.
+ */
+
+RuleTable :: ~ RuleTable () {
+        clear ();
+}
+
+/**
+ * Release a trie node and everything below it.
+ */
+
+/* static */
+void RuleTable :: freeNode (Node * node) {
+        while (node != 0) {
+                Node          * next = node->m_sibling;
+                freeNode (node->m_child);
+
+                RuleEntry     * entry;
+                while ((entry = node->m_head) != 0) {
+                        node->m_head = entry->m_next;
+                        free (entry);
+                }
+
+                free (node);
+                node = next;
+        }
+}
+
+/**
+ * Discard the contents of the table.
+ */
+
+void RuleTable :: clear () {
+        freeNode (m_root);
+        m_root = 0;
+}
+
+/**
+ * Extract the literal text at the front of a rule pattern, as narrow text.
+ *
+ * This has to agree exactly with what globMatch () will accept, so the prefix
+ * stops at the first wildcard, but also at any character outside the 7-bit
+ * range since those can never compare equal to the narrow example string. A
+ * backslash here is just taken literally, as that is what the matcher does.
+ */
+
+/* static */
+size_t RuleTable :: prefix (const FilterRule * rule, char * dest,
+                            size_t length) {
+        const wchar_t * scan = rule->m_pattern;
+        if (scan == 0)
+                return 0;
+
+        size_t          count = 0;
+        wchar_t         ch;
+        while (count < length && (ch = * scan ++) != 0) {
+                if (ch == '*' || ch == '?' || ch >= 0x80)
+                        break;
+
+                dest [count ++] = (char) ch;
+        }
+
+        return count;
+}
+
+/**
+ * Add a rule into the index, at the trie node for its literal prefix.
+ *
+ * Rules are expected to be added in rule order, so that each node's list
+ * stays sorted without any extra work; the order value passed in is what the
+ * cursor uses to merge the lists from different nodes.
+ *
+ * For the URL table, rules whose literal prefix can never match something that
+ * starts with a '/' are left out entirely.
+ */
+
+bool RuleTable :: add (FilterRule * rule, unsigned long order, bool urlOnly) {
+        char            text [MAX_PREFIX];
+        size_t          length = prefix (rule, text, ARRAY_LENGTH (text));
+
+        if (urlOnly && length > 0 && text [0] != '/')
+                return false;
+
+        if (m_root == 0) {
+                m_root = (Node *) malloc (sizeof (Node));
+                if (m_root == 0)
+                        return false;
+
+                memset (m_root, 0, sizeof (Node));
+        }
+
+        Node          * node = m_root;
+        for (size_t i = 0 ; i < length ; ++ i) {
+                Node          * child = node->m_child;
+                while (child != 0 && child->m_ch != text [i])
+                        child = child->m_sibling;
+
+                if (child == 0) {
+                        child = (Node *) malloc (sizeof (Node));
+                        if (child == 0)
+                                return false;
+
+                        memset (child, 0, sizeof (Node));
+                        child->m_ch = text [i];
+                        child->m_sibling = node->m_child;
+                        node->m_child = child;
+                }
+
+                node = child;
+        }
+
+        RuleEntry     * entry = (RuleEntry *) malloc (sizeof (RuleEntry));
+        if (entry == 0)
+                return false;
+
+        entry->m_next = 0;
+        entry->m_rule = rule;
+        entry->m_order = order;
+
+        if (node->m_tail != 0) {
+                node->m_tail->m_next = entry;
+        } else
+                node->m_head = entry;
+        node->m_tail = entry;
+
+        return true;
+}
+
+/**
+ * A node in the radix tree for an address table.
+ */
+
+struct AddressTable :: Node {
+        Node          * m_child [2];
+        RuleEntry     * m_head;
+        RuleEntry     * m_tail;
+};
+
+/**
+ * Simple constructor for an address table.
+ */
+
+AddressTable :: AddressTable () : m_root (0) {
+}
+
+/**
+ * Simple destructor for an address table.
+ */
+
+AddressTable :: ~ AddressTable () {
+        clear ();
+}
+
+/**
+ * Release a radix tree node and everything below it.
+ */
+
+/* static */
+void AddressTable :: freeNode (Node * node) {
+        if (node == 0)
+                return;
+
+        freeNode (node->m_child [0]);
+        freeNode (node->m_child [1]);
+
+        RuleEntry     * entry;
+        while ((entry = node->m_head) != 0) {
+                node->m_head = entry->m_next;
+                free (entry);
+        }
+
+        free (node);
+}
+
+/**
+ * Discard the contents of the table.
+ */
+
+void AddressTable :: clear () {
+        freeNode (m_root);
+        m_root = 0;
+}
+
+/**
+ * Add a numeric rule into the index, at the node for its network prefix.
+ *
+ * As with the text tables, rules are added in rule order.
+ */
+
+bool AddressTable :: add (FilterRule * rule, unsigned long order) {
+        Node         ** link = & m_root;
+        unsigned long   bit = 0;
+        for (;;) {
+                Node          * node = * link;
+                if (node == 0) {
+                        node = (Node *) malloc (sizeof (Node));
+                        if (node == 0)
+                                return false;
+
+                        memset (node, 0, sizeof (Node));
+                        * link = node;
+                }
+
+                if (bit == rule->m_prefixLength)
+                        break;
+
+                unsigned long   branch = (rule->m_network >> (31 - bit)) & 1;
+                link = node->m_child + branch;
+                ++ bit;
+        }
+
+        RuleEntry     * entry = (RuleEntry *) malloc (sizeof (RuleEntry));
+        if (entry == 0)
+                return false;
+
+        entry->m_next = 0;
+        entry->m_rule = rule;
+        entry->m_order = order;
+
+        Node          * node = * link;
+        if (node->m_tail != 0) {
+                node->m_tail->m_next = entry;
+        } else
+                node->m_head = entry;
+        node->m_tail = entry;
+
+        return true;
+}
+
+/**
+ * Gather the candidate lists for an example from the trie.
+ */
+
+RuleCursor :: RuleCursor (const RuleTable & table, const char * example) :
+                m_count (0) {
+        add (table, example);
+}
+
+/**
+ * Add the candidate lists for an example from a text table.
+ */
+
+void RuleCursor :: add (const RuleTable & table, const char * example) {
+        const RuleTable :: Node * node = table.m_root;
+        if (node == 0 || example == 0)
+                return;
+
+        for (;;) {
+                if (node->m_head != 0)
+                        m_lists [m_count ++] = node->m_head;
+
+                char            ch = * example ++;
+                if (ch == 0)
+                        break;
+
+                node = node->m_child;
+                while (node != 0 && node->m_ch != ch)
+                        node = node->m_sibling;
+
+                if (node == 0)
+                        break;
+        }
+}
+
+/**
+ * Add the candidate lists for an address from a numeric table; these are the
+ * rules for every network along the path to the address in the radix tree.
+ */
+
+void RuleCursor :: add (const AddressTable & table, unsigned long address) {
+        const AddressTable :: Node * node = table.m_root;
+        for (unsigned long bit = 0 ; node != 0 ; ++ bit) {
+                if (node->m_head != 0)
+                        m_lists [m_count ++] = node->m_head;
+
+                if (bit == 32)
+                        break;
+
+                node = node->m_child [(address >> (31 - bit)) & 1];
+        }
+}
+
+/**
+ * Return the next candidate rule in rule order, or 0 once all the candidates
+ * have been exhausted.
+ */
+
+FilterRule * RuleCursor :: next () {
+        unsigned long   best = m_count;
+        for (unsigned long i = 0 ; i < m_count ; ++ i) {
+                if (m_lists [i] == 0)
+                        continue;
+
+                if (best == m_count ||
+                    m_lists [i]->m_order < m_lists [best]->m_order) {
+                        best = i;
+                }
+        }
+
+        if (best == m_count)
+                return 0;
+
+        const RuleEntry * entry = m_lists [best];
+        m_lists [best] = entry->m_next;
+        return entry->m_rule;
+}
+
+/**
+ * Build a new rule set snapshot from a list of freshly parsed rules, layered
+ * on top of an optional base set.
+ */
+
+RuleSet :: RuleSet (RuleSet * base, FilterRule * head) : m_refs (1),
+                m_base (base), m_head (head), m_count (0), m_order (0),
+                m_view (0), m_limit (0), m_needs (0), m_reordered (false) {
+        unsigned long   count = base != 0 ? base->m_count : 0;
+        FilterRule    * rule;
+        for (rule = head ; rule != 0 ; rule = rule->m_next)
+                ++ count;
+
+        m_order = (FilterRule **) malloc ((count + 1) * sizeof (FilterRule *));
+
+        if (base != 0) {
+                base->addRef ();
+
+                for (unsigned long i = 0 ; i < base->m_count ; ++ i)
+                        index (base->m_order [i]);
+        }
+
+        for (rule = head ; rule != 0 ; rule = rule->m_next)
+                index (rule);
+}
+
+/**
+ * Build a rule set snapshot which holds exactly the same rules as the base
+ * set, but in a new order; the order array is taken over by the new set.
+ *
+ * The base should be the set which owns the rules, rather than an earlier
+ * reordering of them, so that the orderings don't pile up one on another.
+ */
+
+RuleSet :: RuleSet (RuleSet * base, FilterRule ** order, unsigned long count) :
+                m_refs (1), m_base (base), m_head (0), m_count (0),
+                m_order (order), m_view (0), m_limit (0), m_needs (0),
+                m_reordered (true) {
+        base->addRef ();
+
+        for (unsigned long i = 0 ; i < count ; ++ i)
+                index (order [i]);
+}
+
+/**
+ * Destroy a rule set; only the rules actually parsed for this set belong to
+ * it, the rest belong to the base set, if any.
+ */
+
+RuleSet :: ~ RuleSet () {
+        m_ipRules.clear ();
+        m_ipNetworks.clear ();
+        m_dnsRules.clear ();
+        m_urlRules.clear ();
+
+        FilterRules :: freeRules (m_head);
+        free (m_order);
+
+        if (m_view != 0)
+                UnmapViewOfFile (m_view);
+
+        if (m_base != 0)
+                m_base->release ();
+}
+
+/**
+ * Add a rule to our index tables; rules have to be added in rule order.
+ */
+
+void RuleSet :: index (FilterRule * rule) {
+        if (m_order == 0)
+                return;
+
+        unsigned long   order = m_count ++;
+        m_order [order] = rule;
+
+        /*
+         * A global limit doesn't match anything, it just applies everywhere;
+         * the last one in rule order wins.
+         */
+
+        if (rule->m_global) {
+                m_limit = rule->m_limit;
+                m_needs |= FilterRules :: NEED_READ;
+                return;
+        }
+
+        /*
+         * Limits and the statistics for choosing between targets both depend
+         * on seeing the data arrive.
+         */
+
+        if (rule->m_limit != 0 || rule->m_targets > 1)
+                m_needs |= FilterRules :: NEED_READ;
+
+        if (rule->m_numeric) {
+                m_ipNetworks.add (rule, order);
+        } else if (rule->m_hasPort) {
+                m_ipRules.add (rule, order);
+        } else
+                m_dnsRules.add (rule, order);
+
+        /*
+         * Lookups by URL or host have always considered every rule, not just
+         * the ones written with a leading '/', so the URL table needs to hold
+         * anything that could match.
+         */
+
+        if (m_urlRules.add (rule, order, true))
+                m_needs |= FilterRules :: NEED_SEND;
+}
+
+/**
+ * Simple reference counting for rule sets.
+ */
+
+void RuleSet :: addRef () {
+        InterlockedIncrement (& m_refs);
+}
+
+void RuleSet :: release () {
+        if (InterlockedDecrement (& m_refs) == 0)
+                delete this;
+}
+
+/**
+ * Epoch counter for rule readers.
+ *
+ * Readers register with their thread's counter for the current epoch, and when
+ * a new set of rules is published the epoch is advanced; once every thread's
+ * counter for the previous epoch is clear, nothing can still be looking at the
+ * old rules. This keeps the cost for readers down to a pair of interlocked
+ * operations on a cache line of their own, with no lock, and pushes all the
+ * waiting onto the (rare) writers.
+ */
+
+static volatile LONG    l_epoch;
+
+/**
+ * Enter a reader section.
+ */
+
+RuleGuard :: RuleGuard () {
+        volatile LONG * counts = g_readerSlot ();
+
+        for (;;) {
+                LONG            epoch = l_epoch;
+                m_count = counts + READER_RULES + (epoch & 1);
+
+                InterlockedIncrement (m_count);
+                if (l_epoch == epoch)
+                        break;
+
+                /*
+                 * A writer advanced the epoch between our reading it and
+                 * registering, so that writer might not see us; try again.
+                 */
+
+                InterlockedDecrement (m_count);
+        }
+}
+
+/**
+ * Leave a reader section.
+ */
+
+RuleGuard :: ~ RuleGuard () {
+        InterlockedDecrement (m_count);
+}
+
+/**
+ * Lock for serializing changes to the rules; since the rules themselves are
+ * immutable snapshots, lookups don't need to take this.
+ */
+
+CRITICAL_SECTION        l_filterLock [1];
+
+/**
+ * Initialise function pointers to the Winsock address-info functions.
+ */
+
+static bool l_initFuncs (void) {
+        if (g_addrFunc != 0 && g_freeFunc != 0)
+                return true;
+
+        InitializeCriticalSection (l_filterLock);
+
+        HMODULE         ws2 = GetModuleHandle (L"WS2_32.DLL");
+        if (ws2 == 0)
+                return false;
+
+        g_addrFunc = (GetAddrInfoWFunc) GetProcAddress (ws2, "GetAddrInfoW");
+        g_freeFunc = (FreeAddrInfoWFunc) GetProcAddress (ws2, "FreeAddrInfoW");
+
+        return g_addrFunc != 0 && g_freeFunc != 0;
+}
+
+/**
+ * Direct the lookups for rule targets to a specific GetAddrInfoW () entry.
+ *
+ * Once the filter has hooked the resolver functions the targets named in the
+ * rules have to bypass that hook, or else they would be subject to the DNS
+ * rules themselves; the filter passes in the entry point which goes straight
+ * on to the original system function.
+ */
+
+/* static */
+void FilterRules :: resolver (void * addrFunc) {
+        if (! l_initFuncs () || addrFunc == 0)
+                return;
+
+        g_addrFunc = (GetAddrInfoWFunc) addrFunc;
+}
+
+/**
+ * Say what to call with the name of each replacement document in the rules,
+ * as they are parsed or loaded from an image.
+ *
+ * Rendering a document means a trip to the registry, which the filter would
+ * rather make while the rules are going in than while Steam is waiting on the
+ * response; compiling rules in the monitor has no use for this, and leaves it
+ * unset.
+ */
+
+/* static */
+void FilterRules :: preload (RulePreloadFunc func) {
+        g_preloadFunc = func;
+}
+
+/**
+ * Simple constructor for the rule list.
+ */
+
+FilterRules :: FilterRules (unsigned short defaultPort) :
+                m_current (0), m_pending (0), m_defaultPort (defaultPort) {
+}
+
+/**
+ * Simple destructor for the rule list.
+ */
+
+FilterRules :: ~ FilterRules () {
+        if (m_current != 0)
+                m_current->release ();
+
+        free (m_pending);
+}
+
+/**
+ * Parse a new filter specification.
+ *
+ * The filter specification is roughly like this:
+ *      rules   ::== <rule> (';' <rule>)*
  *
  * If I want to make it possible to support multi-line filter rules, then I
  * have a difficult decision with respect to how to treat newlines. I can treat
@@ -822,86 +2468,305 @@ bool FilterRules :: parse (const wchar_t * from, const wchar_t * to,
                         return false;
                 }
 
-                /*
-                 * If no port was specified and there's no pattern (which is in
-                 * essence a wildcard), use the default port.
-                 *
-                 * This helps grandfather in a simple IP-only specification for
-                 * what to redirect to in cases where the port is implied.
-                 */
-
-                if (! temp->m_hasPort && temp->m_pattern == 0) {
-                        temp->m_hasPort = true;
-                        temp->m_port = m_defaultPort;
-                }
+                /*
+                 * If no port was specified and there's no pattern (which is in
+                 * essence a wildcard), use the default port.
+                 *
+                 * This helps grandfather in a simple IP-only specification for
+                 * what to redirect to in cases where the port is implied.
+                 */
+
+                if (! temp->m_hasPort && temp->m_pattern == 0) {
+                        temp->m_hasPort = true;
+                        temp->m_port = m_defaultPort;
+                }
+
+                from = next;
+                to = nextTo;
+        }
+
+        return true;
+}
+
+/**
+ * Free a list of filter rules.
+ */
+
+/* static */
+void FilterRules :: freeRules (FilterRule * head) {
+        while (head != 0) {
+                FilterRule    * next = head->m_next;
+                delete head;
+                head = next;
+        }
+}
+
+/**
+ * Publish a new rule set in place of the current one, with the lock held.
+ *
+ * The old rules may still be in use by other threads, so once the new set has
+ * been swapped in, advance the reader epoch and wait for everyone who might
+ * have picked up the old set to be done with before releasing it.
+ */
+
+void FilterRules :: publish (RuleSet * rules) {
+        void * volatile * slot = (void * volatile *) & m_current;
+        RuleSet       * old;
+        old = (RuleSet *) InterlockedExchangePointer (slot, rules);
+        if (old == 0)
+                return;
+
+        LONG            epoch = InterlockedIncrement (& l_epoch) - 1;
+        g_waitReaders ((ReaderKind) (READER_RULES + (epoch & 1)), INFINITE);
+
+        old->release ();
+}
+
+/**
+ * Bring in any rules whose parsing had to be deferred, with the lock held.
+ *
+ * Rules are only ever deferred when the Winsock functions aren't available,
+ * and in that case no rule set can have been published yet.
+ */
+
+void FilterRules :: parsePending () {
+        wchar_t       * pending = m_pending;
+        if (pending == 0)
+                return;
+
+        m_pending = 0;
+
+        FilterRule    * head = 0;
+        FilterRule    * tail = 0;
+        if (parse (pending, 0, head, tail))
+                publish (new RuleSet (m_current, head));
+
+        free (pending);
+}
+
+/**
+ * Replace the current rule set entirely with a new one.
+ *
+ * Any deferred rules are superseded by the new ones.
+ */
+
+void FilterRules :: replace (RuleSet * rules) {
+        EnterCriticalSection (l_filterLock);
+
+        wchar_t       * pending = m_pending;
+        m_pending = 0;
+
+        publish (rules);
+
+        LeaveCriticalSection (l_filterLock);
+
+        free (pending);
+}
+
+/**
+ * Pick up the current rule set for a lookup, inside a reader section.
+ *
+ * If there is a pending set of rules from before Winsock loaded, try and parse
+ * them now; but since we are inside a reader section, don't wait on the lock
+ * if a writer holds it, since the writer could be waiting for us.
+ */
+
+RuleSet * FilterRules :: current () {
+        RuleSet       * rules = m_current;
+        if (rules != 0 || m_pending == 0)
+                return rules;
+
+        if (! TryEnterCriticalSection (l_filterLock))
+                return 0;
+
+        parsePending ();
+        rules = m_current;
+
+        LeaveCriticalSection (l_filterLock);
+        return rules;
+}
+
+/**
+ * Create a fresh set of filter rules from a spec string.
+ *
+ * Any extra rules given go on the end of the new set, in the same snapshot;
+ * that way there's never a moment where the new rules are in place without
+ * them, as there would be if they were appended afterwards.
+ */
+
+/* static */
+bool FilterRules :: install (const wchar_t * specs, const wchar_t * extra) {
+        if (! l_initFuncs ()) {
+                /*
+                 * If we get here before the DLLs have loaded, save the specs.
+                 * When called to do a match, the DLLs will be present and we
+                 * can do a deferred init.
+                 *
+                 * Obviously this means we can't report some errors properly,
+                 * but it's a reasonable trade-off.
+                 */
+
+                if (specs != 0 || extra != 0) {
+                        free (m_pending);
+                        m_pending = FilterRule :: wcscatdup (specs, L";",
+                                                             extra);
+                }
+                return true;
+        }
+
+        FilterRule    * head = 0;
+        FilterRule    * tail = 0;
+
+        if (specs != 0 && ! parse (specs, 0, head, tail))
+                return false;
+        if (extra != 0 && ! parse (extra, 0, head, tail))
+                return false;
+
+        /*
+         * Build the new snapshot and its index tables before taking the lock.
+         */
+
+        replace (new RuleSet (0, head));
+        return true;
+}
+
+/**
+ * Create a fresh set of filter rules from a compiled rule image.
+ *
+ * The image has to have been compiled from exactly the rule text given, which
+ * is checked against the hash in the image; if it all checks out, the new rule
+ * set takes over the image (which must be a mapped view of a section, since
+ * it will be unmapped when the rules are done with) and this returns true.
+ * Otherwise, the caller still owns the image and can fall back to parsing the
+ * rule text itself.
+ *
+ * As with installing from text, any extra rules are parsed onto the end.
+ */
+
+bool FilterRules :: install (const void * image, unsigned long size,
+                             const wchar_t * specs, const wchar_t * extra) {
+        if (image == 0 || specs == 0 || size < sizeof (ImageHeader) ||
+            ! l_initFuncs ()) {
+                return false;
+        }
+
+        const ImageHeader * header = (const ImageHeader *) image;
+        unsigned long   length;
+        unsigned long   hash = l_hashText (specs, length);
+
+        if (header->m_magic != IMAGE_MAGIC ||
+            header->m_version != IMAGE_VERSION ||
+            header->m_size > size || header->m_hash != hash ||
+            header->m_length != length) {
+                return false;
+        }
+
+        FilterRule    * head = 0;
+        FilterRule    * tail = 0;
+        unsigned long   offset = sizeof (ImageHeader);
+
+        for (unsigned long i = 0 ; i < header->m_count ; ++ i) {
+                FilterRule    * temp = new FilterRule;
+                if (tail != 0) {
+                        tail->m_next = temp;
+                } else
+                        head = temp;
+                tail = temp;
+
+                if (! temp->load ((const unsigned char *) image,
+                                  header->m_size, offset)) {
+                        freeRules (head);
+                        return false;
+                }
+        }
+
+        if (extra != 0 && ! parse (extra, 0, head, tail))
+                return false;
 
-                from = next;
-                to = nextTo;
-        }
+        RuleSet       * rules = new RuleSet (0, head);
+        rules->m_view = image;
 
+        replace (rules);
         return true;
 }
 
 /**
- * Free a list of filter rules.
+ * Compile a rule specification into a rule image.
+ *
+ * This does all the work of parsing the rules, including resolving the names
+ * of any replacement targets, and returns the resulting image in memory from
+ * malloc () along with its size.
  */
 
-/* static */
-void FilterRules :: freeRules (FilterRule * head) {
-        while (head != 0) {
-                FilterRule    * next = head->m_next;
-                delete head;
-                head = next;
-        }
-}
+void * FilterRules :: compile (const wchar_t * specs, unsigned long & size) {
+        size = 0;
+        if (specs == 0 || ! l_initFuncs ())
+                return 0;
 
-/**
- * Create a fresh set of filter rules from a spec string.
- */
+        FilterRule    * head = 0;
+        FilterRule    * tail = 0;
+        if (! parse (specs, 0, head, tail))
+                return 0;
 
-/* static */
-bool FilterRules :: install (const wchar_t * specs) {
-        if (! l_initFuncs ()) {
-                /*
-                 * If we get here before the DLLs have loaded, save the specs.
-                 * When called to do a match, the DLLs will be present and we
-                 * can do a deferred init.
-                 *
-                 * Obviously this means we can't report some errors properly,
-                 * but it's a reasonable trade-off.
-                 */
+        /*
+         * Measure everything up first, so the image is one allocation.
+         */
 
-                if (specs != 0)
-                        m_pending = wcsdup (specs);
-                return true;
+        unsigned long   total = sizeof (ImageHeader);
+        unsigned long   count = 0;
+        FilterRule    * rule;
+        for (rule = head ; rule != 0 ; rule = rule->m_next, ++ count)
+                total += rule->imageSize ();
+
+        unsigned char * image = (unsigned char *) malloc (total);
+        if (image == 0) {
+                freeRules (head);
+                return 0;
         }
 
-        FilterRule    * head = 0;
-        FilterRule    * tail = 0;
+        memset (image, 0, total);
 
-        if (specs != 0 && ! parse (specs, 0, head, tail))
-                return false;
+        ImageHeader   * header = (ImageHeader *) image;
+        header->m_magic = IMAGE_MAGIC;
+        header->m_version = IMAGE_VERSION;
+        header->m_size = total;
+        header->m_hash = l_hashText (specs, header->m_length);
+        header->m_count = count;
 
-        EnterCriticalSection (l_filterLock);
+        unsigned long   offset = sizeof (ImageHeader);
+        for (rule = head ; rule != 0 ; rule = rule->m_next) {
+                rule->save (image, offset);
+                offset += rule->imageSize ();
+        }
 
-        FilterRule    * temp = m_head;
-        m_head = head;
-        m_tail = tail;
+        freeRules (head);
 
-        LeaveCriticalSection (l_filterLock);
+        size = total;
+        return image;
+}
 
-        /*
-         * Strictly speaking, this is bad since a piece of matched rule data
-         * can have escaped from a match () function in a thread. Delaying
-         * the actual free for one round would help with that.
-         */
+/**
+ * Form the name of the shared memory section used to pass a rule image for
+ * the given rule text to the filter in the given process.
+ *
+ * The destination must have room for IMAGE_NAME characters.
+ */
 
-        freeRules (temp);
-        return true;
+/* static */
+void FilterRules :: imageName (wchar_t * dest, unsigned long processId,
+                               const wchar_t * specs) {
+        unsigned long   length;
+        unsigned long   hash = l_hashText (specs, length);
+
+        wsprintfW (dest, L"Local\\SteamLimitRules.%lx.%lx.%lx", processId,
+                   hash, length);
 }
 
 /**
  * Add additional rules to an existing set.
+ *
+ * This builds a new snapshot which shares the existing rules, rather than
+ * modifying the current snapshot in place.
  */
 
 /* static */
@@ -916,14 +2781,15 @@ bool FilterRules :: append (const wchar_t * specs) {
 
         EnterCriticalSection (l_filterLock);
 
-        if (m_pending != 0) {
-                parse (m_pending, 0, m_head, m_tail);
-                free (m_pending);
-                m_pending = 0;
-        }
+        parsePending ();
+
+        FilterRule    * head = 0;
+        FilterRule    * tail = 0;
 
         bool            result;
-        result = parse (specs, 0, m_head, m_tail);
+        result = parse (specs, 0, head, tail);
+        if (result && head != 0)
+                publish (new RuleSet (m_current, head));
 
         LeaveCriticalSection (l_filterLock);
         return result;
@@ -942,58 +2808,78 @@ bool FilterRules :: append (const wchar_t * specs) {
 /**
  * Match the filter rules against an address.
  *
- * Since the main spec strings used to match rules are glob patterns, the IPv4
- * address is quickly rendered as text for matching.
+ * Rules written as numeric addresses or networks are matched directly against
+ * the address; for any glob-pattern rules, the IPv4 address is quickly
+ * rendered as text for matching, but only if there are any such rules.
  */
 
 bool FilterRules :: matchIp (const sockaddr_in * name, void * module,
-                             sockaddr_in ** replace) {
+                             sockaddr_in ** replace, TargetStats ** target,
+                             RateLimit ** limit, RaceTargets * race) {
         if (! l_initFuncs ())
                 return false;
 
         unsigned short  port = ntohs (name->sin_port);
-        char            example [80];
-        char          * temp = example;
+        const unsigned char * bytes = & name->sin_addr.S_un.S_un_b.s_b1;
+        unsigned long   address = ((unsigned long) bytes [0] << 24) |
+                                  ((unsigned long) bytes [1] << 16) |
+                                  ((unsigned long) bytes [2] << 8) |
+                                  bytes [3];
+
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return false;
 
-        if (module != 0) {
-                size_t          len;
-                len = GetModuleFileNameA ((HMODULE) module, temp,
-                                          sizeof (example));
-                temp += len;
-                * temp ++ = '!';
-        }
+        RuleCursor      cursor;
+        cursor.add (rules->m_ipNetworks, address);
+
+        char            example [80];
+        if (! rules->m_ipRules.empty ()) {
+                char          * temp = example;
+
+                if (module != 0) {
+                        size_t          len;
+                        len = GetModuleFileNameA ((HMODULE) module, temp,
+                                                  sizeof (example));
+                        temp += len;
+                        * temp ++ = '!';
+                }
 
-        wsprintfA (temp, "%d.%d.%d.%d:%d",
-                   name->sin_addr.S_un.S_un_b.s_b1,
-                   name->sin_addr.S_un.S_un_b.s_b2,
-                   name->sin_addr.S_un.S_un_b.s_b3,
-                   name->sin_addr.S_un.S_un_b.s_b4,
-                   port);
+                wsprintfA (temp, "%d.%d.%d.%d:%d",
+                           bytes [0], bytes [1], bytes [2], bytes [3], port);
 
 #if     0
-        /*
-         * There are more debug tell-tales elsewhere now, and since I'm not
-         * doing any debug on the rule system itself at present this creates
-         * noise in the rest of the debug logging (which I'm cleaning up for
-         * field debug purposes for v0.5.5).
-         */
+                /*
+                 * There are more debug tell-tales elsewhere now, and since I'm
+                 * not doing any debug on the rule system itself at present
+                 * this creates noise in the rest of the debug logging (which
+                 * I'm cleaning up for field debug purposes for v0.5.5).
+                 */
 
-        OutputDebugStringA (example);
+                OutputDebugStringA (example);
 #endif
 
-        EnterCriticalSection (l_filterLock);
-
-        if (m_pending != 0) {
-                parse (m_pending, 0, m_head, m_tail);
-                free (m_pending);
-                m_pending = 0;
+                cursor.add (rules->m_ipRules, example);
         }
 
-        FilterRule    * test = m_head;
+        FilterRule    * test;
         addrinfo      * out = 0;
-        for (; test != 0 ; test = test->m_next) {
-                if (! test->m_hasPort)
+        while ((test = cursor.next ()) != 0) {
+                if (test->m_numeric) {
+                        /*
+                         * A plain address rule in text form would not match
+                         * once the module name is glued on the front.
+                         */
+
+                        if (module != 0 && test->m_anchored)
+                                continue;
+
+                        if (test->match (address, port, & out))
+                                break;
+
                         continue;
+                }
 
                 if (test->m_port != 0 && test->m_port != port)
                         continue;
@@ -1002,49 +2888,94 @@ bool FilterRules :: matchIp (const sockaddr_in * name, void * module,
                         break;
         }
 
-        LeaveCriticalSection (l_filterLock);
-
         if (out != 0) {
                 * replace = (sockaddr_in *) out->ai_addr;
         } else
                 * replace = 0;
 
+        /*
+         * If the rule chose between several targets, hand back the statistics
+         * for the chosen one so the caller can report how the connection goes;
+         * the caller gets a reference, since the connection can outlive the
+         * rules.
+         */
+
+        if (target != 0) {
+                * target = 0;
+
+                TargetStats   * stats;
+                if (out != 0 && test->m_targets > 1 &&
+                    (stats = FilterRule :: stats (out))->m_adaptive) {
+                        stats->addRef ();
+                        * target = stats;
+                }
+        }
+
+        /*
+         * Likewise for any rate limit the rule puts on its connections.
+         */
+
+        if (limit != 0) {
+                * limit = 0;
+
+                if (out != 0 && test->m_limit != 0) {
+                        test->m_limit->addRef ();
+                        * limit = test->m_limit;
+                }
+        }
+
+        /*
+         * And if the rule races its targets, hand back the candidates for the
+         * race; there's no race to run if the chosen target is a block.
+         */
+
+        if (race != 0) {
+                race->m_count = 0;
+
+                if (out != 0 && test->m_race && test->m_targets > 1 &&
+                    ((sockaddr_in *) out->ai_addr)->sin_addr.S_un.S_addr !=
+                            INADDR_NONE) {
+                        test->candidates (out, * race);
+                }
+        }
+
         return test != 0;
 }
 
 /**
  * Match the filter rules against a DNS name, returning an IP.
+ *
+ * If the caller wants them, the addresses of all the rule's usable targets can
+ * be copied out as well, ready for the caller to hand over as a whole answer;
+ * on the way in the count says how much room there is for them.
  */
 
-bool FilterRules :: matchDns (const char * name, sockaddr_in ** replace) {
+bool FilterRules :: matchDns (const char * name, sockaddr_in ** replace,
+                              unsigned long * addrs, unsigned long * count) {
         if (! l_initFuncs ())
                 return false;
 
-        EnterCriticalSection (l_filterLock);
-
-        if (m_pending != 0) {
-                parse (m_pending, 0, m_head, m_tail);
-                free (m_pending);
-                m_pending = 0;
-        }
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return false;
 
-        FilterRule    * test = m_head;
+        RuleCursor      cursor (rules->m_dnsRules, name);
+        FilterRule    * test;
         addrinfo      * out = 0;
-        for (; test != 0 ; test = test->m_next) {
-                if (test->m_hasPort)
-                        continue;
-
+        while ((test = cursor.next ()) != 0) {
                 if (test->match (name, & out))
                         break;
         }
 
-        LeaveCriticalSection (l_filterLock);
-
         if (out != 0) {
                 * replace = (sockaddr_in *) out->ai_addr;
         } else
                 * replace = 0;
 
+        if (count != 0)
+                * count = out != 0 ? test->failover (out, addrs, * count) : 0;
+
         return test != 0;
 }
 
@@ -1059,31 +2990,26 @@ bool FilterRules :: matchUrl (const char * name, const char ** replace) {
         if (! l_initFuncs ())
                 return false;
 
-        EnterCriticalSection (l_filterLock);
-
-        if (m_pending != 0) {
-                parse (m_pending, 0, m_head, m_tail);
-                free (m_pending);
-                m_pending = 0;
-        }
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return false;
 
-        FilterRule    * test = m_head;
-        for (; test != 0 ; test = test->m_next) {
+        RuleCursor      cursor (rules->m_urlRules, name);
+        FilterRule    * test;
+        while ((test = cursor.next ()) != 0) {
                 if (test->match (name, replace, SLASH_MAYBE))
                         break;
         }
 
-        LeaveCriticalSection (l_filterLock);
-
         return test != 0;
 }
 
 /**
  * Match a host name and return a suitable replacement string.
  *
- * For now I make this the same as matchUrl () since I'm not keeping all the
- * rule types in separate lists (since the total size of the rulebase is just
- * not large enough to warrant it).
+ * This is the same as matchUrl (), since host rules are written with a '//'
+ * prefix and so live in the same table as the URL rules.
  *
  * Note that the expectation here is that the incoming name will have '//' as
  * a sigil at the front to distinguish it lexically from a URL.
@@ -1096,4 +3022,318 @@ bool FilterRules :: matchHost (const char * name, const char ** replace) {
         return matchUrl (name, replace);
 }
 
+/**
+ * Match the host and URL of an HTTP request, given the lengths the request
+ * scanner found for the verb, the URL and the host: header.
+ *
+ * This is all the rule matching the send hook does for a request, so that
+ * the bench can run exactly the same work; what to do about the result is up
+ * to the caller. If the request is not one to filter at all, the result is
+ * false.
+ */
+
+bool FilterRules :: matchRequest (const char * buf, size_t verb, size_t url,
+                                  const char * host, size_t hostLength,
+                                  RequestMatch & match) {
+        match.m_matchHost = false;
+        match.m_matchUrl = false;
+        match.m_matchPair = false;
+        match.m_newHost = 0;
+        match.m_replace = 0;
+        match.m_hostPart = 0;
+
+        if (verb == 0 || url == 0)
+                return false;
+
+        /*
+         * If the requested URL is excessively large, truncate it (it gets big
+         * because of useless query parameters Valve attach for debug/tracking,
+         * that don't factor into what we care about).
+         */
+
+        char          * dest = match.m_temp;
+        size_t          avail = sizeof (match.m_temp);
+
+        if (url + hostLength + 3 > avail) {
+                if (hostLength + 3 > avail)
+                        return false;
+
+                url = avail - hostLength - 3;
+        }
+
+        match.m_url = url;
+
+        memcpy (dest, buf, verb);
+        dest += verb;
+
+        if (hostLength > 0) {
+                /*
+                 * Extract a copy of the host name, originally for the purpose
+                 * of just printing it but now for matching it as well, using
+                 * the '//' sigil at the front of the pattern (similar to how
+                 * the URL patterns use a '/' sigil).
+                 */
+
+                match.m_hostPart = dest;
+                dest [1] = dest [0] = '/';
+                memcpy (dest + 2, host, hostLength - 2);
+                dest [hostLength] = 0;
+
+                match.m_matchHost = matchHost (dest, & match.m_newHost);
+
+                /*
+                 * Now format the temp copy for printing and having the request
+                 * URL glued to it.
+                 */
+
+                dest += hostLength;
+        }
+
+        match.m_urlPart = dest;
+        memcpy (dest, buf + verb, url - verb);
+        dest += url - verb;
+
+        * dest = 0;
+        match.m_end = dest;
+
+        /*
+         * A host rule that blocks the request settles it without the URL.
+         */
+
+        const char    * newHost = match.m_newHost;
+        if (match.m_matchHost && (newHost == 0 || * newHost == 0))
+                return true;
+
+        match.m_matchUrl = matchUrl (match.m_urlPart, & match.m_replace);
+        if (match.m_matchUrl || match.m_matchHost || match.m_hostPart == 0)
+                return true;
+
+        /*
+         * As a final attempt to decide, the host+URL can be matched as a pair;
+         * this lets a pattern which matches the prefix of the URL act as a
+         * catch-all for certain URLs that applies if and only if it hasn't
+         * been permitted by an earlier positive match.
+         */
+
+        match.m_matchPair = matchHost (match.m_hostPart, & match.m_newHost);
+        return true;
+}
+
+/**
+ * Find the global rate limit for the current rules, if there is one; the
+ * caller gets a reference, since the rules can change while it's in use.
+ */
+
+RateLimit * FilterRules :: rateLimit () {
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0 || rules->m_limit == 0)
+                return 0;
+
+        rules->m_limit->addRef ();
+        return rules->m_limit;
+}
+
+/**
+ * Say which kinds of traffic the current rules need to see, so the filter can
+ * leave out the hooks for the rest.
+ */
+
+unsigned long FilterRules :: needs () {
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        return rules != 0 ? rules->m_needs : 0;
+}
+
+/**
+ * Report the statistics for each rule, in the current rule order.
+ *
+ * The cost column is the average time for a test of the rule in nanoseconds,
+ * taken from the sampled tests; the counts are only approximate while lookups
+ * are still going on, since nothing here stops the hooks from counting.
+ */
+
+void FilterRules :: report (RuleReportFunc func, void * context) {
+        LARGE_INTEGER   frequency;
+        if (! QueryPerformanceFrequency (& frequency) ||
+            frequency.QuadPart == 0) {
+                frequency.QuadPart = 1;
+        }
+
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return;
+
+        char            line [320];
+        (* func) (context, "rule      tests       hits  cost  pattern\r\n");
+
+        for (unsigned long i = 0 ; i < rules->m_count ; ++ i) {
+                FilterRule    * rule = rules->m_order [i];
+
+                LONGLONG        ticks;
+                ticks = _InterlockedCompareExchange64 (& rule->m_ticks, 0, 0);
+
+                unsigned long   samples = rule->m_samples;
+                unsigned long   cost = 0;
+                if (samples > 0)
+                        cost = (unsigned long) (ticks * 1000000 /
+                                                frequency.QuadPart * 1000 /
+                                                samples);
+
+                const wchar_t * pattern = rule->m_pattern;
+                wsprintfA (line, "%4lu %10lu %10lu %5lu  %.200ls\r\n", i,
+                           (unsigned long) rule->m_tests,
+                           (unsigned long) rule->m_hits, cost,
+                           pattern != 0 ? pattern : L"(any)");
+
+                (* func) (context, line);
+
+                if (rule->m_limit != 0) {
+                        wsprintfA (line, "     %s limit %luKB/s\r\n",
+                                   rule->m_global ? "global" : "rate",
+                                   rule->m_limit->rate () / 1024);
+
+                        (* func) (context, line);
+                }
+
+                if (rule->m_targets < 2)
+                        continue;
+
+                if (rule->m_race) {
+                        wsprintfA (line, "     race %lums apart\r\n",
+                                   (unsigned long) rule->m_stagger);
+
+                        (* func) (context, line);
+                }
+
+                /*
+                 * For rules which choose between targets, show how each of the
+                 * targets is doing as well.
+                 */
+
+                addrinfo      * info = rule->m_replace;
+                for (; info != 0 ; info = info->ai_next) {
+                        TargetStats   * stats = FilterRule :: stats (info);
+                        sockaddr_in   * addr = (sockaddr_in *) info->ai_addr;
+                        unsigned char * bytes;
+                        bytes = & addr->sin_addr.S_un.S_un_b.s_b1;
+
+                        wsprintfA (line, "     -> %d.%d.%d.%d:%d connects %ld"
+                                   " failures %ld active %ld %ldms %ldB/s\r\n",
+                                   bytes [0], bytes [1], bytes [2], bytes [3],
+                                   ntohs (addr->sin_port), stats->m_connects,
+                                   stats->m_failures, stats->m_active,
+                                   stats->m_latency, stats->m_rate);
+
+                        (* func) (context, line);
+                }
+        }
+}
+
+/**
+ * Copy out the hit counts for the current rules, in rule order, returning how
+ * many rules there are (which can be more than there was room to copy).
+ */
+
+unsigned long FilterRules :: hitCounts (volatile LONG * dest,
+                                        unsigned long count) {
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return 0;
+
+        for (unsigned long i = 0 ; i < rules->m_count && i < count ; ++ i)
+                dest [i] = rules->m_order [i]->m_hits;
+
+        return rules->m_count;
+}
+
+/**
+ * Clear the statistics for all the current rules.
+ */
+
+void FilterRules :: resetStats () {
+        RuleGuard       guard;
+        RuleSet       * rules = current ();
+        if (rules == 0)
+                return;
+
+        for (unsigned long i = 0 ; i < rules->m_count ; ++ i) {
+                FilterRule    * rule = rules->m_order [i];
+
+                InterlockedExchange (& rule->m_tests, 0);
+                InterlockedExchange (& rule->m_hits, 0);
+                InterlockedExchange (& rule->m_samples, 0);
+                InterlockedExchange64 (& rule->m_ticks, 0);
+        }
+}
+
+/**
+ * Move the busiest rules towards the front of the rule list.
+ *
+ * Since the first rule to match is the one that applies, a rule can only be
+ * moved ahead of another when the two can never both match the same thing;
+ * so this is an insertion sort by hit count where a rule stops moving as soon
+ * as it meets one it might overlap with. Each step just swaps a pair of
+ * independent neighbours, so the rules still give exactly the same answers.
+ *
+ * The new order is published as a new snapshot sharing the same rules, so as
+ * with appending rules this mustn't be called inside a reader section. If the
+ * current snapshot is itself only a reordering it owns none of the rules, so
+ * the new one is built on the snapshot which does; the superseded ordering is
+ * then let go along with the rest of the old snapshot, rather than being kept
+ * alive as the base of the new one.
+ */
+
+bool FilterRules :: reorder () {
+        if (! l_initFuncs ())
+                return false;
+
+        EnterCriticalSection (l_filterLock);
+
+        parsePending ();
+
+        RuleSet       * rules = m_current;
+        unsigned long   count = rules != 0 ? rules->m_count : 0;
+        FilterRule   ** order = 0;
+        bool            moved = false;
+
+        RuleSet       * owner = rules;
+        while (owner != 0 && owner->m_reordered)
+                owner = owner->m_base;
+
+        if (count > 1)
+                order = (FilterRule **) malloc (count * sizeof (FilterRule *));
+
+        if (order != 0) {
+                memcpy (order, rules->m_order, count * sizeof (FilterRule *));
+
+                for (unsigned long i = 1 ; i < count ; ++ i) {
+                        for (unsigned long j = i ; j > 0 ; -- j) {
+                                FilterRule    * hot = order [j];
+                                FilterRule    * cold = order [j - 1];
+
+                                if ((unsigned long) hot->m_hits <=
+                                    (unsigned long) cold->m_hits ||
+                                    ! hot->disjoint (cold)) {
+                                        break;
+                                }
+
+                                order [j - 1] = hot;
+                                order [j] = cold;
+                                moved = true;
+                        }
+                }
+
+                if (moved) {
+                        publish (new RuleSet (owner, order, count));
+                } else
+                        free (order);
+        }
+
+        LeaveCriticalSection (l_filterLock);
+        return moved;
+}
+
 /**@}*/
@@ -62,7 +62,14 @@
 
 struct addrinfo;
 struct sockaddr_in;
+class GlobMatcher;
+class TargetStats;
+class RateLimit;
 class FilterRules;
+class RuleTable;
+struct RaceTargets;
+class AddressTable;
+struct RuleEntry;
 
 /**
  * Data structure representing parsed filters.
@@ -75,20 +82,58 @@ class FilterRules;
  *
  * Another concept here is that I can not only replace the target IP, but the
  * port as well, and multiple rewrite targets are rotated around.
+ *
+ * Connection rules which are written as plain addresses or CIDR blocks, with
+ * a port or port range, are also decoded into numeric form so they can be
+ * matched without rendering the address as text at all.
+ *
+ * Each rule also keeps a count of how often it has been tested and how often
+ * it matched, and the cost of a sample of those tests, so that it's possible
+ * to see which rules are doing the work (and which are just costing time).
+ *
+ * Rules can also be saved into, and loaded from, a compiled rule image; rules
+ * loaded that way borrow their pattern text and compiled glob straight from
+ * the image rather than having their own copies.
+ *
+ * A connection rule can also carry a receive rate limit, shared by all the
+ * connections it matches; and a term which is just a rate limit on its own
+ * sets the limit for everything the filter sees, rather than being a rule
+ * which matches anything.
  */
 
 class FilterRule {
         friend class FilterRules;
+        friend class RuleTable;
+        friend class AddressTable;
+        friend class RuleSet;
+        friend class RuleSample;
 
 private:
         wchar_t       * m_pattern;
+        GlobMatcher   * m_glob;
         bool            m_hasPort;
         unsigned short  m_port;
+        bool            m_numeric;
+        bool            m_anchored;
+        unsigned short  m_portHigh;
+        unsigned char   m_prefixLength;
+        unsigned long   m_network;
         char          * m_rewrite;
         addrinfo      * m_replace;
-        addrinfo      * m_nextReplace;
+        addrinfo      * volatile m_nextReplace;
+        unsigned short  m_targets;
+        RateLimit     * m_limit;
+        bool            m_global;
+        bool            m_race;
+        unsigned short  m_stagger;
+        bool            m_borrowed;
         FilterRule    * m_next;
 
+        volatile LONG   m_tests;
+        volatile LONG   m_hits;
+        volatile LONG   m_samples;
+        volatile LONGLONG m_ticks;
+
 static  const wchar_t * lookahead (const wchar_t * from, const wchar_t * to,
                                    wchar_t ch);
 static  wchar_t       * unescape (wchar_t * dest, size_t length,
@@ -97,6 +142,12 @@ static  wchar_t       * wcsdup (const wchar_t * from, const wchar_t * to);
 static  wchar_t       * wcscatdup (const wchar_t * left, const wchar_t * middle,
                                    const wchar_t * right);
 static  char          * urldup (const wchar_t * from, const wchar_t * to);
+static  const wchar_t * number (const wchar_t * from, const wchar_t * to,
+                                unsigned long limit, unsigned long & value);
+static  bool            diverge (const wchar_t * left, const wchar_t * right,
+                                 bool reverse);
+static  TargetStats   * stats (addrinfo * info);
+static  addrinfo      * newTarget (addrinfo * next);
 
         void            freeInfo (addrinfo * info);
 
@@ -104,7 +155,24 @@ static  char          * urldup (const wchar_t * from, const wchar_t * to);
                                  unsigned short & port);
         bool            parseReplace (const wchar_t * from, const wchar_t * to,
                                       addrinfo * & link);
+        bool            parseNetwork (const wchar_t * from, const wchar_t * to);
+        bool            parseRate (const wchar_t * from, const wchar_t * to);
+        bool            parseRace (const wchar_t * from, const wchar_t * to);
         bool            parseRule (const wchar_t * from, const wchar_t * to);
+        bool            matchPattern (const char * example, int slashMode);
+        void            select (addrinfo ** replace);
+        void            candidates (addrinfo * first, RaceTargets & race);
+        unsigned long   failover (addrinfo * first, unsigned long * addrs,
+                                  unsigned long limit);
+        bool            disjoint (const FilterRule * other) const;
+        bool            disjointText (const FilterRule * other) const;
+        bool            urlCandidate () const;
+
+        unsigned long   imageSize () const;
+        void            save (unsigned char * image,
+                              unsigned long offset) const;
+        bool            load (const unsigned char * image, unsigned long size,
+                              unsigned long & offset);
 
 public:
 static  bool            installFilters (wchar_t * str);
@@ -112,20 +180,326 @@ static  bool            installFilters (wchar_t * str);
         bool            match (const char * example, addrinfo ** replace);
         bool            match (const char * example, const char ** replace,
                                int slashMode);
+        bool            match (unsigned long address, unsigned short port,
+                               addrinfo ** replace);
 
                         FilterRule ();
                       ~ FilterRule ();
 };
 
+/**
+ * Live statistics for one of the replacement targets in a rule.
+ *
+ * When a rule lists several targets, just rotating through them gives a dead
+ * or congested server the same share of the connections as a fast one; so for
+ * each target we keep track of how connections to it fare, and the selection
+ * prefers whichever target looks like it will give a new connection the most
+ * throughput, with targets which fail to connect left alone for a while.
+ *
+ * These live in the same memory block as the target's address information,
+ * but since a connection can outlast the rules it was made with they're
+ * reference-counted, and the block is only freed once the last user is done.
+ */
+
+class TargetStats {
+        friend class FilterRule;
+        friend class FilterRules;
+
+public:
+        enum {
+                COOLDOWN_BASE = 1000,
+                COOLDOWN_SHIFT = 6
+        };
+
+private:
+        volatile LONG   m_refs;
+        void          * m_block;
+        bool            m_adaptive;
+
+        volatile LONG   m_connects;
+        volatile LONG   m_failures;
+        volatile LONG   m_streak;
+        volatile LONG   m_active;
+        volatile LONG   m_latency;
+        volatile LONG   m_rate;
+        volatile LONG   m_cooldown;
+
+        bool            cooling (unsigned long now) const;
+        bool            better (const TargetStats * other,
+                                unsigned long now) const;
+
+public:
+        void            addRef ();
+        void            release ();
+
+        void            opened ();
+        void            connected (unsigned long elapsed);
+        void            failed ();
+        void            delivered (unsigned long bytes, unsigned long elapsed);
+        void            closed ();
+};
+
+/**
+ * The targets a connection should be raced between, for rules which ask for
+ * that by listing a '~' among their targets.
+ *
+ * A target that doesn't answer costs a connection the whole TCP timeout before
+ * anything can try elsewhere, and the statistics only learn to avoid it after
+ * that has happened; so for these rules the connect hook tries the best few
+ * targets at once, each a little after the last, and uses whichever answers
+ * first. The first candidate is always the one the normal selection chose and
+ * the others follow in order of preference; each comes with a reference to its
+ * statistics (if it has any) for the caller to release.
+ */
+
+struct RaceTargets {
+        enum {
+                RACE_TARGETS = 3,
+                RACE_STAGGER = 50,
+                RACE_STAGGER_MAX = 1000,
+                RACE_WAIT = 3000
+        };
+
+        sockaddr_in     m_address [RACE_TARGETS];
+        TargetStats   * m_target [RACE_TARGETS];
+        unsigned long   m_count;
+        unsigned long   m_stagger;
+
+                        RaceTargets () : m_count (0), m_stagger (0) { }
+
+        void            release ();
+};
+
+/**
+ * Index a subset of the rules by the literal text at the front of each
+ * pattern.
+ *
+ * Originally all the rules lived in one list that every lookup walked from
+ * the front, testing each pattern in turn. That's fine for a handful of rules
+ * but the ISP rule sets keep growing, and most of the patterns start with some
+ * literal text (a domain name, or a URL path) that rules them out without ever
+ * needing to run the glob matcher.
+ *
+ * So, each table is a simple character trie keyed on the literal prefix of
+ * each pattern (the text up to the first wildcard); walking the example down
+ * the trie collects every rule that could possibly match, and the cursor below
+ * merges those back into the original rule order so that the first rule which
+ * matches is still the same one it always was.
+ */
+
+class RuleTable {
+        friend class RuleCursor;
+
+public:
+        enum { MAX_PREFIX = 32 };
+
+private:
+        struct Node;
+
+        Node          * m_root;
+
+static  void            freeNode (Node * node);
+static  size_t          prefix (const FilterRule * rule, char * dest,
+                                size_t length);
+
+public:
+                        RuleTable ();
+                      ~ RuleTable ();
+
+        bool            add (FilterRule * rule, unsigned long order,
+                             bool urlOnly = false);
+        void            clear ();
+        bool            empty () const { return m_root == 0; }
+};
+
+/**
+ * Index the numeric connection rules by network prefix.
+ *
+ * This is a plain binary radix tree over the bits of an IPv4 address, where
+ * the rules for each network hang off the node for its prefix; looking up an
+ * address walks at most 32 nodes and collects the rules of every network that
+ * contains the address, which the cursor then merges in rule order as usual.
+ */
+
+class AddressTable {
+        friend class RuleCursor;
+
+private:
+        struct Node;
+
+        Node          * m_root;
+
+static  void            freeNode (Node * node);
+
+public:
+                        AddressTable ();
+                      ~ AddressTable ();
+
+        bool            add (FilterRule * rule, unsigned long order);
+        void            clear ();
+};
+
+/**
+ * Walk the candidate rules for an example string in rule order.
+ *
+ * The candidates come from each trie node along the path of the example, and
+ * each node's list is already in rule order, so this is just a small merge;
+ * for connection rules the lists from the text and numeric tables are merged
+ * together, so whichever kind of rule comes first still wins.
+ */
+
+class RuleCursor {
+public:
+        enum { MAX_LISTS = RuleTable :: MAX_PREFIX + 1 + 33 };
+
+private:
+        const RuleEntry * m_lists [MAX_LISTS];
+        unsigned long   m_count;
+
+public:
+                        RuleCursor () : m_count (0) { }
+                        RuleCursor (const RuleTable & table,
+                                    const char * example);
+
+        void            add (const RuleTable & table, const char * example);
+        void            add (const AddressTable & table,
+                             unsigned long address);
+
+        FilterRule    * next ();
+};
+
+/**
+ * The set of parsed rules, along with the per-kind index tables over them.
+ *
+ * Each rule set is an immutable snapshot once it has been built; lookups just
+ * pick up the current snapshot and use it without any locking, and changing
+ * the rules means building a new snapshot and publishing it in place of the
+ * old one, which is only freed once no hook thread can still be using it.
+ *
+ * Appending rules builds a new snapshot on top of the existing one; the new
+ * snapshot indexes both sets of rules, but the older rules still belong to the
+ * base snapshot, which is kept alive by reference for as long as it's needed.
+ *
+ * Every snapshot also keeps a flat list of all the rules it indexes in rule
+ * order, so that a snapshot can be built with the same rules in a different
+ * order, which is how hot rules get moved up the list.
+ *
+ * A snapshot whose rules were loaded from a mapped rule image also owns the
+ * view of the image, since the rules point into it.
+ *
+ * The global rate limit, if the rules set one, is picked out as the snapshot
+ * is indexed, so that the receive hooks can find it without a search.
+ */
+
+class RuleSet {
+        friend class FilterRules;
+
+private:
+        volatile LONG   m_refs;
+        RuleSet       * m_base;
+        FilterRule    * m_head;
+        unsigned long   m_count;
+        FilterRule   ** m_order;
+        const void    * m_view;
+
+        RuleTable       m_ipRules;
+        AddressTable    m_ipNetworks;
+        RuleTable       m_dnsRules;
+        RuleTable       m_urlRules;
+        RateLimit     * m_limit;
+        unsigned long   m_needs;
+        bool            m_reordered;
+
+        void            index (FilterRule * rule);
+
+public:
+                        RuleSet (RuleSet * base, FilterRule * head);
+                        RuleSet (RuleSet * base, FilterRule ** order,
+                                 unsigned long count);
+                      ~ RuleSet ();
+
+        void            addRef ();
+        void            release ();
+};
+
+/**
+ * Mark a section of code in which rule data is being used.
+ *
+ * Since the rule data handed back from the match functions points into the
+ * current snapshot, hooks which hang onto that data after the match returns
+ * should keep one of these in scope for as long as they do; the match
+ * functions also use them internally, and they nest freely.
+ *
+ * Inside one of these, it's not safe to install or append rules, since that
+ * waits for all the readers of the old rules to finish.
+ */
+
+class RuleGuard {
+private:
+        volatile LONG * m_count;
+
+public:
+                        RuleGuard ();
+                      ~ RuleGuard ();
+};
+
+/**
+ * Callback for reporting on the rules, one line of text at a time.
+ */
+
+typedef void (* RuleReportFunc) (void * context, const char * line);
+
+/**
+ * Callback for getting a replacement document named in the rules ready, given
+ * the name without the leading '<'.
+ */
+
+typedef void (* RulePreloadFunc) (const char * name);
+
+/**
+ * The rules matched against an HTTP request.
+ *
+ * The request line is copied to a buffer with the host name (if any) between
+ * the verb and the URL, so the host can be matched with the '//' sigil and the
+ * pair can be matched as one; the URL length is where the copy stopped, which
+ * may be short of the real URL if it was too long to copy whole.
+ *
+ * The URL isn't matched when the host rule blocks the request; if neither the
+ * host nor the URL matches, the host and URL are matched as a pair, setting
+ * the host replacement.
+ */
+
+struct RequestMatch {
+        char            m_temp [256];
+        const char    * m_end;
+        const char    * m_hostPart;
+        const char    * m_urlPart;
+        size_t          m_url;
+
+        bool            m_matchHost;
+        bool            m_matchUrl;
+        bool            m_matchPair;
+        const char    * m_newHost;
+        const char    * m_replace;
+};
+
 /**
  * Represent a collection of filter rules.
+ *
+ * As well as being parsed from text, a collection of rules can be compiled to
+ * a flat binary image which holds the rules in an already-parsed form (with
+ * the replacement targets already resolved to addresses), and installed from
+ * an image like that; this lets the monitor do all the parsing work and hand
+ * the result to the filter in the Steam process via a shared memory section,
+ * whose name is derived from the target process and the source rule text.
  */
 
 class FilterRules {
+        friend class RuleSet;
+
 private:
-        FilterRule    * m_head;
-        FilterRule    * m_tail;
-        wchar_t       * m_pending;
+        RuleSet       * volatile m_current;
+        wchar_t       * volatile m_pending;
 
         unsigned short  m_defaultPort;
 
@@ -133,22 +507,59 @@ static  void            freeRules (FilterRule * head);
 
         bool            parse (const wchar_t * from, const wchar_t * to,
                                FilterRule * & head, FilterRule * & tail);
+        void            parsePending ();
+        RuleSet       * current ();
+        void            publish (RuleSet * rules);
+        void            replace (RuleSet * rules);
 
 public:
+        enum { IMAGE_NAME = 64 };
+
+        enum {
+                NEED_SEND = 1,
+                NEED_READ = 2
+        };
+
                         FilterRules (unsigned short defaultPort = 0);
                       ~ FilterRules ();
 
         bool            append (const wchar_t * rules);
-        bool            install (const wchar_t * rules);
+        bool            install (const wchar_t * rules,
+                                 const wchar_t * extra = 0);
+        bool            install (const void * image, unsigned long size,
+                                 const wchar_t * rules,
+                                 const wchar_t * extra = 0);
+        void          * compile (const wchar_t * rules, unsigned long & size);
 
         bool            matchIp (const sockaddr_in * name, void * module,
-                               sockaddr_in ** replace);
+                                 sockaddr_in ** replace,
+                                 TargetStats ** target = 0,
+                                 RateLimit ** limit = 0,
+                                 RaceTargets * race = 0);
         bool            matchDns (const char * name,
-                               sockaddr_in ** replace);
+                                  sockaddr_in ** replace,
+                                  unsigned long * addrs = 0,
+                                  unsigned long * count = 0);
         bool            matchUrl (const char * name,
                                   const char ** replace);
         bool            matchHost (const char * name,
                                    const char ** replace);
+        bool            matchRequest (const char * buf, size_t verb,
+                                      size_t url, const char * host,
+                                      size_t hostLength,
+                                      RequestMatch & match);
+        RateLimit     * rateLimit ();
+        unsigned long   needs ();
+
+        void            report (RuleReportFunc func, void * context);
+        unsigned long   hitCounts (volatile LONG * dest, unsigned long count);
+        void            resetStats ();
+        bool            reorder ();
+
+static  void            resolver (void * addrFunc);
+static  void            preload (RulePreloadFunc func);
+static  void            imageName (wchar_t * dest, unsigned long processId,
+                                   const wchar_t * rules);
 };
 
 /**@}*/
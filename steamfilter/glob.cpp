@@ -31,6 +31,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <malloc.h>
 #include "glob.h"
 
 /**
@@ -39,6 +43,11 @@
  * The only notable thing about this is that we're usually matching a simple
  * single-byte example string against a wide pattern, as a consequence of the
  * Steam client using gethostbyname ().
+ *
+ * This used to be a direct recursive matcher, but the cost of that with several
+ * interior '*' wildcards (as the host+URL rules have) adds up quickly, so now
+ * this just compiles the pattern and runs the compiled form; anything that
+ * matches the same pattern repeatedly should keep the compiled form around.
  */
 
 bool globMatch (const char * example, const wchar_t * pattern,
@@ -46,103 +55,268 @@ bool globMatch (const char * example, const wchar_t * pattern,
         if (example == 0)
                 return false;
 
-        wchar_t         ch;
-        for (; (ch = * pattern) != 0 ; ++ pattern) {
+        GlobMatcher   * glob = GlobMatcher :: compile (pattern);
+        if (glob == 0)
+                return false;
+
+        bool            result = glob->match (example, slashMode);
+        free (glob);
+        return result;
+}
+
+/**
+ * Compile a glob pattern.
+ *
+ * The rules for the pattern are the same as they always were for the classic
+ * recursive matcher:
+ *  - a '?' matches any single character, or the end of the example;
+ *  - a '*' at the end of the pattern succeeds immediately;
+ *  - any other '*' matches any run of characters, except that it may not be
+ *    allowed to cross a '/' depending on the slash mode; in SLASH_MAYBE mode
+ *    that's decided by whether the next pattern character is a '/' or '.';
+ *  - everything else, including a '\\', matches just itself. Since the example
+ *    is narrow text, pattern characters outside 7-bit ASCII never match.
+ *
+ * Position i in the automaton means the first i pattern characters have been
+ * matched; the first rows of masks hold, for each class of example character,
+ * the positions that consume that character and step forward. Characters in
+ * the example which don't appear in the pattern all share class 0.
+ */
+
+/* static */
+GlobMatcher * GlobMatcher :: compile (const wchar_t * pattern) {
+        if (pattern == 0)
+                return 0;
+
+        size_t          length = wcslen (pattern);
+        if (length > 0xFFFE)
+                return 0;
+
+        /*
+         * Work out the character classes in a first pass, since the size of
+         * the compiled form depends on how many there are.
+         */
+
+        unsigned char   classes [128];
+        unsigned short  count = 1;
+        memset (classes, 0, sizeof (classes));
+
+        size_t          i;
+        for (i = 0 ; i < length ; ++ i) {
+                wchar_t         ch = pattern [i];
+                if (ch == '*' || ch == '?' || ch >= 0x80)
+                        continue;
+
+                if (classes [ch] == 0)
+                        classes [ch] = (unsigned char) count ++;
+        }
+
+        unsigned short  words = (unsigned short) ((length + 1 + 31) / 32);
+        unsigned long   rows = count + 3;
+        unsigned long   size = sizeof (GlobMatcher) +
+                               (rows * words - 1) * sizeof (unsigned long);
+
+        GlobMatcher   * glob = (GlobMatcher *) malloc (size);
+        if (glob == 0)
+                return 0;
+
+        memset (glob, 0, size);
+        glob->m_size = size;
+        glob->m_positions = (unsigned short) length;
+        glob->m_words = words;
+        glob->m_classes = count;
+        glob->m_trailing = -1;
+        memcpy (glob->m_class, classes, sizeof (classes));
+
+        unsigned long * star = glob->m_masks + count * words;
+        unsigned long * dotSlash = star + words;
+        unsigned long * quest = dotSlash + words;
+
+        for (i = 0 ; i < length ; ++ i) {
+                wchar_t         ch = pattern [i];
+                size_t          word = i / 32;
+                unsigned long   bit = 1UL << (i % 32);
+
                 if (ch == '?') {
                         /*
-                         * Allow any character or the end of the example string
-                         * to match a '?'.
+                         * Any character at all steps past a '?'.
                          */
 
-                        if (* example != 0)
-                                ++ example;
+                        for (unsigned short row = 0 ; row < count ; ++ row)
+                                glob->m_masks [row * words + word] |= bit;
 
+                        quest [word] |= bit;
                         continue;
-                } else if (ch != '*') {
+                }
+
+                if (ch == '*') {
                         /*
-                         * Exact match on one character.
-                         *
-                         * If that character is a backslash, it escapes the
-                         * next pattern character.
+                         * A trailing '*' is an instant success, so it's not
+                         * really part of the automaton at all.
                          */
 
-                        if (ch == '\\' &&
-                            (ch = * pattern) == 0) {
-                                return false;
+                        wchar_t         next = pattern [i + 1];
+                        if (next == 0) {
+                                glob->m_trailing = (short) i;
+                                continue;
                         }
 
-                        if (* example != ch)
-                                return false;
+                        star [word] |= bit;
+                        if (next == '/' || next == '.')
+                                dotSlash [word] |= bit;
 
-                        ++ example;
                         continue;
                 }
 
-                /*
-                 * Quickly recognise a trailing '*' as auto-success having got
-                 * this far through the example - this makes sense as long as
-                 * we either don't have a list of delimiter-type characters
-                 * that '*' doesn't match - like '/' in the old UNIX shell,
-                 * although that was more because path structure got parsed out
-                 * of patterns first (and each path level was processed as part
-                 * of directory expansion) - or because even if we do a trailing
-                 * '*' can safely be a special case.
-                 */
-
-                ch = pattern [1];
-                if (ch == 0)
-                        return true;
+                if (ch < 0x80)
+                        glob->m_masks [classes [ch] * words + word] |= bit;
+        }
 
-                /*
-                 * Do for our purposes should a '*' be able to match a '/' or
-                 * not - one way of deciding is by whether there are any '/'
-                 * characters in the rest of the pattern, or we can just say
-                 * any interior '*' doesn't match a '/' but a trailing one does,
-                 * or we can say that we can treat a star-slash combo as
-                 * implying a not-match.
-                 */
-
-                bool            noSlash = slashMode == SLASH_NO_MATCH ? true :
-                                          slashMode == SLASH_MATCH ? false :
-                                          ch == '/' || ch == '.';
-
-                /*
-                 * Wildcard match, consume any number of characters. As in the
-                 * original UNIX v6 code, this is a fairly inefficient way of
-                 * implementing Kleene-type closure compared to any of the more
-                 * fun matching systems (Boyer-Moore, Knuth-Morris-Pratt, or
-                 * most forms of regular expression execution via compilation
-                 * to NFA/DFA/vm-code) but it's super-simple and as small code
-                 * size is part of the design goal, why not?
-                 */
-
-                for (;;) {
-                        /*
-                         * Start with a recursive call just on the current
-                         * example.
-                         */
+        return glob;
+}
 
-                        if (globMatch (example, pattern + 1, slashMode))
-                                return true;
+/**
+ * Check that a compiled pattern which has been copied in from elsewhere is
+ * consistent, and fits in the given space, so that matching with it can't
+ * stray outside of it.
+ */
 
-                        ch = * example;
-                        if (ch == 0)
-                                return false;
+bool GlobMatcher :: valid (unsigned long space) const {
+        if (space < sizeof (GlobMatcher) || m_size > space)
+                return false;
 
-                        /*
-                         * Before consuming a character, if we want to make '/'
-                         * a special case we leave out of a '*' pattern we can
-                         * do it here.
-                         */
+        if (m_classes == 0 || m_classes > 128 ||
+            m_words != (m_positions + 1 + 31) / 32 ||
+            m_trailing < -1 || m_trailing >= (long) m_positions) {
+                return false;
+        }
+
+        unsigned long   rows = m_classes + 3;
+        if (m_size != sizeof (GlobMatcher) +
+                      (rows * m_words - 1) * sizeof (unsigned long)) {
+                return false;
+        }
+
+        for (unsigned short i = 0 ; i < 128 ; ++ i)
+                if (m_class [i] >= m_classes)
+                        return false;
+
+        return true;
+}
+
+/**
+ * Add to a state set everything reachable from it through the positions in
+ * the mask without consuming any example input.
+ *
+ * This is usually the set of '*' positions, which can always be skipped, but
+ * at the end of the example the '?' positions can be skipped too.
+ */
+
+void GlobMatcher :: close (unsigned long * state,
+                           const unsigned long * mask) const {
+        bool            changed;
+        do {
+                changed = false;
 
-                        if (noSlash && ch == '/')
-                                return false;
+                unsigned long   carry = 0;
+                for (unsigned short i = 0 ; i < m_words ; ++ i) {
+                        unsigned long   skip = state [i] & mask [i];
+                        unsigned long   add = (skip << 1) | carry;
+                        carry = skip >> 31;
 
-                        ++ example;
+                        if ((add & ~ state [i]) != 0) {
+                                state [i] |= add;
+                                changed = true;
+                        }
                 }
+        } while (changed);
+}
+
+/**
+ * Run the compiled pattern over an example string.
+ */
+
+bool GlobMatcher :: match (const char * example, int slashMode) const {
+        if (example == 0)
+                return false;
+
+        unsigned long   local [LOCAL_WORDS];
+        unsigned long * state = local;
+        if (m_words > LOCAL_WORDS)
+                state = (unsigned long *) _alloca (m_words * sizeof (* state));
+
+        const unsigned long * star = m_masks + m_classes * m_words;
+        const unsigned long * dotSlash = star + m_words;
+        const unsigned long * quest = dotSlash + m_words;
+
+        /*
+         * Which of the '*' positions aren't allowed to consume a '/'.
+         */
+
+        const unsigned long * noSlash = slashMode == SLASH_NO_MATCH ? star :
+                                        slashMode == SLASH_MATCH ? 0 :
+                                        dotSlash;
+
+        unsigned short  trailWord = 0;
+        unsigned long   trailBit = 0;
+        if (m_trailing >= 0) {
+                trailWord = m_trailing / 32;
+                trailBit = 1UL << (m_trailing % 32);
         }
 
-        return * example == 0;
+        memset (state, 0, m_words * sizeof (* state));
+        state [0] = 1;
+        close (state, star);
+
+        for (;;) {
+                if ((state [trailWord] & trailBit) != 0)
+                        return true;
+
+                unsigned char   ch = (unsigned char) * example ++;
+                if (ch == 0)
+                        break;
+
+                const unsigned long * step = m_masks;
+                if (ch < 0x80)
+                        step += m_class [ch] * m_words;
+
+                unsigned long   carry = 0;
+                unsigned long   live = 0;
+                for (unsigned short i = 0 ; i < m_words ; ++ i) {
+                        unsigned long   moved = state [i] & step [i];
+                        unsigned long   stay = state [i] & star [i];
+                        if (ch == '/' && noSlash != 0)
+                                stay &= ~ noSlash [i];
+
+                        state [i] = (moved << 1) | carry | stay;
+                        carry = moved >> 31;
+                        live |= state [i];
+                }
+
+                if (live == 0)
+                        return false;
+
+                close (state, star);
+        }
+
+        /*
+         * At the end of the example, the '?' positions can also be skipped,
+         * and then the match succeeds if we can reach the end of the pattern.
+         */
+
+        unsigned long   local2 [LOCAL_WORDS];
+        unsigned long * skip = local2;
+        if (m_words > LOCAL_WORDS)
+                skip = (unsigned long *) _alloca (m_words * sizeof (* skip));
+
+        for (unsigned short i = 0 ; i < m_words ; ++ i)
+                skip [i] = star [i] | quest [i];
+
+        close (state, skip);
+
+        unsigned long   end = 1UL << (m_positions % 32);
+        return (state [m_positions / 32] & end) != 0 ||
+               (state [trailWord] & trailBit) != 0;
 }
 
 /**@}*/
@@ -4,7 +4,8 @@
 /**@addtogroup Filter Steam limiter filter hook DLL.
  * @{@file
  *
- * Declare prototype for a simple UNIX glob-matching routine.
+ * Declare prototypes for a simple UNIX glob-matching routine, and for the
+ * compiled form of glob patterns used by the filter rules.
  *
  * @author Nigel Bree <nigel.bree@gmail.com>
  *
@@ -41,5 +42,43 @@
 bool globMatch (const char * example, const wchar_t * pattern,
                 int slashMode = SLASH_MAYBE);
 
+/**
+ * A glob pattern compiled into a small automaton over narrow characters.
+ *
+ * Each position in the pattern is a state, and the set of live states is kept
+ * as a bit-vector so that every character of the example is handled in a
+ * fixed number of word operations, no matter how many '*' wildcards there are
+ * in the pattern; there's no backtracking at all.
+ *
+ * The compiled form is a single flat allocation with no internal pointers, so
+ * it can be copied around (or stored in a file) as a simple block of bytes of
+ * size () length, and released with free (); a block that has come from
+ * somewhere else can be checked for consistency with valid () before use.
+ */
+
+class GlobMatcher {
+private:
+        enum { LOCAL_WORDS = 8 };
+
+        unsigned long   m_size;
+        unsigned short  m_positions;
+        unsigned short  m_words;
+        unsigned short  m_classes;
+        short           m_trailing;
+        unsigned char   m_class [128];
+        unsigned long   m_masks [1];
+
+        void            close (unsigned long * state,
+                               const unsigned long * mask) const;
+
+public:
+static  GlobMatcher   * compile (const wchar_t * pattern);
+
+        unsigned long   size () const { return m_size; }
+        bool            valid (unsigned long space) const;
+        bool            match (const char * example,
+                               int slashMode = SLASH_MAYBE) const;
+};
+
 /**@}*/
 #endif  /* ! defined (GLOB_H) */
@@ -0,0 +1,114 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * The private heap which the filter's own data inside Steam is allocated from.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+
+#include "heap.h"
+
+/**
+ * Private heap for the filter's data.
+ *
+ * Everything here is allocated inside Steam on its network threads, so rather
+ * than contend with Steam for the process heap, we have our own; it also means
+ * that when we're unloaded everything we ever allocated goes away in one step,
+ * even if something has been leaked along the way.
+ *
+ * The heap is made on first use, since the socket table is a global and so
+ * its constructor can run before anything else; where it's supported, the
+ * low-fragmentation mode is asked for so that the small, uniformly sized
+ * tracking structures come out of per-size buckets.
+ *
+ * Whatever happens the first time is what sticks for as long as the DLL is
+ * loaded. If the heap can't be made, allocations just fail, rather than some
+ * of them coming from the process heap and then being freed to this one (or
+ * the other way around); and once the heap has been destroyed on unload it's
+ * never made again, since anything allocated after that would be leaked.
+ */
+
+static HANDLE           l_heap;
+
+static HANDLE l_privateHeap (void) {
+        HANDLE          heap = l_heap;
+        if (heap == 0) {
+                HANDLE          fresh = HeapCreate (0, 0, 0);
+                if (fresh != 0) {
+                        unsigned long   mode = 2;
+                        HeapSetInformation (fresh, HeapCompatibilityInformation,
+                                            & mode, sizeof (mode));
+                } else
+                        fresh = INVALID_HANDLE_VALUE;
+
+                void * volatile * slot = (void * volatile *) & l_heap;
+                heap = InterlockedCompareExchangePointer (slot, fresh, 0);
+                if (heap == 0) {
+                        heap = fresh;
+                } else if (fresh != INVALID_HANDLE_VALUE)
+                        HeapDestroy (fresh);
+        }
+
+        return heap != INVALID_HANDLE_VALUE ? heap : 0;
+}
+
+/**
+ * Allocate from the private heap, if there is one.
+ */
+
+void * g_privateAlloc (size_t length, unsigned long flags) {
+        HANDLE          heap = l_privateHeap ();
+        return heap != 0 ? HeapAlloc (heap, flags, length) : 0;
+}
+
+/**
+ * Free something allocated from the private heap; once the heap itself has
+ * gone, so has everything in it.
+ */
+
+void g_privateFree (void * mem) {
+        HANDLE          heap = l_privateHeap ();
+        if (heap != 0 && mem != 0)
+                HeapFree (heap, 0, mem);
+}
+
+/**
+ * Release the private heap and everything in it, for good.
+ */
+
+void g_unloadHeap (void) {
+        void * volatile * slot = (void * volatile *) & l_heap;
+        HANDLE          heap;
+        heap = (HANDLE) InterlockedExchangePointer (slot, INVALID_HANDLE_VALUE);
+        if (heap != 0 && heap != INVALID_HANDLE_VALUE)
+                HeapDestroy (heap);
+}
+
+/**@}*/
@@ -0,0 +1,406 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * Scanning of outgoing HTTP request headers for the URL filters.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define WIN32_LEAN_AND_MEAN     1
+#include <windows.h>
+#include <intrin.h>
+#include <emmintrin.h>
+
+#include "httpscan.h"
+#include "heap.h"
+
+/**
+ * The header names we look for, in lower case, padded out to a full vector.
+ * @{
+ */
+
+static const char       l_hostName [16] = "host:";
+static const char       l_lengthName [16] = "content-length:";
+static const char       l_encodingName [32] = "transfer-encoding:";
+
+/**@}*/
+
+/**
+ * The request methods we know; the start of a send which isn't one of these
+ * isn't HTTP.
+ */
+
+static const char     * l_methods [] = {
+        "GET ", "POST ", "HEAD ", "PUT ", "DELETE ", "OPTIONS ", "PATCH ",
+        "CONNECT ", "TRACE ", 0
+};
+
+/**
+ * Fold an ASCII character to lower case, ignoring the locale.
+ */
+
+static unsigned char l_lower (unsigned char ch) {
+        if (ch >= 'A' && ch <= 'Z')
+                ch += 'a' - 'A';
+        return ch;
+}
+
+/**
+ * Case-insensitive comparison of the start of a buffer against a lower-case
+ * string.
+ */
+
+static bool l_prefix (const char * buf, size_t length, const char * text) {
+        for (; * text != 0 ; ++ buf, ++ text, -- length)
+                if (length == 0 || l_lower (* buf) != (unsigned char) * text)
+                        return false;
+
+        return true;
+}
+
+/**
+ * Fold the first 16 bytes of a line to lower case, all at once.
+ *
+ * The SSE2 compares are signed, but that's fine since anything outside of the
+ * ASCII range can never be in the range of upper-case letters anyway.
+ */
+
+static __m128i l_foldLine (const char * line) {
+        __m128i         text = _mm_loadu_si128 ((const __m128i *) line);
+        __m128i         upper;
+        upper = _mm_and_si128 (_mm_cmpgt_epi8 (text, _mm_set1_epi8 ('A' - 1)),
+                               _mm_cmplt_epi8 (text, _mm_set1_epi8 ('Z' + 1)));
+
+        return _mm_add_epi8 (text, _mm_and_si128 (upper, _mm_set1_epi8 (0x20)));
+}
+
+/**
+ * Check whether a header line starts with a given name.
+ *
+ * When there's a whole vector's worth of buffer left the first 16 bytes of the
+ * name are compared in one go against the folded line, otherwise (and for any
+ * part of the name past 16 bytes) it's done a byte at a time.
+ */
+
+static bool l_headerIs (const char * line, size_t lineLength, bool vector,
+                        __m128i folded, const char * name) {
+        size_t          nameLength = strlen (name);
+        if (lineLength < nameLength)
+                return false;
+
+        if (! vector)
+                return l_prefix (line, lineLength, name);
+
+        size_t          first = nameLength < 16 ? nameLength : 16;
+        __m128i         want = _mm_loadu_si128 ((const __m128i *) name);
+        int             mask;
+        mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (folded, want));
+        int             need = (1 << first) - 1;
+        if ((mask & need) != need)
+                return false;
+
+        return l_prefix (line + first, lineLength - first, name + first);
+}
+
+/**
+ * Skip the spaces in front of a header value.
+ */
+
+static const char * l_value (const char * from, const char * end) {
+        while (from < end && (* from == ' ' || * from == '\t'))
+                ++ from;
+
+        return from;
+}
+
+/**
+ * Simple constructor.
+ */
+
+HttpScan :: HttpScan () : m_phase (START), m_body (0), m_held (0),
+                m_heldLength (0) {
+}
+
+/**
+ * Free anything we were holding on to.
+ */
+
+HttpScan :: ~ HttpScan () {
+        release ();
+}
+
+/**
+ * Find the next newline, 16 bytes at a time.
+ *
+ * Loads are unaligned, and never go past the end of the buffer; whatever is
+ * left over at the end is finished off by memchr ().
+ */
+
+/* static */
+const char * HttpScan :: findLine (const char * from, const char * end) {
+        __m128i         newline = _mm_set1_epi8 ('\n');
+
+        while (end - from >= 16) {
+                __m128i         text;
+                text = _mm_loadu_si128 ((const __m128i *) from);
+
+                int             mask;
+                mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (text, newline));
+                if (mask != 0) {
+                        unsigned long   bit;
+                        _BitScanForward (& bit, mask);
+                        return from + bit;
+                }
+
+                from += 16;
+        }
+
+        return (const char *) memchr (from, '\n', end - from);
+}
+
+/**
+ * Decide whether the start of a send looks like the start of an HTTP request.
+ *
+ * The whole method, and the space after it, has to be there; a send too short
+ * for that isn't held on to in the hope that the rest turns up (any client we
+ * care about sends at least the request line in one go), it's just passed on
+ * and the connection left alone, since a few stray bytes that happen to match
+ * the start of a method would otherwise have the next send held up as well.
+ */
+
+/* static */
+bool HttpScan :: isRequest (const char * buf, size_t length) {
+        for (const char ** method = l_methods ; * method != 0 ; ++ method) {
+                const char    * text = * method;
+                size_t          need = strlen (text);
+                if (need > length)
+                        continue;
+
+                size_t          i = 0;
+                while (i < need && l_lower (buf [i]) == l_lower (text [i]))
+                        ++ i;
+
+                if (i == need)
+                        return true;
+        }
+
+        return false;
+}
+
+/**
+ * Parse a request's headers, if they are all there.
+ *
+ * This makes a single pass over the header lines and stops at the blank line
+ * which ends them, so nothing past that is ever looked at.
+ */
+
+/* static */
+bool HttpScan :: parse (const char * buf, size_t length, Request & request) {
+        memset (& request, 0, sizeof (request));
+
+        const char    * end = buf + length;
+        const char    * line = findLine (buf, end);
+        if (line == 0)
+                return false;
+
+        /*
+         * The request line; note where the URL ends, for the verbs the URL
+         * filters are interested in.
+         */
+
+        if (l_prefix (buf, length, "get /")) {
+                request.m_verb = 4;
+        } else if (l_prefix (buf, length, "post /"))
+                request.m_verb = 5;
+
+        if (request.m_verb > 0) {
+                const char    * url = buf + request.m_verb;
+                const char    * space;
+                space = (const char *) memchr (url, ' ', line - url);
+                if (space != 0)
+                        request.m_url = space - buf;
+        }
+
+        for (;;) {
+                const char    * start = line + 1;
+                line = findLine (start, end);
+                if (line == 0)
+                        return false;
+
+                size_t          lineLength = line - start;
+                if (lineLength == 0 || (lineLength == 1 && * start == '\r'))
+                        break;
+
+                bool            vector = end - start >= 16;
+                __m128i         folded = _mm_setzero_si128 ();
+                if (vector)
+                        folded = l_foldLine (start);
+
+                if (l_headerIs (start, lineLength, vector, folded,
+                                l_hostName)) {
+                        const char    * value;
+                        value = l_value (start + 5, line);
+                        if (line [- 1] == '\r' && line - 1 > value) {
+                                request.m_host = value;
+                                request.m_hostLength = line + 1 - value;
+                        }
+                } else if (l_headerIs (start, lineLength, vector, folded,
+                                       l_lengthName)) {
+                        const char    * value;
+                        value = l_value (start + 15, line);
+
+                        unsigned long   count = 0;
+                        for (; value < line ; ++ value) {
+                                unsigned char   digit = * value - '0';
+                                if (digit > 9 || count > 0x0FFFFFFFUL)
+                                        break;
+                                count = count * 10 + digit;
+                        }
+
+                        request.m_contentLength = count;
+                } else if (l_headerIs (start, lineLength, vector, folded,
+                                       l_encodingName)) {
+                        /*
+                         * Any transfer coding means we can't count the body
+                         * off by length; there's only chunked in practice.
+                         */
+
+                        request.m_chunked = true;
+                }
+        }
+
+        request.m_length = line + 1 - buf;
+        return true;
+}
+
+/**
+ * Count off body bytes for the current request, returning how many of the
+ * given length were part of the body.
+ */
+
+unsigned long HttpScan :: skipBody (unsigned long length) {
+        if (m_phase != BODY)
+                return 0;
+
+        unsigned long   used = length < m_body ? length : m_body;
+        m_body -= used;
+        if (m_body == 0)
+                m_phase = START;
+
+        return used;
+}
+
+/**
+ * Hold on to an incomplete set of request headers (plus whatever follows them
+ * in the same send) until the rest of them turn up.
+ *
+ * There's a limit to how much we'll hold; if the headers are bigger than that
+ * then this fails, leaving the held data as it was.
+ */
+
+bool HttpScan :: hold (const char * buf, size_t length) {
+        if (m_phase != HEADERS) {
+                release ();
+                m_phase = HEADERS;
+        }
+
+        if (length > HOLD_LIMIT - m_heldLength)
+                return false;
+
+        if (m_held == 0) {
+                m_held = (char *) g_privateAlloc (HOLD_LIMIT);
+                if (m_held == 0)
+                        return false;
+        }
+
+        memcpy (m_held + m_heldLength, buf, length);
+        m_heldLength += length;
+        return true;
+}
+
+/**
+ * Once a request has been sent on its way, start counting off its body.
+ *
+ * If the whole body and then some came with the headers, the client is
+ * pipelining requests; that's rare enough (and the Steam client doesn't do
+ * it) that the connection is just left alone from then on, as it is for a
+ * body that has a transfer coding and so no fixed length.
+ */
+
+void HttpScan :: started (const Request & request, size_t body) {
+        if (request.m_chunked || body > request.m_contentLength) {
+                m_phase = OPAQUE;
+                return;
+        }
+
+        m_body = request.m_contentLength - (unsigned long) body;
+        m_phase = m_body > 0 ? BODY : START;
+}
+
+/**
+ * Cut the held data back to what it was before a send that didn't go out, so
+ * that the same send can be held again when the caller tries it again.
+ */
+
+void HttpScan :: unhold (size_t length) {
+        if (m_phase == HEADERS && length < m_heldLength)
+                m_heldLength = length;
+}
+
+/**
+ * Go back to waiting for a new request, after one that was dealt with some
+ * other way (such as being replaced).
+ */
+
+void HttpScan :: restart (void) {
+        release ();
+        m_body = 0;
+        m_phase = START;
+}
+
+/**
+ * Stop looking at this connection.
+ */
+
+void HttpScan :: giveUp (void) {
+        m_phase = OPAQUE;
+}
+
+/**
+ * Let go of any held data.
+ */
+
+void HttpScan :: release (void) {
+        if (m_held != 0)
+                g_privateFree (m_held);
+
+        m_held = 0;
+        m_heldLength = 0;
+}
+
+/**@}*/
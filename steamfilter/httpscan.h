@@ -0,0 +1,121 @@
+#ifndef HTTPSCAN_H
+#define HTTPSCAN_H              1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares a simple scanner for outgoing HTTP request headers, and the
+ * per-connection state which lets it only look at request boundaries.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+
+/**
+ * Scanner for the headers of outgoing HTTP requests.
+ *
+ * Finding the few headers we care about used to be done by a separate search
+ * of the whole send buffer for each one, on every send, so the bodies of any
+ * uploads got searched too. This makes one pass over the headers, finding the
+ * line ends 16 bytes at a time with SSE2 and checking the name at the start
+ * of each line against the ones we want.
+ *
+ * Each connection has one of these in its socket state, to follow where the
+ * request boundaries are; once the headers of a request have been seen, the
+ * body is just counted off without looking at it, and a connection that turns
+ * out not to be carrying HTTP at all is left alone from then on. If the
+ * headers of a request arrive over several sends, they're held back until
+ * the whole set is there so the request can be filtered as a whole.
+ */
+
+class HttpScan {
+public:
+        enum { HOLD_LIMIT = 8192 };
+
+        /**
+         * What the headers of a complete request told us.
+         *
+         * The verb length is only set for the GET and POST requests that the
+         * URL filters apply to, and includes the following space; the URL
+         * length is from the start of the request to the end of the URL. The
+         * host length includes the CRLF at the end of the header.
+         */
+
+        struct Request {
+                size_t          m_length;
+                size_t          m_verb;
+                size_t          m_url;
+                const char    * m_host;
+                size_t          m_hostLength;
+                unsigned long   m_contentLength;
+                bool            m_chunked;
+        };
+
+private:
+        enum Phase {
+                START,
+                HEADERS,
+                BODY,
+                OPAQUE
+        };
+
+        Phase           m_phase;
+        unsigned long   m_body;
+        char          * m_held;
+        size_t          m_heldLength;
+
+        /* NOCOPY */    HttpScan (const HttpScan &);
+        void            operator = (const HttpScan &);
+
+public:
+                        HttpScan ();
+                      ~ HttpScan ();
+
+static  const char    * findLine (const char * from, const char * end);
+static  bool            isRequest (const char * buf, size_t length);
+static  bool            parse (const char * buf, size_t length,
+                               Request & request);
+
+        bool            opaque (void) const { return m_phase == OPAQUE; }
+        bool            inBody (void) const { return m_phase == BODY; }
+        bool            holding (void) const { return m_phase == HEADERS; }
+        const char    * held (void) const { return m_held; }
+        size_t          heldLength (void) const { return m_heldLength; }
+
+        unsigned long   skipBody (unsigned long length);
+        bool            hold (const char * buf, size_t length);
+        void            unhold (size_t length);
+        void            started (const Request & request, size_t body);
+        void            restart (void);
+        void            giveUp (void);
+        void            release (void);
+};
+
+/**@}*/
+#endif  /* ! defined (HTTPSCAN_H) */
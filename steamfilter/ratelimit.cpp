@@ -0,0 +1,203 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * Token buckets for limiting the rate data is received at.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+
+#include "ratelimit.h"
+
+/**
+ * Make a new limit, for a rate in bytes per second.
+ */
+
+/* static */
+RateLimit * RateLimit :: create (unsigned long rate) {
+        if (rate == 0)
+                return 0;
+
+        return new RateLimit (rate);
+}
+
+/**
+ * Set up a bucket which starts out full.
+ *
+ * The bucket holds enough for BURST_MS of data at the full rate, so that the
+ * reads it allows aren't so small that the per-read overhead starts to count;
+ * but never less than a full-sized TCP segment, since smaller reads than that
+ * just mean more of them.
+ */
+
+RateLimit :: RateLimit (unsigned long rate) : m_refs (1), m_rate (rate),
+                m_burst ((LONGLONG) rate * BURST_MS / 1000), m_tokens (0),
+                m_last (0), m_frequency (0) {
+        InitializeCriticalSection (& m_lock);
+
+        if (m_burst < MIN_SLICE)
+                m_burst = MIN_SLICE;
+        m_tokens = m_burst;
+
+        LARGE_INTEGER   value;
+        if (QueryPerformanceFrequency (& value))
+                m_frequency = value.QuadPart;
+
+        QueryPerformanceCounter (& value);
+        m_last = value.QuadPart;
+}
+
+RateLimit :: ~ RateLimit () {
+        DeleteCriticalSection (& m_lock);
+}
+
+/**
+ * Simple reference counting for limits.
+ */
+
+void RateLimit :: addRef (void) {
+        InterlockedIncrement (& m_refs);
+}
+
+void RateLimit :: release (void) {
+        if (InterlockedDecrement (& m_refs) == 0)
+                delete this;
+}
+
+/**
+ * Top up the bucket for the time since it was last looked at, with the lock
+ * held.
+ *
+ * Anything more than a second of idle time just fills the bucket, which keeps
+ * the arithmetic comfortably inside 64 bits.
+ */
+
+void RateLimit :: refill (void) {
+        LARGE_INTEGER   now;
+        QueryPerformanceCounter (& now);
+
+        LONGLONG        elapsed = now.QuadPart - m_last;
+        if (elapsed <= 0 || m_frequency == 0)
+                return;
+
+        if (elapsed >= m_frequency) {
+                m_tokens = m_burst;
+                m_last = now.QuadPart;
+                return;
+        }
+
+        /*
+         * Only advance the clock by the time the new bytes account for, so
+         * lots of quick reads don't each lose a fraction of a byte.
+         */
+
+        LONGLONG        bytes = elapsed * m_rate / m_frequency;
+        if (bytes == 0)
+                return;
+
+        m_last += bytes * m_frequency / m_rate;
+        m_tokens += bytes;
+        if (m_tokens > m_burst)
+                m_tokens = m_burst;
+}
+
+/**
+ * Work out how long in milliseconds a reader has to wait for the bucket to get
+ * out of debt; 0 means a read can go ahead now.
+ */
+
+unsigned long RateLimit :: delay (void) {
+        EnterCriticalSection (& m_lock);
+
+        refill ();
+
+        unsigned long   wait = 0;
+        if (m_tokens < 0) {
+                LONGLONG        ms = (- m_tokens * 1000 + m_rate - 1) / m_rate;
+                wait = ms > MAX_WAIT ? MAX_WAIT : (unsigned long) ms;
+        }
+
+        LeaveCriticalSection (& m_lock);
+        return wait;
+}
+
+/**
+ * Work out how much of a read of the given size the bucket will allow now.
+ *
+ * This is what's in the bucket, but at least MIN_SLICE so that a reader who
+ * has waited out the debt always gets to make progress.
+ */
+
+unsigned long RateLimit :: allow (unsigned long want) {
+        EnterCriticalSection (& m_lock);
+
+        refill ();
+
+        LONGLONG        tokens = m_tokens;
+        if (tokens < MIN_SLICE)
+                tokens = MIN_SLICE;
+
+        LeaveCriticalSection (& m_lock);
+        return tokens < want ? (unsigned long) tokens : want;
+}
+
+/**
+ * Take data which has been received out of the bucket.
+ *
+ * Datagrams can't be cut down to fit, so the debt they run up could be large;
+ * rather than stall a socket for ages after a burst, the debt is capped at a
+ * second's worth.
+ */
+
+void RateLimit :: charge (unsigned long bytes) {
+        EnterCriticalSection (& m_lock);
+
+        m_tokens -= bytes;
+        if (m_tokens < - (LONGLONG) m_rate)
+                m_tokens = - (LONGLONG) m_rate;
+
+        LeaveCriticalSection (& m_lock);
+}
+
+/**
+ * Give back part of a charge made in advance for a read which turned out to
+ * deliver less than it might have.
+ */
+
+void RateLimit :: refund (unsigned long bytes) {
+        EnterCriticalSection (& m_lock);
+
+        m_tokens += bytes;
+        if (m_tokens > m_burst)
+                m_tokens = m_burst;
+
+        LeaveCriticalSection (& m_lock);
+}
+
+/**@}*/
@@ -0,0 +1,94 @@
+#ifndef RATELIMIT_H
+#define RATELIMIT_H             1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares a simple token bucket for limiting the rate data is received
+ * at, shared between all the connections a limit applies to.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Token bucket for a receive rate limit.
+ *
+ * The original point of the limiter was only ever to steer Steam at servers
+ * which don't count against a user's quota; but where there's no such server,
+ * the next best thing is to keep Steam from flooding the connection, so that
+ * a download can run during the day without ruining everything else.
+ *
+ * The bucket fills at the limit rate (measured with the performance counter,
+ * since the tick count only moves every 15ms or so, which is a long time at
+ * these rates) and reads are charged against it once the data is in hand; a
+ * read can take the bucket into debt, and the debt has to be paid off before
+ * the next read is allowed. Limits are reference-counted, because connections
+ * can outlast the rules which gave them their limits.
+ */
+
+class RateLimit {
+public:
+        enum {
+                BURST_MS = 250,
+                MIN_SLICE = 1460,
+                MAX_WAIT = 1000
+        };
+
+private:
+        volatile LONG   m_refs;
+        CRITICAL_SECTION m_lock;
+        unsigned long   m_rate;
+        LONGLONG        m_burst;
+        LONGLONG        m_tokens;
+        LONGLONG        m_last;
+        LONGLONG        m_frequency;
+
+        void            refill (void);
+
+                        RateLimit (unsigned long rate);
+                      ~ RateLimit ();
+
+        /* NOCOPY */    RateLimit (const RateLimit &);
+        void            operator = (const RateLimit &);
+
+public:
+static  RateLimit     * create (unsigned long rate);
+
+        void            addRef (void);
+        void            release (void);
+
+        unsigned long   rate (void) const { return m_rate; }
+
+        unsigned long   delay (void);
+        unsigned long   allow (unsigned long want);
+        void            charge (unsigned long bytes);
+        void            refund (unsigned long bytes);
+};
+
+/**@}*/
+#endif  /* ! defined (RATELIMIT_H) */
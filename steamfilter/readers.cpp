@@ -0,0 +1,193 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * Per-thread counters for the sections of code which use the hooks or the
+ * rules, so that the code which takes those away knows when it can.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+
+#include "readers.h"
+
+/**
+ * A thread's counters, in a cache line of its own.
+ *
+ * The owner is the ID of the thread which has claimed the slot; the first slot
+ * is never claimed, it's the one shared by any threads that don't get a slot.
+ */
+
+struct __declspec (align (64)) ReaderSlot {
+        volatile LONG   m_owner;
+        volatile LONG   m_counts [READER_KINDS];
+};
+
+static ReaderSlot       l_slots [READER_SLOTS];
+
+/**
+ * The TLS index holding each thread's slot.
+ *
+ * Static TLS isn't usable in a DLL loaded with LoadLibrary () before Vista, so
+ * this is done the old-fashioned way; the index is allocated by the first
+ * thread to come along, and given back when the filter unloads. After that,
+ * anything still running here (such as an APC the unload couldn't wait for)
+ * just shares the first slot.
+ */
+
+static volatile LONG    l_index = (LONG) TLS_OUT_OF_INDEXES;
+static volatile LONG    l_unloaded;
+
+static unsigned long l_tlsIndex (void) {
+        LONG            index = l_index;
+        if (index != (LONG) TLS_OUT_OF_INDEXES || l_unloaded != 0)
+                return index;
+
+        unsigned long   fresh = TlsAlloc ();
+        if (fresh == TLS_OUT_OF_INDEXES)
+                return fresh;
+
+        index = InterlockedCompareExchange (& l_index, (LONG) fresh,
+                                            (LONG) TLS_OUT_OF_INDEXES);
+        if (index == (LONG) TLS_OUT_OF_INDEXES)
+                return fresh;
+
+        TlsFree (fresh);
+        return index;
+}
+
+/**
+ * Give back the TLS index, for good, as the filter unloads.
+ *
+ * Each DLL load would otherwise leak an index, and a process only has a
+ * thousand or so of them to go round.
+ */
+
+void g_unloadReaders (void) {
+        InterlockedExchange (& l_unloaded, 1);
+
+        LONG            index;
+        index = InterlockedExchange (& l_index, (LONG) TLS_OUT_OF_INDEXES);
+        if (index != (LONG) TLS_OUT_OF_INDEXES)
+                TlsFree (index);
+}
+
+/**
+ * Find the calling thread's counters, claiming a slot for it if need be.
+ *
+ * This is called on the way into the hooks, where the caller's last-error
+ * value has to be left alone, and TlsGetValue () resets it.
+ */
+
+volatile LONG * g_readerSlot (void) {
+        unsigned long   error = GetLastError ();
+        unsigned long   index = l_tlsIndex ();
+        if (index == TLS_OUT_OF_INDEXES) {
+                SetLastError (error);
+                return l_slots [0].m_counts;
+        }
+
+        ReaderSlot    * slot = (ReaderSlot *) TlsGetValue (index);
+        if (slot == 0) {
+                LONG            self = (LONG) GetCurrentThreadId ();
+
+                slot = l_slots;
+                for (unsigned long i = 1 ; i < READER_SLOTS ; ++ i) {
+                        if (l_slots [i].m_owner == 0 &&
+                            InterlockedCompareExchange (& l_slots [i].m_owner,
+                                                        self, 0) == 0) {
+                                slot = l_slots + i;
+                                break;
+                        }
+                }
+
+                TlsSetValue (index, slot);
+        }
+
+        SetLastError (error);
+        return slot->m_counts;
+}
+
+/**
+ * Give up the calling thread's slot, as the thread exits.
+ *
+ * If the thread somehow still seems to be inside a section, the slot is kept
+ * as it is, so anyone waiting on it isn't fooled. APCs still queued for the
+ * thread are thrown away along with it, though, so those stop counting.
+ */
+
+void g_releaseReaderSlot (void) {
+        LONG            index = l_index;
+        if (index == (LONG) TLS_OUT_OF_INDEXES)
+                return;
+
+        ReaderSlot    * slot = (ReaderSlot *) TlsGetValue (index);
+        if (slot == 0)
+                return;
+
+        TlsSetValue (index, 0);
+        if (slot == l_slots)
+                return;
+
+        InterlockedExchange (slot->m_counts + READER_APCS, 0);
+
+        for (unsigned long i = 0 ; i < READER_KINDS ; ++ i)
+                if (slot->m_counts [i] != 0)
+                        return;
+
+        InterlockedExchange (& slot->m_owner, 0);
+}
+
+/**
+ * Wait for every thread to be out of a kind of section, for up to a timeout in
+ * milliseconds (which can be INFINITE); this returns whether they all were.
+ *
+ * The caller has to have done whatever stops threads entering the section in
+ * a way that matters (unhooking, or publishing new rules) with an interlocked
+ * operation first, since threads entering use one before they go on to look.
+ */
+
+bool g_waitReaders (ReaderKind kind, unsigned long timeout) {
+        unsigned long   start = GetTickCount ();
+
+        for (;;) {
+                unsigned long   i = 0;
+                while (i < READER_SLOTS && l_slots [i].m_counts [kind] == 0)
+                        ++ i;
+
+                if (i == READER_SLOTS)
+                        return true;
+
+                if (timeout != INFINITE && GetTickCount () - start >= timeout)
+                        return false;
+
+                Sleep (1);
+        }
+}
+
+/**@}*/
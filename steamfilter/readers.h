@@ -0,0 +1,73 @@
+#ifndef READERS_H
+#define READERS_H               1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares per-thread counters for marking the sections of code which
+ * use something that another thread may want to take away, such as the hooks
+ * themselves or a snapshot of the rules.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * The kinds of section a thread can be inside.
+ *
+ * Each thread which uses these gets a slot of its own, in its own cache line,
+ * so entering and leaving a section only ever touches memory that the thread
+ * has to itself; the (rare) code which waits for a kind of section to be left
+ * scans all the slots instead. Once the slots run out, the threads left over
+ * share the first one, which still works, just not as quickly.
+ *
+ * The rules have two kinds, one per parity of the rule epoch, so that a writer
+ * only waits for readers which could have seen the old rules.
+ *
+ * Completion routines queued as APCs are counted apart from the hooks, since
+ * they only run once their thread waits alertably, which it might never do.
+ */
+
+enum ReaderKind {
+        READER_RULES,
+        READER_RULES_ODD,
+        READER_HOOKS,
+        READER_APCS,
+        READER_KINDS
+};
+
+enum {
+        READER_SLOTS = 128
+};
+
+volatile LONG * g_readerSlot (void);
+void            g_releaseReaderSlot (void);
+bool            g_waitReaders (ReaderKind kind, unsigned long timeout);
+void            g_unloadReaders (void);
+
+/**@}*/
+#endif  /* ! defined (READERS_H) */
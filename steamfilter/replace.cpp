@@ -41,7 +41,9 @@
  *
  * Since replacement events are expected to be rare, there is generally only
  * likely to be a single outstanding one, and generally it will be consumed in
- * a single read call, so a simple linked list should do for matching things.
+ * a single read call; but the per-socket state is looked up on every read and
+ * write, so it's kept in a hash table where the usual case of there being no
+ * replacement pending costs next to nothing.
  *
  * When a replacement URL is detected, the replacement data structure is set up
  * and the caller's request is discarded so that the connected peer does not
@@ -72,6 +74,11 @@
 #include <winsock2.h>
 
 #include "replace.h"
+#include "filterrule.h"
+#include "httpscan.h"
+#include "ratelimit.h"
+#include "eventlog.h"
+#include "heap.h"
 
 /**
  * Cliche for measuring array lengths, to avoid mistakes with sizeof ().
@@ -82,29 +89,23 @@
 /**
  * Base object for implementing socket state tracking.
  *
- * This is set up for binding sockets and event handles so that applications
- * get notified when a socket becomes readable, since the lack of true AIO in
- * classic sockets requires separate eventing mechanisms (from the simple to
- * the absurd as in epoll (), which is essentially socket-specific as well as
- * baroque and hard to use compared to a universal AIO model).
+ * Each kind of tracking item hangs off the entry for its socket in the socket
+ * table below, in a simple chain so that (for instance) several replacement
+ * documents due on the same connection are delivered in the order they were
+ * set up. Since items are deleted through this base, the destructor is
+ * virtual.
+ *
+ * Items that have to be picked out by something other than their socket can
+ * say whether they match a key, which is compared by pointer.
  */
 
 class SocketTrack {
-        /*
-         * Friend-ing an entire template is not something you see often, but
-         * it's been a part of the language for a while.
-         */
-
-        template <class T>
-        friend class SocketList;
+        friend class SocketTable;
 
 private:
         SocketTrack   * m_next;
-        SocketTrack   * m_prev;
         SOCKET          m_handle;
-
-public:
-        WSAEVENT        m_event;
+        unsigned long   m_added;
 
 private:
         /* NOCOPY */    SocketTrack (const SocketTrack &);
@@ -112,8 +113,11 @@ private:
 
 public:
                         SocketTrack (SOCKET handle);
+virtual               ~ SocketTrack () { }
 
         SOCKET          handle (void) const { return m_handle; }
+        unsigned long   added (void) const { return m_added; }
+virtual bool            matches (const void * /* key */) const { return false; }
 
 static  void          * operator new (size_t length) throw ();
 static  void          * operator new (size_t length, void * mem) throw ();
@@ -126,7 +130,7 @@ static  void            operator delete (void * mem) throw ();
 
 /* static */
 void * SocketTrack :: operator new (size_t length) throw () {
-        return HeapAlloc (GetProcessHeap (), 0, length);
+        return g_privateAlloc (length);
 }
 
 /**
@@ -145,445 +149,1304 @@ void * SocketTrack :: operator new (size_t length, void * mem) throw () {
 
 /* static */
 void SocketTrack :: operator delete (void * mem) throw () {
-        HeapFree (GetProcessHeap (), 0, mem);
+        g_privateFree (mem);
 }
 
 /**
  * Trivial constructor.
  */
 
-SocketTrack :: SocketTrack (SOCKET handle) : m_next (0), m_prev (0),
-                m_handle (handle), m_event (0) {
+SocketTrack :: SocketTrack (SOCKET handle) : m_next (0), m_handle (handle),
+                m_added (GetTickCount ()) {
 }
 
 /**
- * Simple list-holder.
+ * The kinds of tracking item a socket can have.
+ */
+
+enum TrackKind {
+        TRACK_REPLACE,
+        TRACK_DISCARD,
+        TRACK_TRANSFER,
+        TRACK_COMPLETION,
+        TRACK_REQUEST,
+        TRACK_LIMIT,
+        TRACK_PACING,
+        TRACK_DESTINATION,
+        TRACK_KINDS
+};
+
+/**
+ * All the state we hold for one socket.
+ *
+ * As well as the tracking items, this says whether the socket has been put in
+ * non-blocking mode, and holds the timer for telling the owner of a socket
+ * when a read we turned away can go ahead.
+ */
+
+struct SocketState {
+        SOCKET          m_handle;
+        WSAEVENT        m_event;
+        HANDLE          m_port;
+        ULONG_PTR       m_key;
+        bool            m_nonBlocking;
+        HANDLE          m_timer;
+        SocketTrack   * m_items [TRACK_KINDS];
+};
+
+/**
+ * Table of the state for every socket we're keeping track of.
  *
- * Intrusive lists have been a part of C++ forever, since they were the common
- * thing done in C for many years before. However, in early C++ what was done
- * in most programs was to convert a common node structure and extend it using
- * virtual functions.
+ * Originally each kind of tracking item lived in its own linked list, each
+ * with a lock, which was fine while the only things in the lists were the odd
+ * replacement document; but every socket Steam binds an event to needs an
+ * entry too, and the lists are consulted on every read and write, so walking
+ * them was the bulk of the cost of the read and write hooks.
  *
- * Although this could be done to be typesafe, it had problems not the least of
- * which was typesafety required constantly injecting new virtual functions
- * into the base classes or the moral equivalent (e.g. COM-style QueryInterface
- * which was elegant but not being integrated into the language, lots of work).
+ * So, the state for each socket is kept in an open-addressed hash table, split
+ * into shards by the socket hash so that threads working on different sockets
+ * rarely contend for a lock; for the common case where there are no items of
+ * a given kind anywhere (as there is almost never a replacement or discard
+ * pending) there's a count per kind which lets lookups return without taking
+ * any lock at all.
  *
- * Templates in the 1990 ARM promised to help with this by introducing some
- * parametric genericity, but being mostly a system pf complex hygenic macro-
- * expanders the quality of implementation was low and remained low for well
- * into the 2000s and even then tended to cause code explosion. Finally, around
- * the late 2000's quality implementations of templates style could really
- * rival the old pre-1990s one in total efficiency thanks to function-level
- * linking and deduplication (although that's not entirely free either, as it
- * can make for a disorienting debug experience).
+ * Within a shard, slots which held a socket that has since gone are left as
+ * tombstones (marked with INVALID_SOCKET) so that probe sequences aren't cut
+ * short; a free slot has a handle of 0, which Windows never uses for sockets.
+ * The shard is rebuilt once free slots get scarce.
  */
 
-template <class T>
-struct SocketList {
-typedef CRITICAL_SECTION      Mutex;
+typedef void (* TrackVisitFunc) (SocketTrack * item, void * context);
+
+class SocketTable {
+public:
+        enum {
+                SHARDS = 16,
+                INITIAL_SLOTS = 16
+        };
+
+private:
+        struct Shard {
+                CRITICAL_SECTION m_lock [1];
+                SocketState   * m_slots;
+                unsigned long   m_capacity;
+                unsigned long   m_used;
+                unsigned long   m_live;
+        };
+
+        Shard           m_shards [SHARDS];
+        volatile LONG   m_counts [TRACK_KINDS];
+        HANDLE          m_timers;
+
+static  unsigned long   hash (SOCKET handle);
+static  bool            rebuild (Shard & shard);
+static  SocketState   * lookup (Shard & shard, SOCKET handle,
+                                unsigned long hash, bool create);
+static  void            release (Shard & shard, SocketState * state);
 
-        Mutex           m_lock [1];
-        T             * m_head;
+        Shard         & shard (SOCKET handle, unsigned long & hash);
 
-                        SocketList ();
-                      ~ SocketList ();
+public:
+                        SocketTable ();
+                      ~ SocketTable ();
 
         void            free (void);
+        bool            startTimers (void);
+
+        void            setEvent (SOCKET handle, WSAEVENT event);
+        WSAEVENT        event (SOCKET handle);
+        void            setPort (SOCKET handle, HANDLE port, ULONG_PTR key);
+        HANDLE          port (SOCKET handle, ULONG_PTR * key);
+        void            setBlocking (SOCKET handle, bool nonBlocking);
+        bool            nonBlocking (SOCKET handle);
+        bool            defer (SOCKET handle, unsigned long delay,
+                               WAITORTIMERCALLBACK callback);
+
+        bool            any (TrackKind kind) const {
+                return m_counts [kind] != 0;
+        }
 
-        void            add (T & item);
-        T             * find (SOCKET handle);
-        void            remove (T * item, bool free = false);
+        bool            add (SocketTrack * item, TrackKind kind);
+        SocketTrack   * find (SOCKET handle, TrackKind kind);
+        bool            visit (SOCKET handle, TrackKind kind,
+                               TrackVisitFunc func, void * context);
+        SocketTrack   * take (SOCKET handle, TrackKind kind, const void * key);
+        SocketTrack   * expire (SOCKET handle, TrackKind kind,
+                                unsigned long age, unsigned long keep);
+        void            remove (SocketTrack * item, TrackKind kind);
         void            remove (SOCKET handle);
 };
 
 /**
- * Initialize an empty list.
+ * Initialize an empty table.
  */
 
-template <class T>
-SocketList<T> :: SocketList () : m_head (0) {
-        InitializeCriticalSection (m_lock);
+SocketTable :: SocketTable () : m_timers (0) {
+        memset (m_shards, 0, sizeof (m_shards));
+        memset ((void *) m_counts, 0, sizeof (m_counts));
+
+        for (unsigned long i = 0 ; i < SHARDS ; ++ i)
+                InitializeCriticalSection (m_shards [i].m_lock);
 }
 
 /**
- * Deinitialize the list and locking structure.
+ * Deinitialize the table and locking structures.
  */
 
-template <class T>
-SocketList<T> :: ~ SocketList () {
+SocketTable :: ~ SocketTable () {
         free ();
 
-        DeleteCriticalSection (m_lock);
+        for (unsigned long i = 0 ; i < SHARDS ; ++ i)
+                DeleteCriticalSection (m_shards [i].m_lock);
 }
 
 /**
- * Free all the list members, deallocating them.
+ * Mix up the bits of a socket handle; handles are small, and multiples of 4,
+ * so they need a little stirring before they make a good hash.
  */
 
-template <class T>
-void SocketList<T> :: free (void) {
-        EnterCriticalSection (m_lock);
+/* static */
+unsigned long SocketTable :: hash (SOCKET handle) {
+        unsigned long   value = (unsigned long) handle;
+        value ^= value >> 16;
+        value *= 0x45D9F3BUL;
+        value ^= value >> 16;
+        return value;
+}
 
-        while (m_head != 0)
-                remove (m_head, true);
+/**
+ * Pick the shard for a handle.
+ */
 
-        LeaveCriticalSection (m_lock);
+SocketTable :: Shard & SocketTable :: shard (SOCKET handle,
+                                             unsigned long & value) {
+        value = hash (handle);
+        return m_shards [value % SHARDS];
 }
 
 /**
- * Add a new item.
+ * Rebuild a shard's slots, with the lock held, to clear out the tombstones
+ * and to grow it if it's getting full.
  */
 
-template <class T>
-void SocketList<T> :: add (T & item) {
-        EnterCriticalSection (m_lock);
+/* static */
+bool SocketTable :: rebuild (Shard & shard) {
+        unsigned long   capacity = shard.m_capacity;
+        if (capacity == 0) {
+                capacity = INITIAL_SLOTS;
+        } else if (shard.m_live * 4 >= capacity)
+                capacity *= 2;
+
+        SocketState   * slots;
+        slots = (SocketState *) g_privateAlloc (capacity *
+                                                        sizeof (SocketState),
+                                                HEAP_ZERO_MEMORY);
+        if (slots == 0)
+                return false;
 
-        item.m_next = m_head;
-        item.m_prev = 0;
-        m_head = & item;
+        SocketState   * old = shard.m_slots;
+        unsigned long   oldCapacity = shard.m_capacity;
 
-        LeaveCriticalSection (m_lock);
+        shard.m_slots = slots;
+        shard.m_capacity = capacity;
+        shard.m_used = shard.m_live;
+
+        for (unsigned long i = 0 ; i < oldCapacity ; ++ i) {
+                SocketState   * from = old + i;
+                if (from->m_handle == 0 || from->m_handle == INVALID_SOCKET)
+                        continue;
+
+                unsigned long   mask = capacity - 1;
+                unsigned long   index = (hash (from->m_handle) / SHARDS) & mask;
+                while (slots [index].m_handle != 0)
+                        index = (index + 1) & mask;
+
+                slots [index] = * from;
+        }
+
+        if (old != 0)
+                g_privateFree (old);
+
+        return true;
 }
 
 /**
- * Find an item.
- *
- * In a more general template, this would be a member template so that the
- * key type and comparison function could be parameterized, but this is just
- * a simplified example of the general style so I haven't bothered.
- *
- * The key reason this is here is to show a clean example of something memory-
- * light, which nothing in the modern STL can really claim to be (even for the
- * few good parts of classic STL, the retrofitting of exceptions into the STL
- * containers meant it's usually easier to ditch them in memory-constrained or
- * code-size-limited environments).
+ * Find the state for a socket in a shard, with the lock held, optionally
+ * making a new entry for it.
  */
 
-template <class T>
-T * SocketList<T> :: find (SOCKET handle) {
-        EnterCriticalSection (m_lock);
+/* static */
+SocketState * SocketTable :: lookup (Shard & shard, SOCKET handle,
+                                     unsigned long value, bool create) {
+        if (create && (shard.m_used + 1) * 4 > shard.m_capacity * 3 &&
+            ! rebuild (shard)) {
+                return 0;
+        }
 
-        T             * scan = m_head;
-        while (scan != 0) {
-                if (scan->m_handle == handle)
+        if (shard.m_slots == 0)
+                return 0;
+
+        unsigned long   mask = shard.m_capacity - 1;
+        unsigned long   index = (value / SHARDS) & mask;
+        SocketState   * free = 0;
+
+        for (unsigned long probe = 0 ; probe <= mask ; ++ probe) {
+                SocketState   * slot = shard.m_slots + index;
+                if (slot->m_handle == handle)
+                        return slot;
+
+                if (slot->m_handle == 0) {
+                        if (free == 0)
+                                free = slot;
                         break;
+                }
 
-                scan = (T *) scan->m_next;
+                if (slot->m_handle == INVALID_SOCKET && free == 0)
+                        free = slot;
+
+                index = (index + 1) & mask;
         }
 
-        LeaveCriticalSection (m_lock);
-        return scan;
+        if (! create || free == 0)
+                return 0;
+
+        if (free->m_handle == 0)
+                ++ shard.m_used;
+        ++ shard.m_live;
+
+        memset (free, 0, sizeof (* free));
+        free->m_handle = handle;
+        return free;
 }
 
 /**
- * Remove an item from the list, optionally freeing it.
+ * If a socket's entry holds nothing any more, turn it into a tombstone.
  */
 
-template <class T>
-void SocketList<T> :: remove (T * item, bool free) {
-        EnterCriticalSection (m_lock);
-
-        T             * prev = (T *) item->m_prev;
-        T             * next = (T *) item->m_next;
-        if (prev == 0) {
-                m_head = next;
-        } else
-                prev->m_next = next;
-        if (next != 0)
-                next->m_prev = prev;
+/* static */
+void SocketTable :: release (Shard & shard, SocketState * state) {
+        if (state->m_event != 0 || state->m_port != 0 ||
+            state->m_nonBlocking || state->m_timer != 0) {
+                return;
+        }
 
-        LeaveCriticalSection (m_lock);
+        for (unsigned long i = 0 ; i < TRACK_KINDS ; ++ i)
+                if (state->m_items [i] != 0)
+                        return;
 
-        if (free)
-                delete item;
+        state->m_handle = INVALID_SOCKET;
+        -- shard.m_live;
 }
 
 /**
- * Remove and free an item based on a key.
+ * Free all the table entries, deallocating any tracking items.
+ *
+ * The timer queue goes first, waiting for any timer callback that is already
+ * running, so that nothing of ours is left to run once the DLL is unloaded.
  */
 
-template <class T>
-void SocketList<T> :: remove (SOCKET handle) {
-        EnterCriticalSection (m_lock);
+void SocketTable :: free (void) {
+        if (m_timers != 0) {
+                DeleteTimerQueueEx (m_timers, INVALID_HANDLE_VALUE);
+                m_timers = 0;
+        }
 
-        T            ** link = & m_head;
-        T             * scan = m_head;
-        T             * prev = 0;
-        while ((scan = * link) != 0) {
-                if (scan->m_handle == handle) {
-                        * link = (T *) scan->m_next;
-                        scan->m_prev = prev;
-                        break;
+        for (unsigned long i = 0 ; i < SHARDS ; ++ i) {
+                Shard         & shard = m_shards [i];
+                EnterCriticalSection (shard.m_lock);
+
+                for (unsigned long j = 0 ; j < shard.m_capacity ; ++ j) {
+                        SocketState   * state = shard.m_slots + j;
+                        state->m_timer = 0;
+                        for (unsigned long k = 0 ; k < TRACK_KINDS ; ++ k) {
+                                SocketTrack   * item;
+                                while ((item = state->m_items [k]) != 0) {
+                                        state->m_items [k] = item->m_next;
+                                        InterlockedDecrement (m_counts + k);
+                                        delete item;
+                                }
+                        }
                 }
 
-                prev = scan;
-                link = (T **) & scan->m_next;
-        }
+                if (shard.m_slots != 0)
+                        g_privateFree (shard.m_slots);
 
-        LeaveCriticalSection (m_lock);
+                shard.m_slots = 0;
+                shard.m_capacity = shard.m_used = shard.m_live = 0;
 
-        if (scan != 0)
-                delete scan;
+                LeaveCriticalSection (shard.m_lock);
+        }
 }
 
 /**
- * Structure for representing a replacement context.
+ * Create the queue for the timers which wake up the owners of sockets we have
+ * turned reads away from.
  */
 
-struct Replacement : public SocketTrack {
-        unsigned long   m_length;
-        unsigned long   m_offset;
-
-        unsigned char * m_data;
+bool SocketTable :: startTimers (void) {
+        if (m_timers == 0)
+                m_timers = CreateTimerQueue ();
 
-                        Replacement (SOCKET handle) : SocketTrack (handle) { }
-};
+        return m_timers != 0;
+}
 
 /**
- * Structure for representing an context where we're discarding output.
+ * Record the event handle bound to a socket; a zero event removes a binding.
  */
 
-struct Discarding : public SocketTrack {
-        unsigned long   m_length;
+void SocketTable :: setEvent (SOCKET handle, WSAEVENT event) {
+        if (handle == 0 || handle == INVALID_SOCKET)
+                return;
 
-                        Discarding (SOCKET handle) : SocketTrack (handle) { }
-};
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
 
-/**
- * The global list of bound event handles for sockets.
- */
+        SocketState   * state = lookup (shard, handle, value, event != 0);
+        if (state != 0) {
+                state->m_event = event;
+                release (shard, state);
+        }
 
-SocketList<SocketTrack> l_events;
+        LeaveCriticalSection (shard.m_lock);
+}
 
 /**
- * The global list of active replacement items.
+ * Find the event handle bound to a socket, if there is one.
  */
 
-SocketList<Replacement> l_replace;
-
-/**
- * Global list of sockets where we are discarding sent data.
- */
+WSAEVENT SocketTable :: event (SOCKET handle) {
+        if (handle == 0 || handle == INVALID_SOCKET)
+                return 0;
 
-SocketList<Discarding>  l_discard;
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
 
-/**
- * Root registry key in which replacement items are located.
- */
+        SocketState   * state = lookup (shard, handle, value, false);
+        WSAEVENT        event = state != 0 ? state->m_event : 0;
 
-HKEY                    l_rootKey;
+        LeaveCriticalSection (shard.m_lock);
+        return event;
+}
 
 /**
- * Set the root path used as the context for the names of replacement items.
+ * Record the completion port a socket has been associated with, and the key
+ * completions for it are posted with.
  *
- * It would presumably be nice to support either or both of registry and file
- * paths here, so that users could choose. In the first instance I'll probably
- * only implement registry-hosted item support, but it would be sensible to
- * have the filesystem path setup present in the hosting machinery.
+ * A socket can only ever be associated with one port, and stays that way until
+ * it's closed, so there's no need to handle removing a binding.
  */
 
-void g_initReplacement (ReplaceHKEY key, const wchar_t * regPath) {
-        LSTATUS         status = ERROR_NOT_FOUND;
-        HKEY            result = 0;
-        if (regPath != 0) {
-                status = RegOpenKeyExW ((HKEY) key, regPath, 0, KEY_READ,
-                                        & result);
+void SocketTable :: setPort (SOCKET handle, HANDLE port, ULONG_PTR key) {
+        if (handle == 0 || handle == INVALID_SOCKET || port == 0)
+                return;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, true);
+        if (state != 0) {
+                state->m_port = port;
+                state->m_key = key;
         }
 
-        if (status == ERROR_SUCCESS)
-                l_rootKey = result;
+        LeaveCriticalSection (shard.m_lock);
 }
 
 /**
- * Do any unload-time cleanup.
+ * Find the completion port a socket is associated with, if there is one.
  */
 
-void g_unloadReplacement (void) {
-        if (l_rootKey != 0) {
-                RegCloseKey (l_rootKey);
-                l_rootKey = 0;
+HANDLE SocketTable :: port (SOCKET handle, ULONG_PTR * key) {
+        if (handle == 0 || handle == INVALID_SOCKET)
+                return 0;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        HANDLE          port = 0;
+        if (state != 0) {
+                port = state->m_port;
+                if (key != 0)
+                        * key = state->m_key;
         }
 
-        l_replace.free ();
-        l_events.free ();
+        LeaveCriticalSection (shard.m_lock);
+        return port;
 }
 
 /**
- * Add tracking for an event handle bound to a socket.
- *
- * This might potentially be used to change a binding from one event or even to
- * remove a binding, although most socket client applications don't do that.
+ * Record whether a socket has been put in non-blocking mode.
  */
 
-void g_addEventHandle (SOCKET handle, WSAEVENT event) {
-        SocketTrack   * item = l_events.find (handle);
-        if (item != 0) {
-                item->m_event = event;
+void SocketTable :: setBlocking (SOCKET handle, bool nonBlocking) {
+        if (handle == 0 || handle == INVALID_SOCKET)
                 return;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, nonBlocking);
+        if (state != 0) {
+                state->m_nonBlocking = nonBlocking;
+                release (shard, state);
         }
 
-        item = new SocketTrack (handle);
-        l_events.add (* item);
+        LeaveCriticalSection (shard.m_lock);
 }
 
 /**
- * When a socket handle is being closed, remove any tracking data for it.
+ * Say whether a socket is in non-blocking mode; binding an event to a socket
+ * puts it in non-blocking mode too, and it can't be put back while there is
+ * an event bound to it.
  */
 
-void g_removeTracking (SOCKET handle) {
-        l_events.remove (handle);
-        l_replace.remove (handle);
-        l_discard.remove (handle);
+bool SocketTable :: nonBlocking (SOCKET handle) {
+        if (handle == 0 || handle == INVALID_SOCKET)
+                return false;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        bool            result = false;
+        if (state != 0)
+                result = state->m_nonBlocking || state->m_event != 0;
+
+        LeaveCriticalSection (shard.m_lock);
+        return result;
 }
 
 /**
- * Add a potential replacement document to the replacement set.
- *
- * This is a hook into us performed during rule parsing, although if we're
- * sourcing data from the registry we will probably do nothing.
+ * Start the timer which calls back once a read turned away from a socket can
+ * go ahead, replacing any timer already running for it.
  *
- * Whether file or registry is preferred, the name of the source is always
- * going to be relative to something; another problem with file access is that
- * the source directory for such content is unlikely to be one we can arrange
- * as such in the context of Steam itself, and it will need to have been set up
- * for us during the filter load somehow.
+ * The timer is one-shot; it's only deleted when it's replaced or the socket is
+ * closed, since deleting a timer from inside its own callback is messy.
  */
 
-void g_replacementCache (const wchar_t * /* name */) {
+bool SocketTable :: defer (SOCKET handle, unsigned long delay,
+                           WAITORTIMERCALLBACK callback) {
+        if (m_timers == 0 || handle == 0 || handle == INVALID_SOCKET)
+                return false;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, true);
+        HANDLE          old = 0;
+        bool            started = false;
+        if (state != 0) {
+                old = state->m_timer;
+                state->m_timer = 0;
+                started = CreateTimerQueueTimer (& state->m_timer, m_timers,
+                                                 callback, (void *) handle,
+                                                 delay, 0,
+                                                 WT_EXECUTEONLYONCE) != FALSE;
+                if (! started)
+                        state->m_timer = 0;
+
+                release (shard, state);
+        }
+
+        LeaveCriticalSection (shard.m_lock);
+
+        if (old != 0)
+                DeleteTimerQueueTimer (m_timers, old, 0);
+
+        return started;
 }
 
 /**
- * Format the current local date and time as an RFC 822/RFC 1123 string.
+ * Add a new tracking item to the end of the chain of its kind for a socket.
  */
 
-bool l_formatDate (char * buffer, size_t length) {
-        if (length < 32)
+bool SocketTable :: add (SocketTrack * item, TrackKind kind) {
+        SOCKET          handle = item->m_handle;
+        if (handle == 0 || handle == INVALID_SOCKET)
                 return false;
 
-static  char          * days [7] = {
-                "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
-        };
-static  char          * months [13] = {
-                "",
-                "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-                "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-        };
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
 
-        SYSTEMTIME      now;
-        GetSystemTime (& now);
+        SocketState   * state = lookup (shard, handle, value, true);
+        if (state != 0) {
+                SocketTrack  ** link = state->m_items + kind;
+                while (* link != 0)
+                        link = & (* link)->m_next;
 
-        wsprintfA (buffer, "%s, %d %s %04d %02d:%02d:%02d GMT",
-                   days [now.wDayOfWeek], now.wDay, months [now.wMonth],
-                   now.wYear, now.wHour, now.wMinute, now.wSecond);
+                item->m_next = 0;
+                * link = item;
+                InterlockedIncrement (m_counts + kind);
+        }
 
-        return true;
+        LeaveCriticalSection (shard.m_lock);
+        return state != 0;
 }
 
 /**
- * Helper for g_addReplacement (), create a replacement item record.
+ * Find the first tracking item of a kind for a socket.
+ *
+ * If there are no items of that kind at all, which is the usual case, this
+ * doesn't need to go near the table; the count might be a little stale, but
+ * an item added for a socket by one thread is only expected to be looked for
+ * after that thread has done something else with the socket (such as sending
+ * the request the item replaces), which takes care of any ordering.
  */
 
-bool g_addReplacement (SOCKET handle, const wchar_t * replacement, int status,
-                       const char * extraText) {
-        /*
-         * Compute the space required to hold a UTF-8 version of the input, and
-         * any template-type substitution needed (not that we support that as
-         * yet).
-         */
+SocketTrack * SocketTable :: find (SOCKET handle, TrackKind kind) {
+        if (m_counts [kind] == 0 || handle == 0 || handle == INVALID_SOCKET)
+                return 0;
 
-        int             utf8 = 0;
-        if (replacement != 0) {
-                utf8 = WideCharToMultiByte (CP_UTF8, 0, replacement, - 1, 0, 0, 0, 0);
-                if (utf8 == 0)
-                        return false;
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
 
-                -- utf8;
-        }
+        SocketState   * state = lookup (shard, handle, value, false);
+        SocketTrack   * item = state != 0 ? state->m_items [kind] : 0;
 
-        /*
-         * Given the size of the replacement document, we can prepare the HTTP
-         * headers for it and thus know the size of the header and thus the
-         * total combined space to allocate.
-         */
+        LeaveCriticalSection (shard.m_lock);
+        return item;
+}
 
-        char            date [80];
-        if (! l_formatDate (date, ARRAY_LENGTH (date)))
+/**
+ * Call a function on the first tracking item of a kind for a socket with the
+ * shard lock held, so that the socket being closed can't free the item while
+ * it is being worked on; this returns whether there was one.
+ *
+ * The function mustn't go near the table itself.
+ */
+
+bool SocketTable :: visit (SOCKET handle, TrackKind kind,
+                           TrackVisitFunc func, void * context) {
+        if (m_counts [kind] == 0 || handle == 0 || handle == INVALID_SOCKET)
                 return false;
 
-        char            redirect [512];
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
 
-        const char    * location = "";
-        const char    * statusText = "UNKNOWN";
-        switch (status) {
-        case 200:
-                if (replacement == 0 && extraText != 0)
-                        utf8 = strlen (extraText);
+        SocketState   * state = lookup (shard, handle, value, false);
+        SocketTrack   * item = state != 0 ? state->m_items [kind] : 0;
+        if (item != 0)
+                (* func) (item, context);
 
-                statusText = "OK";
-                break;
+        LeaveCriticalSection (shard.m_lock);
+        return item != 0;
+}
 
-        case 302:
-                if (extraText == 0)
-                        return false;
+/**
+ * Find a tracking item of a kind for a socket which matches a key, and unlink
+ * it from the table; freeing it is up to the caller.
+ */
 
-                wsprintfA (redirect, "Location: %s\r\n", extraText);
-                location = redirect;
+SocketTrack * SocketTable :: take (SOCKET handle, TrackKind kind,
+                                   const void * key) {
+        if (m_counts [kind] == 0 || handle == 0 || handle == INVALID_SOCKET)
+                return 0;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        SocketTrack   * item = 0;
+        if (state != 0) {
+                SocketTrack  ** link = state->m_items + kind;
+                while (* link != 0 && ! (* link)->matches (key))
+                        link = & (* link)->m_next;
+
+                item = * link;
+                if (item != 0) {
+                        * link = item->m_next;
+                        InterlockedDecrement (m_counts + kind);
+                        release (shard, state);
+                }
+        }
 
-                statusText = "REDIRECT";
-                break;
+        LeaveCriticalSection (shard.m_lock);
+        return item;
+}
 
-        default:
-                if (extraText != 0)
-                        statusText = extraText;
-                break;
+/**
+ * Unlink the oldest tracking item of a kind for a socket if it is older than
+ * the given age in milliseconds, or if there are more than a given number of
+ * items of that kind for the socket; freeing it is up to the caller.
+ */
+
+SocketTrack * SocketTable :: expire (SOCKET handle, TrackKind kind,
+                                     unsigned long age, unsigned long keep) {
+        if (m_counts [kind] == 0 || handle == 0 || handle == INVALID_SOCKET)
+                return 0;
+
+        unsigned long   now = GetTickCount ();
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        SocketTrack   * item = 0;
+        if (state != 0 && (item = state->m_items [kind]) != 0) {
+                unsigned long   count = 0;
+                for (SocketTrack * scan = item ; scan != 0 ;
+                     scan = scan->m_next) {
+                        ++ count;
+                }
+
+                if (count > keep || now - item->m_added > age) {
+                        state->m_items [kind] = item->m_next;
+                        InterlockedDecrement (m_counts + kind);
+                        release (shard, state);
+                } else
+                        item = 0;
         }
 
-        char            header [1024];
-        wsprintfA (header,
-                   "HTTP/1.1 %d %s\r\n"
-                   "Date: %s\r\n"
-                   "Expires: %s\r\n"
-                   "Content-Type: text/html; charset=UTF8\r\n"
-                   "Content-Length: %ld\r\n"
-                   "Connection: Keep-Alive\r\n"
-                   "%s"
-                   "\r\n", status, statusText, date, date, utf8, location);
+        LeaveCriticalSection (shard.m_lock);
+        return item;
+}
 
-        size_t          headerLength = strlen (header);
+/**
+ * Remove a tracking item and free it.
+ */
 
-        unsigned long   size = sizeof (Replacement) + headerLength + utf8 + 1;
+void SocketTable :: remove (SocketTrack * item, TrackKind kind) {
+        SOCKET          handle = item->m_handle;
+
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        bool            found = false;
+        if (state != 0) {
+                SocketTrack  ** link = state->m_items + kind;
+                while (* link != 0 && * link != item)
+                        link = & (* link)->m_next;
+
+                if (* link == item) {
+                        * link = item->m_next;
+                        found = true;
+                        InterlockedDecrement (m_counts + kind);
+                        release (shard, state);
+                }
+        }
 
-        /*
-         * Allocate the replacement control structure, and copy the replacement
-         * document text into it (converting to UTF-8).
-         */
+        LeaveCriticalSection (shard.m_lock);
 
-        void          * mem = Replacement :: operator new (size);
-        if (mem == 0)
-                return false;
+        if (found)
+                delete item;
+}
 
-        Replacement   * item = new (mem) Replacement (handle);
-        item->m_data = (unsigned char *) (item + 1);
+/**
+ * Remove everything we know about a socket.
+ */
 
-        memcpy (item->m_data, header, headerLength);
+void SocketTable :: remove (SOCKET handle) {
+        if (handle == 0 || handle == INVALID_SOCKET)
+                return;
 
-        if (replacement != 0) {
-                utf8 = WideCharToMultiByte (CP_UTF8, 0, replacement, - 1,
-                                            (LPSTR) item->m_data + headerLength,
-                                            utf8, 0, 0);
-                if (utf8 == 0) {
-                        delete item;
-                        return false;
+        unsigned long   value;
+        Shard         & shard = this->shard (handle, value);
+        EnterCriticalSection (shard.m_lock);
+
+        SocketState   * state = lookup (shard, handle, value, false);
+        SocketTrack   * items [TRACK_KINDS] = { 0 };
+        HANDLE          timer = 0;
+        if (state != 0) {
+                for (unsigned long i = 0 ; i < TRACK_KINDS ; ++ i) {
+                        items [i] = state->m_items [i];
+                        state->m_items [i] = 0;
                 }
-                -- utf8;
+
+                timer = state->m_timer;
+                state->m_event = 0;
+                state->m_port = 0;
+                state->m_key = 0;
+                state->m_nonBlocking = false;
+                state->m_timer = 0;
+                release (shard, state);
+        }
+
+        LeaveCriticalSection (shard.m_lock);
+
+        if (timer != 0)
+                DeleteTimerQueueTimer (m_timers, timer, 0);
+
+        for (unsigned long i = 0 ; i < TRACK_KINDS ; ++ i) {
+                SocketTrack   * item;
+                while ((item = items [i]) != 0) {
+                        items [i] = item->m_next;
+                        InterlockedDecrement (m_counts + i);
+                        delete item;
+                }
+        }
+}
+
+/**
+ * A rendered replacement document, with its HTTP headers.
+ *
+ * Rendering a document means reading it from the registry, converting it to
+ * UTF-8 and formatting the headers around it, none of which changes from one
+ * use of the document to the next except for the date; so documents are kept
+ * rendered in a cache, and shared between everything using them by counting
+ * references. The date headers are the only part made fresh each time, and so
+ * they're left out of the rendered text, which is split just after the status
+ * line where the dates go.
+ */
+
+struct Document {
+        volatile LONG   m_refs;
+        Document      * m_next;
+        unsigned long   m_hash;
+        char          * m_key;
+
+        unsigned long   m_split;
+        unsigned long   m_length;
+        unsigned char * m_data;
+
+        void            addRef ();
+        void            release ();
+};
+
+/**
+ * Simple reference counting for documents.
+ */
+
+void Document :: addRef () {
+        InterlockedIncrement (& m_refs);
+}
+
+void Document :: release () {
+        if (InterlockedDecrement (& m_refs) == 0)
+                g_privateFree (this);
+}
+
+/**
+ * Structure for representing a replacement context.
+ *
+ * This holds just the dates to patch into the shared document, and how much
+ * of the whole thing the reader has had so far.
+ */
+
+struct Replacement : public SocketTrack {
+        enum { DATES = 96 };
+
+        Document      * m_document;
+        unsigned long   m_length;
+        unsigned long   m_offset;
+        unsigned long   m_dateLength;
+        char            m_dates [DATES];
+
+                        Replacement (SOCKET handle, Document * document);
+                      ~ Replacement ();
+};
+
+/**
+ * A replacement holds its own reference to the document.
+ */
+
+Replacement :: Replacement (SOCKET handle, Document * document) :
+                SocketTrack (handle), m_document (document), m_length (0),
+                m_offset (0), m_dateLength (0) {
+        document->addRef ();
+}
+
+Replacement :: ~ Replacement () {
+        m_document->release ();
+}
+
+/**
+ * The cache of rendered replacement documents.
+ *
+ * There are only ever as many documents as there are rules which name them,
+ * so a simple list will do; the cache is flushed whenever anything under the
+ * registry key the documents come from changes, which we find out about by
+ * asking the registry to signal an event for us and checking the event as a
+ * document is looked up, so there's no need for a thread to watch with.
+ */
+
+class DocumentCache {
+private:
+        CRITICAL_SECTION m_lock [1];
+        Document      * m_head;
+        HKEY            m_key;
+        HANDLE          m_changed;
+
+        void            watch (void);
+
+public:
+                        DocumentCache ();
+                      ~ DocumentCache ();
+
+static  unsigned long   hash (const char * key);
+
+        void            watch (HKEY key);
+        void            unwatch (void);
+        void            flush (void);
+
+        Document      * find (const char * key);
+        Document      * add (Document * document);
+};
+
+/**
+ * Structure for representing an context where we're discarding output.
+ */
+
+struct Discarding : public SocketTrack {
+        unsigned long   m_length;
+
+                        Discarding (SOCKET handle) : SocketTrack (handle) { }
+};
+
+/**
+ * Structure for following a connection made to one of several replacement
+ * targets, so what it delivers can be credited to the target.
+ *
+ * Throughput is measured over windows of at least TRANSFER_WINDOW ms, which is
+ * long enough to smooth over the burstiness of individual reads.
+ */
+
+struct Transfer : public SocketTrack {
+        enum { TRANSFER_WINDOW = 1000 };
+
+        TargetStats   * m_target;
+        unsigned long   m_connecting;
+        unsigned long   m_start;
+        unsigned long   m_bytes;
+
+                        Transfer (SOCKET handle, TargetStats * target);
+                      ~ Transfer ();
+};
+
+/**
+ * The global table of socket state.
+ */
+
+SocketTable             l_sockets;
+
+/**
+ * Set up an empty cache.
+ */
+
+DocumentCache :: DocumentCache () : m_head (0), m_key (0), m_changed (0) {
+        InitializeCriticalSection (m_lock);
+}
+
+DocumentCache :: ~ DocumentCache () {
+        unwatch ();
+        flush ();
+
+        DeleteCriticalSection (m_lock);
+}
+
+/**
+ * Hash a document key (with FNV-1a).
+ */
+
+/* static */
+unsigned long DocumentCache :: hash (const char * key) {
+        unsigned long   value = 2166136261UL;
+        for (; * key != 0 ; ++ key)
+                value = (value ^ (unsigned char) * key) * 16777619UL;
+
+        return value;
+}
+
+/**
+ * Start watching a registry key for changes.
+ */
+
+void DocumentCache :: watch (HKEY key) {
+        unwatch ();
+
+        m_key = key;
+        m_changed = CreateEventW (0, FALSE, FALSE, 0);
+        watch ();
+}
+
+/**
+ * Ask the registry to signal us on the next change.
+ *
+ * The request is tied to the calling thread and is signalled if that thread
+ * exits, but that just means a spurious flush.
+ */
+
+void DocumentCache :: watch (void) {
+        if (m_key == 0 || m_changed == 0)
+                return;
+
+        unsigned long   filter;
+        filter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+        RegNotifyChangeKeyValue (m_key, TRUE, filter, m_changed, TRUE);
+}
+
+/**
+ * Stop watching for changes; the key itself belongs to the caller.
+ */
+
+void DocumentCache :: unwatch (void) {
+        if (m_changed != 0)
+                CloseHandle (m_changed);
+
+        m_changed = 0;
+        m_key = 0;
+}
+
+/**
+ * Drop the cache's references to all the documents.
+ */
+
+void DocumentCache :: flush (void) {
+        EnterCriticalSection (m_lock);
+
+        Document      * head = m_head;
+        m_head = 0;
+
+        LeaveCriticalSection (m_lock);
+
+        Document      * next;
+        for (; head != 0 ; head = next) {
+                next = head->m_next;
+                head->release ();
+        }
+}
+
+/**
+ * Look for a document in the cache; the caller gets a new reference to it.
+ */
+
+Document * DocumentCache :: find (const char * key) {
+        if (m_changed != 0 &&
+            WaitForSingleObject (m_changed, 0) == WAIT_OBJECT_0) {
+                flush ();
+                watch ();
+        }
+
+        unsigned long   value = hash (key);
+
+        EnterCriticalSection (m_lock);
+
+        Document      * scan = m_head;
+        for (; scan != 0 ; scan = scan->m_next)
+                if (scan->m_hash == value && strcmp (scan->m_key, key) == 0)
+                        break;
+
+        if (scan != 0)
+                scan->addRef ();
+
+        LeaveCriticalSection (m_lock);
+        return scan;
+}
+
+/**
+ * Add a newly rendered document to the cache, taking over the caller's
+ * reference and giving the caller a new one.
+ *
+ * If some other thread got in first with the same document, the caller's copy
+ * is released and the caller gets the other one instead.
+ */
+
+Document * DocumentCache :: add (Document * document) {
+        EnterCriticalSection (m_lock);
+
+        Document      * scan = m_head;
+        for (; scan != 0 ; scan = scan->m_next) {
+                if (scan->m_hash == document->m_hash &&
+                    strcmp (scan->m_key, document->m_key) == 0) {
+                        break;
+                }
+        }
+
+        if (scan == 0) {
+                document->m_next = m_head;
+                m_head = document;
+                scan = document;
+        } else
+                document->release ();
+
+        scan->addRef ();
+
+        LeaveCriticalSection (m_lock);
+        return scan;
+}
+
+/**
+ * The global cache of rendered documents.
+ */
+
+DocumentCache           l_documents;
+
+/**
+ * Root registry key in which replacement items are located.
+ */
+
+HKEY                    l_rootKey;
+
+/**
+ * Set the root path used as the context for the names of replacement items.
+ *
+ * It would presumably be nice to support either or both of registry and file
+ * paths here, so that users could choose. In the first instance I'll probably
+ * only implement registry-hosted item support, but it would be sensible to
+ * have the filesystem path setup present in the hosting machinery.
+ */
+
+void g_initReplacement (ReplaceHKEY key, const wchar_t * regPath) {
+        LSTATUS         status = ERROR_NOT_FOUND;
+        HKEY            result = 0;
+        if (regPath != 0) {
+                status = RegOpenKeyExW ((HKEY) key, regPath, 0, KEY_READ,
+                                        & result);
+        }
+
+        if (status == ERROR_SUCCESS) {
+                l_rootKey = result;
+                l_documents.watch (result);
+        }
+
+        l_sockets.startTimers ();
+}
+
+/**
+ * Do any unload-time cleanup.
+ */
+
+void g_unloadReplacement (void) {
+        l_documents.unwatch ();
+
+        if (l_rootKey != 0) {
+                RegCloseKey (l_rootKey);
+                l_rootKey = 0;
+        }
+
+        l_sockets.free ();
+        l_documents.flush ();
+}
+
+/**
+ * Add tracking for an event handle bound to a socket.
+ *
+ * This might potentially be used to change a binding from one event or even to
+ * remove a binding, although most socket client applications don't do that.
+ */
+
+void g_addEventHandle (SOCKET handle, WSAEVENT event) {
+        l_sockets.setEvent (handle, event);
+}
+
+/**
+ * Record a socket being put in or out of non-blocking mode.
+ */
+
+void g_setNonBlocking (SOCKET handle, bool nonBlocking) {
+        l_sockets.setBlocking (handle, nonBlocking);
+}
+
+/**
+ * Say whether a socket is in non-blocking mode, so a read on it mustn't wait.
+ */
+
+bool g_isNonBlocking (SOCKET handle) {
+        return l_sockets.nonBlocking (handle);
+}
+
+/**
+ * What to call once a read we turned away can go ahead; this is always the same
+ * function, so it's just kept here rather than with every timer.
+ */
+
+WakeFunc                l_wake;
+
+/**
+ * Timer callback for a read that was turned away.
+ */
+
+void CALLBACK l_deferDone (void * param, BOOLEAN /* fired */) {
+        WakeFunc        wake = l_wake;
+        if (wake != 0)
+                (* wake) ((SOCKET) param);
+}
+
+/**
+ * Arrange to wake up the owner of a non-blocking socket once a read we turned
+ * away with WSAEWOULDBLOCK can go ahead.
+ *
+ * An owner which is waiting on an event or window message for the socket won't
+ * hear about it again until it reads from the socket again, since that's what
+ * makes Winsock report the data still waiting; so the wake-up function is the
+ * hook's chance to do that read on the owner's behalf, without taking the data.
+ */
+
+bool g_deferRead (SOCKET handle, unsigned long delay, WakeFunc wake) {
+        l_wake = wake;
+        return l_sockets.defer (handle, delay, l_deferDone);
+}
+
+/**
+ * When a socket handle is being closed, remove any tracking data for it.
+ */
+
+void g_removeTracking (SOCKET handle) {
+        l_sockets.remove (handle);
+}
+
+/**
+ * Say whether any substitute responses are still to be delivered, including
+ * the completions for overlapped reads of them and the discarding of request
+ * bodies that go with them.
+ */
+
+bool g_replacing (void) {
+        return l_sockets.any (TRACK_REPLACE) || l_sockets.any (TRACK_DISCARD) ||
+               l_sockets.any (TRACK_COMPLETION);
+}
+
+/**
+ * Format the current local date and time as an RFC 822/RFC 1123 string.
+ */
+
+bool l_formatDate (char * buffer, size_t length) {
+        if (length < 32)
+                return false;
+
+static  char          * days [7] = {
+                "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+        };
+static  char          * months [13] = {
+                "",
+                "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+        };
+
+        SYSTEMTIME      now;
+        GetSystemTime (& now);
+
+        wsprintfA (buffer, "%s, %d %s %04d %02d:%02d:%02d GMT",
+                   days [now.wDayOfWeek], now.wDay, months [now.wMonth],
+                   now.wYear, now.wHour, now.wMinute, now.wSecond);
+
+        return true;
+}
+
+/**
+ * Render a replacement document, along with all its HTTP headers except for
+ * the dates, into a new document with a single reference.
+ */
+
+Document * l_render (const char * key, const wchar_t * replacement,
+                     int status, const char * extraText) {
+        /*
+         * Compute the space required to hold a UTF-8 version of the input, and
+         * any template-type substitution needed (not that we support that as
+         * yet).
+         */
+
+        int             utf8 = 0;
+        if (replacement != 0) {
+                utf8 = WideCharToMultiByte (CP_UTF8, 0, replacement, - 1,
+                                            0, 0, 0, 0);
+                if (utf8 == 0)
+                        return 0;
+
+                -- utf8;
+        }
+
+        /*
+         * Given the size of the replacement document, we can prepare the HTTP
+         * headers for it and thus know the size of the header and thus the
+         * total combined space to allocate.
+         */
+
+        char            redirect [512];
+
+        const char    * location = "";
+        const char    * statusText = "UNKNOWN";
+        switch (status) {
+        case 200:
+                if (replacement == 0 && extraText != 0)
+                        utf8 = strlen (extraText);
+
+                statusText = "OK";
+                break;
+
+        case 302:
+                if (extraText == 0)
+                        return 0;
+
+                wsprintfA (redirect, "Location: %s\r\n", extraText);
+                location = redirect;
+
+                statusText = "REDIRECT";
+                break;
+
+        default:
+                if (extraText != 0)
+                        statusText = extraText;
+                break;
+        }
+
+        char            header [2048];
+        int             split;
+        split = wsprintfA (header, "HTTP/1.1 %d %s\r\n", status, statusText);
+
+        wsprintfA (header + split,
+                   "Content-Type: text/html; charset=UTF8\r\n"
+                   "Content-Length: %ld\r\n"
+                   "Connection: Keep-Alive\r\n"
+                   "%s"
+                   "\r\n", utf8, location);
+
+        size_t          headerLength = strlen (header);
+        size_t          keyLength = strlen (key) + 1;
+
+        unsigned long   size = sizeof (Document) + keyLength + headerLength +
+                               utf8 + 1;
+
+        /*
+         * Allocate the document, and copy the replacement document text into
+         * it (converting to UTF-8).
+         */
+
+        Document      * document;
+        document = (Document *) g_privateAlloc (size);
+        if (document == 0)
+                return 0;
+
+        document->m_refs = 1;
+        document->m_next = 0;
+        document->m_hash = DocumentCache :: hash (key);
+        document->m_key = (char *) (document + 1);
+        document->m_split = split;
+        document->m_data = (unsigned char *) document->m_key + keyLength;
+
+        memcpy (document->m_key, key, keyLength);
+        memcpy (document->m_data, header, headerLength);
+
+        if (replacement != 0) {
+                utf8 = WideCharToMultiByte (CP_UTF8, 0, replacement, - 1,
+                                            (LPSTR) document->m_data +
+                                                    headerLength,
+                                            utf8 + 1, 0, 0);
+                if (utf8 == 0) {
+                        document->release ();
+                        return 0;
+                }
+                -- utf8;
         } else if (utf8 > 0) {
                 /*
                  * An alternative way to supply content via a #200 rule. In
                  * this mode, we use ~ as an escape for '\n';
                  */
 
-                unsigned char * dest = item->m_data + headerLength;
+                unsigned char * dest = document->m_data + headerLength;
                 unsigned long   count = utf8;
                 while (count > 0) {
                         unsigned char   ch = * extraText;
@@ -599,35 +1462,55 @@ bool g_addReplacement (SOCKET handle, const wchar_t * replacement, int status,
                 }
         }
 
-        item->m_length = headerLength + utf8;
-        item->m_offset = 0;
+        document->m_length = headerLength + utf8;
+        return document;
+}
 
-        l_replace.add (* item);
+/**
+ * Set up a socket to have a document read back from it.
+ *
+ * The only part of the response made specially for this socket is the date
+ * headers, which go after the status line at the front of the document.
+ */
+
+bool l_addReplacement (SOCKET handle, Document * document) {
+        Replacement   * item = new Replacement (handle, document);
+        if (item == 0)
+                return false;
+
+        char            date [80];
+        if (! l_formatDate (date, ARRAY_LENGTH (date))) {
+                delete item;
+                return false;
+        }
+
+        item->m_dateLength = wsprintfA (item->m_dates,
+                                        "Date: %s\r\n"
+                                        "Expires: %s\r\n", date, date);
+        item->m_length = document->m_length + item->m_dateLength;
+
+        if (! l_sockets.add (item, TRACK_REPLACE)) {
+                delete item;
+                return false;
+        }
 
         /*
          * Look for a bound event handle for the owner socket, and signal it as
          * we're making read data available.
          */
 
-        SocketTrack   * track = l_events.find (item->handle ());
-        if (track != 0)
-                SetEvent (track->m_event);
+        WSAEVENT        event = l_sockets.event (handle);
+        if (event != 0)
+                SetEvent (event);
 
         return true;
 }
 
 /**
- * Add a named replacement document item to be substituted on the indicated handle.
+ * Read a named replacement document from the registry and render it.
  */
 
-bool g_addReplacement (SOCKET handle, const char * name, const char * /* url */) {
-        wchar_t         tempName [80];
-        int             result;
-        result = MultiByteToWideChar (CP_UTF8, 0, name, - 1,
-                                      tempName, ARRAY_LENGTH (tempName));
-        if (result == 0)
-                return false;
-
+Document * l_loadDocument (const char * key, const wchar_t * name) {
         /*
          * Determine whether the named item exists, and what its size in UTF-16
          * characters is.
@@ -635,58 +1518,170 @@ bool g_addReplacement (SOCKET handle, const char * name, const char * /* url */)
 
         LSTATUS         status;
         unsigned long   length = 0;
-        status = RegQueryValueExW (l_rootKey, tempName, 0, 0, 0, & length);
+        status = RegQueryValueExW (l_rootKey, name, 0, 0, 0, & length);
         if (status != ERROR_SUCCESS) {
-                OutputDebugStringA ("HTTP replacement not found\r\n");
-                return false;
+                g_log (LOG_REPLACEMENT_MISSING);
+                return 0;
         }
 
         wchar_t       * replacement;
-        replacement = (wchar_t *) HeapAlloc (GetProcessHeap (), 0, length);
+        replacement = (wchar_t *) g_privateAlloc (length + sizeof (wchar_t));
         if (replacement == 0)
-                return false;
+                return 0;
+
+        unsigned long   type;
+        status = RegQueryValueExW (l_rootKey, name, 0, & type,
+                                   (LPBYTE) replacement, & length);
+        if (status != ERROR_SUCCESS) {
+                g_privateFree (replacement);
+                return 0;
+        }
+
+        if (type == REG_MULTI_SZ) {
+                /*
+                 * For MULTI_SZ just join all the component strings by changing
+                 * the interior terminator bytes into newlines.
+                 */
+
+                length = length / sizeof (wchar_t);
+                wchar_t       * scan = replacement;
+                wchar_t       * end = scan + length - 1;
+                for (; scan != end ; ++ scan)
+                        if (* scan == 0)
+                                * scan = '\n';
+        } else if (type == REG_SZ || type == REG_EXPAND_SZ) {
+                length = length / sizeof (wchar_t);
+        } else {
+                g_privateFree (replacement);
+                return 0;
+        }
+
+        /*
+         * Since a registry value has the potential to not be terminated,
+         * ensure that a terminator is present.
+         */
+
+        if (length == 0 || replacement [length - 1] != 0) {
+                replacement [length] = 0;
+                ++ length;
+        }
+
+        Document      * document = l_render (key, replacement, 200, 0);
+        g_privateFree (replacement);
+        return document;
+}
+
+/**
+ * Find a named replacement document, from the cache or the registry.
+ *
+ * The key for a named document in the cache is its name with a leading '<',
+ * just as it's written in a rule; that keeps it apart from the status-code
+ * documents, whose keys start with a '#'.
+ */
+
+Document * l_findDocument (const char * name) {
+        char            key [84];
+        key [0] = '<';
+        lstrcpynA (key + 1, name, ARRAY_LENGTH (key) - 1);
+
+        Document      * document = l_documents.find (key);
+        if (document != 0)
+                return document;
+
+        wchar_t         tempName [80];
+        int             result;
+        result = MultiByteToWideChar (CP_UTF8, 0, name, - 1,
+                                      tempName, ARRAY_LENGTH (tempName));
+        if (result == 0)
+                return 0;
+
+        document = l_loadDocument (key, tempName);
+        if (document == 0)
+                return 0;
+
+        return l_documents.add (document);
+}
+
+/**
+ * Add a potential replacement document to the replacement set.
+ *
+ * This is a hook into us performed during rule parsing, and as rules are
+ * loaded from a precompiled image; the name is UTF-8, as it is in the rule.
+ *
+ * Whether file or registry is preferred, the name of the source is always
+ * going to be relative to something; another problem with file access is that
+ * the source directory for such content is unlikely to be one we can arrange
+ * as such in the context of Steam itself, and it will need to have been set up
+ * for us during the filter load somehow.
+ *
+ * Since documents are now cached once rendered, what this does is render the
+ * named document into the cache ahead of time, so the first request for it
+ * doesn't have to wait on the registry.
+ */
+
+void g_replacementCache (const char * name) {
+        if (name == 0 || l_rootKey == 0)
+                return;
+
+        Document      * document = l_findDocument (name);
+        if (document != 0)
+                document->release ();
+}
+
+/**
+ * Helper for g_addReplacement (), create a replacement item record.
+ *
+ * The simple status-code documents from a '#' rule are cached by the status
+ * and text; an explicitly supplied document is just used the once.
+ */
+
+bool g_addReplacement (SOCKET handle, const wchar_t * replacement, int status,
+                       const char * extraText) {
+        Document      * document = 0;
+
+        if (replacement != 0) {
+                document = l_render ("", replacement, status, extraText);
+        } else {
+                size_t          length = 0;
+                if (extraText != 0)
+                        length = strlen (extraText);
+
+                char            key [1100];
+                if (length > ARRAY_LENGTH (key) - 16)
+                        return false;
+
+                wsprintfA (key, "#%d ", status);
+                if (extraText != 0)
+                        strcat (key, extraText);
 
-        unsigned long   type;
-        status = RegQueryValueExW (l_rootKey, tempName, 0, & type,
-                                   (LPBYTE) replacement, & length);
-        if (status != ERROR_SUCCESS) {
-                HeapFree (GetProcessHeap (), 0, replacement);
-                return false;
+                document = l_documents.find (key);
+                if (document == 0) {
+                        document = l_render (key, 0, status, extraText);
+                        if (document != 0)
+                                document = l_documents.add (document);
+                }
         }
 
-        if (type == REG_MULTI_SZ) {
-                /*
-                 * For MULTI_SZ just join all the component strings by changing
-                 * the interior terminator bytes into newlines.
-                 */
-
-                length = length / sizeof (wchar_t);
-                wchar_t       * scan = replacement;
-                wchar_t       * end = scan + length - 1;
-                for (; scan != end ; ++ scan)
-                        if (* scan == 0)
-                                * scan = '\n';
-        } else if (type == REG_SZ || type == REG_EXPAND_SZ) {
-                length = length / sizeof (wchar_t);
-        } else {
-                HeapFree (GetProcessHeap (), 0, replacement);
+        if (document == 0)
                 return false;
-        }
 
-        /*
-         * Since a registry value has the potential to not be terminated,
-         * ensure that a terminator is present.
-         */
+        bool            result = l_addReplacement (handle, document);
+        document->release ();
+        return result;
+}
 
-        if (replacement [length - 1] != 0) {
-                replacement [length] = 0;
-                ++ length;
-        }
+/**
+ * Add a named replacement document item to be substituted on the indicated handle.
+ */
 
-        bool            value;
-        value = g_addReplacement (handle, replacement, 200, 0);
-        HeapFree (GetProcessHeap (), 0, replacement);
-        return value;
+bool g_addReplacement (SOCKET handle, const char * name, const char * /* url */) {
+        Document      * document = l_findDocument (name);
+        if (document == 0)
+                return false;
+
+        bool            result = l_addReplacement (handle, document);
+        document->release ();
+        return result;
 }
 
 /**
@@ -694,7 +1689,7 @@ bool g_addReplacement (SOCKET handle, const char * name, const char * /* url */)
  */
 
 Replacement * g_findReplacement (SOCKET handle) {
-        return l_replace.find (handle);
+        return (Replacement *) l_sockets.find (handle, TRACK_REPLACE);
 }
 
 /**
@@ -704,6 +1699,9 @@ Replacement * g_findReplacement (SOCKET handle) {
  * API format to suit this (if we wanted to support multiple WSABUF structures,
  * for example, although for now we don't).
  *
+ * The response is copied straight from the shared document, with the dates
+ * for this response spliced in after the status line.
+ *
  * Note that we're assuming here that a given source socket is only being read
  * on a single thread, so there is no need for locking here. That's probably
  * not a safe assumption in general to make if we ever get used with clients
@@ -715,16 +1713,43 @@ bool g_consumeReplacement (Replacement * item, unsigned long length, void * buf,
         if (item == 0 || buf == 0)
                 return false;
 
-        unsigned long   avail = item->m_length - item->m_offset;
-        if (length < avail)
-                avail = length;
+        Document      * document = item->m_document;
+        unsigned long   split = document->m_split;
+        unsigned long   dates = split + item->m_dateLength;
+
+        unsigned char * dest = (unsigned char *) buf;
+        unsigned long   total = 0;
+
+        while (length > 0 && item->m_offset < item->m_length) {
+                unsigned long   offset = item->m_offset;
+                const unsigned char * from;
+                unsigned long   avail;
+
+                if (offset < split) {
+                        from = document->m_data + offset;
+                        avail = split - offset;
+                } else if (offset < dates) {
+                        from = (const unsigned char *) item->m_dates +
+                               offset - split;
+                        avail = dates - offset;
+                } else {
+                        from = document->m_data + offset - item->m_dateLength;
+                        avail = item->m_length - offset;
+                }
+
+                if (length < avail)
+                        avail = length;
 
-        memcpy (buf, item->m_data, avail);
+                memcpy (dest, from, avail);
 
-        if (copied != 0)
-                * copied = avail;
+                dest += avail;
+                total += avail;
+                length -= avail;
+                item->m_offset += avail;
+        }
 
-        item->m_offset += avail;
+        if (copied != 0)
+                * copied = total;
 
         if (item->m_offset != item->m_length)
                 return true;
@@ -733,7 +1758,7 @@ bool g_consumeReplacement (Replacement * item, unsigned long length, void * buf,
          * The replacement item has been consumed, remove it.
          */
 
-        l_replace.remove (item, true);
+        l_sockets.remove (item, TRACK_REPLACE);
         return true;
 }
 
@@ -755,7 +1780,11 @@ bool g_addDiscard (SOCKET handle, unsigned long length) {
                 return false;
 
         item->m_length = length;
-        l_discard.add (* item);
+        if (! l_sockets.add (item, TRACK_DISCARD)) {
+                delete item;
+                return false;
+        }
+
         return true;
 }
 
@@ -764,7 +1793,7 @@ bool g_addDiscard (SOCKET handle, unsigned long length) {
  */
 
 Discarding * g_findDiscard (SOCKET handle) {
-        return l_discard.find (handle);
+        return (Discarding *) l_sockets.find (handle, TRACK_DISCARD);
 }
 
 /**
@@ -783,7 +1812,458 @@ bool g_consumeDiscard (Discarding * item, unsigned long length, unsigned long *
                 * skip = used;
 
         if (item->m_length == 0)
-                l_discard.remove (item, true);
+                l_sockets.remove (item, TRACK_DISCARD);
+        return true;
+}
+
+/**
+ * Start following a connection to a replacement target; the item takes its
+ * own reference to the target statistics.
+ */
+
+Transfer :: Transfer (SOCKET handle, TargetStats * target) :
+                SocketTrack (handle), m_target (target), m_connecting (0),
+                m_start (GetTickCount ()), m_bytes (0) {
+        target->addRef ();
+        target->opened ();
+}
+
+/**
+ * When the connection is closed, credit the target with whatever is left of
+ * the current window.
+ *
+ * A connection still waiting to complete when it's closed never delivered a
+ * thing, which from the point of view of choosing a target is as good as a
+ * failure to connect.
+ */
+
+Transfer :: ~ Transfer () {
+        if (m_connecting != 0) {
+                m_target->failed ();
+        } else if (m_bytes > 0) {
+                unsigned long   elapsed = GetTickCount () - m_start;
+                if (elapsed >= TRANSFER_WINDOW / 4)
+                        m_target->delivered (m_bytes, elapsed);
+        }
+
+        m_target->closed ();
+        m_target->release ();
+}
+
+/**
+ * Add tracking for a connection to a replacement target.
+ *
+ * For non-blocking sockets the connection is still in progress when the
+ * connect () call returns, and there's no clean way to see it complete short
+ * of hooking every way an application can wait for that; so instead, the
+ * arrival of the first data is taken as the sign of a working connection.
+ */
+
+bool g_addTransfer (SOCKET handle, TargetStats * target, bool connected) {
+        SocketTrack   * old = l_sockets.find (handle, TRACK_TRANSFER);
+        if (old != 0)
+                l_sockets.remove (old, TRACK_TRANSFER);
+
+        Transfer      * item = new Transfer (handle, target);
+        if (item == 0)
+                return false;
+
+        if (! connected)
+                item->m_connecting = item->m_start;
+
+        if (! l_sockets.add (item, TRACK_TRANSFER)) {
+                delete item;
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Update a replacement target's transfer with data received, with the lock
+ * for its socket held; the receiving threads all come through here.
+ */
+
+void l_countTransfer (SocketTrack * track, void * context) {
+        Transfer      * item = (Transfer *) track;
+        unsigned long   bytes = * (unsigned long *) context;
+
+        unsigned long   now = GetTickCount ();
+        if (item->m_connecting != 0) {
+                item->m_target->connected (now - item->m_connecting);
+                item->m_connecting = 0;
+                item->m_start = now;
+        }
+
+        item->m_bytes += bytes;
+
+        unsigned long   elapsed = now - item->m_start;
+        if (elapsed < Transfer :: TRANSFER_WINDOW)
+                return;
+
+        item->m_target->delivered (item->m_bytes, elapsed);
+        item->m_bytes = 0;
+        item->m_start = now;
+}
+
+/**
+ * Credit data received on a socket to the replacement target it connected
+ * to, if there is one.
+ */
+
+void g_countTransfer (SOCKET handle, unsigned long bytes) {
+        if (bytes == 0)
+                return;
+
+        l_sockets.visit (handle, TRACK_TRANSFER, l_countTransfer, & bytes);
+}
+
+/**
+ * Structure for remembering the result of an overlapped operation which we
+ * completed for the caller, for WSAGetOverlappedResult () to report.
+ */
+
+struct Completion : public SocketTrack {
+        OVERLAPPED    * m_overlapped;
+        unsigned long   m_count;
+        unsigned long   m_flags;
+
+                        Completion (SOCKET handle, OVERLAPPED * overlapped) :
+                                SocketTrack (handle),
+                                m_overlapped (overlapped), m_count (0),
+                                m_flags (0) {
+                        }
+
+        bool            matches (const void * key) const {
+                return key == m_overlapped;
+        }
+};
+
+/**
+ * Record the completion port a socket has been associated with.
+ */
+
+void g_bindPort (SOCKET handle, HANDLE port, ULONG_PTR key) {
+        l_sockets.setPort (handle, port, key);
+}
+
+/**
+ * Find the completion port a socket has been associated with, if any.
+ */
+
+HANDLE g_findPort (SOCKET handle, ULONG_PTR * key) {
+        return l_sockets.port (handle, key);
+}
+
+/**
+ * Remember the result of an overlapped operation we completed ourselves.
+ *
+ * Applications using completion ports tend not to ask for the result, since
+ * the completion packet carries it, so to stop these piling up any earlier
+ * record for the same OVERLAPPED is dropped here, and whenever the OVERLAPPED
+ * is handed down to the provider for a real operation (they are usually
+ * reused for each operation on a connection, and the earlier result cannot be
+ * asked for again once the structure has been reused, so a stale record would
+ * otherwise hide the real result). Anything left is freed when the socket is
+ * closed.
+ */
+
+bool g_addCompletion (SOCKET handle, OVERLAPPED * overlapped,
+                      unsigned long count, unsigned long flags) {
+        SocketTrack   * old;
+        old = l_sockets.take (handle, TRACK_COMPLETION, overlapped);
+        if (old != 0)
+                delete old;
+
+        Completion    * item = new Completion (handle, overlapped);
+        if (item == 0)
+                return false;
+
+        item->m_count = count;
+        item->m_flags = flags;
+
+        if (! l_sockets.add (item, TRACK_COMPLETION)) {
+                delete item;
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Forget any result we recorded for an OVERLAPPED, as it's about to be used
+ * for an operation the provider will complete.
+ */
+
+void g_dropCompletion (SOCKET handle, OVERLAPPED * overlapped) {
+        if (overlapped == 0)
+                return;
+
+        SocketTrack   * old;
+        old = l_sockets.take (handle, TRACK_COMPLETION, overlapped);
+        if (old != 0)
+                delete old;
+}
+
+/**
+ * Retrieve (and forget) the result of an overlapped operation we completed,
+ * if the OVERLAPPED is one of ours.
+ */
+
+bool g_takeCompletion (SOCKET handle, OVERLAPPED * overlapped,
+                       unsigned long * count, unsigned long * flags) {
+        Completion    * item;
+        item = (Completion *) l_sockets.take (handle, TRACK_COMPLETION,
+                                              overlapped);
+        if (item == 0)
+                return false;
+
+        if (count != 0)
+                * count = item->m_count;
+        if (flags != 0)
+                * flags = item->m_flags;
+
+        delete item;
+        return true;
+}
+
+/**
+ * Structure for following the HTTP requests sent on a connection.
+ */
+
+struct RequestState : public SocketTrack {
+        HttpScan        m_scan;
+
+                        RequestState (SOCKET handle) : SocketTrack (handle) { }
+};
+
+/**
+ * Find the request scanning state for a socket, making it if need be.
+ *
+ * Since a socket is only sent on by one thread at a time, and this is only
+ * used from the send hooks, the state isn't locked once it's been found.
+ */
+
+HttpScan * g_requestState (SOCKET handle) {
+        RequestState  * item;
+        item = (RequestState *) l_sockets.find (handle, TRACK_REQUEST);
+        if (item != 0)
+                return & item->m_scan;
+
+        item = new RequestState (handle);
+        if (item == 0)
+                return 0;
+
+        if (! l_sockets.add (item, TRACK_REQUEST)) {
+                delete item;
+                return 0;
+        }
+
+        return & item->m_scan;
+}
+
+/**
+ * Structure for holding the rate limit which the rule a connection matched
+ * puts on it.
+ */
+
+struct SocketLimit : public SocketTrack {
+        RateLimit     * m_limit;
+
+                        SocketLimit (SOCKET handle, RateLimit * limit) :
+                                SocketTrack (handle), m_limit (limit) {
+                                limit->addRef ();
+                        }
+                      ~ SocketLimit () {
+                                m_limit->release ();
+                        }
+};
+
+/**
+ * Apply a rate limit to a connection; the item takes its own reference.
+ */
+
+bool g_addLimit (SOCKET handle, RateLimit * limit) {
+        SocketTrack   * old = l_sockets.find (handle, TRACK_LIMIT);
+        if (old != 0)
+                l_sockets.remove (old, TRACK_LIMIT);
+
+        SocketLimit   * item = new SocketLimit (handle, limit);
+        if (item == 0)
+                return false;
+
+        if (! l_sockets.add (item, TRACK_LIMIT)) {
+                delete item;
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Find the rate limit for a connection, if it has one; this stays valid until
+ * the socket is closed.
+ */
+
+RateLimit * g_findLimit (SOCKET handle) {
+        SocketLimit   * item;
+        item = (SocketLimit *) l_sockets.find (handle, TRACK_LIMIT);
+        return item != 0 ? item->m_limit : 0;
+}
+
+/**
+ * Structure for remembering what an overlapped read was charged against its
+ * rate limits when it was started.
+ *
+ * Until an overlapped read completes there's no knowing how much it will get,
+ * so it's charged for everything it asked for, and this lets the difference be
+ * given back once the real count turns up.
+ */
+
+struct Pacing : public SocketTrack {
+        enum { EXPIRE = 30000, KEEP = 8 };
+
+        OVERLAPPED    * m_overlapped;
+        RateLimit     * m_global;
+        RateLimit     * m_local;
+        unsigned long   m_reserved;
+
+                        Pacing (SOCKET handle, OVERLAPPED * overlapped,
+                                RateLimit * global, RateLimit * local,
+                                unsigned long reserved);
+                      ~ Pacing ();
+
+        bool            matches (const void * key) const {
+                return key == m_overlapped;
+        }
+};
+
+Pacing :: Pacing (SOCKET handle, OVERLAPPED * overlapped, RateLimit * global,
+                  RateLimit * local, unsigned long reserved) :
+                SocketTrack (handle), m_overlapped (overlapped),
+                m_global (global), m_local (local), m_reserved (reserved) {
+        if (global != 0)
+                global->addRef ();
+        if (local != 0)
+                local->addRef ();
+}
+
+Pacing :: ~ Pacing () {
+        if (m_global != 0)
+                m_global->release ();
+        if (m_local != 0)
+                m_local->release ();
+}
+
+/**
+ * Remember the advance charge for an overlapped read.
+ *
+ * The charge is only settled when the read's OVERLAPPED comes back to us, in
+ * WSAGetOverlappedResult () or another read; a caller that takes completions
+ * from a port or a completion routine and uses a fresh OVERLAPPED every time
+ * would otherwise leave the records piling up until the socket is closed. So
+ * a socket only keeps its most recent few records, and none for long; the
+ * reads whose records are dropped just keep their whole charge.
+ */
+
+bool g_addPacing (SOCKET handle, OVERLAPPED * overlapped, RateLimit * global,
+                  RateLimit * local, unsigned long reserved) {
+        SocketTrack   * old;
+        while ((old = l_sockets.expire (handle, TRACK_PACING, Pacing :: EXPIRE,
+                                        Pacing :: KEEP - 1)) != 0) {
+                delete old;
+        }
+
+        Pacing        * item;
+        item = new Pacing (handle, overlapped, global, local, reserved);
+        if (item == 0)
+                return false;
+
+        if (! l_sockets.add (item, TRACK_PACING)) {
+                delete item;
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Settle up the advance charge for an overlapped read, given what it actually
+ * received, giving back whatever it didn't use.
+ */
+
+void g_settlePacing (SOCKET handle, OVERLAPPED * overlapped,
+                     unsigned long actual) {
+        Pacing        * item;
+        item = (Pacing *) l_sockets.take (handle, TRACK_PACING, overlapped);
+        if (item == 0)
+                return;
+
+        if (actual < item->m_reserved) {
+                unsigned long   unused = item->m_reserved - actual;
+                if (item->m_global != 0)
+                        item->m_global->refund (unused);
+                if (item->m_local != 0)
+                        item->m_local->refund (unused);
+        }
+
+        delete item;
+}
+
+/**
+ * Structure for remembering which entry in the telemetry address table a
+ * connection is counted against.
+ */
+
+struct Destination : public SocketTrack {
+        unsigned long   m_slot;
+        unsigned long   m_connecting;
+
+                        Destination (SOCKET handle, unsigned long slot,
+                                     unsigned long connecting) :
+                                SocketTrack (handle), m_slot (slot),
+                                m_connecting (connecting) {
+                        }
+};
+
+/**
+ * Record the telemetry entry for a connection; for a connection which is still
+ * being made, this also records the tick count when it was started.
+ */
+
+bool g_addDestination (SOCKET handle, unsigned long slot,
+                       unsigned long connecting) {
+        SocketTrack   * old = l_sockets.find (handle, TRACK_DESTINATION);
+        if (old != 0)
+                l_sockets.remove (old, TRACK_DESTINATION);
+
+        Destination   * item = new Destination (handle, slot, connecting);
+        if (item == 0)
+                return false;
+
+        if (! l_sockets.add (item, TRACK_DESTINATION)) {
+                delete item;
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Find the telemetry entry for a connection, along with the time it was
+ * started if this is the first data to arrive on it.
+ */
+
+bool g_countDestination (SOCKET handle, unsigned long & slot,
+                         unsigned long & connecting) {
+        Destination   * item;
+        item = (Destination *) l_sockets.find (handle, TRACK_DESTINATION);
+        if (item == 0)
+                return false;
+
+        slot = item->m_slot;
+        connecting = item->m_connecting;
+        item->m_connecting = 0;
         return true;
 }
 
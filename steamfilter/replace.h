@@ -37,6 +37,9 @@
 
 struct Replacement;
 struct Discarding;
+class TargetStats;
+class HttpScan;
+class RateLimit;
 
 #include <winsock2.h>
 
@@ -45,10 +48,17 @@ typedef void          * ReplaceHKEY;
 void            g_initReplacement (ReplaceHKEY key, const wchar_t * regPath);
 void            g_unloadReplacement (void);
 
+typedef void (* WakeFunc) (SOCKET handle);
+
 void            g_addEventHandle (SOCKET handle, WSAEVENT event);
+void            g_setNonBlocking (SOCKET handle, bool nonBlocking);
+bool            g_isNonBlocking (SOCKET handle);
+bool            g_deferRead (SOCKET handle, unsigned long delay,
+                             WakeFunc wake);
 void            g_removeTracking (SOCKET handle);
+bool            g_replacing (void);
 
-void            g_replacementCache (const wchar_t * name);
+void            g_replacementCache (const char * name);
 bool            g_addReplacement (SOCKET handle, const char * name,
                                   const char * url);
 bool            g_addReplacement (SOCKET handle, const wchar_t * replacement,
@@ -63,5 +73,32 @@ Discarding    * g_findDiscard (SOCKET handle);
 bool            g_consumeDiscard (Discarding * item, unsigned long length,
                                   unsigned long * skip);
 
+bool            g_addTransfer (SOCKET handle, TargetStats * target,
+                               bool connected);
+void            g_countTransfer (SOCKET handle, unsigned long bytes);
+
+void            g_bindPort (SOCKET handle, HANDLE port, ULONG_PTR key);
+HANDLE          g_findPort (SOCKET handle, ULONG_PTR * key);
+bool            g_addCompletion (SOCKET handle, OVERLAPPED * overlapped,
+                                 unsigned long count, unsigned long flags);
+void            g_dropCompletion (SOCKET handle, OVERLAPPED * overlapped);
+bool            g_takeCompletion (SOCKET handle, OVERLAPPED * overlapped,
+                                  unsigned long * count, unsigned long * flags);
+
+HttpScan      * g_requestState (SOCKET handle);
+
+bool            g_addLimit (SOCKET handle, RateLimit * limit);
+RateLimit     * g_findLimit (SOCKET handle);
+bool            g_addPacing (SOCKET handle, OVERLAPPED * overlapped,
+                             RateLimit * global, RateLimit * local,
+                             unsigned long reserved);
+void            g_settlePacing (SOCKET handle, OVERLAPPED * overlapped,
+                                unsigned long actual);
+
+bool            g_addDestination (SOCKET handle, unsigned long slot,
+                                  unsigned long connecting);
+bool            g_countDestination (SOCKET handle, unsigned long & slot,
+                                    unsigned long & connecting);
+
 /**@}*/
 #endif  /*! defined (REPLACE_H) */
@@ -0,0 +1,281 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This implements the filter's side of the rule block, through which the
+ * monitor hands us new rules without having to call into Steam to do it.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <windows.h>
+#include <stdlib.h>
+
+#include "rulebase.h"
+
+/**
+ * How many times to look for the monitor to finish writing a new set of rules
+ * before giving up until it tells us again, and how long to wait between
+ * looks, in milliseconds.
+ *
+ * @{
+ */
+
+#define RULEBASE_TRIES          100
+#define RULEBASE_POLL           1
+
+/**@}*/
+
+/**
+ * How often the thread calls the idle function when nothing else is happening,
+ * in milliseconds.
+ */
+
+#define RULEBASE_IDLE           1000
+
+/**
+ * How long to wait for our thread to finish when unloading, in milliseconds.
+ */
+
+#define RULEBASE_UNLOAD         5000
+
+/**
+ * The section holding the block and our view of it, the events the thread
+ * waits on, and the thread itself.
+ *
+ * @{
+ */
+
+static HANDLE           l_section;
+static RulebaseBlock  * volatile l_block;
+static HANDLE           l_changed;
+static HANDLE           l_stop;
+static HANDLE           l_thread;
+static RulebaseInstall  l_install;
+static RulebaseIdle     l_idle;
+
+/**@}*/
+
+/**
+ * Copy out the rule text the monitor has written, if it's new, and install it.
+ */
+
+static void l_update (RulebaseBlock * block) {
+        wchar_t       * text = 0;
+        LONG            generation;
+
+        for (unsigned long tries = 0 ;; ++ tries) {
+                generation = block->m_generation;
+                if (generation == block->m_installed)
+                        return;
+
+                if ((generation & 1) != 0) {
+                        if (tries == RULEBASE_TRIES)
+                                return;
+
+                        Sleep (RULEBASE_POLL);
+                        continue;
+                }
+
+                unsigned long   length = block->m_length;
+                if (length >= RULEBASE_TEXT)
+                        length = 0;
+
+                free (text);
+                text = (wchar_t *) malloc ((length + 1) * sizeof (wchar_t));
+                if (text == 0)
+                        return;
+
+                memcpy (text, block->m_text, length * sizeof (wchar_t));
+                text [length] = 0;
+
+                MemoryBarrier ();
+                if (block->m_generation == generation)
+                        break;
+        }
+
+        int             result = (* l_install) (text);
+        free (text);
+
+        block->m_result = result;
+        MemoryBarrier ();
+        block->m_installed = generation;
+}
+
+/**
+ * Wait for the monitor to tell us about new rules.
+ *
+ * The thread holds a reference to the DLL of its own, which it lets go of as
+ * it exits; that way, the DLL can't be unloaded from under it.
+ */
+
+static DWORD WINAPI l_watch (void * param) {
+        HMODULE         self = (HMODULE) param;
+        HANDLE          events [2] = { l_stop, l_changed };
+
+        for (;;) {
+                unsigned long   wait;
+                wait = WaitForMultipleObjects (2, events, FALSE,
+                                               RULEBASE_IDLE);
+                if (wait == WAIT_TIMEOUT) {
+                        if (l_idle != 0)
+                                (* l_idle) ();
+                        continue;
+                }
+
+                if (wait != WAIT_OBJECT_0 + 1)
+                        break;
+
+                RulebaseBlock * block = l_block;
+                if (block != 0)
+                        l_update (block);
+        }
+
+        FreeLibraryAndExitThread (self, 0);
+        return 0;
+}
+
+/**
+ * Create the block for this process, and start listening for new rules.
+ *
+ * As with the telemetry, the section and the event are created with the
+ * default security for the process, which lets the monitor at them since it's
+ * running as the same user.
+ */
+
+bool g_initRulebase (RulebaseInstall install, RulebaseIdle idle) {
+        if (l_block != 0)
+                return true;
+
+        wchar_t         name [64];
+        wsprintfW (name, RULEBASE_NAME, GetCurrentProcessId ());
+
+        HANDLE          section;
+        section = CreateFileMappingW (INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+                                      0, sizeof (RulebaseBlock), name);
+        if (section == 0)
+                return false;
+
+        RulebaseBlock * block;
+        block = (RulebaseBlock *) MapViewOfFile (section, FILE_MAP_WRITE, 0,
+                                                 0, sizeof (RulebaseBlock));
+        if (block == 0) {
+                CloseHandle (section);
+                return false;
+        }
+
+        wsprintfW (name, RULEBASE_EVENT, GetCurrentProcessId ());
+        l_changed = CreateEventW (0, FALSE, FALSE, name);
+        l_stop = CreateEventW (0, TRUE, FALSE, 0);
+
+        HMODULE         self = 0;
+        GetModuleHandleExW (GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                            (LPCWSTR) l_watch, & self);
+
+        if (l_changed == 0 || l_stop == 0 || self == 0) {
+                if (self != 0)
+                        FreeLibrary (self);
+
+                l_section = section;
+                l_block = block;
+                g_unloadRulebase ();
+                return false;
+        }
+
+        /*
+         * Whatever was in a section left over from an earlier load of the
+         * filter has been superseded by the rules we were loaded with.
+         */
+
+        memset (block, 0, sizeof (RulebaseBlock));
+        block->m_version = RULEBASE_VERSION;
+        block->m_size = sizeof (RulebaseBlock);
+        block->m_processId = GetCurrentProcessId ();
+
+        MemoryBarrier ();
+        block->m_magic = RULEBASE_MAGIC;
+
+        l_section = section;
+        l_block = block;
+        l_install = install;
+        l_idle = idle;
+
+        l_thread = CreateThread (0, 0, l_watch, self, 0, 0);
+        if (l_thread == 0) {
+                FreeLibrary (self);
+                g_unloadRulebase ();
+                return false;
+        }
+
+        return true;
+}
+
+/**
+ * Stop listening for new rules, and release the block.
+ *
+ * This has to be done before the hooks are taken out, so that the thread isn't
+ * installing rules (and switching hooks on for them) while that's happening.
+ * If the thread is stuck installing rules, everything is left to it; it will
+ * see the stop event once it's done, and it keeps the DLL loaded until then.
+ */
+
+void g_unloadRulebase (void) {
+        if (l_thread != 0) {
+                SetEvent (l_stop);
+
+                unsigned long   wait;
+                wait = WaitForSingleObject (l_thread, RULEBASE_UNLOAD);
+                CloseHandle (l_thread);
+                l_thread = 0;
+
+                if (wait != WAIT_OBJECT_0) {
+                        l_block = 0;
+                        l_section = 0;
+                        l_changed = 0;
+                        l_stop = 0;
+                        return;
+                }
+        }
+
+        RulebaseBlock * block = l_block;
+        l_block = 0;
+
+        if (block != 0)
+                UnmapViewOfFile (block);
+        if (l_section != 0)
+                CloseHandle (l_section);
+        if (l_changed != 0)
+                CloseHandle (l_changed);
+        if (l_stop != 0)
+                CloseHandle (l_stop);
+
+        l_section = 0;
+        l_changed = 0;
+        l_stop = 0;
+}
+
+/**@}*/
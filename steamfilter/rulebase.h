@@ -0,0 +1,105 @@
+#ifndef RULEBASE_H
+#define RULEBASE_H              1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares the layout of the block through which the monitor can hand the
+ * filter DLL a new set of rules without calling into Steam, and the filter's
+ * functions for listening for them.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * The rule block the filter shares with the monitor.
+ *
+ * Switching profiles used to mean injecting another call to SteamFilter ()
+ * into Steam; now the monitor can write the new rule text here instead and
+ * set the event, and a small thread in the filter which waits on that picks
+ * the text up and installs it. The names of the section and the event are
+ * both formed from the process the filter is running in.
+ *
+ * There is only ever one writer, the monitor, which makes the generation odd
+ * while it's changing the text and then even again; the filter copies the
+ * text out and checks that the generation was even and didn't change while it
+ * did so, as with the telemetry series. Once the filter is done with a
+ * generation, it sets the result and then the installed generation, which the
+ * monitor can wait for to see how it went.
+ *
+ * As with the compiled rule images, the filter looks for an image precompiled
+ * by the monitor for the same text, so the monitor should build that first.
+ *
+ * Anything which changes the layout has to change the version, and writers
+ * ignore blocks with a version they don't know.
+ */
+
+enum {
+        RULEBASE_MAGIC = 0x42524c53,
+        RULEBASE_VERSION = 1,
+
+        RULEBASE_TEXT = 16384
+};
+
+#define RULEBASE_NAME           L"Local\\SteamLimitRulebase.%lx"
+#define RULEBASE_EVENT          L"Local\\SteamLimitRulebaseEvent.%lx"
+
+/**
+ * The block itself; the length of the text is in characters, not counting the
+ * terminator which the filter supplies.
+ */
+
+struct RulebaseBlock {
+        unsigned long   m_magic;
+        unsigned long   m_version;
+        unsigned long   m_size;
+        unsigned long   m_processId;
+
+        volatile LONG   m_generation;
+        volatile LONG   m_installed;
+        volatile LONG   m_result;
+        unsigned long   m_length;
+
+        wchar_t         m_text [RULEBASE_TEXT];
+};
+
+/**
+ * The filter's side of the rule block; the install function is called from the
+ * filter's thread with each new set of rule text, and returns 1 if the rules
+ * went in. Since the thread is there anyway, it also calls the idle function
+ * every so often, for anything the filter only needs to look at now and then.
+ */
+
+typedef int     (* RulebaseInstall) (wchar_t * rules);
+typedef void    (* RulebaseIdle) (void);
+
+bool            g_initRulebase (RulebaseInstall install, RulebaseIdle idle);
+void            g_unloadRulebase (void);
+
+/**@}*/
+#endif  /* ! defined (RULEBASE_H) */
@@ -0,0 +1,269 @@
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * Publishing statistics from the filter for the monitor to show.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <winsock2.h>
+#include <intrin.h>
+
+#include "telemetry.h"
+#include "replace.h"
+
+/**
+ * The section holding the block, and our view of it.
+ */
+
+static HANDLE           l_section;
+static TelemetryBlock * volatile l_block;
+
+/**
+ * Add to a 64-bit total shared between threads, as in the rule statistics.
+ */
+
+static void l_add64 (volatile LONGLONG * total, LONGLONG value) {
+        LONGLONG        old;
+        do {
+                old = * total;
+        } while (_InterlockedCompareExchange64 (total, old + value,
+                                                old) != old);
+}
+
+/**
+ * Create the block for this process.
+ *
+ * The section is created with the default security for the process, which as
+ * it's running as the same user as the monitor is what we want.
+ */
+
+bool g_initTelemetry (void) {
+        if (l_block != 0)
+                return true;
+
+        wchar_t         name [64];
+        wsprintfW (name, TELEMETRY_NAME, GetCurrentProcessId ());
+
+        HANDLE          section;
+        section = CreateFileMappingW (INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+                                      0, sizeof (TelemetryBlock), name);
+        if (section == 0)
+                return false;
+
+        TelemetryBlock * block;
+        block = (TelemetryBlock *) MapViewOfFile (section, FILE_MAP_WRITE, 0,
+                                                  0, sizeof (TelemetryBlock));
+        if (block == 0) {
+                CloseHandle (section);
+                return false;
+        }
+
+        /*
+         * If the section was left over from an earlier load of the filter in
+         * the same process, the monitor may still have it mapped; starting
+         * afresh is simplest, and the monitor copes with counts going down.
+         */
+
+        memset (block, 0, sizeof (TelemetryBlock));
+        block->m_version = TELEMETRY_VERSION;
+        block->m_size = sizeof (TelemetryBlock);
+        block->m_processId = GetCurrentProcessId ();
+
+        MemoryBarrier ();
+        block->m_magic = TELEMETRY_MAGIC;
+
+        l_section = section;
+        l_block = block;
+        return true;
+}
+
+/**
+ * Release the block; this is only done once the hooks are all gone.
+ */
+
+void g_unloadTelemetry (void) {
+        TelemetryBlock * block = l_block;
+        l_block = 0;
+
+        if (block != 0)
+                UnmapViewOfFile (block);
+        if (l_section != 0)
+                CloseHandle (l_section);
+
+        l_section = 0;
+}
+
+/**
+ * Get the block, if there is one.
+ */
+
+TelemetryBlock * g_telemetry (void) {
+        return l_block;
+}
+
+/**
+ * Say whether a reader has looked at the block recently.
+ */
+
+bool g_telemetryWatched (void) {
+        TelemetryBlock * block = l_block;
+        if (block == 0)
+                return false;
+
+        unsigned long   watched = (unsigned long) block->m_watched;
+        return watched != 0 && GetTickCount () - watched < TELEMETRY_WATCH_MS;
+}
+
+/**
+ * Count an event.
+ */
+
+void g_telemetryCount (TelemetryCounter counter) {
+        TelemetryBlock * block = l_block;
+        if (block != 0)
+                InterlockedIncrement (block->m_counters + counter);
+}
+
+/**
+ * Find the entry for a remote address, claiming a free one if need be; this
+ * gives back the index of the entry, or ~ 0UL if the table is full.
+ *
+ * This is a simple open-addressed table, probing on from the slot the address
+ * hashes to; since entries are never freed, there's no need for tombstones.
+ */
+
+static unsigned long l_findAddress (TelemetryBlock * block, LONG address) {
+        unsigned long   hash = (unsigned long) address * 2654435761UL;
+        unsigned long   slot = (hash >> 16) % TELEMETRY_ADDRESSES;
+
+        for (unsigned long i = 0 ; i < TELEMETRY_ADDRESSES ; ++ i) {
+                TelemetryAddress * entry = block->m_addresses + slot;
+
+                LONG            old = entry->m_address;
+                if (old == 0)
+                        old = InterlockedCompareExchange (& entry->m_address,
+                                                          address, 0);
+                if (old == 0 || old == address)
+                        return slot;
+
+                slot = (slot + 1) % TELEMETRY_ADDRESSES;
+        }
+
+        return ~ 0UL;
+}
+
+/**
+ * Add a time in milliseconds to the connect latency histogram.
+ */
+
+static void l_addLatency (TelemetryBlock * block, unsigned long elapsed) {
+        unsigned long   bucket = 0;
+        while (elapsed >= (1UL << bucket) && bucket < TELEMETRY_LATENCY - 1)
+                ++ bucket;
+
+        InterlockedIncrement (block->m_latency + bucket);
+}
+
+/**
+ * Record a connection attempt; the start time is the tick count from just
+ * before the real connect () was called, and the result and error are what it
+ * gave back.
+ *
+ * For a non-blocking connect, the first data to arrive is taken as the sign
+ * that the connection completed, as with the replacement target statistics.
+ */
+
+void g_telemetryConnect (SOCKET handle, const sockaddr_in * name,
+                         unsigned long start, int result,
+                         unsigned long error) {
+        TelemetryBlock * block = l_block;
+        if (block == 0)
+                return;
+
+        InterlockedIncrement (block->m_counters + TELEMETRY_CONNECTS);
+
+        bool            pending = result != 0 && error == WSAEWOULDBLOCK;
+        if (result != 0 && ! pending)
+                return;
+
+        unsigned long   slot;
+        slot = l_findAddress (block, (LONG) name->sin_addr.S_un.S_addr);
+        if (slot == ~ 0UL)
+                return;
+
+        InterlockedIncrement (& block->m_addresses [slot].m_connects);
+
+        if (! pending)
+                l_addLatency (block, GetTickCount () - start);
+
+        g_addDestination (handle, slot, pending ? start : 0);
+}
+
+/**
+ * Credit data received on a socket to the address it's connected to.
+ */
+
+void g_telemetryReceive (SOCKET handle, unsigned long bytes) {
+        TelemetryBlock * block = l_block;
+        if (block == 0 || bytes == 0)
+                return;
+
+        unsigned long   slot;
+        unsigned long   start;
+        if (! g_countDestination (handle, slot, start))
+                return;
+
+        if (start != 0)
+                l_addLatency (block, GetTickCount () - start);
+
+        if (slot < TELEMETRY_ADDRESSES)
+                l_add64 (& block->m_addresses [slot].m_bytes, bytes);
+}
+
+/**
+ * Publish the time series of received data.
+ */
+
+void g_telemetrySeries (const unsigned long * series, unsigned long current,
+                        unsigned long filled, long long total) {
+        TelemetryBlock * block = l_block;
+        if (block == 0)
+                return;
+
+        InterlockedIncrement (& block->m_sequence);
+
+        memcpy (block->m_series, series, sizeof (block->m_series));
+        block->m_current = current;
+        block->m_filled = filled;
+        block->m_received = total;
+
+        InterlockedIncrement (& block->m_sequence);
+}
+
+/**@}*/
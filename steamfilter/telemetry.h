@@ -0,0 +1,165 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H             1
+
+/**@addtogroup Filter Steam limiter filter hook DLL.
+ * @{@file
+ *
+ * This declares the layout of the block of statistics which the filter DLL
+ * publishes for the monitor to read, and the filter's functions for keeping
+ * it up to date.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * The statistics block the filter shares with the monitor.
+ *
+ * Apart from what goes to DbgView, there was no way to see from outside what
+ * the filter is doing; in particular, whether a profile is actually sending
+ * the downloads to the unmetered server it's meant to. So the filter keeps
+ * this block in a named section for the monitor to map, named for the process
+ * the filter is running in.
+ *
+ * Nothing here is locked. The counters are all updated with interlocked
+ * operations, and can be read at any time. The time series of received data
+ * (and the running total, which can't be read atomically on x86) is updated
+ * in one go, with the sequence number made odd while that's happening; a
+ * reader takes a copy and checks that the sequence number was even and didn't
+ * change while it did so, and if not tries again.
+ *
+ * The one thing a reader writes is the tick count at which it last looked. The
+ * read hooks are switched off while no rule needs them, which would leave the
+ * received data unmeasured, so the filter keeps them on for as long as that is
+ * less than TELEMETRY_WATCH_MS old.
+ *
+ * Anything which changes the layout has to change the version, and readers
+ * ignore blocks with a version they don't know.
+ */
+
+enum {
+        TELEMETRY_MAGIC = 0x4d4c5453,
+        TELEMETRY_VERSION = 2,
+
+        TELEMETRY_WATCH_MS = 5000,
+        TELEMETRY_SERIES = 64,
+        TELEMETRY_BUCKET_MS = 1000,
+        TELEMETRY_LATENCY = 12,
+        TELEMETRY_ADDRESSES = 32,
+        TELEMETRY_RULES = 64
+};
+
+#define TELEMETRY_NAME          L"Local\\SteamLimitTelemetry.%lx"
+
+/**
+ * The event counters in the block.
+ */
+
+enum TelemetryCounter {
+        TELEMETRY_CONNECTS,
+        TELEMETRY_REDIRECTED,
+        TELEMETRY_REFUSED,
+        TELEMETRY_LOOKUP_ANSWERED,
+        TELEMETRY_LOOKUP_REFUSED,
+        TELEMETRY_REQUEST_BLOCKED,
+        TELEMETRY_REQUEST_SUBSTITUTED,
+        TELEMETRY_REQUEST_REWRITTEN,
+        TELEMETRY_COUNTERS
+};
+
+/**
+ * What we know about the traffic to one remote address.
+ *
+ * The address (in network order) is 0 for a free entry; entries are claimed
+ * with a compare-and-swap, and once claimed they stay put.
+ */
+
+struct TelemetryAddress {
+        volatile LONG   m_address;
+        volatile LONG   m_connects;
+        volatile LONGLONG m_bytes;
+};
+
+/**
+ * The block itself.
+ *
+ * The series holds the bytes received in each of the last TELEMETRY_SERIES
+ * buckets, as a ring; the current bucket (which is still filling up) is the
+ * one at m_current, and m_filled of the ones before it are complete. The
+ * latency histogram counts connects by how long they took to complete, with
+ * entry n counting those taking less than 2^n milliseconds (except the last,
+ * which counts everything slower). The rule hits are in rule order.
+ */
+
+struct TelemetryBlock {
+        unsigned long   m_magic;
+        unsigned long   m_version;
+        unsigned long   m_size;
+        unsigned long   m_processId;
+
+        volatile LONG   m_watched;
+
+        volatile LONG   m_sequence;
+        unsigned long   m_current;
+        unsigned long   m_filled;
+        unsigned long   m_series [TELEMETRY_SERIES];
+        LONGLONG        m_received;
+
+        volatile LONG   m_counters [TELEMETRY_COUNTERS];
+        volatile LONG   m_latency [TELEMETRY_LATENCY];
+
+        unsigned long   m_rules;
+        volatile LONG   m_ruleHits [TELEMETRY_RULES];
+
+        TelemetryAddress m_addresses [TELEMETRY_ADDRESSES];
+};
+
+/**
+ * The filter's side of the telemetry; this uses Winsock types, so it's only
+ * visible to code which has Winsock, which the monitor doesn't.
+ */
+
+#ifdef  _WINSOCK2API_
+
+bool            g_initTelemetry (void);
+void            g_unloadTelemetry (void);
+TelemetryBlock * g_telemetry (void);
+bool            g_telemetryWatched (void);
+
+void            g_telemetryCount (TelemetryCounter counter);
+void            g_telemetryConnect (SOCKET handle, const sockaddr_in * name,
+                                    unsigned long start, int result,
+                                    unsigned long error);
+void            g_telemetryReceive (SOCKET handle, unsigned long bytes);
+void            g_telemetrySeries (const unsigned long * series,
+                                   unsigned long current, unsigned long filled,
+                                   long long total);
+
+#endif  /* defined (_WINSOCK2API_) */
+
+/**@}*/
+#endif  /* ! defined (TELEMETRY_H) */
@@ -49,15 +49,23 @@
 /**@}*/
 
 /**
- * Code array containing the initial shim we'll use to bootstrap in our filter
- * DLL to the target process.
+ * The size of the code array containing the initial shim we'll use to
+ * bootstrap in our filter DLL to the target process.
  *
  * This is page-sized since VirtualAllocEx () works in page-sized units, and to
  * return results from the called DLL it's handy to just copy the entire block
- * in and out.
+ * in and out. Each call builds its shim in an array of its own, so calls into
+ * different processes can be made from different threads at once.
  */
 
-unsigned char   codeBytes [4096];
+#define SHIM_SIZE               4096
+
+/**
+ * What injectFilter () returns if the shim is still running when we give up
+ * waiting for it.
+ */
+
+#define SHIM_TIMEOUT            (~ 1UL)
 
 /**
  * Write a 32-bit value into the output in Intel byte order.
@@ -131,11 +139,15 @@ typedef unsigned long (WINAPI * LGPA) (void * base,
                                        unsigned long ordinal,
                                        void ** result);
 
-static  LGPA            lgpa;
-static  HMODULE         ntdll;
+static  LGPA volatile    lgpa;
 
-        if (ntdll == 0) {
-                ntdll = GetModuleHandleW (L"NTDLL.DLL");
+        /*
+         * Calls can come in from several threads at once; they'd all find the
+         * same address, so it doesn't matter which one gets to write it.
+         */
+
+        if (lgpa == 0) {
+                HMODULE         ntdll = GetModuleHandleW (L"NTDLL.DLL");
                 lgpa = (LGPA) GetProcAddress (ntdll, "LdrGetProcedureAddress");
         }
 
@@ -159,7 +171,12 @@ static  HMODULE         ntdll;
 
 #define PUSH_EAX        0x50
 #define PUSH_EBX        0x53
+#define PUSH_EBP        0x55
+#define PUSH_ESI        0x56
 #define POP_EAX         0x58
+#define POP_EBX         0x5B
+#define POP_EBP         0x5D
+#define POP_ESI         0x5E
 #define JE              0x74
 
 #define MOV_RM          0x89
@@ -174,6 +191,8 @@ static  HMODULE         ntdll;
 #define LEA             0x8D
 #define ESI_MEM         0x35
 #define RET             0xC3
+#define RET_N           0xC2
+#define MOV_IMM         0xC7
 
 #define INDIRECT        0xFF
 #define PUSH_ESI_OFFSET 0x76
@@ -202,6 +221,13 @@ static  HMODULE         ntdll;
                 * p ++ = (unsigned char) (o); \
         } while (0)
 
+#define MOV_ESI_AT_IMM(p, o, x) do { \
+                * p ++ = MOV_IMM; \
+                * p ++ = ESI_OFFSET_EAX; \
+                * p ++ = (unsigned char) (o); \
+                p = writeLong (p, x); \
+        } while (0)
+
 #define MOV_EAX_ESI_AT(p, o) do { \
                 * p ++ = MOV_REG; \
                 * p ++ = EAX_ESI_OFFSET; \
@@ -252,6 +278,94 @@ static  HMODULE         ntdll;
                 * p ++ = (unsigned char) (o); \
         } while (0)
 
+/**
+ * The block at the start of the shim page, holding the parameters and results
+ * of the call the shim makes.
+ *
+ * This holds pointers to the parameters to be passed to the invoked function
+ * rather than the data, so that we can reasonably assure ourselves that
+ * everything fits within the 128-byte short offset encoding the shim uses.
+ */
+
+struct ParamBlock {
+        FARPROC         loadLib;
+        FARPROC         gmh;
+        FARPROC         gpa;
+        FARPROC         freeLib;
+        wchar_t       * param;
+        wchar_t       * path;
+        void          * result;
+        size_t          resultSize;
+        HMODULE         loadedLibrary;
+        unsigned char * entryName;
+        unsigned char * entryPoint;
+
+        void          * regRoot;
+        wchar_t       * regPath;
+        wchar_t       * curDir;
+        unsigned long   status;
+        unsigned long   finished;
+};
+
+/**
+ * How long to wait for a shim run as an APC to finish, and how often to look,
+ * in milliseconds.
+ *
+ * @{
+ */
+
+#define QUEUED_WAIT             60000
+#define QUEUED_POLL             10
+
+/**@}*/
+
+/**
+ * Run a shim on a suspended thread in a new process, as it starts.
+ *
+ * A process that's just been created has nothing loaded but NTDLL and the
+ * program, so the shim can't run on a new thread of its own; KERNEL32.DLL
+ * isn't there for it to call into yet. But user APCs queued to the process's
+ * first thread before it starts are delivered once the loader has set the
+ * process up and just before the program's entry point is called, which is
+ * exactly the moment we want.
+ *
+ * There's no thread exit to wait for, so the shim marks the parameter block
+ * when it's done and we look for that; the page can't be freed afterwards, as
+ * the shim may not quite have returned, so it's just left behind.
+ */
+
+unsigned long runQueued (HANDLE steam, HANDLE thread, unsigned char * mem,
+                         unsigned char * code, unsigned long entry) {
+        unsigned long   queued;
+        queued = QueueUserAPC ((PAPCFUNC) entry, thread, 0);
+        ResumeThread (thread);
+
+        if (queued == 0)
+                return 0;
+
+        size_t          status = offsetof (ParamBlock, status);
+
+        for (unsigned long waited = 0 ; waited < QUEUED_WAIT ;
+             waited += QUEUED_POLL) {
+                if (WaitForSingleObject (steam, QUEUED_POLL) == WAIT_OBJECT_0)
+                        return 0;
+
+                unsigned long   done [2];
+                unsigned long   got;
+                if (! ReadProcessMemory (steam, mem + status, done,
+                                         sizeof (done), & got))
+                        return 0;
+
+                if (done [1] == 0)
+                        continue;
+
+                ReadProcessMemory (steam, mem, code, SHIM_SIZE, & got);
+                return done [0];
+        }
+
+        return 0;
+}
+
 /**
  * Inject our filter DLL into the steam process.
  *
@@ -261,15 +375,24 @@ static  HMODULE         ntdll;
  * address-space randomization which will even go that far, in which case I'd
  * have to work slightly harder to bootstrap the injected code, but for now the
  * classic techniques should do.
+ *
+ * Normally the shim is run by a new thread in the target, but if a thread is
+ * passed in then it's a suspended thread that hasn't started yet, and the shim
+ * is run on that instead as it starts; see below.
+ *
+ * The shim is built in the code array passed in, which must be SHIM_SIZE bytes
+ * long; that's also where any result data is read back to.
  */
 
 unsigned long injectFilter (HANDLE steam, unsigned char * mem,
+                            unsigned char * code,
                             const wchar_t * path, const char * entryName,
                             const wchar_t * paramString = 0,
                             void * regRoot = 0, const wchar_t * regPath = 0,
-                            const wchar_t * curDir = 0) {
+                            const wchar_t * curDir = 0, HANDLE first = 0,
+                            unsigned long timeout = INFINITE) {
         /*
-         * The first two entries in the codeBytes will be the addresses of the
+         * The first two entries in the code array will be the addresses of the
          * LoadLibrary and GetProcAddress functions which will bootstrap in our
          * monitor DLL.
          *
@@ -287,32 +410,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
         if (kernel == 0)
                 return 0;
 
-        /*
-         * Reserve space for a pointer to the parameters to be passed to the
-         * invoked function. This uses a pointer rather than the data so that
-         * we can reasonably assure ourselves that everything fits within the
-         * 128-byte short offset encoding we use below.
-         */
-
-        struct ParamBlock {
-                FARPROC         loadLib;
-                FARPROC         gmh;
-                FARPROC         gpa;
-                FARPROC         freeLib;
-                wchar_t       * param;
-                wchar_t       * path;
-                void          * result;
-                size_t          resultSize;
-                HMODULE         loadedLibrary;
-                unsigned char * entryName;
-                unsigned char * entryPoint;
-
-                void          * regRoot;
-                wchar_t       * regPath;
-                wchar_t       * curDir;
-        };
-
-        ParamBlock    * params = (ParamBlock *) codeBytes;
+        ParamBlock    * params = (ParamBlock *) code;
 
         /*
          * Always clear out any stale values from a previous cycle, now that we
@@ -320,7 +418,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
          * stale data in the new context.
          */
 
-        memset (params, 0, sizeof (codeBytes));
+        memset (code, 0, SHIM_SIZE);
 
         params->loadLib = SafeGetProcAddress (kernel, "LoadLibraryW");
         params->gmh = SafeGetProcAddress (kernel, "GetModuleHandleW");
@@ -337,7 +435,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
 
         if (paramString != 0) {
                 dest = writeString (start = dest, paramString);
-                writePointer (& params->param, mem + (start - codeBytes));
+                writePointer (& params->param, mem + (start - code));
         }
 
         /*
@@ -353,7 +451,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
 
         bool            getModule = wcschr (path, L'\\') == 0;
         dest = writeString (start = dest, path);
-        writePointer (& params->path, mem + (start - codeBytes));
+        writePointer (& params->path, mem + (start - code));
 
         /*
          * Write the extra context parameter; a registry path and the current
@@ -366,7 +464,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
                 params->regPath = 0;
         } else {
                 dest = writeString (start = dest, regPath);
-                writePointer (& params->regPath, mem + (start - codeBytes));
+                writePointer (& params->regPath, mem + (start - code));
         }
 
         wchar_t         tempDir [128];
@@ -376,7 +474,7 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
         }
 
         dest = writeString (start = dest, curDir);
-        writePointer (& params->curDir, mem + (start - codeBytes));
+        writePointer (& params->curDir, mem + (start - code));
 
         /*
          * Now write out the name of the entry point we want to use; this is
@@ -389,15 +487,25 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
 
         if (entryName != 0) {
                 dest = writeString (start = dest, entryName);
-                writePointer (& params->entryName, mem + (start - codeBytes));
+                writePointer (& params->entryName, mem + (start - code));
         }
 
         /*
          * Starting here we build the actual x86 loader code.
          */
 
-        dest += (dest - codeBytes) & 1;
-        unsigned long   codeOffset = dest - codeBytes;
+        dest += (dest - code) & 1;
+        unsigned long   codeOffset = dest - code;
+
+        /*
+         * The shim is called as a __stdcall function, so it keeps to the rules
+         * for that and preserves the registers it uses; a new thread doesn't
+         * care, but an APC returns to code that does.
+         */
+
+        * dest ++ = PUSH_EBP;
+        * dest ++ = PUSH_ESI;
+        * dest ++ = PUSH_EBX;
 
         /*
          * Obtain a base pointer to our code frame which we can use to access
@@ -480,27 +588,40 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
         CALL_ESI_AT (dest, offsetof (ParamBlock, freeLib));
 
         * dest ++ = POP_EAX;
-        * dest ++ = RET;
+
+        /*
+         * Leave the result in the parameter block too, and mark that we're
+         * done, for when there's no thread exit code to look at.
+         */
+
+        MOV_ESI_AT_EAX (dest, offsetof (ParamBlock, status));
+        MOV_ESI_AT_IMM (dest, offsetof (ParamBlock, finished), 1);
+
+        * dest ++ = POP_EBX;
+        * dest ++ = POP_ESI;
+        * dest ++ = POP_EBP;
+
+        * dest ++ = RET_N;
+        * dest ++ = sizeof (void *);
+        * dest ++ = 0;
 
         /*
          * Now that we've build the code, align things and what's left in the
          * code page is potential return result room.
          */
 
-        size_t          offset = (dest - codeBytes + 15) & ~ 15;
+        size_t          offset = (dest - code + 15) & ~ 15;
 
         writePointer (& params->result, mem + offset);
-        writeLong (& params->resultSize, sizeof (codeBytes) - offset);
+        writeLong (& params->resultSize, SHIM_SIZE - offset);
 
         /*
          * Now write the shim into the target process.
          */
 
         unsigned long   wrote;
-        if (! WriteProcessMemory (steam, mem, codeBytes, sizeof (codeBytes),
-                                  & wrote)) {
+        if (! WriteProcessMemory (steam, mem, code, SHIM_SIZE, & wrote))
                 return 0;
-        }
 
         /*
          * Having written the shim, run it!
@@ -508,6 +629,9 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
 
         unsigned long   entry = (unsigned long) mem + codeOffset;
 
+        if (first != 0)
+                return runQueued (steam, first, mem, code, entry);
+
         unsigned long   id;
         HANDLE          thread;
         thread = CreateRemoteThread (steam, 0, 0, (LPTHREAD_START_ROUTINE) entry,
@@ -520,10 +644,14 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
          * not found) or whatever the function returned.
          */
 
-        WaitForSingleObject (thread, INFINITE);
-
         unsigned long   result;
+        if (WaitForSingleObject (thread, timeout) != WAIT_OBJECT_0) {
+                CloseHandle (thread);
+                return SHIM_TIMEOUT;
+        }
+
         GetExitCodeThread (thread, & result);
+        CloseHandle (thread);
 
         /*
          * Read back the content of the shim, so we can get any result data.
@@ -534,19 +662,26 @@ unsigned long injectFilter (HANDLE steam, unsigned char * mem,
          * binary serialization format.
          */
 
-        ReadProcessMemory (steam, mem, codeBytes, sizeof (codeBytes), & wrote);
+        ReadProcessMemory (steam, mem, code, SHIM_SIZE, & wrote);
 
         return result;
 }
 
 /**
  * Call into our DLL by injection.
+ *
+ * Normally the shim page is allocated for the call and freed after it, but the
+ * caller can keep one to use again for later calls into the same process; if
+ * there's no page there yet, one is allocated and left there. A shim that runs
+ * past the timeout may still be using its page, so a kept page is forgotten
+ * then, and one allocated for the call just isn't freed.
  */
 
 unsigned long callFilter (HANDLE steam, const wchar_t * path,
                           const char * entryPoint, const wchar_t * param = 0,
                           void * regRoot = 0, const wchar_t * regPath = 0,
-                          const wchar_t * curDir = 0) {
+                          const wchar_t * curDir = 0, void ** page = 0,
+                          unsigned long timeout = CALL_WAIT) {
         /*
          * Allocate a page of VM inside the target process.
          *
@@ -554,12 +689,17 @@ unsigned long callFilter (HANDLE steam, const wchar_t * path,
          * but we need it to construct the shim code to load our DLL.
          */
 
-        void          * mem;
-        mem = VirtualAllocEx (steam, 0, sizeof (codeBytes), MEM_COMMIT,
-                              PAGE_EXECUTE_READWRITE);
+        void          * mem = page != 0 ? * page : 0;
+        if (mem == 0)
+                mem = VirtualAllocEx (steam, 0, SHIM_SIZE, MEM_COMMIT,
+                                      PAGE_EXECUTE_READWRITE);
         if (mem == 0)
                 return 0;
 
+        if (page != 0)
+                * page = mem;
+
+        unsigned char   code [SHIM_SIZE];
         unsigned long   result;
         int             tries = 1;
 
@@ -567,8 +707,9 @@ unsigned long callFilter (HANDLE steam, const wchar_t * path,
                 ++ tries;
 
         for (;;) {
-                result = injectFilter (steam, (unsigned char *) mem, path, entryPoint,
-                                       param, regRoot, regPath, curDir);
+                result = injectFilter (steam, (unsigned char *) mem, code,
+                                       path, entryPoint, param, regRoot,
+                                       regPath, curDir, 0, timeout);
 
                 if (result != ~ 0UL || tries < 2)
                         break;
@@ -581,50 +722,69 @@ unsigned long callFilter (HANDLE steam, const wchar_t * path,
                  */
 
                 -- tries;
-                injectFilter (steam, (unsigned char *) mem, L"steamfilter.dll",
-                              0, 0);
+                result = injectFilter (steam, (unsigned char *) mem, code,
+                                       L"steamfilter.dll", 0, 0, 0, 0, 0, 0,
+                                       timeout);
+                if (result == SHIM_TIMEOUT)
+                        break;
         }
 
-        if (strcmp (entryPoint, "FilterUnload") == 0) {
+        bool            unload = strcmp (entryPoint, "FilterUnload") == 0;
+        if (result != SHIM_TIMEOUT && unload) {
                 /*
                  * Give the unload an extra refcount adjustment just in case.
                  */
 
-                injectFilter (steam, (unsigned char *) mem, L"steamfilter.dll",
-                              0, 0);
+                if (injectFilter (steam, (unsigned char *) mem, code,
+                                  L"steamfilter.dll", 0, 0, 0, 0, 0, 0,
+                                  timeout) == SHIM_TIMEOUT)
+                        result = SHIM_TIMEOUT;
+        }
+
+        if (result == SHIM_TIMEOUT) {
+                if (page != 0)
+                        * page = 0;
+
+                return 0;
         }
 
         /*
-         * Always unload our shim; if we want to call another function in the
-         * loaded DLL, we can just build another shim.
+         * Unless the caller is keeping it, always unload our shim; if we want
+         * to call another function in the loaded DLL, we can just build
+         * another shim.
          */
 
-        VirtualFreeEx (steam, mem, 0, MEM_RELEASE);
+        if (page == 0)
+                VirtualFreeEx (steam, mem, 0, MEM_RELEASE);
+
         return result;
 }
 
 /**
- * Call into a filter DLL using a process ID.
+ * Form a full path name to our shim DLL based on our own executable file name.
  */
 
-bool callFilterId (unsigned long processId, const char * entryPoint,
-                   const wchar_t * param, void * regRoot,
-                   const wchar_t * regPath, const wchar_t * curDir) {
-        /*
-         * Form a full path name to our shim DLL based on our own executable
-         * file name.
-         */
-
-        wchar_t         path [1024];
-        wcscpy_s (path, ARRAY_LENGTH (path), g_appPath);
+static bool filterPath (wchar_t * path, size_t length) {
+        wcscpy_s (path, length, g_appPath);
 
         wchar_t       * end = wcsrchr (path, '\\');
         if (end == 0)
-                return 0;
+                return false;
 
         ++ end;
 
-        if (wcscpy_s (end, ARRAY_END (path) - end, L"steamfilter.dll") != 0)
+        return wcscpy_s (end, path + length - end, L"steamfilter.dll") == 0;
+}
+
+/**
+ * Call into a filter DLL using a process ID.
+ */
+
+bool callFilterId (unsigned long processId, const char * entryPoint,
+                   const wchar_t * param, void * regRoot,
+                   const wchar_t * regPath, const wchar_t * curDir) {
+        wchar_t         path [1024];
+        if (! filterPath (path, ARRAY_LENGTH (path)))
                 return 0;
 
         /*
@@ -665,4 +825,88 @@ bool callFilterId (unsigned long processId, const char * entryPoint,
         return result == 1;
 }
 
+/**
+ * Call into a filter DLL in a process we already have open, keeping a shim
+ * page in the process for the next call.
+ */
+
+bool callFilterPage (void * process, void ** page, const char * entryPoint,
+                     const wchar_t * param, void * regRoot,
+                     const wchar_t * regPath, unsigned long timeout) {
+        wchar_t         path [1024];
+        if (! filterPath (path, ARRAY_LENGTH (path)))
+                return false;
+
+        unsigned long   result;
+        result = callFilter (process, path, entryPoint, param, regRoot,
+                             regPath, 0, page, timeout);
+
+        return result == 1;
+}
+
+/**
+ * Call into a filter DLL in a process which has been created suspended, from
+ * its first thread as that starts.
+ *
+ * The thread is always resumed, whether or not the call could be set up.
+ */
+
+bool callFilterStart (void * process, void * thread, const char * entryPoint,
+                      const wchar_t * param, void * regRoot,
+                      const wchar_t * regPath, const wchar_t * curDir) {
+        wchar_t         path [1024];
+        void          * mem = 0;
+        if (filterPath (path, ARRAY_LENGTH (path)))
+                mem = VirtualAllocEx (process, 0, SHIM_SIZE, MEM_COMMIT,
+                                      PAGE_EXECUTE_READWRITE);
+
+        unsigned char   code [SHIM_SIZE];
+        unsigned long   result = 0;
+        if (mem != 0)
+                result = injectFilter (process, (unsigned char *) mem, code,
+                                       path, entryPoint, param, regRoot,
+                                       regPath, curDir, thread);
+
+        /*
+         * If the shim couldn't be written, the thread is still suspended;
+         * resuming one that's already running does nothing, so just make sure.
+         */
+
+        ResumeThread (thread);
+        return result == 1;
+}
+
+/**
+ * Have the filter DLL compile a set of rules for the filter in a process.
+ *
+ * This loads the filter DLL into our own process to do the parsing and name
+ * resolution for the rules here, rather than in Steam; the resulting image is
+ * left in a shared memory section which the filter will look for when it's
+ * called with the same rule text. The returned section handle should be closed
+ * once the filter has been called.
+ */
+
+typedef HANDLE (WINAPI * CompileFunc) (const wchar_t * rules,
+                                       unsigned long processId);
+
+void * compileFilter (unsigned long processId, const wchar_t * rules) {
+        wchar_t         path [1024];
+        if (rules == 0 || ! filterPath (path, ARRAY_LENGTH (path)))
+                return 0;
+
+        HMODULE         filter = LoadLibraryW (path);
+        if (filter == 0)
+                return 0;
+
+        CompileFunc     compile;
+        compile = (CompileFunc) GetProcAddress (filter, "FilterCompile");
+
+        HANDLE          section = 0;
+        if (compile != 0)
+                section = (* compile) (rules, processId);
+
+        FreeLibrary (filter);
+        return section;
+}
+
 /**@}*/
@@ -41,6 +41,13 @@
 
 extern  wchar_t       * g_appPath;
 
+/**
+ * How long, in milliseconds, to wait for a call into the filter to return
+ * before giving up on it.
+ */
+
+#define CALL_WAIT               30000
+
 /**
  * Call into a filter DLL using a process ID, with the name and path of the
  * filter DLL being implicitly generated from the calling process.
@@ -50,5 +57,35 @@ bool callFilterId (unsigned long processId, const char * entryPoint,
                    const wchar_t * param = 0, void * regRoot = 0,
                    const wchar_t * regPath = 0, const wchar_t * curDir = 0);
 
+/**
+ * Call into a filter DLL in a process we have a handle to, keeping a page in
+ * the process for the shim so it can be used again for later calls there.
+ *
+ * The page pointer starts out clear, and is set to the page once there is one;
+ * it's cleared again if a call times out, as the abandoned shim may still be
+ * running there. It's up to the caller to free the page when done with it.
+ */
+
+bool callFilterPage (void * process, void ** page, const char * entryPoint,
+                     const wchar_t * param = 0, void * regRoot = 0,
+                     const wchar_t * regPath = 0,
+                     unsigned long timeout = CALL_WAIT);
+
+/**
+ * Call into a filter DLL in a process created suspended, by having the first
+ * thread in the process make the call as it starts; the process and thread
+ * are handles to those, and the thread is resumed.
+ */
+
+bool callFilterStart (void * process, void * thread, const char * entryPoint,
+                      const wchar_t * param = 0, void * regRoot = 0,
+                      const wchar_t * regPath = 0, const wchar_t * curDir = 0);
+
+/**
+ * Compile filter rules ahead of time for the filter in a given process.
+ */
+
+void * compileFilter (unsigned long processId, const wchar_t * rules);
+
 /**@}*/
 #endif  /* ! defined (INJECT_H) */
@@ -35,7 +35,11 @@
 #include "inject.h"
 #include "hyperlink.h"
 #include "profile.h"
+#include "targets.h"
+#include "watch.h"
 #include "../nolocale.h"
+#include "../steamfilter/telemetry.h"
+#include "../steamfilter/eventlog.h"
 
 #include "resource.h"
 #include <shellapi.h>
@@ -54,6 +58,9 @@
 #define WM_NOTIFYICON   (WM_USER + 1)
 #define WM_SUSPEND      (WM_USER + 2)
 #define WM_SUSPENDED    (WM_USER + 3)
+#define WM_STEAMSTARTED (WM_USER + 4)
+#define WM_LAUNCHSTEAM  (WM_USER + 5)
+#define WM_ATTACHED     (WM_USER + 6)
 
 /**
  * Globally record the application's current path.
@@ -83,12 +90,25 @@ bool            g_filterDisabled;
 
 unsigned long   g_steamProcess;
 
+/**
+ * A handle to the Steam process we're working with, so we hear when it exits.
+ */
+
+HANDLE          g_steamHandle;
+
 /**
  * If our "about" window is visible, the window should be here.
  */
 
 HWND            g_aboutWindow;
 
+/**
+ * When the mouse was last over the notification icon, which is when its
+ * tooltip is showing.
+ */
+
+unsigned long   g_hoverTick;
+
 /**
  * Put the profile-picker window here.
  */
@@ -101,24 +121,84 @@ HWND            g_profileWindow;
 
 ULONGLONG       g_upgradeCheckTime;
 
+/**
+ * The last time we asked the filter to reorder its rules.
+ */
+
+ULONGLONG       g_reorderTime;
+
 /**
  * The currently selected profile ID, which determines the filter to use.
  */
 
 unsigned long   g_profileId;
 
+/**
+ * A view of one of the sections the filter publishes, and the process it's for.
+ */
+
+struct SectionView {
+        HANDLE          m_section;
+        void          * m_view;
+        unsigned long   m_process;
+};
+
+/**
+ * Our views of the telemetry and the event log the filter publishes.
+ */
+
+SectionView     g_telemetryView;
+SectionView     g_logView;
+
+/**
+ * A summary of the telemetry for the "About" window, kept so the window can
+ * show it as soon as it opens.
+ */
+
+wchar_t         g_telemetryText [160];
+
+/**
+ * How often to poll for Steam, in milliseconds.
+ *
+ * While the filter is in Steam, the poll also keeps the telemetry and event
+ * log moving so it stays quick; otherwise, if we're being told when Steam
+ * starts, the poll is only a backstop and there's no need to wake up often.
+ * The exception is after the Steam client we were filtering exits: it often
+ * does that to restart itself, and the new one may well have started while
+ * the old one was still there to be told about, so we keep looking quickly
+ * until we find a Steam client again.
+ *
+ * @{
+ */
+
+#define POLL_BUSY               1000
+#define POLL_IDLE               30000
+
+/**@}*/
+
 /**
  * How often to check for upgrades after being installed.
  *
  * This doesn't cause an in-your-face prompt, so more often than less is not
  * likely to be harmful. The only potential drawback here would be for anyone
- * on a dial-up connection. Once a week seems good.
+ * on a dial-up connection. This used to be once a week, but now that the
+ * webservice lets the script revalidate its copy of the bundle (and usually
+ * just gets told nothing has changed) every six hours costs next to nothing.
  *
  * This is based on a FILETIME, so 100ns is the basic "tick" aka 2.5 million,
- * we'll put the number of days as the leftmost term.
+ * we'll put the number of hours as the leftmost term.
  */
 
-#define UPGRADE_CHECK_DELTA     (7 * 24 * 60 * 60 * 10000000ULL)
+#define UPGRADE_CHECK_DELTA     (6 * 60 * 60 * 10000000ULL)
+
+/**
+ * How often to have the filter move its busiest rules to the front, if that
+ * has been enabled in the registry; since the filter already has to test the
+ * rules on every lookup the reordering is cheap, but there's no point in doing
+ * it more often than the traffic patterns actually change.
+ */
+
+#define REORDER_DELTA           (5 * 60 * 10000000ULL)
 
 /**
  * The standard Windows shell key for application launch at login.
@@ -138,11 +218,25 @@ unsigned long   g_profileId;
 #define VERSION_VALUE   L"NextVersion"
 #define TIMESTAMP_VALUE L"UpgradeCheck"
 #define PROFILE_VALUE   L"Profile"
+#define HOTRULES_VALUE  L"HotRules"
+#define LOGLEVEL_VALUE  L"LogLevel"
+#define HELPERS_VALUE   L"Helpers"
 
 #define REPLACE_SETTINGS        LIMIT_SETTINGS L"\\Replace"
 
 /**@}*/
 
+/**
+ * Valve's settings for the Steam client, which say where it is.
+ *
+ * @{
+ */
+
+#define VALVE_SETTINGS  L"Software\\Valve\\Steam"
+#define STEAMEXE_VALUE  L"SteamExe"
+
+/**@}*/
+
 /**
  * The application's setting root key.
  */
@@ -225,6 +319,96 @@ void runCommand (const wchar_t * command, const wchar_t * parameters = 0,
         SetCursorPos (point.x, point.y);
 }
 
+/**
+ * Record the Steam process the filter is in, if any.
+ */
+
+void setSteamProcess (unsigned long processId) {
+        if (g_steamHandle != 0)
+                CloseHandle (g_steamHandle);
+
+        g_steamHandle = 0;
+        if (processId != 0)
+                g_steamHandle = OpenProcess (SYNCHRONIZE, FALSE, processId);
+
+        g_steamProcess = processId;
+}
+
+/**
+ * Put the filter into a Steam process, with the rules from the current
+ * profile, taking it out of any other one it was in.
+ *
+ * Normally this is done by a worker thread, since the filter can take a while
+ * to get going, and we hear how it went with a WM_ATTACHED message later.
+ *
+ * If we started the process ourselves, we have a handle to it and to its
+ * first thread, which is still suspended; the filter is then called from that
+ * thread as it starts, and the thread is resumed.
+ */
+
+bool attachFilter (unsigned long processId, HANDLE process = 0,
+                   HANDLE thread = 0) {
+        if (g_steamProcess != 0) {
+                if (! targetKnown (g_steamProcess))
+                        unloadTarget (g_steamProcess);
+
+                detachTargets ();
+                setSteamProcess (0);
+        }
+
+        Profile         current (g_profileId, & g_settings);
+        const wchar_t * rules = current.filter ();
+
+        if (thread == 0) {
+                return attachTarget (processId, rules, HKEY_CURRENT_USER,
+                                     REPLACE_SETTINGS);
+        }
+
+        /*
+         * Do the work of parsing the rules here rather than in Steam, if the
+         * filter is able to; if not, it will just parse the text itself.
+         */
+
+        HANDLE          image = compileTarget (processId, rules);
+
+        bool            injected;
+        injected = callFilterStart (process, thread, "SteamFilterStart", rules,
+                                    HKEY_CURRENT_USER, REPLACE_SETTINGS);
+
+        if (image != 0)
+                CloseHandle (image);
+
+        if (! injected)
+                return false;
+
+        /*
+         * The injection succeeded; keep track of the process along with the
+         * others, so that later calls into it (such as to reorder the rules)
+         * are made from a worker thread rather than from here.
+         */
+
+        adoptTarget (processId);
+        setSteamProcess (processId);
+        return true;
+}
+
+/**
+ * Put the filter into any of the Steam client's helper processes that have
+ * been configured, using the same rules as the client.
+ */
+
+void attachSteamHelpers (void) {
+        wchar_t       * helpers = 0;
+        g_settings [HELPERS_VALUE] >>= helpers;
+        if (helpers == 0)
+                return;
+
+        Profile         current (g_profileId, & g_settings);
+        attachHelpers (helpers, current.filter (), HKEY_CURRENT_USER,
+                       REPLACE_SETTINGS);
+        free (helpers);
+}
+
 /**
  * Poll for Steam application instances.
  *
@@ -293,7 +477,32 @@ static  wchar_t         className [] = { L"USurface" };
                 break;
         }
 
-        if (attach && processId == g_steamProcess)
+        if (attach && processId == g_steamProcess) {
+                /*
+                 * Optionally, every so often have the filter move the rules
+                 * which match the most up to the front of the rule list. That
+                 * waits for the filter's readers, so it's handed to a worker
+                 * thread rather than holding up the window here.
+                 */
+
+                unsigned long   hotRules = 0;
+                g_settings [HOTRULES_VALUE] >>= hotRules;
+
+                if (hotRules != 0 && now - g_reorderTime > REORDER_DELTA) {
+                        g_reorderTime = now;
+                        callTarget (processId, "FilterStats", L"reorder");
+                }
+
+                attachSteamHelpers ();
+                return;
+        }
+
+        /*
+         * If a worker is still busy putting the filter into this Steam, wait
+         * to hear how that went rather than starting another go at it.
+         */
+
+        if (attach && targetBusy (processId))
                 return;
 
         /*
@@ -314,28 +523,143 @@ static  unsigned long   unloadCount;
          */
 
         if (! attach || g_filterDisabled) {
-                callFilterId (processId, "FilterUnload");
-                g_steamProcess = 0;
+                bool            known = targetKnown (processId);
+                detachTargets ();
+                if (! known)
+                        unloadTarget (processId);
+
+                setSteamProcess (0);
                 ++ unloadCount;
                 return;
         }
 
-        if (g_steamProcess != 0)
-                callFilterId (g_steamProcess, "FilterUnload");
+        unloadCount = 0;
+        attachFilter (processId);
+}
 
-        Profile         current (g_profileId, & g_settings);
+/**
+ * Hear that a worker thread is done putting the filter, or a new set of rules
+ * for it, into a process.
+ *
+ * The filter may have been taken out again, or another go at it started, since
+ * the message was sent, so check with the target list rather than believing it.
+ * If a reload has left the Steam client without the filter, forget about it so
+ * the next poll puts it back.
+ *
+ * Taking the filter out of a process is reported the same way, once the worker
+ * has forgotten about the process; if that leaves us without a Steam client,
+ * poll for one straight away rather than waiting, since that's usually because
+ * the filter is being put back in with new rules.
+ */
 
-        unloadCount = 0;
+void filterAttached (unsigned long processId) {
+        bool            attached;
+        attached = ! g_filterDisabled && targetAttached (processId);
 
-        if (! callFilterId (processId, "SteamFilter", current.filter (),
-                            HKEY_CURRENT_USER, REPLACE_SETTINGS))
+        if (g_steamProcess == 0 && attached) {
+                setSteamProcess (processId);
+        } else if (processId == g_steamProcess && ! attached &&
+                   ! targetBusy (processId)) {
+                setSteamProcess (0);
+        } else if (g_steamProcess == 0 && ! targetKnown (processId))
+                steamPoll (true);
+}
+
+/**
+ * Put the filter into a Steam client we've been told has just started, rather
+ * than waiting until its window turns up on the next poll; by then it has
+ * usually already been talking to the network, which is what the filter's
+ * passthrough mode is there to put up with.
+ *
+ * If there's still a Steam client running with the filter in it, the new one
+ * is most likely just passing a steam: link on to it before exiting, so it's
+ * left alone.
+ */
+
+void steamStarted (unsigned long processId) {
+        if (g_filterDisabled || g_steamProcess != 0)
+                return;
+
+        attachFilter (processId);
+}
+
+/**
+ * Change the rules the filter is using to those of the current profile.
+ *
+ * Where the filter can take new rules through its rule block, this doesn't
+ * involve calling into Steam at all; where it can't, the worker just calls
+ * SteamFilter () again. If the Steam client isn't one the workers know about,
+ * such as one we launched ourselves, the filter is taken out and put back.
+ */
+
+void reloadFilter (void) {
+        if (g_steamProcess != 0 && ! g_filterDisabled &&
+            targetAttached (g_steamProcess)) {
+                Profile         current (g_profileId, & g_settings);
+                if (reloadTargets (current.filter (), HKEY_CURRENT_USER,
+                                   REPLACE_SETTINGS)) {
+                        return;
+                }
+        }
+
+        steamPoll (false);
+        steamPoll (true);
+}
+
+/**
+ * Start the Steam client with the filter already in it.
+ *
+ * Steam is created suspended, and the filter is called from its first thread
+ * as that starts, so the rules are in place before Steam's first connection;
+ * there's no window in which it can get one past us.
+ *
+ * If a Steam we're filtering is already running, a new one just hands its
+ * command line on to that and exits, so it's simply started as it is; the
+ * same goes if the filter is disabled.
+ */
+
+void launchSteam (void) {
+        wchar_t       * steam = 0;
+        RegKey (VALVE_SETTINGS) [STEAMEXE_VALUE] >>= steam;
+        if (steam == 0)
                 return;
 
         /*
-         * The injection succeeded.
+         * Valve write the path with forward slashes.
          */
 
-        g_steamProcess = processId;
+        for (wchar_t * scan = steam ; * scan != 0 ; ++ scan)
+                if (* scan == '/')
+                        * scan = '\\';
+
+        wchar_t         command [1024];
+        wchar_t         directory [1024];
+        wsprintfW (command, L"\"%.1000s\"", steam);
+        wcscpy_s (directory, ARRAY_LENGTH (directory), steam);
+
+        wchar_t       * end = wcsrchr (directory, '\\');
+        if (end != 0)
+                * end = 0;
+
+        bool            filter = ! g_filterDisabled && g_steamProcess == 0;
+
+        STARTUPINFOW    startup = { sizeof (startup) };
+        PROCESS_INFORMATION info;
+        BOOL            started;
+        started = CreateProcessW (steam, command, 0, 0, FALSE,
+                                  filter ? CREATE_SUSPENDED : 0, 0,
+                                  end != 0 ? directory : 0, & startup,
+                                  & info);
+        free (steam);
+
+        if (! started)
+                return;
+
+        if (filter)
+                attachFilter (info.dwProcessId, info.hProcess, info.hThread);
+
+        CloseHandle (info.hThread);
+        CloseHandle (info.hProcess);
 }
 
 /**
@@ -577,6 +901,464 @@ static  const POINT     home = { 0, 0 };
         ShowWindow (window, SW_SHOW);
 }
 
+/**
+ * Map one of the sections the filter publishes for the Steam process we're
+ * attached to, if it has one; the filter creates them as it hooks in, so if
+ * it isn't there yet this is just tried again on the next poll.
+ *
+ * The sections all start with the same magic number, version and size, which
+ * are checked against what we know before the rest is looked at.
+ */
+
+void * mapSection (SectionView & map, const wchar_t * format,
+                   unsigned long access, unsigned long magic,
+                   unsigned long version, unsigned long size) {
+        if (map.m_process == g_steamProcess && map.m_view != 0)
+                return map.m_view;
+
+        if (map.m_view != 0)
+                UnmapViewOfFile (map.m_view);
+        if (map.m_section != 0)
+                CloseHandle (map.m_section);
+
+        map.m_view = 0;
+        map.m_section = 0;
+        map.m_process = g_steamProcess;
+        if (g_steamProcess == 0)
+                return 0;
+
+        wchar_t         name [64];
+        wsprintfW (name, format, g_steamProcess);
+
+        HANDLE          section = OpenFileMappingW (access, FALSE, name);
+        if (section == 0)
+                return 0;
+
+        const unsigned long * view;
+        view = (const unsigned long *) MapViewOfFile (section, access, 0, 0, 0);
+        if (view == 0 || view [0] != magic || view [1] != version ||
+            view [2] < size) {
+                if (view != 0)
+                        UnmapViewOfFile (view);
+                CloseHandle (section);
+                return 0;
+        }
+
+        map.m_section = section;
+        map.m_view = (void *) view;
+        return map.m_view;
+}
+
+/**
+ * Say whether anyone is looking at the telemetry; that is, the "about" window
+ * is open, or the tooltip for the notification icon is likely to be up.
+ */
+
+bool telemetryWatched (void) {
+        if (g_aboutWindow != 0)
+                return true;
+
+        return GetTickCount () - g_hoverTick < TELEMETRY_WATCH_MS;
+}
+
+/**
+ * Map the telemetry block for the Steam process we're attached to.
+ *
+ * The filter only measures what it receives while a rule needs that or while
+ * someone is looking, since measuring means hooking every read; so looks are
+ * stamped in the block, but only while someone really is looking rather than
+ * on every poll. The cost is that the rate starts from nothing each time the
+ * tooltip comes up or the "about" window opens, and takes a second or two to
+ * fill in once the filter has noticed.
+ */
+
+const TelemetryBlock * mapTelemetry (void) {
+        TelemetryBlock * block;
+        block = (TelemetryBlock *) mapSection (g_telemetryView, TELEMETRY_NAME,
+                                               FILE_MAP_WRITE, TELEMETRY_MAGIC,
+                                               TELEMETRY_VERSION,
+                                               sizeof (TelemetryBlock));
+
+        if (block != 0 && telemetryWatched ())
+                InterlockedExchange (& block->m_watched, GetTickCount ());
+
+        return block;
+}
+
+/**
+ * Read one of the 64-bit counts in the telemetry block in a single access.
+ *
+ * A plain load of one of these in a 32-bit process is two loads, and the
+ * filter can add to the count in between; a compare-exchange that never
+ * changes anything reads it whole (which is one reason the block is mapped
+ * for writing).
+ */
+
+LONGLONG readCount (const volatile LONGLONG * count) {
+        return InterlockedCompareExchange64 ((volatile LONGLONG *) count, 0, 0);
+}
+
+/**
+ * Take a look at what the filter has been up to, and show it in the tooltip
+ * for the notification icon and in the "About" window if that's open.
+ *
+ * The rate is worked out from how much more has been received since the last
+ * look, and the busiest address is the one which got the most of that; the
+ * total comes from the filter's time series, which is written under a simple
+ * sequence count so it's read until it comes out the same twice; if it never
+ * does, the last total stands rather than a torn one.
+ */
+
+void showTelemetry (NOTIFYICONDATA & data) {
+static  LONGLONG        lastReceived;
+static  LONGLONG        lastBytes [TELEMETRY_ADDRESSES];
+static  unsigned long   lastTick;
+static  unsigned long   lastProcess;
+
+        wchar_t         tip [ARRAY_LENGTH (data.szTip)];
+        LoadStringW (GetModuleHandle (0), IDS_APPTITLE, tip,
+                     ARRAY_LENGTH (tip));
+
+        g_telemetryText [0] = 0;
+
+        const TelemetryBlock * block = mapTelemetry ();
+        LONGLONG        received;
+        received = g_steamProcess == lastProcess ? lastReceived : 0;
+        for (unsigned long tries = 0 ; block != 0 && tries < 4 ; ++ tries) {
+                LONG            sequence = block->m_sequence;
+                MemoryBarrier ();
+                LONGLONG        total = block->m_received;
+                MemoryBarrier ();
+
+                if ((sequence & 1) == 0 && sequence == block->m_sequence) {
+                        received = total;
+                        break;
+                }
+
+                Sleep (0);
+        }
+
+        unsigned long   now = GetTickCount ();
+        unsigned long   elapsed = now - lastTick;
+
+        if (block != 0 && g_steamProcess != lastProcess) {
+                lastReceived = received;
+                const TelemetryAddress * entry = block->m_addresses;
+                for (unsigned long i = 0 ; i < TELEMETRY_ADDRESSES ; ++ i)
+                        lastBytes [i] = readCount (& entry [i].m_bytes);
+
+                elapsed = 0;
+        }
+
+        lastProcess = block != 0 ? g_steamProcess : 0;
+        lastTick = now;
+
+        if (block != 0) {
+                unsigned long   rate = 0;
+                if (elapsed > 0 && received > lastReceived)
+                        rate = (unsigned long) ((received - lastReceived) *
+                                                1000 / elapsed);
+
+                lastReceived = received;
+
+                /*
+                 * Pick out the address that got the most data since the last
+                 * look.
+                 */
+
+                LONGLONG        best = 0;
+                unsigned long   address = 0;
+                for (unsigned long i = 0 ; i < TELEMETRY_ADDRESSES ; ++ i) {
+                        const TelemetryAddress * entry;
+                        entry = block->m_addresses + i;
+
+                        LONGLONG        bytes = readCount (& entry->m_bytes);
+                        if (bytes - lastBytes [i] > best) {
+                                best = bytes - lastBytes [i];
+                                address = entry->m_address;
+                        }
+
+                        lastBytes [i] = bytes;
+                }
+
+                const unsigned char * bytes;
+                bytes = (const unsigned char *) & address;
+
+                wchar_t         line [80];
+                if (address != 0) {
+                        wsprintfW (line, L"\n%luKB/s from %d.%d.%d.%d",
+                                   rate >> 10, bytes [0], bytes [1],
+                                   bytes [2], bytes [3]);
+                } else
+                        wsprintfW (line, L"\n%luKB/s", rate >> 10);
+
+                wcscat_s (tip, ARRAY_LENGTH (tip), line);
+
+                const volatile LONG * counts = block->m_counters;
+                wsprintfW (g_telemetryText, L"%luMB received%s\n"
+                           L"%lu connects, %lu redirected, %lu refused, "
+                           L"%lu requests blocked",
+                           (unsigned long) (received >> 20), line + 1,
+                           counts [TELEMETRY_CONNECTS],
+                           counts [TELEMETRY_REDIRECTED],
+                           counts [TELEMETRY_REFUSED],
+                           counts [TELEMETRY_REQUEST_BLOCKED]);
+        }
+
+        if (g_aboutWindow != 0)
+                SetDlgItemTextW (g_aboutWindow, IDC_TELEMETRY, g_telemetryText);
+
+        /*
+         * Only poke the shell when there is something new to show.
+         */
+
+        if (wcscmp (tip, data.szTip) == 0)
+                return;
+
+        wcscpy_s (data.szTip, ARRAY_LENGTH (data.szTip), tip);
+        data.uFlags = NIF_TIP;
+        Shell_NotifyIconW (NIM_MODIFY, & data);
+        data.uFlags = NIF_MESSAGE | NIF_ICON | NIF_TIP;
+}
+
+/**
+ * Describe a record from the filter's event log to DbgView, the way the filter
+ * used to itself; the text is that of the record along with any more of it
+ * from records carrying it on.
+ */
+
+void showLogRecord (const LogRecord & record, const char * text) {
+        const unsigned char * from;
+        const unsigned char * to;
+        from = (const unsigned char *) & record.m_from;
+        to = (const unsigned char *) & record.m_to;
+
+        const char    * message = 0;
+        const char    * how;
+        char            line [1024];
+
+        switch (record.m_event) {
+        case LOG_CONTINUE:
+                OutputDebugStringA (text);
+                return;
+
+        case LOG_CONNECT_REDIRECTED:
+                wsprintfA (line, "Connect redirected %d.%d.%d.%d to "
+                           "%d.%d.%d.%d:%lu\r\n",
+                           from [0], from [1], from [2], from [3],
+                           to [0], to [1], to [2], to [3], record.m_value);
+                break;
+
+        case LOG_CONNECT_REFUSED:
+                wsprintfA (line, "Connect refused %d.%d.%d.%d:%lu\r\n",
+                           from [0], from [1], from [2], from [3],
+                           record.m_value);
+                break;
+
+        case LOG_LOOKUP_RULE:
+        case LOG_LOOKUP_CACHED:
+        case LOG_LOOKUP_RESOLVED:
+                how = record.m_event == LOG_LOOKUP_RULE ? "as" :
+                      record.m_event == LOG_LOOKUP_CACHED ? "cached as" :
+                      "resolved as";
+                wsprintfA (line, "lookup %.400s %s %d.%d.%d.%d\r\n", text,
+                           how, to [0], to [1], to [2], to [3]);
+                break;
+
+        case LOG_LOOKUP_REFUSED:
+                wsprintfA (line, "lookup %.400s refused\r\n", text);
+                break;
+
+        case LOG_LOOKUP_FAILED:
+                wsprintfA (line, "lookup %.400s failed\r\n", text);
+                break;
+
+        case LOG_REQUEST:
+                if (record.m_to == 0) {
+                        wsprintfA (line, "%.900s\r\n", text);
+                        break;
+                }
+
+                wsprintfA (line, "%d.%d.%d.%d:%lu %.900s\r\n",
+                           to [0], to [1], to [2], to [3], record.m_value,
+                           text);
+                break;
+
+        case LOG_SEND:
+        case LOG_WSASEND:
+                wsprintfA (line, "%s: %lu bytes\r\n",
+                           record.m_event == LOG_SEND ? "send" : "WSASend",
+                           record.m_value);
+                OutputDebugStringA (line);
+                OutputDebugStringA (text);
+                return;
+
+        case LOG_PASSTHROUGH:
+                message = "passthrough";
+                break;
+        case LOG_REQUEST_SUBSTITUTED:
+                message = "Substituting HTTP request";
+                break;
+        case LOG_RESPONSE_SUBSTITUTED:
+                message = "Substituting HTTP response";
+                break;
+        case LOG_REPLACEMENT_MISSING:
+                message = "HTTP replacement not found";
+                break;
+        case LOG_HOST_REJECTED:
+                message = "Rejected host";
+                break;
+        case LOG_HOST_REPLACED:
+                message = "Replaced host";
+                break;
+        case LOG_HOST_TOO_LONG:
+                message = "Host rewrite too long";
+                break;
+        case LOG_HOST_URL_REJECTED:
+                message = "Rejected host+url";
+                break;
+        case LOG_URL_REJECTED:
+                message = "Rejected URL";
+                break;
+        case LOG_URL_TOO_LONG:
+                message = "URL rewrite too long";
+                break;
+        case LOG_STATUS_FAILED:
+                message = "Failed to replace status";
+                break;
+
+        default:
+                return;
+        }
+
+        if (message != 0)
+                wsprintfA (line, "%s\r\n", message);
+
+        OutputDebugStringA (line);
+}
+
+/**
+ * Collect whatever the filter has recorded in its event log since the last
+ * look, and pass it on to DbgView; this is also where the filter gets told
+ * how much to record.
+ *
+ * A record which is still being written is left until the next look, and if
+ * it still isn't finished by then it's given up on; any the filter has written
+ * over before we got to them are lost, which we say. Text which didn't fit in
+ * one record carries on in later records from the same thread, and those get
+ * glued back together here.
+ *
+ * The LogLevel setting is 0 (or missing) for the filter's default, 1 to also
+ * show lookups and requests that pass untouched, 2 to show everything sent as
+ * well, or -1 to record nothing.
+ */
+
+void drainLog (void) {
+static  unsigned long   next;
+static  unsigned long   stuck = ~ 0UL;
+static  unsigned long   lastProcess;
+static  LogRecord       records [LOG_RECORDS];
+static  bool            used [LOG_RECORDS];
+
+        LogBlock      * block;
+        block = (LogBlock *) mapSection (g_logView, LOG_NAME, FILE_MAP_WRITE,
+                                         LOG_MAGIC, LOG_VERSION,
+                                         sizeof (LogBlock));
+        if (block == 0)
+                return;
+
+        unsigned long   level = LOG_ACTIONS;
+        g_settings [LOGLEVEL_VALUE] >>= level;
+        if (block->m_level != (LONG) level)
+                InterlockedExchange (& block->m_level, (LONG) level);
+
+        /*
+         * When we first see a ring, only show what is still in it; if the
+         * ticket count goes backwards, the filter has been loaded afresh.
+         */
+
+        unsigned long   head = (unsigned long) block->m_next;
+        if (g_steamProcess != lastProcess) {
+                lastProcess = g_steamProcess;
+                next = head > LOG_RECORDS ? head - LOG_RECORDS : 0;
+        }
+
+        if ((LONG) (head - next) < 0)
+                next = 0;
+
+        unsigned long   lost = 0;
+        if (head - next > LOG_RECORDS) {
+                lost = head - next - LOG_RECORDS;
+                next = head - LOG_RECORDS;
+        }
+
+        unsigned long   count = 0;
+        for (; next != head ; ++ next) {
+                const LogRecord * record;
+                record = block->m_records + (next & (LOG_RECORDS - 1));
+
+                LONG            sequence = record->m_sequence;
+                MemoryBarrier ();
+                memcpy (records + count, (const void *) record,
+                        sizeof (LogRecord));
+                MemoryBarrier ();
+
+                LONG            diff = (LONG) (sequence - (next + 1));
+                if (diff == 0 && record->m_sequence == sequence) {
+                        used [count ++] = false;
+                        continue;
+                }
+
+                if (diff < 0 && next != stuck) {
+                        stuck = next;
+                        break;
+                }
+
+                ++ lost;
+        }
+
+        if (lost > 0) {
+                char            line [80];
+                wsprintfA (line, "%lu filter log records lost\r\n", lost);
+                OutputDebugStringA (line);
+        }
+
+        for (unsigned long i = 0 ; i < count ; ++ i) {
+                if (used [i])
+                        continue;
+
+                const LogRecord & record = records [i];
+                char            text [LOG_MAX_TEXT + 1];
+                size_t          length = record.m_length;
+                memcpy (text, record.m_text, length);
+
+                /*
+                 * Only a full record can have more following it.
+                 */
+
+                size_t          last = length;
+                if (record.m_event == LOG_CONTINUE)
+                        last = 0;
+
+                for (unsigned long j = i + 1 ; j < count && last == LOG_TEXT ;
+                     ++ j) {
+                        const LogRecord & more = records [j];
+                        if (more.m_thread != record.m_thread)
+                                continue;
+                        if (more.m_event != LOG_CONTINUE ||
+                            length + more.m_length > LOG_MAX_TEXT)
+                                break;
+
+                        memcpy (text + length, more.m_text, more.m_length);
+                        length += more.m_length;
+                        last = more.m_length;
+                        used [j] = true;
+                }
+
+                text [length] = 0;
+                showLogRecord (record, text);
+        }
+}
 
 /**
  * Create and show the "About" window.
@@ -626,6 +1408,7 @@ void showAbout (void) {
         wcscat_s (text, ARRAY_LENGTH (text), g_appVer);
 
         SetDlgItemTextW (g_aboutWindow, IDC_APPNAME, text);
+        SetDlgItemTextW (g_aboutWindow, IDC_TELEMETRY, g_telemetryText);
 
         showCentered (g_aboutWindow);
 }
@@ -793,8 +1576,7 @@ INT_PTR CALLBACK profileProc (HWND window, UINT message, WPARAM wparam,
                 g_profileId = index;
                 g_settings [PROFILE_VALUE] <<= g_profileId;
 
-                steamPoll (false);
-                steamPoll (true);
+                reloadFilter ();
         }
 
         DestroyWindow (window);
@@ -837,9 +1619,30 @@ LRESULT CALLBACK windowProc (HWND window, UINT message, WPARAM wparam,
                 PostQuitMessage (0);
                 return 0;
 
+        case WM_STEAMSTARTED:
+                steamStarted (wparam);
+                return 0;
+
+        case WM_LAUNCHSTEAM:
+                launchSteam ();
+                return 1;
+
+        case WM_ATTACHED:
+                filterAttached (wparam);
+                return 0;
+
         case WM_SUSPEND:
                 DestroyWindow (window);
                 steamPoll (false);
+                detachTargets ();
+
+                /*
+                 * The instance asking us to step aside is waiting for the
+                 * answer before it puts its own filter in, so the filter has
+                 * to be out by then.
+                 */
+
+                waitTargets ();
 
                 PostThreadMessage (GetCurrentThreadId (), WM_SUSPENDED,
                                    wparam, lparam);
@@ -856,6 +1659,11 @@ LRESULT CALLBACK windowProc (HWND window, UINT message, WPARAM wparam,
                         showContextMenu (window);
                         break;
 
+                case WM_MOUSEMOVE:
+                        g_hoverTick = GetTickCount ();
+                        mapTelemetry ();
+                        break;
+
                 default:
                         break;
                 }
@@ -976,6 +1784,7 @@ wchar_t * getAppPath (void) {
 int CALLBACK wWinMain (HINSTANCE instance, HINSTANCE, wchar_t * command, int show) {
         bool            quit = false;
         bool            suspend = false;
+        bool            launch = false;
 
         for (; __argc > 1 ; -- __argc, ++ __wargv) {
                 wchar_t       * arg = __wargv [1];
@@ -989,6 +1798,11 @@ int CALLBACK wWinMain (HINSTANCE instance, HINSTANCE, wchar_t * command, int sho
                         suspend = true;
                         continue;
                 }
+
+                if (wcscmp (arg, L"-launch") == 0) {
+                        launch = true;
+                        continue;
+                }
         }
 
         /*
@@ -999,6 +1813,21 @@ int CALLBACK wWinMain (HINSTANCE instance, HINSTANCE, wchar_t * command, int sho
         window = FindWindowEx (0, 0, L"SteamMonitor", 0);
 
         while (window != 0) {
+                if (launch) {
+                        /*
+                         * Let the existing instance start Steam, so it can
+                         * filter it; if that's an older version which doesn't
+                         * understand the request, just start Steam as it is.
+                         */
+
+                        if (SendMessage (window, WM_LAUNCHSTEAM, 0, 0) == 0) {
+                                g_filterDisabled = true;
+                                launchSteam ();
+                        }
+
+                        return 0;
+                }
+
                 if (suspend) {
                         LRESULT         result;
                         result = SendMessage (window, WM_SUSPEND,
@@ -1136,6 +1965,14 @@ reinitialize:
         data.hWnd = window;
         Shell_NotifyIconW (NIM_ADD, & data);
 
+        /*
+         * Ask to be told when Steam starts; the filter needs Winsock to be
+         * loaded before it can attach, so there's no point hearing any sooner.
+         */
+
+        watchProcess (L"steam.exe", L"WS2_32.DLL", window, WM_STEAMSTARTED);
+        startTargets (window, WM_ATTACHED);
+
         /*
          * Figure out when the last upgrade check was run. If there's no record
          * of that in the registry yet, assume it's now.
@@ -1157,11 +1994,45 @@ reinitialize:
 
         g_filterDisabled = getFilter ();
 
+        /*
+         * If we were asked to, start Steam now that we have the settings for
+         * the filter to go into it; only once, though, not again after we
+         * restart from being suspended.
+         */
+
+        if (launch) {
+                launch = false;
+                launchSteam ();
+        }
+
         unsigned short  release = 0;
+        bool            searching = false;
 
         for (;;) {
+                if (g_steamProcess != 0)
+                        searching = false;
+
+                unsigned long   timeout = POLL_BUSY;
+                if (g_steamProcess == 0 && ! searching && watchingProcess ())
+                        timeout = POLL_IDLE;
+
+                unsigned long   count = g_steamHandle != 0 ? 1 : 0;
                 unsigned long   wait;
-                wait = MsgWaitForMultipleObjects (0, 0, 0, 1000, QS_ALLINPUT);
+                wait = MsgWaitForMultipleObjects (count, & g_steamHandle, FALSE,
+                                                  timeout, QS_ALLINPUT);
+
+                /*
+                 * When the Steam client we're filtering exits, forget about
+                 * it so that the next one gets the filter as soon as it runs,
+                 * and look for that straight away in case it already is.
+                 */
+
+                if (count > 0 && wait == WAIT_OBJECT_0) {
+                        setSteamProcess (0);
+                        searching = true;
+                        steamPoll (true);
+                        continue;
+                }
 
                 if (wait == WAIT_TIMEOUT) {
                         /*
@@ -1169,6 +2040,8 @@ reinitialize:
                          */
 
                         steamPoll (true);
+                        showTelemetry (data);
+                        drainLog ();
 
                         /*
                          * After a number of continuous poll cycles, wipe the
@@ -1224,6 +2097,8 @@ reinitialize:
                 if (quit) {
                         Shell_NotifyIconW (NIM_DELETE, & data);
                         steamPoll (false);
+                        detachTargets ();
+                        waitTargets ();
                         return 0;
                 }
         }
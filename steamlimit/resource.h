@@ -23,6 +23,7 @@
 #define IDC_SITE                        32781
 #define IDC_AUTHOR                      32782
 #define IDC_FEEDBACK                    32783
+#define IDC_TELEMETRY                   32784
 
 #define IDD_ABOUT_UPGRADE               203
 #define IDB_UPGRADE                     32771
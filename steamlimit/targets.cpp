@@ -0,0 +1,723 @@
+/**@addtogroup Monitor Steam limiter monitor application.
+ * @{@file
+ *
+ * Put the filter into processes from a pool of worker threads, so that a slow
+ * call into one doesn't hold up the monitor's window or the others, and keep
+ * track of the processes it's been put into so it can be taken out again.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define WIN32_LEAN_AND_MEAN     1
+#include <windows.h>
+#include <tlhelp32.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inject.h"
+#include "targets.h"
+#include "../steamfilter/rulebase.h"
+
+/**
+ * Simple cliches for measuring arrays.
+ * @{
+ */
+
+#define ARRAY_LENGTH(a)         (sizeof (a) / sizeof (* a))
+#define ARRAY_END(a)            ((a) + ARRAY_LENGTH (a))
+
+/**@}*/
+
+/**
+ * The most processes we keep track of at once, and how long to wait for the
+ * work in hand to finish before exiting, in milliseconds; putting the filter
+ * in involves looking up the names in the rules as well as the call itself,
+ * so that gets a bit longer than just the call.
+ *
+ * @{
+ */
+
+#define TARGET_MAX              32
+#define TARGET_WAIT             (CALL_WAIT * 2)
+#define TARGET_POLL             10
+
+/**@}*/
+
+/**
+ * How long to wait for the filter to pick up rules handed to it through its
+ * rule block, and how often to look, in milliseconds.
+ *
+ * @{
+ */
+
+#define RELOAD_WAIT             5000
+#define RELOAD_POLL             1
+
+/**@}*/
+
+/**
+ * A process we've put the filter into, or tried to.
+ *
+ * Along with the process handle we keep the page the shim for calling the
+ * filter was last run from, so later calls into the process can use it rather
+ * than each allocating one of their own. While m_busy is set, a worker thread
+ * owns the rest of the entry; otherwise it's only touched with the lock held.
+ * If the filter is to come out of a process while a worker has it, m_detach
+ * is set and the worker takes the filter out once it's done.
+ */
+
+struct Target {
+        unsigned long   m_process;
+        HANDLE          m_handle;
+        void          * m_page;
+        bool            m_attached;
+        bool            m_busy;
+        bool            m_detach;
+};
+
+/**
+ * What a worker thread is to do with a call into the filter.
+ *
+ * Attaching compiles the rules first, and records whether the filter went in;
+ * a reload is an attach that tries handing the rules over through the rule
+ * block first, and only calls into the process if that doesn't work. Detaching
+ * takes the filter out and forgets about the process.
+ */
+
+enum {
+        JOB_ATTACH = 1,
+        JOB_NOTIFY = 2,
+        JOB_RELOAD = 4,
+        JOB_DETACH = 8
+};
+
+/**
+ * A call into the filter for a worker thread to make.
+ */
+
+struct Job {
+        Target        * m_target;
+        const char    * m_entry;
+        wchar_t       * m_param;
+        void          * m_regRoot;
+        wchar_t       * m_regPath;
+        unsigned long   m_flags;
+};
+
+/**
+ * The processes we know about, and where to tell about attaching to them.
+ *
+ * @{
+ */
+
+static Target           l_targets [TARGET_MAX];
+static CRITICAL_SECTION l_lock;
+static CRITICAL_SECTION l_compile;
+static HWND volatile    l_window;
+static UINT             l_message;
+static bool             l_started;
+
+/**@}*/
+
+/**
+ * Find the entry for a process, if there is one; the lock must be held.
+ */
+
+static Target * l_find (unsigned long processId) {
+        Target        * scan = l_targets;
+        for (; scan != ARRAY_END (l_targets) ; ++ scan) {
+                if (scan->m_handle != 0 && scan->m_process == processId)
+                        return scan;
+        }
+
+        return 0;
+}
+
+/**
+ * Let go of an entry which isn't busy; the lock must be held.
+ */
+
+static void l_forget (Target * target) {
+        if (target->m_page != 0)
+                VirtualFreeEx (target->m_handle, target->m_page, 0,
+                               MEM_RELEASE);
+
+        CloseHandle (target->m_handle);
+        memset (target, 0, sizeof (* target));
+}
+
+/**
+ * Find or make the entry for a process; the lock must be held.
+ *
+ * The entries for processes which have exited are recycled as we go, since
+ * nothing tells us about those other than their handles being signalled.
+ */
+
+static Target * l_open (unsigned long processId) {
+        Target        * target = l_find (processId);
+        if (target != 0)
+                return target;
+
+        Target        * scan = l_targets;
+        for (; scan != ARRAY_END (l_targets) ; ++ scan) {
+                if (scan->m_handle != 0 && ! scan->m_busy &&
+                    WaitForSingleObject (scan->m_handle, 0) == WAIT_OBJECT_0) {
+                        l_forget (scan);
+                }
+
+                if (scan->m_handle == 0 && target == 0)
+                        target = scan;
+        }
+
+        if (target == 0)
+                return 0;
+
+        /*
+         * This is the access callFilterId () asks for, and the ability to
+         * wait on the handle so we can tell when the process has gone.
+         */
+
+        unsigned long   access;
+        access = PROCESS_CREATE_THREAD | PROCESS_VM_OPERATION |
+                 PROCESS_VM_READ | PROCESS_VM_WRITE |
+                 PROCESS_QUERY_INFORMATION | SYNCHRONIZE;
+
+        HANDLE          proc;
+        proc = OpenProcess (access, FALSE, processId);
+        if (proc == 0)
+                return 0;
+
+        target->m_process = processId;
+        target->m_handle = proc;
+        return target;
+}
+
+/**
+ * Hand a set of rules to the filter in a process through its rule block, and
+ * wait for it to say how installing them went.
+ *
+ * This returns false if the filter has no rule block (such as if it's an older
+ * version) or doesn't answer in time, in which case the caller can fall back
+ * to calling into the process. Only one worker deals with a given process at a
+ * time, so we're the only writer.
+ */
+
+static bool l_publish (unsigned long processId, const wchar_t * rules,
+                       bool & result) {
+        size_t          length = rules != 0 ? wcslen (rules) : 0;
+        if (length >= RULEBASE_TEXT)
+                return false;
+
+        wchar_t         name [64];
+        wsprintfW (name, RULEBASE_NAME, processId);
+
+        HANDLE          section;
+        section = OpenFileMappingW (FILE_MAP_WRITE, FALSE, name);
+        if (section == 0)
+                return false;
+
+        RulebaseBlock * block;
+        block = (RulebaseBlock *) MapViewOfFile (section, FILE_MAP_WRITE, 0,
+                                                 0, sizeof (RulebaseBlock));
+        CloseHandle (section);
+        if (block == 0)
+                return false;
+
+        wsprintfW (name, RULEBASE_EVENT, processId);
+        HANDLE          changed = OpenEventW (EVENT_MODIFY_STATE, FALSE, name);
+
+        bool            published = false;
+
+        if (changed != 0 && block->m_magic == RULEBASE_MAGIC &&
+            block->m_version == RULEBASE_VERSION &&
+            block->m_size >= sizeof (RulebaseBlock)) {
+                LONG            generation = block->m_generation & ~ 1L;
+
+                InterlockedExchange (& block->m_generation, generation + 1);
+                memcpy (block->m_text, rules, length * sizeof (wchar_t));
+                block->m_length = length;
+                InterlockedExchange (& block->m_generation, generation + 2);
+
+                SetEvent (changed);
+
+                for (unsigned long waited = 0 ; waited < RELOAD_WAIT ;
+                     waited += RELOAD_POLL) {
+                        if (block->m_installed == generation + 2) {
+                                result = block->m_result == 1;
+                                published = true;
+                                break;
+                        }
+
+                        Sleep (RELOAD_POLL);
+                }
+        }
+
+        if (changed != 0)
+                CloseHandle (changed);
+
+        UnmapViewOfFile (block);
+        return published;
+}
+
+/**
+ * Make the call a job asks for into the filter, from a worker thread which
+ * owns the target.
+ */
+
+static bool l_call (Job * job) {
+        Target        * target = job->m_target;
+
+        /*
+         * Do the work of parsing the rules here rather than in the target, if
+         * the filter is able to; if not, it will just parse the text itself.
+         */
+
+        HANDLE          image = 0;
+        if ((job->m_flags & JOB_ATTACH) != 0)
+                image = compileTarget (target->m_process, job->m_param);
+
+        bool            result = false;
+        bool            done = false;
+        if ((job->m_flags & JOB_RELOAD) != 0)
+                done = l_publish (target->m_process, job->m_param, result);
+
+        if (! done) {
+                result = callFilterPage (target->m_handle, & target->m_page,
+                                         job->m_entry, job->m_param,
+                                         job->m_regRoot, job->m_regPath);
+        }
+
+        if (image != 0)
+                CloseHandle (image);
+
+        return result;
+}
+
+/**
+ * Take the filter out of a process, from a worker thread which owns the
+ * target, and forget about the process.
+ */
+
+static void l_unload (Target * target) {
+        if (WaitForSingleObject (target->m_handle, 0) == WAIT_TIMEOUT) {
+                callFilterPage (target->m_handle, & target->m_page,
+                                "FilterUnload");
+        }
+
+        EnterCriticalSection (& l_lock);
+        l_forget (target);
+        LeaveCriticalSection (& l_lock);
+}
+
+/**
+ * Make a call into the filter on a worker thread.
+ *
+ * Once the filter has been taken out of a process, we always say so, since
+ * the window may think it's still attached.
+ */
+
+static DWORD WINAPI l_work (void * param) {
+        Job           * job = (Job *) param;
+        Target        * target = job->m_target;
+        unsigned long   processId = target->m_process;
+
+        bool            detach = (job->m_flags & JOB_DETACH) != 0;
+        bool            result = false;
+        if (! detach)
+                result = l_call (job);
+
+        EnterCriticalSection (& l_lock);
+        if ((job->m_flags & JOB_ATTACH) != 0)
+                target->m_attached = result;
+
+        detach = detach || target->m_detach;
+        if (! detach)
+                target->m_busy = false;
+        LeaveCriticalSection (& l_lock);
+
+        if (detach) {
+                l_unload (target);
+                result = false;
+        }
+
+        bool            notify = detach || (job->m_flags & JOB_NOTIFY) != 0;
+        if (notify && l_window != 0)
+                PostMessageW (l_window, l_message, processId, result);
+
+        free (job->m_param);
+        free (job->m_regPath);
+        free (job);
+        return 0;
+}
+
+/**
+ * Hand a call into the filter in a process to a worker thread.
+ *
+ * Only one call is in hand for a process at a time. Calls that attach or
+ * detach the filter start tracking the process if we weren't already (a
+ * detach from a process we don't know about is in case there's a stale filter
+ * in it); others only go to processes we know about.
+ */
+
+static bool l_queue (unsigned long processId, const char * entry,
+                     const wchar_t * param, void * regRoot,
+                     const wchar_t * regPath, unsigned long flags) {
+        if (! l_started)
+                return false;
+
+        Job           * job = (Job *) malloc (sizeof (Job));
+        if (job == 0)
+                return false;
+
+        job->m_entry = entry;
+        job->m_param = param != 0 ? _wcsdup (param) : 0;
+        job->m_regRoot = regRoot;
+        job->m_regPath = regPath != 0 ? _wcsdup (regPath) : 0;
+        job->m_flags = flags;
+
+        bool            queued = false;
+
+        EnterCriticalSection (& l_lock);
+
+        Target        * target;
+        if ((flags & (JOB_ATTACH | JOB_DETACH)) != 0) {
+                target = l_open (processId);
+        } else
+                target = l_find (processId);
+
+        if (target != 0 && ! target->m_busy) {
+                job->m_target = target;
+                target->m_busy = true;
+
+                queued = QueueUserWorkItem (l_work, job,
+                                            WT_EXECUTELONGFUNCTION) != 0;
+                if (! queued)
+                        target->m_busy = false;
+        }
+
+        LeaveCriticalSection (& l_lock);
+
+        if (queued)
+                return true;
+
+        free (job->m_param);
+        free (job->m_regPath);
+        free (job);
+        return false;
+}
+
+/**
+ * See whether a name is in a list of names separated by semicolons.
+ */
+
+static bool l_named (const wchar_t * names, const wchar_t * name) {
+        size_t          length = wcslen (name);
+
+        while (* names != 0) {
+                const wchar_t * end = wcschr (names, ';');
+                if (end == 0)
+                        end = names + wcslen (names);
+
+                if ((size_t) (end - names) == length &&
+                    _wcsnicmp (names, name, length) == 0) {
+                        return true;
+                }
+
+                names = * end == 0 ? end : end + 1;
+        }
+
+        return false;
+}
+
+/**
+ * Say where to tell about attaching the filter.
+ */
+
+void startTargets (HWND window, UINT message) {
+        l_window = window;
+        l_message = message;
+
+        if (l_started)
+                return;
+
+        InitializeCriticalSection (& l_lock);
+        InitializeCriticalSection (& l_compile);
+        l_started = true;
+}
+
+/**
+ * Start putting the filter into a process.
+ */
+
+bool attachTarget (unsigned long processId, const wchar_t * rules,
+                   void * regRoot, const wchar_t * regPath, bool notify) {
+        return l_queue (processId, "SteamFilter", rules, regRoot, regPath,
+                        JOB_ATTACH | (notify ? JOB_NOTIFY : 0));
+}
+
+/**
+ * Hand a new set of rules to the filter in every process it's in.
+ *
+ * Each attached process gets a reload of its own, and we hear how each one
+ * went as for an attach; this returns false if any of them couldn't be
+ * started, so the caller can fall back to taking the filter out and putting
+ * it back.
+ */
+
+bool reloadTargets (const wchar_t * rules, void * regRoot,
+                    const wchar_t * regPath) {
+        if (! l_started)
+                return false;
+
+        unsigned long   processes [TARGET_MAX];
+        unsigned long   count = 0;
+
+        EnterCriticalSection (& l_lock);
+
+        Target        * scan = l_targets;
+        for (; scan != ARRAY_END (l_targets) ; ++ scan) {
+                if (scan->m_handle != 0 && scan->m_attached)
+                        processes [count ++] = scan->m_process;
+        }
+
+        LeaveCriticalSection (& l_lock);
+
+        bool            all = true;
+        for (unsigned long i = 0 ; i < count ; ++ i) {
+                if (! l_queue (processes [i], "SteamFilter", rules, regRoot,
+                               regPath, JOB_ATTACH | JOB_NOTIFY | JOB_RELOAD))
+                        all = false;
+        }
+
+        return all;
+}
+
+/**
+ * Put the filter into any helper processes that don't have it yet.
+ *
+ * The helpers are found by name rather than by being children of Steam, as
+ * some of them are started by other helpers and some by the system. A helper
+ * we can't put the filter into is left alone until it exits, rather than being
+ * tried again every time we look.
+ */
+
+void attachHelpers (const wchar_t * names, const wchar_t * rules,
+                    void * regRoot, const wchar_t * regPath) {
+        if (names == 0 || * names == 0)
+                return;
+
+        HANDLE          list;
+        list = CreateToolhelp32Snapshot (TH32CS_SNAPPROCESS, 0);
+        if (list == INVALID_HANDLE_VALUE)
+                return;
+
+        PROCESSENTRY32W process = { sizeof (process) };
+        BOOL            more = Process32FirstW (list, & process);
+
+        for (; more ; more = Process32NextW (list, & process)) {
+                if (! l_named (names, process.szExeFile) ||
+                    targetKnown (process.th32ProcessID)) {
+                        continue;
+                }
+
+                l_queue (process.th32ProcessID, "SteamFilter", rules, regRoot,
+                         regPath, JOB_ATTACH);
+        }
+
+        CloseHandle (list);
+}
+
+/**
+ * Keep track of a process the filter is already in.
+ */
+
+bool adoptTarget (unsigned long processId) {
+        if (! l_started)
+                return false;
+
+        EnterCriticalSection (& l_lock);
+        Target        * target = l_open (processId);
+        if (target != 0 && ! target->m_busy)
+                target->m_attached = true;
+        LeaveCriticalSection (& l_lock);
+
+        return target != 0;
+}
+
+/**
+ * Compile a set of rules for a process, in our own process.
+ *
+ * The compiler is loaded into our own process for this, and it isn't built for
+ * having several threads in it at once, so everything takes turns at it.
+ */
+
+HANDLE compileTarget (unsigned long processId, const wchar_t * rules) {
+        if (! l_started)
+                return compileFilter (processId, rules);
+
+        EnterCriticalSection (& l_compile);
+        HANDLE          image = compileFilter (processId, rules);
+        LeaveCriticalSection (& l_compile);
+
+        return image;
+}
+
+/**
+ * Start a call into the filter in a process.
+ */
+
+bool callTarget (unsigned long processId, const char * entryPoint,
+                 const wchar_t * param) {
+        return l_queue (processId, entryPoint, param, 0, 0, 0);
+}
+
+/**
+ * Say whether there's work in hand on a process.
+ */
+
+bool targetBusy (unsigned long processId) {
+        if (! l_started)
+                return false;
+
+        EnterCriticalSection (& l_lock);
+        Target        * target = l_find (processId);
+        bool            busy = target != 0 && target->m_busy;
+        LeaveCriticalSection (& l_lock);
+
+        return busy;
+}
+
+/**
+ * Say whether the filter is known to be in a process.
+ *
+ * This is what to go by when told that an attach has finished, rather than
+ * what the message says; the filter might have been taken back out, or a new
+ * attach started, since it was posted.
+ */
+
+bool targetAttached (unsigned long processId) {
+        if (! l_started)
+                return false;
+
+        EnterCriticalSection (& l_lock);
+        Target        * target = l_find (processId);
+        bool            attached;
+        attached = target != 0 && ! target->m_busy && target->m_attached;
+        LeaveCriticalSection (& l_lock);
+
+        return attached;
+}
+
+/**
+ * Say whether a process is one we've tried to put the filter into.
+ */
+
+bool targetKnown (unsigned long processId) {
+        if (! l_started)
+                return false;
+
+        EnterCriticalSection (& l_lock);
+        bool            known = l_find (processId) != 0;
+        LeaveCriticalSection (& l_lock);
+
+        return known;
+}
+
+/**
+ * Start taking the filter out of a process.
+ */
+
+bool unloadTarget (unsigned long processId) {
+        return l_queue (processId, "FilterUnload", 0, 0, 0, JOB_DETACH);
+}
+
+/**
+ * Take the filter back out of every process we know about.
+ *
+ * A process with work still in hand is marked, and the worker which has it
+ * takes the filter out once it's done; the rest get workers of their own.
+ * Only the window's thread starts work, so nothing becomes busy between
+ * looking and queueing.
+ */
+
+void detachTargets (void) {
+        if (! l_started)
+                return;
+
+        unsigned long   processes [TARGET_MAX];
+        unsigned long   count = 0;
+
+        EnterCriticalSection (& l_lock);
+
+        Target        * scan = l_targets;
+        for (; scan != ARRAY_END (l_targets) ; ++ scan) {
+                if (scan->m_handle == 0)
+                        continue;
+
+                if (scan->m_busy) {
+                        scan->m_detach = true;
+                } else
+                        processes [count ++] = scan->m_process;
+        }
+
+        LeaveCriticalSection (& l_lock);
+
+        for (unsigned long i = 0 ; i < count ; ++ i)
+                unloadTarget (processes [i]);
+}
+
+/**
+ * Wait for the work in hand on every process to finish, for a while.
+ *
+ * Any process still busy after that is most likely stuck, and is left to the
+ * worker which has it.
+ */
+
+bool waitTargets (void) {
+        if (! l_started)
+                return true;
+
+        for (unsigned long waited = 0 ;; waited += TARGET_POLL) {
+                bool            busy = false;
+
+                EnterCriticalSection (& l_lock);
+                Target        * scan = l_targets;
+                for (; scan != ARRAY_END (l_targets) ; ++ scan)
+                        busy = busy || scan->m_busy;
+                LeaveCriticalSection (& l_lock);
+
+                if (! busy)
+                        return true;
+                if (waited >= TARGET_WAIT)
+                        return false;
+
+                Sleep (TARGET_POLL);
+        }
+}
+
+/**@}*/
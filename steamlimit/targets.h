@@ -0,0 +1,141 @@
+#ifndef TARGETS_H
+#define TARGETS_H               1
+
+/**@addtogroup Monitor Steam limiter monitor application.
+ * @{@file
+ *
+ * Declare the functions for putting the filter into processes from a pool of
+ * worker threads, and keeping track of where it's been put.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Say where to tell about attaching the filter to a target; when an attach
+ * started by attachTarget () is done, the message is posted to the window
+ * with the process ID as the wparam and the result as the lparam.
+ *
+ * Calling this again just changes the window the messages go to.
+ */
+
+void startTargets (HWND window, UINT message);
+
+/**
+ * Start putting the filter into a process with a set of rules, compiling them
+ * first, on a worker thread; this returns false if the work couldn't be
+ * started, such as if some is already in hand for the process.
+ */
+
+bool attachTarget (unsigned long processId, const wchar_t * rules,
+                   void * regRoot, const wchar_t * regPath,
+                   bool notify = true);
+
+/**
+ * Hand a new set of rules to the filter in every process it's known to be in,
+ * without calling into them where the filter can take the rules through its
+ * rule block; each one is reported on as for an attach. This returns false if
+ * that couldn't be started for all of them.
+ */
+
+bool reloadTargets (const wchar_t * rules, void * regRoot,
+                    const wchar_t * regPath);
+
+/**
+ * Put the filter into any helper processes running with one of the given
+ * names which it isn't in already; the names are separated by semicolons.
+ */
+
+void attachHelpers (const wchar_t * names, const wchar_t * rules,
+                    void * regRoot, const wchar_t * regPath);
+
+/**
+ * Start keeping track of a process the filter was put into some other way,
+ * such as by calling it from the first thread of a process we started, so
+ * that later calls into it can be made from a worker thread as for the rest.
+ */
+
+bool adoptTarget (unsigned long processId);
+
+/**
+ * Compile a set of rules for a process ahead of calling into it, taking turns
+ * with the worker threads.
+ */
+
+HANDLE compileTarget (unsigned long processId, const wchar_t * rules);
+
+/**
+ * Start a call into the filter in a process, on a worker thread, without
+ * waiting to hear how it went.
+ */
+
+bool callTarget (unsigned long processId, const char * entryPoint,
+                 const wchar_t * param = 0);
+
+/**
+ * Say whether there's work in hand on a process.
+ */
+
+bool targetBusy (unsigned long processId);
+
+/**
+ * Say whether the filter is known to be in a process.
+ */
+
+bool targetAttached (unsigned long processId);
+
+/**
+ * Say whether a process is one we've tried to put the filter into.
+ */
+
+bool targetKnown (unsigned long processId);
+
+/**
+ * Start taking the filter out of a process on a worker thread, whether or not
+ * we know about it, and forget about it; when that's done, the message is
+ * posted as for an attach.
+ */
+
+bool unloadTarget (unsigned long processId);
+
+/**
+ * Start taking the filter back out of every process we put it into, and
+ * forgetting about them; work already in hand on a process is left to finish
+ * first, by the worker doing it.
+ */
+
+void detachTargets (void);
+
+/**
+ * Wait a while for all the work in hand to finish, such as before exiting;
+ * this returns false if some is still going.
+ */
+
+bool waitTargets (void);
+
+/**@}*/
+#endif  /* ! defined (TARGETS_H) */
@@ -0,0 +1,248 @@
+/**@addtogroup Monitor Steam limiter monitor application.
+ * @{@file
+ *
+ * Find out about new instances of a program as they start, using WMI's trace
+ * of process creation.
+ *
+ * @author Nigel Bree <nigel.bree@gmail.com>
+ *
+ * Copyright (C) 2013 Nigel Bree; All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _WIN32_DCOM
+#include <windows.h>
+#include <tlhelp32.h>
+#include <wbemidl.h>
+
+#include "watch.h"
+
+/**
+ * How long to wait for a new process to load the module we're waiting on, and
+ * how often to look, in milliseconds.
+ *
+ * @{
+ */
+
+#define MODULE_WAIT             30000
+#define MODULE_POLL             20
+
+/**@}*/
+
+/**
+ * What we're watching for, and where to tell about it.
+ *
+ * @{
+ */
+
+static const wchar_t  * l_image;
+static const wchar_t  * l_module;
+static HWND volatile    l_window;
+static UINT             l_message;
+static HANDLE           l_thread;
+static volatile LONG    l_watching;
+
+/**@}*/
+
+/**
+ * Wait for a process to load a module.
+ *
+ * A process that's just been created hasn't even got its loader going, so
+ * nothing can be done with it until then; this looks at its module list
+ * every so often until the module shows up. The toolhelp functions can fail
+ * while the loader is busy changing the list, so that's just tried again.
+ */
+
+static bool l_waitForModule (unsigned long processId, const wchar_t * name) {
+        for (unsigned long waited = 0 ; waited < MODULE_WAIT ;
+             waited += MODULE_POLL) {
+                HANDLE          list;
+                list = CreateToolhelp32Snapshot (TH32CS_SNAPMODULE, processId);
+
+                if (list == INVALID_HANDLE_VALUE) {
+                        unsigned long   error = GetLastError ();
+                        if (error != ERROR_BAD_LENGTH &&
+                            error != ERROR_PARTIAL_COPY)
+                                return false;
+                } else {
+                        MODULEENTRY32W  module = { sizeof (module) };
+                        BOOL            more = Module32FirstW (list, & module);
+                        bool            found = false;
+
+                        for (; more && ! found ;
+                             more = Module32NextW (list, & module)) {
+                                found = lstrcmpiW (module.szModule, name) == 0;
+                        }
+
+                        CloseHandle (list);
+                        if (found)
+                                return true;
+                }
+
+                Sleep (MODULE_POLL);
+        }
+
+        return false;
+}
+
+/**
+ * Pass on one process creation event.
+ */
+
+static void l_announce (IWbemClassObject * event) {
+        VARIANT         value;
+        VariantInit (& value);
+
+        HRESULT         result;
+        result = event->Get (L"ProcessID", 0, & value, 0, 0);
+        if (SUCCEEDED (result) &&
+            (V_VT (& value) == VT_I4 || V_VT (& value) == VT_UI4)) {
+                unsigned long   processId = V_UI4 (& value);
+
+                if (l_waitForModule (processId, l_module))
+                        PostMessageW (l_window, l_message, processId, 0);
+        }
+
+        VariantClear (& value);
+}
+
+/**
+ * The thread which waits for events from WMI.
+ *
+ * This uses the semi-synchronous form of notification query, where a thread
+ * sits in IEnumWbemClassObject::Next () waiting for each event in turn; the
+ * asynchronous form needs a callback object which WMI calls into from its own
+ * process, which comes with a lot of COM security fuss to make work.
+ *
+ * The process trace events are only available to administrators, so for
+ * most people this will fail; the server only checks that when we first ask
+ * for an event, though, so the watch only counts as working once the first
+ * request for one either gets an event or times out.
+ */
+
+static unsigned long WINAPI l_watchThread (void *) {
+        HRESULT         result = CoInitializeEx (0, COINIT_MULTITHREADED);
+        if (FAILED (result))
+                return 0;
+
+        CoInitializeSecurity (0, -1, 0, 0, RPC_C_AUTHN_LEVEL_DEFAULT,
+                              RPC_C_IMP_LEVEL_IMPERSONATE, 0, EOAC_NONE, 0);
+
+        wchar_t         text [128];
+        wsprintfW (text, L"SELECT ProcessID FROM Win32_ProcessStartTrace "
+                   L"WHERE ProcessName = '%.40s'", l_image);
+
+        BSTR            space = SysAllocString (L"ROOT\\CIMV2");
+        BSTR            language = SysAllocString (L"WQL");
+        BSTR            query = SysAllocString (text);
+
+        IWbemLocator  * locator = 0;
+        IWbemServices * services = 0;
+        IEnumWbemClassObject * events = 0;
+
+        result = CoCreateInstance (__uuidof (WbemLocator), 0,
+                                   CLSCTX_INPROC_SERVER,
+                                   __uuidof (IWbemLocator),
+                                   (void **) & locator);
+
+        if (SUCCEEDED (result))
+                result = locator->ConnectServer (space, 0, 0, 0, 0, 0, 0,
+                                                 & services);
+
+        if (SUCCEEDED (result))
+                result = CoSetProxyBlanket (services, RPC_C_AUTHN_WINNT,
+                                            RPC_C_AUTHZ_NONE, 0,
+                                            RPC_C_AUTHN_LEVEL_CALL,
+                                            RPC_C_IMP_LEVEL_IMPERSONATE, 0,
+                                            EOAC_NONE);
+
+        long            flags;
+        flags = WBEM_FLAG_RETURN_IMMEDIATELY | WBEM_FLAG_FORWARD_ONLY;
+        if (SUCCEEDED (result))
+                result = services->ExecNotificationQuery (language, query,
+                                                          flags, 0, & events);
+
+        long            wait = 0;
+        while (SUCCEEDED (result)) {
+                IWbemClassObject * event = 0;
+                unsigned long   count = 0;
+                result = events->Next (wait, 1, & event, & count);
+                if (FAILED (result))
+                        break;
+
+                InterlockedExchange (& l_watching, 1);
+                wait = WBEM_INFINITE;
+
+                if (count == 0)
+                        continue;
+
+                l_announce (event);
+                event->Release ();
+        }
+
+        InterlockedExchange (& l_watching, 0);
+
+        if (events != 0)
+                events->Release ();
+        if (services != 0)
+                services->Release ();
+        if (locator != 0)
+                locator->Release ();
+
+        SysFreeString (query);
+        SysFreeString (language);
+        SysFreeString (space);
+
+        CoUninitialize ();
+        return 0;
+}
+
+/**
+ * Start the watch, if it isn't already going.
+ */
+
+bool watchProcess (const wchar_t * image, const wchar_t * module,
+                   HWND window, UINT message) {
+        l_window = window;
+        l_message = message;
+
+        if (l_thread != 0)
+                return true;
+
+        l_image = image;
+        l_module = module;
+        l_thread = CreateThread (0, 0, l_watchThread, 0, 0, 0);
+        return l_thread != 0;
+}
+
+/**
+ * Say whether the watch is working.
+ */
+
+bool watchingProcess (void) {
+        return l_watching != 0;
+}
+
+/**@}*/
@@ -15,11 +15,15 @@
 # mappings into the datastore is to prepare a file with a suitable Python data
 # literal I can import, such with the subset of IP ranges I care about.
 
+import bisect
+import hashlib
 import json
 import logging
 import string
 import ip_match
 
+from google.appengine.api import memcache
+
 # Assist the mapping process by converting the IP address string into a number
 
 def stringip_to_number (text):
@@ -30,21 +34,84 @@ def stringip_to_number (text):
 
     return total;
 
+# The same for IPv6 addresses, which may use :: to elide a run of zero groups.
+
+def stringip6_to_number (text):
+    head, elided, tail = text.partition ('::')
+    head = [item for item in head.split (':') if item]
+    tail = [item for item in tail.split (':') if item]
+
+    missing = 8 - len (head) - len (tail)
+    if missing < 0 or (missing > 0 and not elided):
+        raise ValueError (text)
+
+    total = 0
+    for item in head + ['0'] * missing + tail:
+        total = (total << 16) + int (item, 16)
+
+    return total
+
 # Alternate mapping table for IPv6 netblocks; currently there are few of these,
-# but Internode in Australia appear to be one such organization. For now I'm
-# not bothering to explicitly represent the prefix length, I'm just using a
-# simple prefix match.
+# but Internode in Australia appear to be one such organization.
 
 ipv6_prefixes = {
-    "2001:4400:": 0,    # TelstraClear New Zealand
-    "2001:4478:": 12,   # iiNet Australia
-    "2001:4479:": 12,   # iiNet Australia
-    "2001:44B8:": 11,   # Internode Australia
-    "2406:E000:": 2	# Snap! New Zealand
-};
-
-# Find any matching tuple inside the ip_match.ip_table list, which is sorted,
-# and return the ISP number for it
+    '2001:4400::/32': 0,    # TelstraClear New Zealand
+    '2001:4478::/32': 12,   # iiNet Australia
+    '2001:4479::/32': 12,   # iiNet Australia
+    '2001:44b8::/32': 11,   # Internode Australia
+    '2406:e000::/32': 2     # Snap! New Zealand
+}
+
+# The prefixes go into a trie, one level per 4-bit nibble of the address with
+# the ISP for a prefix stored under None at the node where it ends. A prefix
+# whose length isn't a whole number of nibbles is expanded to cover all the
+# nibbles it matches at its last level, and the prefixes go in shortest first
+# so that longer (more specific) ones override the expansions.
+
+def build_trie (prefixes):
+    items = []
+    for text, isp in prefixes.items ():
+        address, length = text.split ('/')
+        items.append ((int (length), stringip6_to_number (address), isp))
+
+    root = {}
+    for length, number, isp in sorted (items):
+        node = root
+        for level in range (length // 4):
+            nibble = (number >> (124 - level * 4)) & 15
+            node = node.setdefault (nibble, {})
+
+        spare = 4 - length % 4
+        if spare == 4:
+            node [None] = isp
+            continue
+
+        first = (number >> (124 - (length // 4) * 4)) & 15
+        first &= ~ ((1 << spare) - 1)
+        for nibble in range (first, first + (1 << spare)):
+            node.setdefault (nibble, {}) [None] = isp
+
+    return root
+
+ipv6_trie = build_trie (ipv6_prefixes)
+
+# Walk the trie as far as the address goes, keeping the longest match.
+
+def find_ipv6 (number):
+    node = ipv6_trie
+    found = - 1
+    for shift in range (124, - 4, - 4):
+        node = node.get ((number >> shift) & 15)
+        if node is None:
+            break
+        found = node.get (None, found)
+
+    return found
+
+# Find the range in the tables from ip_match containing the address, and return
+# the ISP number for it. The range starts are sorted, so the candidate is the
+# last range starting at or below the address, and it's a match if the address
+# is also within its end.
 #
 # The remapping for loopback below is to help testing; since we don't have a
 # real IP to use in the local GAE dev environment, try the various known Steam
@@ -56,41 +123,28 @@ def find_netblock (ip):
 
     ipType = type (ip)
     if ipType == str or ipType == unicode:
+        # IPv4 addresses mapped into IPv6 form go in the IPv4 table
+
+        if ip.lower ().startswith ('::ffff:') and '.' in ip:
+            ip = ip [7:]
+
         if ':' in ip:   # look in IPv6 table.
-            ip = ip.upper ()
-            for prefix in ipv6_prefixes.items ():
-                if ip.startswith (prefix [0]):
-                    return prefix [1]
+            try:
+                netblock = find_ipv6 (stringip6_to_number (ip))
+            except ValueError:
+                netblock = - 1
 
-            logging.warning ('Unknown mapping for IPv6 address ' + ip)
-            return - 1
+            if netblock < 0:
+                logging.warning ('Unknown mapping for IPv6 address ' + ip)
+            return netblock
 
         ipv4 = stringip_to_number (ip)
     else:
         ipv4 = ip
 
-    # Binary search or linear? Now the table is 1200 long, it's worth it to do
-    # a binary search.
-
-    table = ip_match.ip_table
-    low = 0
-    high = len (table) - 1
-
-    while low <= high:
-        mid = (low + high) / 2
-        item = table [mid]
-
-        if item [0] >= ipv4:
-            # Move down
-            high = mid - 1
-            continue
-
-        if item [1] >= ipv4:
-            # We have a match
-            return item [2]
-
-        # Move up
-        low = mid + 1
+    index = bisect.bisect_right (ip_match.ip_starts, ipv4) - 1
+    if index >= 0 and ipv4 <= ip_match.ip_ends [index]:
+        return ip_match.ip_isps [index]
 
     if type (ip) == str:
         logging.warning ('Unknown mapping for IPv4 address ' + ip)
@@ -150,8 +204,13 @@ def send (handler, data):
 
 # All the data we care about, all in a dict, for various handlers to choose
 # from to render
+#
+# Everything other than the country depends only on the ISP, so that part is
+# rendered once per ISP and kept in memcache; the caller's version names the
+# rule data it's rendered from, so that changing the rules never serves stale
+# bundles.
 
-def bundle (self, isps, defaults, source = None):
+def bundle (self, isps, defaults, source = None, version = None):
     if not source:
         source = self.request.get ('ip', self.request.remote_addr)
     netblock = find_netblock (source)
@@ -164,6 +223,21 @@ def bundle (self, isps, defaults, source = None):
     country = self.request.headers.get ('X-AppEngine-Country')
     country = country or 'Unknown'
 
+    key = version and 'bundle:%s:%d' % (version, netblock)
+    result = key and memcache.get (key)
+    if not result:
+        result = render (isps, defaults, netblock)
+        if key:
+            memcache.set (key, result)
+
+    result ['country'] = country
+
+    logging.info (json.dumps (result))
+    return result
+
+# Render the ISP-specific part of a bundle.
+
+def render (isps, defaults, netblock):
     isp = isps.get (netblock)
     if isp is None:
         isp = isps.get (- 1)
@@ -202,7 +276,6 @@ def bundle (self, isps, defaults, source = None):
 
     result ['filterip'] = isp.get ('server')
     result ['ispname'] = isp.get ('name')
-    result ['country'] = country
 
     if proxy and proxyfilter and proxyallow:
         result ['proxy'] = proxy
@@ -216,5 +289,84 @@ def bundle (self, isps, defaults, source = None):
     if test:
         result ['test'] = test
 
-    logging.info (json.dumps (result))
     return result
+
+# The per-ISP parts of a bundle, which are all a delta needs to carry when the
+# rules for the client's ISP have changed.
+
+isp_keys = ('filterip', 'filterrule', 'allow', 'proxy', 'test')
+
+# Work out a delta for a client holding the bundle from an earlier revision.
+# This is only possible if the change history still covers every revision
+# since then and none of those changed the defaults (noted as None), since in
+# that case everything can change; otherwise the answer is None and the client
+# just gets the whole bundle.
+#
+# The delta always carries the client's ISP name, so if the client has moved
+# to another ISP it can see that and ask for a full bundle.
+#
+# This is only asked for once the client's ETag has failed to match, so a
+# client that says it already has the current revision must hold rules that
+# were edited without the revision being bumped; the history can't say what
+# changed then, so that client gets the whole bundle too.
+
+def delta (data, since, revision, changes, isps):
+    try:
+        since = int (since)
+    except (TypeError, ValueError):
+        return None
+
+    if since >= revision:
+        return None
+
+    changed = set ()
+    for number in range (since + 1, revision + 1):
+        if number not in changes:
+            return None
+        changed.update (changes [number])
+
+    if None in changed:
+        return None
+
+    result = {
+        'revision': revision,
+        'since': since,
+        'ispname': data.get ('ispname'),
+        'country': data.get ('country')
+    }
+
+    names = [isps [netblock].get ('name') for netblock in changed
+             if netblock in isps]
+    if data.get ('ispname') in names:
+        for key in isp_keys:
+            result [key] = data.get (key)
+
+    return result
+
+# Send a whole bundle, with a strong ETag so that clients can revalidate the
+# copy they hold without downloading it again. The tag always covers the full
+# bundle for the client, even when what goes out is a delta, so that it names
+# what the client holds after merging.
+#
+# There's no compression done here; the App Engine front end gzips responses
+# itself for clients that ask for it in both Accept-Encoding and User-Agent,
+# and an application-set Content-Encoding header isn't passed through anyway.
+
+def send_bundle (handler, data, revision, changes, isps):
+    data = dict (data, revision = revision)
+    text = json.dumps (data, sort_keys = True)
+    tag = '"' + hashlib.sha1 (text).hexdigest () + '"'
+
+    headers = handler.response.headers
+    headers ['ETag'] = tag
+    headers ['Cache-Control'] = 'private, no-cache'
+    headers ['Vary'] = 'Accept-Encoding'
+
+    match = handler.request.headers.get ('If-None-Match', '')
+    match = [item.strip () for item in match.split (',')]
+    if tag in match or '*' in match:
+        handler.response.set_status (304)
+        return
+
+    since = handler.request.get ('since', default_value = None)
+    send (handler, delta (data, since, revision, changes, isps) or data)
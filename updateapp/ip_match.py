@@ -1,2184 +1,854 @@
 # This file is autogenerated by makeip2isp.js - do not edit
-ip_table = [
-    (16777216, 16777471, 50),
-    (16843008, 16843263, 50),
-    (16909056, 16909311, 50),
-    (19398656, 19726335, 13),
-    (24641536, 27262975, 10),
-    (134743040, 134743295, 50),
-    (134744064, 134744319, 50),
-    (136499200, 136503295, 50),
-    (136560640, 136564735, 50),
-    (235012096, 235077631, 11),
-    (386075648, 386075903, 60),
-    (386089984, 386090239, 60),
-    (386091776, 386092031, 60),
-    (386100224, 386100735, 60),
-    (386248704, 386252799, 0),
-    (386318336, 386322431, 12),
-    (386338816, 386342911, 11),
-    (386354688, 386359295, 60),
-    (386371584, 386375679, 60),
-    (386383872, 386387967, 60),
-    (386502656, 386506751, 12),
-    (386523136, 386527231, 11),
-    (386650112, 386651135, 11),
-    (386670592, 386674687, 60),
-    (386782208, 386783231, 12),
-    (386907136, 386907647, 11),
-    (386908672, 386909183, 12),
-    (387448832, 387579903, 60),
-    (387842048, 387973119, 60),
-    (387980800, 387981055, 60),
-    (388086272, 388086527, 60),
-    (388239360, 388247551, 12),
-    (388542464, 388546559, 60),
-    (388562944, 388567039, 60),
-    (388628480, 388632575, 30),
-    (388898816, 388907007, 13),
-    (389090304, 389091327, 60),
-    (389095424, 389100031, 60),
-    (389101568, 389101823, 60),
-    (389222400, 389226495, 32),
-    (389378048, 389390335, 10),
-    (389963776, 389964287, 60),
-    (389967616, 389967871, 60),
-    (389997568, 389997823, 60),
-    (390148096, 390152191, 0),
-    (390275072, 390275327, 13),
-    (390275584, 390275839, 10),
-    (390279168, 390279935, 60),
-    (390280192, 390280447, 60),
-    (390282240, 390282751, 60),
-    (390329856, 390330367, 60),
-    (390332416, 390594559, 60),
-    (391115520, 391115775, 13),
-    (398566400, 398566911, 60),
-    (398577664, 398578687, 60),
-    (398581760, 398589951, 60),
-    (399340288, 399341055, 10),
-    (399343104, 399343615, 60),
-    (399561728, 399562751, 60),
-    (399564800, 399572991, 60),
-    (399619840, 399620095, 10),
-    (399639808, 399640063, 60),
-    (399642112, 399642623, 60),
-    (399650816, 399660031, 60),
-    (399690240, 399691775, 60),
-    (399699968, 399708159, 60),
-    (399782912, 399783167, 60),
-    (399869440, 399869951, 60),
-    (401354752, 401358847, 50),
-    (402358272, 402366463, 50),
-    (402653184, 404226047, 60),
-    (404619264, 404652031, 60),
-    (404881408, 404946943, 60),
-    (405274624, 405295103, 60),
-    (406585344, 406847487, 60),
-    (407603456, 407603711, 60),
-    (408616960, 408682495, 60),
-    (409075712, 409206783, 60),
-    (409479168, 409479423, 60),
-    (409480192, 409480703, 60),
-    (409480960, 409481215, 60),
-    (409481472, 409481983, 60),
-    (409482240, 409482751, 60),
-    (409483264, 409483775, 60),
-    (409484032, 409484287, 60),
-    (409484800, 409487359, 60),
-    (409487872, 409488127, 60),
-    (409488384, 409489407, 60),
-    (409494528, 409494783, 60),
-    (409495040, 409495551, 60),
-    (409497600, 409498111, 60),
-    (409498368, 409499647, 60),
-    (409499904, 409500159, 60),
-    (409500416, 409500671, 60),
-    (409501184, 409503231, 60),
-    (409503744, 409503999, 60),
-    (409504768, 409505535, 60),
-    (409505792, 409506303, 60),
-    (409506560, 409506815, 60),
-    (409507584, 409509119, 60),
-    (409509376, 409509887, 60),
-    (410386432, 410451967, 60),
-    (410812416, 411140095, 60),
-    (411172864, 411303935, 60),
-    (412286976, 412352511, 60),
-    (412696576, 412704767, 60),
-    (416940032, 417005567, 60),
-    (418709504, 418725887, 60),
-    (459472896, 459505663, 13),
-    (460224512, 460226559, 2),
-    (469499904, 469565439, 7),
-    (469565440, 469598207, 13),
-    (691863552, 691929087, 31),
-    (692899840, 692901887, 30),
-    (692940544, 692940799, 30),
-    (693024768, 693025791, 32),
-    (693040128, 693041151, 32),
-    (693084160, 693085183, 30),
-    (693087488, 693087743, 34),
-    (693381120, 693383167, 34),
-    (693385216, 693403647, 34),
-    (693518336, 693526527, 34),
-    (693526528, 693534719, 33),
-    (696516608, 696778751, 33),
-    (697303040, 697753599, 32),
-    (697755648, 697802751, 32),
-    (697806848, 697827327, 32),
-    (699465728, 699531263, 34),
-    (699990016, 700055551, 31),
-    (700414976, 700415999, 30),
-    (700844544, 700844799, 32),
-    (700858368, 700862463, 32),
-    (702471168, 702472191, 30),
-    (702482432, 702483455, 30),
-    (703987712, 704118783, 32),
-    (708755456, 708771839, 13),
-    (720437248, 720502783, 13),
-    (793247744, 793313279, 7),
-    (833617920, 835190783, 13),
-    (836763648, 836812799, 7),
-    (836829184, 837025791, 7),
-    (843644928, 843710463, 60),
-    (843841536, 844103679, 60),
-    (847249408, 851968255, 60),
-    (851968512, 851970303, 60),
-    (851970560, 851972351, 60),
-    (851972608, 851978239, 60),
-    (851978496, 851985663, 60),
-    (851986176, 851989503, 60),
-    (851989760, 851996671, 60),
-    (851996928, 851999231, 60),
-    (851999488, 852002047, 60),
-    (852002304, 852009727, 60),
-    (852009984, 852010495, 60),
-    (852010752, 852011263, 60),
-    (852011520, 852014079, 60),
-    (852014336, 852018431, 60),
-    (852018688, 852020735, 60),
-    (852020992, 852027647, 60),
-    (852027904, 852032511, 60),
-    (852032768, 852035071, 60),
-    (852035328, 852038143, 60),
-    (852038400, 852039679, 60),
-    (852039936, 852050431, 60),
-    (852050688, 852052479, 60),
-    (852052992, 852059391, 60),
-    (852059904, 852061439, 60),
-    (852061696, 852061951, 60),
-    (852062208, 852068607, 60),
-    (852068864, 852080383, 60),
-    (852080640, 852082687, 60),
-    (852082944, 852086527, 60),
-    (852086784, 852093183, 60),
-    (852093440, 852093951, 60),
-    (852094208, 852095231, 60),
-    (852095488, 852097791, 60),
-    (852098048, 852101631, 60),
-    (852102144, 852109311, 60),
-    (852109568, 852111871, 60),
-    (852112384, 852114175, 60),
-    (852114432, 852114687, 60),
-    (852114944, 852116991, 60),
-    (852117248, 852118015, 60),
-    (852118272, 852120831, 60),
-    (852121088, 852123391, 60),
-    (852123648, 852124671, 60),
-    (852124928, 852127743, 60),
-    (852128256, 852133119, 60),
-    (852133376, 852135167, 60),
-    (852135424, 852138239, 60),
-    (852138496, 852139775, 60),
-    (852140032, 852141055, 60),
-    (852141312, 852143103, 60),
-    (852143360, 852153087, 60),
-    (852153344, 852154879, 60),
-    (852155136, 852156927, 60),
-    (852157184, 852160255, 60),
-    (852160512, 852162815, 60),
-    (852163072, 852165375, 60),
-    (852165632, 852168447, 60),
-    (852168704, 852168959, 60),
-    (852169216, 852173823, 60),
-    (852174080, 852174335, 60),
-    (852174592, 852185599, 60),
-    (852185856, 852192255, 60),
-    (852192512, 852199679, 60),
-    (852199936, 852202495, 60),
-    (852202752, 852206335, 60),
-    (852206592, 852207103, 60),
-    (852207616, 852215039, 60),
-    (852215296, 852222463, 60),
-    (852222720, 852223743, 60),
-    (852224000, 852225279, 60),
-    (852225536, 852233215, 60),
-    (852233472, 852237311, 60),
-    (852237568, 852241151, 60),
-    (852241408, 852245247, 60),
-    (852245504, 852248319, 60),
-    (852248576, 852251391, 60),
-    (852251648, 852254975, 60),
-    (852255232, 852256255, 60),
-    (852256512, 852258303, 60),
-    (852258560, 852267263, 60),
-    (852267520, 852269823, 60),
-    (852270080, 852270335, 60),
-    (852270592, 852270847, 60),
-    (852271104, 852275711, 60),
-    (852275968, 852277247, 60),
-    (852277504, 852279807, 60),
-    (852280064, 855638015, 60),
-    (973471744, 973475071, 15),
-    (973475072, 973475327, 12),
-    (973475328, 973477887, 15),
-    (973477888, 973478143, 12),
-    (973478912, 973483007, 15),
-    (973483008, 973486079, 12),
-    (973486080, 973490175, 15),
-    (973490176, 973498367, 12),
-    (973498368, 973498623, 15),
-    (973499392, 973500159, 12),
-    (973500416, 973504511, 15),
-    (973504512, 973508607, 12),
-    (973508608, 973512703, 15),
-    (973512704, 973513215, 12),
-    (973513216, 973514751, 15),
-    (973514752, 973520895, 12),
-    (973520896, 973521919, 15),
-    (973521920, 973537279, 12),
-    (973537280, 973545471, 15),
-    (973545472, 973602815, 12),
-    (974913536, 974979071, 5),
-    (979894272, 980418559, 13),
-    (982614016, 982622207, 13),
-    (983564288, 984612863, 10),
-    (984743936, 984875007, 14),
-    (996409344, 996487423, 12),
-    (996487680, 996489471, 12),
-    (996489728, 996573183, 12),
-    (999790592, 999793663, 11),
-    (999948288, 1000013823, 13),
-    (1000800256, 1000865791, 11),
-    (1021313024, 1021837311, 10),
-    (1021968384, 1021987071, 1),
-    (1021987328, 1022033919, 1),
-    (1023315712, 1023315967, 10),
-    (1023316992, 1023317247, 10),
-    (1024032768, 1024065535, 10),
-    (1025297920, 1025298175, 0),
-    (1025310720, 1025343487, 12),
-    (1027866624, 1027932159, 12),
-    (1027933184, 1027934207, 12),
-    (1027934720, 1027938303, 12),
-    (1027939072, 1027997695, 12),
-    (1029177344, 1029187583, 13),
-    (1029188096, 1029192191, 13),
-    (1029192448, 1029233663, 13),
-    (1029235712, 1029237759, 13),
-    (1029241856, 1029242879, 13),
-    (1029636096, 1029668863, 12),
-    (1049722880, 1049731071, 40),
-    (1082867712, 1082875903, 60),
-    (1084227584, 1084253183, 61),
-    (1084253696, 1084264191, 61),
-    (1084264448, 1084292607, 61),
-    (1084292864, 1084341759, 61),
-    (1084342016, 1084365823, 61),
-    (1084366080, 1084388351, 61),
-    (1084388608, 1084415487, 61),
-    (1084415744, 1084417279, 61),
-    (1084417536, 1084424191, 61),
-    (1084424448, 1084457983, 61),
-    (1084459008, 1084517631, 61),
-    (1084517888, 1084619007, 61),
-    (1084619264, 1084653567, 61),
-    (1084653824, 1084657663, 61),
-    (1084659456, 1084707071, 61),
-    (1084707328, 1084876031, 61),
-    (1084876288, 1084984831, 61),
-    (1084985344, 1084988671, 61),
-    (1084988928, 1085003775, 61),
-    (1085004032, 1085040383, 61),
-    (1085040640, 1085071359, 61),
-    (1085072384, 1085276159, 61),
-    (1089052672, 1089060863, 50),
-    (1092780032, 1092812799, 60),
-    (1096810496, 1096876031, 60),
-    (1107951616, 1107951871, 61),
-    (1108016640, 1108016895, 61),
-    (1109262336, 1109393407, 60),
-    (1109983232, 1110048767, 60),
-    (1110966272, 1110982655, 60),
-    (1113980928, 1113985023, 50),
-    (1114611712, 1114615807, 10),
-    (1115160576, 1115167999, 61),
-    (1115168256, 1115191007, 61),
-    (1115191012, 1115239423, 61),
-    (1115239680, 1115295231, 61),
-    (1115295744, 1115333631, 61),
-    (1115333888, 1115561983, 61),
-    (1115562496, 1115564031, 61),
-    (1115566080, 1115601919, 61),
-    (1115602176, 1115656703, 61),
-    (1115656960, 1115658751, 61),
-    (1115659008, 1115684863, 61),
-    (1118830592, 1118961663, 60),
-    (1120976896, 1120993279, 60),
-    (1122304000, 1122369535, 60),
-    (1123631104, 1123639295, 50),
-    (1134559232, 1136656383, 60),
-    (1142947840, 1145044991, 60),
-    (1146093568, 1146617855, 60),
-    (1157228544, 1157229567, 61),
-    (1161774080, 1161774335, 32),
-    (1166540800, 1167065087, 60),
-    (1169424384, 1169555455, 60),
-    (1170212608, 1170212863, 13),
-    (1173356544, 1174405119, 60),
-    (1176535040, 1176535551, 50),
-    (1176537088, 1176538111, 50),
-    (1176539136, 1176539647, 50),
-    (1176539904, 1176542719, 50),
-    (1176542976, 1176543231, 50),
-    (1180172288, 1180434431, 60),
-    (1192755200, 1193017343, 60),
-    (1194852352, 1195376639, 60),
-    (1203765248, 1204813823, 60),
-    (1205862400, 1206910975, 60),
-    (1208926208, 1208927795, 50),
-    (1208927796, 1208927799, 10),
-    (1208927800, 1208933891, 50),
-    (1208933892, 1208933895, 10),
-    (1208933896, 1208933939, 50),
-    (1208933940, 1208933943, 10),
-    (1208933944, 1208942591, 50),
-    (1224087808, 1224088063, 60),
-    (1224091904, 1224092415, 60),
-    (1224092928, 1224093183, 60),
-    (1224098304, 1224098815, 60),
-    (1224157696, 1224158207, 60),
-    (1224736768, 1241513983, 60),
-    (1242562560, 1243611135, 60),
-    (1247543296, 1247805439, 60),
-    (1249705984, 1249718783, 50),
-    (1249718784, 1249718787, 10),
-    (1249718788, 1249743871, 50),
-    (1249744896, 1249768447, 50),
-    (1249769216, 1249771519, 50),
-    (1250951168, 1251999743, 60),
-    (1262485504, 1263255551, 60),
-    (1267728384, 1268252671, 60),
-    (1276116992, 1277165567, 60),
-    (1280201728, 1280202751, 60),
-    (1281359872, 1285554175, 60),
-    (1288699904, 1289224191, 61),
-    (1346920448, 1346924543, 32),
-    (1359937536, 1359970303, 40),
-    (1412806656, 1412808703, 32),
-    (1439023104, 1439039487, 40),
-    (1486159872, 1486192639, 40),
-    (1490885376, 1490885631, 32),
-    (1490939904, 1490942975, 30),
-    (1503690752, 1503723519, 40),
-    (1506795520, 1506797567, 50),
-    (1551526912, 1551527935, 32),
-    (1551608832, 1551609855, 30),
-    (1551619072, 1551620095, 32),
-    (1600481280, 1600482303, 32),
-    (1600496640, 1600497663, 30),
-    (1611017216, 1611017471, 60),
-    (1611026432, 1611030527, 60),
-    (1611085824, 1611086335, 0),
-    (1611661312, 1611661823, 13),
-    (1611687936, 1611692031, 60),
-    (1611744256, 1611744511, 60),
-    (1611744768, 1611745279, 60),
-    (1611754496, 1611754751, 60),
-    (1611755008, 1611755519, 60),
-    (1611763968, 1611764223, 60),
-    (1611764480, 1611764991, 60),
-    (1611768832, 1611769599, 60),
-    (1611771904, 1611772159, 13),
-    (1614807040, 1618804735, 60),
-    (1619001344, 1625292799, 60),
-    (1646264320, 1646947839, 60),
-    (1646948096, 1648361471, 60),
-    (1656750080, 1660944383, 60),
-    (1661992960, 1662001151, 61),
-    (1662003200, 1662443519, 61),
-    (1662444032, 1662713855, 61),
-    (1662714880, 1662920703, 61),
-    (1662920960, 1663041535, 61),
-    (1700921344, 1700986879, 3),
-    (1701249024, 1701314559, 10),
-    (1704984576, 1705491455, 10),
-    (1705500672, 1707081727, 10),
-    (1728173056, 1728174079, 17),
-    (1728232960, 1728233215, 12),
-    (1728309248, 1728310271, 1),
-    (1728354304, 1728355327, 2),
-    (1728438272, 1728439295, 0),
-    (1728455424, 1728455679, 12),
-    (1728721152, 1728721407, 10),
-    (1728854016, 1728854527, 10),
-    (1728901376, 1728901631, 12),
-    (1728983040, 1728984063, 10),
-    (1729419264, 1729419519, 13),
-    (1729616384, 1729616639, 10),
-    (1729822976, 1729823231, 10),
-    (1729870848, 1729871871, 16),
-    (1729980160, 1729980415, 12),
-    (1743795200, 1743796223, 2),
-    (1743971328, 1743972351, 9),
-    (1744039680, 1744039935, 12),
-    (1744218112, 1744218367, 13),
-    (1744270848, 1744271359, 10),
-    (1744273408, 1744274431, 12),
-    (1744331008, 1744331263, 11),
-    (1744429056, 1744429567, 12),
-    (1744489472, 1744489727, 10),
-    (1744590592, 1744590847, 10),
-    (1744663552, 1744663807, 0),
-    (1776877568, 1776943103, 34),
-    (1782841344, 1782972415, 12),
-    (1782972416, 1783103487, 13),
-    (1795163136, 1795163647, 60),
-    (1795163904, 1795164671, 60),
-    (1795164928, 1795166207, 60),
-    (1795166464, 1795166719, 60),
-    (1795168000, 1795168767, 60),
-    (1795169024, 1795170047, 60),
-    (1795170304, 1795173119, 60),
-    (1795173376, 1795173887, 60),
-    (1795174400, 1795174911, 60),
-    (1795175168, 1795176703, 60),
-    (1795177728, 1795178495, 60),
-    (1795179008, 1795180031, 60),
-    (1795180288, 1795180543, 60),
-    (1795180800, 1795181311, 60),
-    (1795181568, 1795182079, 60),
-    (1795182592, 1795183103, 60),
-    (1795183360, 1795186687, 60),
-    (1795187456, 1795187967, 60),
-    (1795188736, 1795189503, 60),
-    (1795189760, 1795191039, 60),
-    (1795191552, 1795191807, 60),
-    (1795192064, 1795192575, 60),
-    (1795193088, 1795193343, 60),
-    (1795193600, 1795194111, 60),
-    (1795194880, 1795195135, 60),
-    (1795195392, 1795195647, 60),
-    (1795196160, 1795196671, 60),
-    (1795197184, 1795197439, 60),
-    (1795197696, 1795198463, 60),
-    (1795198720, 1795199231, 60),
-    (1795200256, 1795200511, 60),
-    (1795200768, 1795201023, 60),
-    (1795201280, 1795202815, 60),
-    (1795203072, 1795203327, 60),
-    (1795203584, 1795204351, 60),
-    (1795205888, 1795206399, 60),
-    (1795206912, 1795207679, 60),
-    (1795207936, 1795208703, 60),
-    (1795209216, 1795210751, 60),
-    (1795211264, 1795212287, 60),
-    (1795212800, 1795213567, 60),
-    (1795214080, 1795214591, 60),
-    (1795215104, 1795216383, 60),
-    (1795217152, 1795217407, 60),
-    (1795217664, 1795218431, 60),
-    (1795218944, 1795219199, 60),
-    (1795219456, 1795219711, 60),
-    (1795220480, 1795222015, 60),
-    (1795222272, 1795223039, 60),
-    (1795223296, 1795223807, 60),
-    (1795224064, 1795225087, 60),
-    (1795225344, 1795225599, 60),
-    (1795225856, 1795226623, 60),
-    (1795226880, 1795227903, 60),
-    (1795228160, 1795228671, 60),
-    (1795228928, 1795229183, 60),
-    (1795229952, 1795230719, 60),
-    (1795231232, 1795231487, 60),
-    (1795231744, 1795231999, 60),
-    (1795232512, 1795232767, 60),
-    (1795234048, 1795234559, 60),
-    (1795235072, 1795235583, 60),
-    (1795235840, 1795236095, 60),
-    (1795237120, 1795237375, 60),
-    (1795237632, 1795238655, 60),
-    (1795238912, 1795239167, 60),
-    (1795239424, 1795240191, 60),
-    (1795240448, 1795240703, 60),
-    (1795240960, 1795241215, 60),
-    (1795241472, 1795241727, 60),
-    (1795241984, 1795242239, 60),
-    (1795242496, 1795242751, 60),
-    (1795243264, 1795243775, 60),
-    (1795244032, 1795244287, 60),
-    (1795244544, 1795244799, 60),
-    (1795245312, 1795249663, 60),
-    (1795250176, 1795250431, 60),
-    (1795250688, 1795252223, 60),
-    (1795252480, 1795253503, 60),
-    (1795254272, 1795255039, 60),
-    (1795255296, 1795255807, 60),
-    (1795256320, 1795256575, 60),
-    (1795256832, 1795257087, 60),
-    (1795257344, 1795258879, 60),
-    (1795259136, 1795259647, 60),
-    (1795259904, 1795260927, 60),
-    (1795261184, 1795262463, 60),
-    (1795262720, 1795263743, 60),
-    (1795264000, 1795264511, 60),
-    (1795265792, 1795266047, 60),
-    (1795266560, 1795269119, 60),
-    (1795269632, 1795270143, 60),
-    (1795270400, 1795270911, 60),
-    (1795271168, 1795273471, 60),
-    (1795274752, 1795275007, 60),
-    (1795275264, 1795275775, 60),
-    (1795276800, 1795277055, 60),
-    (1795277824, 1795278079, 60),
-    (1795278592, 1795279103, 60),
-    (1795279616, 1795279871, 60),
-    (1795280384, 1795281663, 60),
-    (1795281920, 1795282431, 60),
-    (1795282688, 1795283199, 60),
-    (1795283456, 1795283967, 60),
-    (1795284224, 1795284479, 60),
-    (1795284992, 1795285247, 60),
-    (1795285504, 1795287039, 60),
-    (1795288064, 1795289343, 60),
-    (1795289600, 1795289855, 60),
-    (1795290112, 1795290879, 60),
-    (1795291136, 1795292159, 60),
-    (1795292672, 1795555327, 60),
-    (1815826432, 1815830527, 50),
-    (1823129600, 1823145983, 50),
-    (1823539200, 1823571967, 50),
-    (1846804480, 1847066623, 13),
-    (1847590912, 1847721983, 13),
-    (1850519552, 1850520575, 10),
-    (1851527168, 1851528191, 2),
-    (1854668800, 1855455231, 10),
-    (1866792960, 1866858495, 2),
-    (1899290624, 1899294719, 12),
-    (1908763136, 1908763391, 50),
-    (1914126336, 1914126591, 1),
-    (1914593280, 1914601471, 16),
-    (1917321216, 1917779967, 13),
-    (1919819776, 1919821823, 6),
-    (1921089536, 1921089791, 13),
-    (1925578752, 1925611519, 12),
-    (1940258816, 1940275199, 16),
-    (1941700608, 1941831679, 8),
-    (1950543872, 1950544383, 0),
-    (1959251968, 1959256063, 1),
-    (1961885696, 1961951231, 14),
-    (1962622720, 1962622975, 13),
-    (1962882304, 1962882559, 12),
-    (1969790976, 1969793023, 13),
-    (1970807808, 1970808319, 0),
-    (1970928672, 1970928675, 10),
-    (1985609728, 1985675263, 5),
-    (1985740800, 1985871871, 7),
-    (1986760704, 1986761215, 12),
-    (1986762496, 1986762751, 12),
-    (1993342976, 1993605119, 11),
-    (1993778688, 1993778943, 10),
-    (1993779200, 1993779711, 10),
-    (1993785344, 1993789439, 13),
-    (1993830400, 1993832447, 10),
-    (1993850880, 1993859071, 11),
-    (1997177344, 1997178879, 10),
-    (1997472256, 1997473023, 0),
-    (2011168768, 2011201535, 3),
-    (2011203584, 2011205631, 3),
-    (2011234304, 2011271167, 13),
-    (2011272192, 2011289855, 13),
-    (2011290112, 2011299839, 13),
-    (2013049856, 2013050879, 10),
-    (2022703104, 2023751679, 10),
-    (2032926720, 2033057791, 11),
-    (2033501952, 2033502207, 12),
-    (2034761728, 2035023871, 0),
-    (2035269632, 2035286015, 9),
-    (2035941376, 2036006911, 7),
-    (2036465664, 2036531199, 1),
-    (2036533248, 2036596735, 1),
-    (2036703232, 2036705279, 12),
-    (2038415872, 2038423551, 12),
-    (2043674624, 2044723199, 10),
-    (2050064384, 2050080767, 16),
-    (2050509312, 2050509823, 8),
-    (2050539008, 2051014655, 8),
-    (2053296128, 2053298175, 13),
-    (2053324800, 2053332991, 12),
-    (2053509632, 2053509887, 10),
-    (2053636096, 2054160383, 13),
-    (2063344640, 2063345663, 11),
-    (2063374336, 2063376383, 9),
-    (2077229056, 2077491199, 10),
-    (2080309248, 2080325631, 2),
-    (2080817152, 2080824319, 7),
-    (2087452672, 2087453695, 12),
-    (2090074112, 2090079231, 15),
-    (2090079232, 2090139647, 12),
-    (2090139648, 2090143743, 15),
-    (2090143744, 2090145791, 12),
-    (2090145792, 2090146815, 15),
-    (2090146816, 2090205183, 12),
-    (2090205184, 2090207231, 15),
-    (2090207232, 2090237951, 12),
-    (2091384832, 2091646975, 12),
-    (2091909120, 2092957695, 10),
-    (2093285376, 2093301759, 3),
-    (2100867072, 2100869119, 10),
-    (2100874240, 2100875263, 13),
-    (2100883456, 2100887551, 12),
-    (2108182528, 2108184575, 14),
-    (2108190720, 2108192767, 14),
-    (2108198912, 2108202495, 14),
-    (2108207616, 2108211199, 14),
-    (2108212224, 2108217855, 14),
-    (2110881792, 2110898175, 12),
-    (2112651264, 2112880639, 8),
-    (2113716224, 2113720319, 11),
-    (2178899968, 2178908159, 0),
-    (2179088384, 2179092479, 0),
-    (2193817600, 2193883135, 2),
-    (2195259392, 2195324927, 4),
-    (2209939456, 2209955327, 13),
-    (2209955584, 2210004991, 13),
-    (2226454528, 2226520063, 2),
-    (2257602560, 2257604863, 10),
-    (2308112384, 2308177919, 10),
-    (2316505856, 2316506111, 10),
-    (2316828672, 2316894207, 12),
-    (2323775488, 2323841023, 10),
-    (2329477120, 2329542655, 10),
-    (2335506432, 2335571967, 30),
-    (2338844072, 2338844075, 10),
-    (2340552704, 2340618239, 10),
-    (2340814848, 2340880383, 10),
-    (2342715392, 2342780927, 10),
-    (2343043072, 2343108607, 10),
-    (2346188800, 2346196991, 14),
-    (2361919232, 2361919487, 2),
-    (2361970688, 2361972223, 2),
-    (2376597504, 2376663039, 10),
-    (2398748672, 2398879743, 50),
-    (2405171200, 2405236735, 11),
-    (2413297664, 2413363199, 11),
-    (2414739456, 2414804991, 10),
-    (2418278656, 2418278911, 32),
-    (2422276096, 2422341631, 13),
-    (2424438784, 2425159679, 10),
-    (2428272640, 2428272895, 50),
-    (2451042304, 2451043327, 32),
-    (2455359232, 2455359487, 10),
-    (2457075712, 2457141247, 10),
-    (2460680192, 2460684287, 8),
-    (2460684544, 2460685055, 8),
-    (2460685312, 2460745727, 8),
-    (2460893184, 2460893439, 10),
-    (2461142016, 2461142271, 12),
-    (2461162240, 2461163519, 10),
-    (2463956992, 2464022527, 13),
-    (2466906112, 2466971647, 10),
-    (2470772736, 2470838271, 10),
-    (2475298816, 2475307007, 60),
-    (2475315200, 2475317247, 60),
-    (2475319296, 2475327487, 60),
-    (2478768128, 2478833663, 60),
-    (2479360256, 2479422463, 13),
-    (2492542976, 2492543231, 12),
-    (2508652544, 2508718079, 10),
-    (2510749696, 2510815231, 10),
-    (2511382784, 2511405055, 10),
-    (2523201536, 2523267071, 11),
-    (2544107520, 2544170495, 61),
-    (2544170752, 2544173055, 61),
-    (2557149184, 2557214719, 30),
-    (2557345792, 2557411327, 30),
-    (2557411328, 2557476863, 33),
-    (2574188544, 2574254079, 2),
-    (2574286848, 2574287103, 10),
-    (2602565632, 2602631167, 2),
-    (2604399872, 2604400127, 2),
-    (2609905664, 2609911807, 10),
-    (2609912064, 2609914367, 10),
-    (2609914624, 2609915391, 10),
-    (2609915648, 2609915903, 10),
-    (2609916160, 2609916415, 10),
-    (2609917696, 2609917951, 10),
-    (2609918208, 2609931263, 10),
-    (2609933056, 2609938943, 10),
-    (2609939200, 2609942527, 10),
-    (2609942784, 2609969919, 10),
-    (2609970176, 2609970431, 10),
-    (2609970688, 2609971199, 10),
-    (2610888704, 2610954239, 30),
-    (2615803904, 2615869439, 30),
-    (2615962368, 2615962623, 30),
-    (2615963136, 2615963647, 30),
-    (2615973376, 2615974143, 30),
-    (2616000512, 2616066047, 30),
-    (2616131584, 2616197119, 32),
-    (2616197120, 2616238079, 30),
-    (2617769984, 2617835519, 30),
-    (2618687744, 2618688255, 10),
-    (2620548096, 2620548607, 10),
-    (2653749248, 2653780223, 10),
-    (2668367360, 2668367615, 13),
-    (2674088704, 2674088959, 10),
-    (2675245312, 2675245567, 2),
-    (2678901760, 2678902015, 2),
-    (2680422400, 2680487935, 10),
-    (2687559936, 2687560191, 30),
-    (2688548864, 2688614399, 13),
-    (2689804032, 2689804287, 30),
-    (2692415488, 2692481023, 30),
-    (2703966208, 2703972095, 13),
-    (2703972352, 2704015359, 13),
-    (2719023104, 2719088639, 60),
-    (2725306368, 2725306623, 13),
-    (2727608320, 2727870463, 60),
-    (2732102656, 2732103679, 50),
-    (2732503040, 2732505087, 50),
-    (2747596800, 2747732479, 30),
-    (2747732736, 2747793407, 30),
-    (2747858944, 2747924479, 30),
-    (2747990016, 2748055551, 30),
-    (2749956864, 2749957119, 10),
-    (2749957376, 2749960191, 10),
-    (2757230592, 2757296127, 30),
-    (2758543360, 2758587903, 13),
-    (2761162752, 2761359359, 30),
-    (2761621504, 2761687039, 30),
-    (2768502784, 2768568319, 30),
-    (2769879040, 2769944575, 30),
-    (2777219072, 2777284607, 60),
-    (2777677824, 2777947647, 32),
-    (2777947904, 2777972735, 32),
-    (2778003456, 2778071039, 32),
-    (2779054080, 2779119615, 32),
-    (2783182848, 2783248383, 10),
-    (2796748800, 2796750847, 8),
-    (2796751104, 2796751359, 8),
-    (2796751616, 2796814335, 8),
-    (2813576192, 2813579775, 0),
-    (2813869312, 2813869567, 12),
-    (2823815424, 2823880703, 30),
-    (2824404992, 2824470527, 30),
-    (2827354112, 2827354367, 10),
-    (2827795200, 2827795455, 13),
-    (2827878400, 2827943935, 30),
-    (2829320192, 2829385727, 30),
-    (2830761984, 2830827519, 10),
-    (2832269312, 2832400383, 30),
-    (2835087360, 2835111935, 13),
-    (2835112960, 2835113983, 13),
-    (2835113984, 2835115007, 10),
-    (2835115008, 2835116031, 13),
-    (2835120128, 2835152895, 13),
-    (2845310976, 2845376511, 60),
-    (2848587776, 2848589311, 30),
-    (2848589568, 2848590079, 30),
-    (2848590336, 2848624383, 30),
-    (2848624640, 2848653311, 30),
-    (2862415872, 2862481407, 13),
-    (2866953216, 2866953471, 10),
-    (2899902464, 2899967999, 50),
-    (2901671936, 2901737471, 60),
-    (2902982656, 2903506943, 60),
-    (2912944128, 2913468415, 60),
-    (2915172352, 2915237887, 50),
-    (2917052416, 2917053439, 60),
-    (2917056512, 2917057535, 10),
-    (2917098496, 2917099519, 13),
-    (2917100544, 2917101567, 0),
-    (2919198720, 2919202815, 50),
-    (2922381312, 2923429887, 60),
-    (2929721344, 2931818495, 60),
-    (2938109952, 2938634239, 13),
-    (2957225984, 2957228031, 33),
-    (3001920256, 3001920511, 10),
-    (3026125568, 3026125823, 10),
-    (3026127616, 3026127871, 10),
-    (3026135040, 3026135295, 10),
-    (3026156544, 3026156799, 10),
-    (3029714688, 3029714943, 12),
-    (3031580928, 3031581183, 13),
-    (3033038848, 3033063423, 12),
-    (3034447872, 3034456063, 12),
-    (3055005696, 3055007743, 1),
-    (3063545856, 3063611391, 5),
-    (3069149184, 3069181951, 16),
-    (3088642048, 3088646143, 13),
-    (3088711168, 3088711423, 10),
-    (3088724992, 3088725503, 10),
-    (3088726528, 3088727039, 10),
-    (3088735744, 3088735999, 10),
-    (3088750592, 3088751615, 10),
-    (3088787456, 3088788479, 13),
-    (3088797696, 3088801791, 8),
-    (3088809216, 3088809471, 10),
-    (3088838656, 3088839679, 8),
-    (3088843776, 3088844799, 12),
-    (3088846848, 3088847103, 60),
-    (3088847872, 3088848383, 13),
-    (3088848896, 3088849407, 10),
-    (3088859136, 3088859647, 60),
-    (3088860160, 3088860671, 60),
-    (3088861184, 3088861695, 60),
-    (3088862208, 3088863231, 60),
-    (3088897792, 3088898047, 10),
-    (3088908288, 3088908799, 32),
-    (3088908800, 3088909311, 13),
-    (3088934400, 3088934911, 10),
-    (3088935936, 3088936447, 30),
-    (3088936448, 3088936959, 8),
-    (3089088512, 3089092607, 10),
-    (3090363392, 3090364415, 60),
-    (3090368512, 3090369535, 60),
-    (3090370560, 3090371583, 12),
-    (3090376192, 3090376447, 60),
-    (3090389760, 3090390015, 60),
-    (3090390784, 3090391039, 60),
-    (3090402816, 3090403327, 60),
-    (3092516864, 3092520959, 12),
-    (3092554752, 3092555775, 12),
-    (3092558848, 3092559103, 60),
-    (3092559616, 3092559871, 60),
-    (3092569344, 3092569599, 13),
-    (3092569600, 3092569855, 60),
-    (3092602880, 3092606975, 60),
-    (3092632320, 3092632575, 13),
-    (3092672512, 3092673535, 60),
-    (3092700928, 3092701183, 10),
-    (3092706560, 3092707583, 60),
-    (3092708096, 3092708351, 60),
-    (3092717568, 3092721663, 8),
-    (3092738048, 3092742143, 10),
-    (3092744192, 3092745215, 10),
-    (3094085632, 3095396351, 60),
-    (3222988288, 3222988543, 11),
-    (3224373248, 3224374015, 13),
-    (3224651776, 3224652287, 11),
-    (3224797696, 3224797951, 0),
-    (3224798976, 3224799231, 11),
-    (3225506304, 3225508863, 13),
-    (3225857536, 3225857791, 10),
-    (3226110976, 3226128383, 10),
-    (3226635776, 3226636031, 32),
-    (3226656256, 3226656511, 11),
-    (3226695168, 3226695423, 11),
-    (3226724096, 3226724351, 11),
-    (3226725632, 3226725887, 12),
-    (3226786560, 3226786815, 10),
-    (3226994432, 3226994687, 10),
-    (3227236608, 3227236863, 11),
-    (3227396352, 3227396607, 12),
-    (3227447808, 3227448063, 30),
-    (3227448064, 3227448575, 11),
-    (3227517184, 3227517439, 30),
-    (3227519744, 3227520255, 32),
-    (3227522560, 3227522815, 30),
-    (3227525632, 3227525887, 33),
-    (3227526656, 3227526911, 30),
-    (3227527936, 3227528191, 32),
-    (3227528704, 3227531775, 30),
-    (3227539712, 3227541503, 30),
-    (3227547648, 3227551487, 30),
-    (3227555328, 3227555583, 30),
-    (3227581184, 3227581439, 30),
-    (3228266752, 3228267007, 6),
-    (3228281600, 3228282111, 4),
-    (3228526848, 3228527103, 10),
-    (3229814016, 3229814271, 13),
-    (3229817088, 3229817343, 10),
-    (3229900032, 3229900287, 13),
-    (3230832128, 3230832383, 0),
-    (3230954496, 3230965759, 10),
-    (3230981376, 3230981631, 2),
-    (3230995456, 3230995711, 10),
-    (3231506688, 3231506943, 2),
-    (3231587328, 3231588351, 50),
-    (3231632896, 3231633151, 60),
-    (3231754496, 3231755007, 12),
-    (3232890880, 3233021951, 50),
-    (3233573632, 3233573887, 11),
-    (3233584896, 3233585151, 10),
-    (3233625600, 3233625855, 12),
-    (3233694208, 3233694463, 10),
-    (3233730816, 3233732351, 10),
-    (3233732352, 3233732607, 13),
-    (3234008064, 3234008575, 0),
-    (3234016256, 3234017791, 13),
-    (3234055424, 3234055679, 10),
-    (3234574336, 3234574591, 13),
-    (3234821888, 3234822399, 11),
-    (3234830336, 3234830591, 15),
-    (3234833664, 3234833919, 10),
-    (3234839296, 3234839551, 11),
-    (3235877376, 3235877631, 13),
-    (3236407296, 3236407551, 13),
-    (3236416256, 3236416511, 11),
-    (3236623616, 3236623871, 13),
-    (3236713472, 3236714495, 60),
-    (3237155840, 3237156863, 10),
-    (3237728000, 3237728255, 13),
-    (3238264832, 3238279679, 40),
-    (3238280192, 3238330367, 40),
-    (3240539904, 3240540159, 13),
-    (3247340800, 3247341055, 50),
-    (3252496384, 3252496639, 0),
-    (3264217088, 3264282623, 40),
-    (3288408064, 3288408319, 30),
-    (3288418048, 3288418303, 30),
-    (3288419072, 3288420351, 32),
-    (3288421632, 3288422143, 32),
-    (3288426240, 3288426495, 30),
-    (3288429312, 3288429567, 30),
-    (3288469504, 3288476671, 33),
-    (3288476928, 3288481791, 33),
-    (3288498176, 3288506367, 33),
-    (3288557824, 3288558079, 30),
-    (3288559872, 3288560639, 32),
-    (3288562688, 3288564735, 30),
-    (3288570624, 3288570879, 32),
-    (3288570880, 3288571903, 30),
-    (3288572160, 3288572415, 32),
-    (3288572416, 3288572927, 30),
-    (3288596992, 3288597247, 30),
-    (3288614656, 3288616191, 30),
-    (3288616704, 3288616959, 32),
-    (3288617728, 3288617983, 30),
-    (3288621312, 3288621567, 30),
-    (3288637440, 3288637951, 30),
-    (3288637952, 3288638207, 33),
-    (3288638208, 3288641279, 30),
-    (3288641280, 3288641791, 32),
-    (3288641792, 3288660991, 30),
-    (3288761600, 3288762623, 30),
-    (3288763648, 3288763903, 32),
-    (3288763904, 3288768767, 30),
-    (3288781824, 3288782591, 30),
-    (3288784384, 3288784895, 30),
-    (3288788224, 3288788479, 30),
-    (3288788992, 3288789503, 30),
-    (3288789760, 3288792063, 30),
-    (3289016320, 3289016575, 30),
-    (3289019904, 3289020159, 30),
-    (3289021440, 3289022463, 30),
-    (3289022976, 3289024511, 30),
-    (3289028096, 3289040895, 30),
-    (3289041920, 3289044479, 30),
-    (3289047040, 3289047295, 32),
-    (3289048320, 3289053695, 30),
-    (3289055232, 3289063167, 30),
-    (3289070080, 3289073919, 30),
-    (3289083136, 3289085183, 30),
-    (3289086464, 3289086719, 30),
-    (3289092864, 3289093119, 33),
-    (3289093120, 3289103615, 30),
-    (3289107712, 3289108991, 30),
-    (3289114880, 3289115135, 30),
-    (3289124864, 3289125119, 30),
-    (3289194240, 3289215487, 30),
-    (3289220096, 3289220351, 30),
-    (3289228032, 3289228799, 30),
-    (3289233664, 3289233919, 32),
-    (3289240832, 3289242111, 30),
-    (3289243904, 3289244671, 30),
-    (3289245696, 3289245951, 30),
-    (3289250048, 3289250303, 32),
-    (3289250560, 3289317375, 30),
-    (3289350144, 3289382911, 32),
-    (3289736192, 3289737215, 32),
-    (3289737472, 3289738239, 32),
-    (3289761792, 3289762047, 32),
-    (3289776128, 3289776639, 30),
-    (3289784320, 3289788415, 30),
-    (3289817088, 3289825279, 33),
-    (3289837568, 3289841663, 34),
-    (3289841664, 3289907199, 30),
-    (3289972736, 3290038271, 32),
-    (3290038272, 3290103807, 30),
-    (3290171392, 3290171647, 33),
-    (3290172416, 3290173183, 32),
-    (3290173440, 3290181631, 33),
-    (3290185728, 3290226687, 33),
-    (3290236416, 3290236671, 30),
-    (3290242816, 3290243071, 32),
-    (3290497024, 3290690047, 30),
-    (3290690304, 3290742527, 30),
-    (3290742784, 3290760447, 30),
-    (3290760704, 3290923007, 30),
-    (3291045888, 3291054079, 34),
-    (3291054080, 3291062271, 33),
-    (3291152384, 3291168767, 32),
-    (3291202304, 3291202559, 31),
-    (3291203584, 3291203839, 34),
-    (3291204352, 3291204607, 32),
-    (3291211520, 3291211775, 32),
-    (3291267072, 3291271167, 33),
-    (3291301376, 3291301631, 32),
-    (3291308032, 3291312127, 30),
-    (3291327744, 3291327999, 30),
-    (3301965824, 3302490111, 30),
-    (3302760448, 3302768639, 31),
-    (3310354432, 3310878719, 33),
-    (3311403008, 3311927295, 30),
-    (3314913280, 3314914303, 32),
-    (3315277824, 3315282943, 30),
-    (3315283968, 3315286015, 30),
-    (3320578048, 3320643583, 32),
-    (3321888768, 3321954303, 60),
-    (3323539200, 3323539455, 14),
-    (3325284864, 3325285119, 10),
-    (3325432832, 3325438719, 30),
-    (3325444096, 3325444351, 30),
-    (3325445888, 3325447167, 30),
-    (3325449216, 3325449471, 30),
-    (3325465856, 3325466111, 30),
-    (3325467136, 3325467391, 30),
-    (3325467648, 3325469695, 30),
-    (3325469952, 3325470207, 30),
-    (3325471232, 3325471487, 30),
-    (3325474816, 3325478143, 30),
-    (3325479424, 3325479679, 32),
-    (3325483776, 3325484031, 30),
-    (3325486080, 3325486335, 30),
-    (3325491200, 3325491455, 32),
-    (3325492480, 3325492735, 30),
-    (3327333120, 3327333375, 61),
-    (3327815680, 3327816703, 60),
-    (3331194880, 3331260415, 13),
-    (3333556224, 3333558271, 60),
-    (3333680896, 3333681151, 61),
-    (3333871360, 3333871615, 11),
-    (3341891072, 3341891583, 13),
-    (3342468096, 3342468351, 12),
-    (3350216704, 3350245631, 61),
-    (3350246400, 3350246655, 61),
-    (3350247424, 3350249471, 61),
-    (3350251520, 3350257663, 61),
-    (3350260736, 3350261759, 61),
-    (3350262016, 3350275583, 61),
-    (3350275840, 3350277375, 61),
-    (3350277632, 3350343935, 61),
-    (3350344192, 3350347263, 61),
-    (3350347520, 3350382079, 61),
-    (3350383104, 3350386687, 61),
-    (3350386944, 3350388223, 61),
-    (3350388480, 3350394111, 61),
-    (3350394368, 3350455295, 61),
-    (3350455552, 3350458367, 61),
-    (3350458624, 3350462463, 61),
-    (3351277568, 3351278591, 50),
-    (3353339904, 3353341951, 50),
-    (3353780736, 3353780991, 10),
-    (3353781760, 3353782015, 10),
-    (3354499072, 3354501119, 12),
-    (3354578432, 3354578943, 60),
-    (3355022080, 3355022335, 61),
-    (3355275008, 3355275263, 10),
-    (3389005824, 3389014015, 0),
-    (3389022976, 3389023231, 13),
-    (3389023744, 3389023999, 10),
-    (3389029376, 3389029631, 0),
-    (3389063936, 3389064191, 12),
-    (3389123328, 3389123583, 10),
-    (3389128448, 3389128703, 13),
-    (3389196544, 3389197567, 10),
-    (3389204480, 3389208319, 14),
-    (3389216768, 3389218815, 1),
-    (3389229312, 3389229567, 10),
-    (3389306112, 3389306367, 10),
-    (3389349888, 3389358079, 13),
-    (3389410304, 3389410559, 13),
-    (3389410816, 3389411071, 11),
-    (3389419776, 3389420031, 11),
-    (3389423616, 3389431807, 16),
-    (3389493248, 3389497087, 12),
-    (3389651968, 3389652223, 12),
-    (3389654528, 3389659135, 12),
-    (3389801472, 3389801727, 10),
-    (3389806848, 3389807103, 11),
-    (3389807872, 3389808127, 13),
-    (3389810688, 3389810943, 1),
-    (3389811968, 3389812223, 10),
-    (3389814528, 3389814783, 12),
-    (3389816832, 3389846271, 10),
-    (3389939200, 3389939455, 10),
-    (3389939456, 3389939711, 11),
-    (3389942528, 3389942783, 0),
-    (3389943808, 3389944063, 11),
-    (3389960448, 3389960703, 10),
-    (3389968896, 3389969151, 14),
-    (3389978368, 3389979391, 12),
-    (3390324736, 3390324991, 0),
-    (3390327808, 3390328063, 0),
-    (3390332160, 3390332415, 0),
-    (3390337280, 3390337535, 8),
-    (3390375936, 3390377983, 12),
-    (3390408704, 3390409215, 6),
-    (3390770432, 3390770687, 10),
-    (3390770944, 3390771199, 11),
-    (3390777344, 3390779391, 0),
-    (3390798848, 3390799103, 0),
-    (3390799872, 3390800383, 0),
-    (3390807040, 3390808063, 8),
-    (3390812160, 3390814719, 8),
-    (3390814720, 3390815231, 2),
-    (3391358720, 3391358975, 8),
-    (3391360512, 3391360767, 13),
-    (3391365120, 3391365375, 0),
-    (3391368192, 3391368447, 6),
-    (3391385088, 3391385343, 9),
-    (3391385344, 3391386111, 8),
-    (3391392768, 3391393023, 8),
-    (3391398912, 3391399935, 0),
-    (3391402496, 3391403007, 2),
-    (3391411712, 3391412223, 9),
-    (3391412224, 3391412735, 0),
-    (3391412992, 3391413759, 2),
-    (3391417088, 3391417343, 0),
-    (3391428352, 3391428607, 0),
-    (3391437312, 3391437567, 8),
-    (3391442432, 3391442687, 1),
-    (3391443200, 3391444223, 8),
-    (3391445248, 3391445503, 8),
-    (3391447040, 3391447295, 2),
-    (3391448064, 3391448575, 2),
-    (3391463424, 3391463679, 0),
-    (3391470336, 3391470591, 0),
-    (3391482880, 3391483903, 8),
-    (3391484416, 3391484671, 8),
-    (3391485952, 3391487487, 8),
-    (3391525888, 3391526143, 10),
-    (3391971328, 3391979519, 12),
-    (3392098560, 3392098815, 0),
-    (3392099840, 3392100095, 10),
-    (3392217600, 3392218111, 3),
-    (3392225024, 3392225279, 7),
-    (3392238336, 3392238591, 2),
-    (3392239104, 3392239615, 8),
-    (3392239616, 3392241151, 2),
-    (3392241152, 3392241407, 8),
-    (3392247040, 3392247295, 0),
-    (3392250112, 3392250367, 8),
-    (3392254464, 3392254719, 7),
-    (3392260096, 3392261887, 0),
-    (3392268544, 3392272383, 1),
-    (3392272640, 3392272895, 6),
-    (3392273408, 3392274431, 0),
-    (3392294912, 3392295935, 8),
-    (3392301056, 3392301311, 2),
-    (3392302592, 3392303103, 2),
-    (3392304384, 3392304639, 2),
-    (3392309504, 3392309759, 0),
-    (3392316416, 3392316671, 1),
-    (3392317696, 3392317951, 2),
-    (3392317952, 3392318207, 3),
-    (3392322560, 3392322815, 7),
-    (3392333568, 3392333823, 8),
-    (3392337408, 3392337663, 1),
-    (3392479232, 3392487423, 12),
-    (3392638976, 3392640511, 12),
-    (3392640768, 3392641279, 12),
-    (3392641536, 3392643071, 12),
-    (3392856064, 3392856319, 10),
-    (3392856576, 3392856831, 10),
-    (3392857344, 3392857599, 10),
-    (3392888832, 3392892927, 12),
-    (3392995840, 3392996351, 6),
-    (3393404928, 3393421311, 14),
-    (3393691648, 3393691903, 12),
-    (3393692416, 3393692671, 15),
-    (3393692672, 3393695743, 12),
-    (3393748992, 3393750527, 15),
-    (3393750528, 3393750783, 12),
-    (3393750784, 3393765375, 15),
-    (3393830912, 3393835007, 7),
-    (3393891072, 3393891327, 12),
-    (3393892096, 3393892351, 12),
-    (3393911808, 3393912063, 12),
-    (3394142208, 3394150399, 0),
-    (3394219776, 3394220031, 10),
-    (3394700288, 3394701311, 10),
-    (3394905600, 3394905855, 10),
-    (3395043328, 3395059711, 12),
-    (3395138560, 3395139071, 12),
-    (3397148672, 3397156863, 2),
-    (3397322752, 3397323775, 1),
-    (3397468928, 3397484287, 12),
-    (3397507584, 3397507839, 10),
-    (3397935104, 3397939199, 16),
-    (3398033408, 3398033663, 0),
-    (3398041600, 3398057983, 14),
-    (3398090752, 3398098943, 12),
-    (3398107136, 3398117887, 13),
-    (3398118144, 3398149631, 13),
-    (3398149888, 3398156287, 13),
-    (3398291456, 3398295551, 14),
-    (3398572032, 3398572799, 12),
-    (3398613760, 3398614015, 10),
-    (3398653952, 3398655999, 10),
-    (3398852608, 3398860799, 1),
-    (3399414016, 3399414271, 10),
-    (3399450624, 3399467007, 12),
-    (3399515904, 3399516159, 10),
-    (3399548928, 3399557119, 12),
-    (3399633408, 3399633663, 10),
-    (3400271360, 3400271615, 12),
-    (3400271872, 3400272383, 10),
-    (3400272384, 3400272639, 12),
-    (3400272640, 3400273663, 10),
-    (3400273664, 3400273919, 12),
-    (3400368128, 3400370175, 15),
-    (3400370176, 3400372223, 12),
-    (3400372224, 3400376319, 15),
-    (3400376320, 3400380415, 12),
-    (3400380416, 3400384511, 15),
-    (3400458240, 3400466431, 14),
-    (3400810496, 3400820223, 3),
-    (3400820480, 3400826879, 3),
-    (3400851456, 3400854527, 10),
-    (3400854784, 3400858879, 10),
-    (3400859136, 3400859391, 10),
-    (3400963072, 3400963327, 12),
-    (3401424896, 3401428991, 3),
-    (3401526784, 3401527039, 1),
-    (3401539584, 3401543679, 17),
-    (3405775104, 3405775359, 10),
-    (3405778176, 3405778431, 11),
-    (3405781248, 3405781503, 13),
-    (3405782784, 3405783039, 12),
-    (3405783808, 3405784063, 10),
-    (3405784320, 3405784575, 12),
-    (3405794560, 3405795071, 13),
-    (3405799936, 3405800191, 11),
-    (3405807872, 3405808127, 11),
-    (3405810432, 3405810687, 12),
-    (3405811456, 3405811711, 11),
-    (3405819904, 3405820159, 11),
-    (3405820416, 3405825279, 12),
-    (3405832704, 3405832959, 14),
-    (3405835776, 3405836031, 12),
-    (3405840384, 3405840639, 13),
-    (3405845760, 3405846271, 13),
-    (3405846528, 3405846783, 10),
-    (3405867008, 3405868031, 13),
-    (3405887232, 3405887487, 14),
-    (3405893632, 3405893759, 10),
-    (3405895680, 3405896703, 13),
-    (3405896960, 3405897215, 13),
-    (3405897472, 3405897727, 10),
-    (3405904896, 3405905151, 11),
-    (3405925120, 3405925375, 13),
-    (3405925376, 3405925887, 10),
-    (3405926400, 3405930495, 12),
-    (3405937664, 3405937919, 16),
-    (3405937920, 3405938175, 10),
-    (3405939968, 3405940223, 10),
-    (3405940224, 3405940479, 11),
-    (3405942784, 3405943039, 12),
-    (3405953024, 3405955071, 10),
-    (3405956864, 3405957119, 12),
-    (3405965056, 3405965311, 10),
-    (3405967104, 3405967359, 14),
-    (3405981440, 3405981695, 10),
-    (3405989120, 3405989375, 12),
-    (3405989632, 3405990655, 13),
-    (3405991680, 3405991935, 16),
-    (3405993984, 3405995007, 13),
-    (3405998080, 3405998335, 10),
-    (3406006528, 3406006783, 10),
-    (3406006784, 3406010367, 13),
-    (3406078976, 3406079999, 10),
-    (3406081024, 3406081535, 12),
-    (3406086144, 3406086911, 10),
-    (3406095360, 3406095615, 12),
-    (3406105856, 3406106111, 16),
-    (3406109184, 3406110463, 14),
-    (3406110720, 3406111231, 10),
-    (3406111488, 3406111743, 10),
-    (3406112768, 3406113791, 13),
-    (3406117376, 3406117887, 10),
-    (3406123008, 3406129407, 10),
-    (3406129920, 3406130175, 10),
-    (3406134784, 3406135039, 11),
-    (3406147584, 3406148095, 10),
-    (3406149632, 3406149887, 12),
-    (3406156800, 3406157055, 10),
-    (3406157824, 3406158079, 13),
-    (3406158848, 3406159871, 13),
-    (3406160384, 3406164991, 13),
-    (3406168064, 3406170111, 13),
-    (3406171136, 3406184447, 13),
-    (3406188544, 3406200831, 13),
-    (3406201856, 3406202111, 16),
-    (3406203904, 3406204159, 13),
-    (3406204672, 3406204927, 13),
-    (3406205440, 3406205951, 11),
-    (3406224896, 3406225407, 13),
-    (3406230528, 3406230783, 10),
-    (3406230784, 3406231039, 13),
-    (3406233600, 3406265855, 12),
-    (3406273280, 3406273535, 11),
-    (3406277888, 3406278143, 12),
-    (3406278400, 3406278655, 10),
-    (3406283776, 3406284287, 12),
-    (3406284288, 3406284543, 10),
-    (3406286592, 3406286847, 10),
-    (3406291712, 3406291967, 11),
-    (3406299648, 3406299903, 11),
-    (3406301440, 3406301695, 11),
-    (3406322176, 3406322431, 10),
-    (3406326528, 3406326783, 10),
-    (3406328064, 3406328319, 10),
-    (3406330880, 3406331135, 12),
-    (3406340352, 3406341119, 12),
-    (3406344192, 3406346239, 12),
-    (3406348544, 3406348799, 12),
-    (3406348800, 3406349055, 14),
-    (3406350336, 3406350591, 12),
-    (3406352000, 3406352007, 10),
-    (3406373120, 3406373375, 11),
-    (3406373632, 3406373887, 13),
-    (3406380032, 3406380543, 14),
-    (3406395136, 3406397439, 13),
-    (3406397440, 3406397951, 12),
-    (3406399488, 3406401279, 10),
-    (3406402048, 3406402559, 13),
-    (3406403072, 3406403327, 10),
-    (3406404864, 3406405119, 14),
-    (3406425856, 3406426111, 13),
-    (3406430464, 3406430719, 15),
-    (3406439424, 3406440191, 10),
-    (3406445568, 3406445823, 11),
-    (3406446592, 3406447871, 13),
-    (3406449664, 3406449919, 12),
-    (3406456064, 3406456831, 13),
-    (3406458368, 3406458623, 12),
-    (3406458880, 3406460927, 13),
-    (3406462976, 3406485759, 13),
-    (3406486016, 3406490111, 13),
-    (3406490112, 3406490367, 10),
-    (3406490368, 3406512127, 13),
-    (3406512128, 3406512383, 10),
-    (3406513920, 3406514175, 12),
-    (3406514432, 3406514687, 10),
-    (3406516480, 3406516735, 13),
-    (3406516992, 3406517247, 12),
-    (3406518272, 3406518527, 10),
-    (3406520320, 3406520831, 13),
-    (3406524416, 3406524671, 10),
-    (3406546944, 3406547199, 13),
-    (3406569216, 3406569471, 12),
-    (3406574592, 3406575103, 12),
-    (3406578432, 3406578943, 10),
-    (3406589952, 3406590463, 14),
-    (3406590720, 3406590975, 12),
-    (3406594816, 3406595071, 14),
-    (3406596096, 3406596351, 12),
-    (3406596864, 3406597375, 13),
-    (3406614784, 3406615039, 10),
-    (3406617088, 3406617343, 10),
-    (3406620160, 3406620415, 13),
-    (3406620416, 3406620671, 10),
-    (3406624768, 3406625023, 12),
-    (3406632192, 3406632447, 10),
-    (3406636288, 3406636543, 16),
-    (3406643200, 3406644223, 13),
-    (3406645760, 3406646015, 15),
-    (3406646016, 3406646783, 10),
-    (3406646784, 3406647295, 14),
-    (3406651392, 3406661375, 13),
-    (3406663680, 3406663935, 12),
-    (3406669056, 3406669311, 14),
-    (3406688768, 3406691071, 13),
-    (3406692352, 3406696447, 10),
-    (3406705152, 3406705407, 10),
-    (3406716928, 3406717439, 10),
-    (3406718720, 3406718975, 12),
-    (3406722048, 3406722559, 10),
-    (3406724352, 3406724607, 13),
-    (3406724864, 3406725119, 13),
-    (3406729984, 3406730239, 10),
-    (3406732288, 3406733311, 11),
-    (3406733312, 3406733567, 10),
-    (3406733568, 3406737407, 12),
-    (3406738432, 3406738687, 12),
-    (3406744576, 3406744831, 10),
-    (3406748672, 3406749695, 10),
-    (3406761984, 3406763007, 13),
-    (3406775552, 3406775807, 11),
-    (3406779392, 3406780159, 13),
-    (3406781696, 3406781951, 11),
-    (3406782208, 3406782463, 12),
-    (3406785280, 3406785535, 11),
-    (3406786304, 3406786559, 12),
-    (3406791936, 3406792191, 13),
-    (3406802688, 3406802943, 11),
-    (3406811136, 3406811647, 12),
-    (3406819840, 3406820095, 12),
-    (3406821376, 3406821631, 11),
-    (3406822912, 3406823167, 10),
-    (3406829568, 3406829823, 12),
-    (3406831616, 3406832127, 13),
-    (3406832640, 3406832895, 10),
-    (3406835712, 3406835967, 12),
-    (3406840576, 3406841855, 13),
-    (3406857216, 3406857471, 10),
-    (3406859520, 3406859775, 13),
-    (3406866176, 3406866431, 12),
-    (3406866688, 3406866943, 14),
-    (3406868224, 3406868479, 13),
-    (3406876672, 3406878719, 11),
-    (3406882048, 3406882303, 12),
-    (3406885120, 3406885887, 11),
-    (3406889216, 3406889471, 10),
-    (3406892288, 3406892543, 10),
-    (3406902272, 3406904319, 10),
-    (3406904320, 3406905343, 12),
-    (3406905344, 3406905599, 11),
-    (3406912000, 3406912255, 12),
-    (3406913024, 3406913279, 13),
-    (3406913536, 3406918143, 12),
-    (3406918144, 3406918399, 14),
-    (3406918656, 3406919167, 10),
-    (3406920960, 3406921215, 12),
-    (3406924288, 3406925055, 13),
-    (3406927872, 3406928127, 10),
-    (3406937088, 3406937343, 10),
-    (3406938368, 3406938623, 11),
-    (3406941184, 3406941951, 10),
-    (3406949120, 3406949375, 12),
-    (3406949888, 3406950143, 13),
-    (3406953216, 3406953471, 12),
-    (3406953984, 3406954239, 14),
-    (3406956544, 3406957055, 15),
-    (3406957312, 3406957567, 11),
-    (3406957824, 3406958079, 12),
-    (3406958080, 3406958591, 13),
-    (3406960640, 3406960895, 14),
-    (3406961408, 3406961663, 12),
-    (3406962944, 3406963711, 10),
-    (3406968064, 3406968319, 14),
-    (3406974464, 3406974719, 12),
-    (3406976512, 3406976767, 14),
-    (3406977024, 3406977279, 13),
-    (3406983168, 3406987263, 10),
-    (3406987264, 3406988031, 11),
-    (3406991104, 3406991359, 10),
-    (3406999040, 3406999295, 12),
-    (3407002368, 3407002623, 10),
-    (3407004672, 3407004927, 13),
-    (3407013888, 3407014399, 14),
-    (3407021824, 3407022079, 12),
-    (3407025920, 3407031295, 11),
-    (3407037952, 3407038207, 12),
-    (3407038208, 3407038463, 10),
-    (3407047424, 3407047679, 11),
-    (3407052800, 3407053055, 12),
-    (3407053824, 3407054079, 16),
-    (3407054848, 3407056127, 10),
-    (3407057152, 3407057407, 10),
-    (3407060480, 3407060735, 10),
-    (3407062784, 3407063039, 13),
-    (3407079936, 3407080191, 13),
-    (3407080192, 3407080447, 10),
-    (3407081728, 3407081983, 12),
-    (3407084544, 3407084799, 12),
-    (3407085056, 3407085311, 12),
-    (3407090688, 3407091711, 10),
-    (3407096576, 3407096831, 10),
-    (3407100160, 3407100415, 13),
-    (3407103744, 3407104255, 12),
-    (3407105024, 3407105279, 11),
-    (3407107840, 3407108095, 10),
-    (3407109888, 3407110143, 12),
-    (3407110912, 3407111167, 12),
-    (3407113216, 3407113727, 10),
-    (3407114752, 3407115007, 10),
-    (3407119360, 3407119615, 12),
-    (3407123712, 3407123967, 14),
-    (3407124736, 3407126527, 10),
-    (3407134720, 3407135743, 10),
-    (3407143424, 3407143935, 16),
-    (3407143936, 3407144447, 11),
-    (3407146496, 3407146751, 10),
-    (3407148544, 3407148799, 11),
-    (3407152384, 3407152639, 12),
-    (3407153408, 3407153663, 12),
-    (3407154944, 3407155199, 11),
-    (3407156224, 3407156479, 15),
-    (3407161088, 3407161343, 13),
-    (3407163648, 3407167487, 10),
-    (3407168768, 3407169279, 11),
-    (3407171328, 3407171583, 12),
-    (3407173632, 3407174143, 12),
-    (3407175168, 3407175423, 11),
-    (3407177984, 3407178239, 12),
-    (3407178240, 3407178495, 11),
-    (3407183104, 3407183359, 12),
-    (3407183616, 3407183871, 11),
-    (3407187968, 3407188223, 10),
-    (3407197184, 3407197439, 10),
-    (3407202304, 3407203327, 10),
-    (3407221504, 3407221759, 12),
-    (3407222016, 3407222271, 11),
-    (3407223296, 3407223551, 10),
-    (3407223552, 3407223807, 11),
-    (3407233792, 3407234047, 11),
-    (3407235840, 3407236095, 11),
-    (3407237888, 3407238143, 10),
-    (3407249408, 3407249919, 10),
-    (3407250944, 3407251455, 10),
-    (3407252736, 3407253247, 13),
-    (3407264768, 3407266815, 10),
-    (3407268352, 3407268607, 12),
-    (3407268608, 3407268863, 10),
-    (3407271936, 3407272191, 11),
-    (3407275264, 3407275519, 10),
-    (3407281664, 3407281919, 14),
-    (3407283968, 3407284223, 12),
-    (3407284480, 3407284735, 15),
-    (3407284736, 3407284991, 11),
-    (3407287040, 3407287295, 13),
-    (3407287296, 3407287807, 10),
-    (3407287808, 3407288063, 11),
-    (3407288064, 3407288319, 10),
-    (3407288320, 3407289343, 11),
-    (3407289856, 3407290111, 12),
-    (3407292672, 3407292927, 10),
-    (3407296768, 3407297023, 12),
-    (3407297024, 3407297279, 10),
-    (3407301376, 3407302143, 10),
-    (3407303168, 3407303423, 14),
-    (3407304192, 3407304447, 10),
-    (3407306752, 3407307007, 10),
-    (3407310080, 3407310335, 11),
-    (3407312384, 3407312639, 10),
-    (3407314944, 3407315199, 12),
-    (3407317504, 3407318015, 11),
-    (3407325184, 3407325439, 14),
-    (3407326976, 3407327231, 10),
-    (3407330816, 3407331071, 12),
-    (3407332352, 3407332607, 14),
-    (3407333376, 3407334399, 12),
-    (3407339776, 3407340031, 15),
-    (3407344896, 3407345151, 12),
-    (3407345152, 3407345407, 11),
-    (3407351296, 3407351807, 13),
-    (3407354368, 3407354623, 12),
-    (3407356672, 3407356927, 12),
-    (3407356928, 3407357183, 10),
-    (3407363072, 3407363327, 10),
-    (3407363584, 3407363839, 12),
-    (3407366144, 3407366399, 10),
-    (3407367680, 3407367935, 13),
-    (3407376640, 3407376895, 13),
-    (3407377664, 3407377919, 14),
-    (3407379712, 3407379967, 14),
-    (3407379968, 3407380223, 10),
-    (3407381248, 3407381503, 11),
-    (3407384576, 3407384831, 12),
-    (3407391232, 3407391487, 10),
-    (3407393792, 3407394815, 10),
-    (3407396096, 3407396351, 12),
-    (3407396352, 3407396607, 10),
-    (3407397888, 3407398655, 12),
-    (3407399168, 3407400191, 13),
-    (3407400704, 3407400959, 11),
-    (3407400960, 3407401215, 12),
-    (3407401472, 3407401727, 10),
-    (3407408640, 3407408895, 10),
-    (3407410432, 3407411199, 11),
-    (3407411968, 3407412735, 14),
-    (3407418880, 3407419135, 11),
-    (3407433472, 3407433727, 12),
-    (3407434496, 3407434751, 15),
-    (3407438336, 3407438591, 10),
-    (3407441152, 3407441407, 12),
-    (3407442944, 3407443199, 13),
-    (3407444992, 3407445247, 14),
-    (3407449600, 3407449855, 11),
-    (3407451904, 3407452159, 12),
-    (3407453184, 3407453695, 10),
-    (3407454976, 3407455231, 10),
-    (3407456000, 3407456255, 10),
-    (3407456512, 3407456767, 12),
-    (3407465472, 3407465727, 11),
-    (3407470592, 3407470847, 14),
-    (3407471104, 3407471359, 11),
-    (3407472128, 3407472639, 12),
-    (3407474432, 3407474687, 11),
-    (3407475968, 3407476735, 11),
-    (3407482368, 3407482623, 11),
-    (3407486976, 3407487231, 12),
-    (3407490816, 3407491071, 13),
-    (3407492096, 3407492351, 11),
-    (3407493888, 3407496703, 10),
-    (3407496704, 3407496959, 11),
-    (3407499520, 3407499775, 14),
-    (3407500800, 3407501055, 12),
-    (3407501056, 3407501311, 11),
-    (3407502848, 3407503359, 11),
-    (3407503360, 3407503615, 12),
-    (3407505920, 3407506175, 15),
-    (3407507456, 3407507711, 10),
-    (3407509504, 3407510527, 11),
-    (3407512064, 3407512319, 10),
-    (3407512576, 3407512831, 13),
-    (3407513600, 3407513855, 11),
-    (3407515904, 3407516415, 11),
-    (3407524352, 3407524607, 10),
-    (3407531520, 3407532287, 11),
-    (3407538944, 3407539199, 10),
-    (3407541504, 3407541759, 10),
-    (3407545088, 3407545343, 11),
-    (3407551232, 3407551487, 12),
-    (3407552256, 3407552511, 10),
-    (3407555072, 3407555583, 10),
-    (3407559168, 3407559423, 11),
-    (3407562240, 3407563007, 10),
-    (3407565312, 3407565823, 13),
-    (3407567104, 3407567359, 12),
-    (3407569920, 3407570175, 14),
-    (3407572736, 3407574015, 11),
-    (3407574528, 3407574783, 10),
-    (3407577088, 3407593471, 10),
-    (3407593728, 3407593983, 11),
-    (3407595264, 3407595519, 10),
-    (3407595776, 3407596031, 12),
-    (3407596544, 3407596799, 13),
-    (3407596800, 3407597055, 14),
-    (3407601408, 3407601663, 13),
-    (3407601920, 3407602175, 10),
-    (3407604992, 3407605247, 10),
-    (3407605248, 3407605759, 13),
-    (3407606784, 3407607807, 10),
-    (3407609088, 3407609343, 10),
-    (3407615232, 3407615487, 13),
-    (3407615488, 3407617023, 12),
-    (3407617024, 3407617279, 10),
-    (3407621632, 3407622143, 11),
-    (3407623936, 3407624191, 11),
-    (3407629056, 3407629311, 11),
-    (3407630592, 3407631871, 13),
-    (3407632640, 3407632895, 10),
-    (3407636992, 3407637247, 13),
-    (3407639296, 3407639551, 10),
-    (3407639552, 3407640063, 12),
-    (3407641088, 3407641343, 12),
-    (3407642368, 3407642623, 13),
-    (3407649536, 3407649791, 14),
-    (3407649792, 3407650047, 11),
-    (3407650048, 3407650303, 12),
-    (3407650560, 3407650815, 11),
-    (3407651328, 3407651583, 12),
-    (3407652352, 3407652607, 13),
-    (3407652608, 3407653119, 11),
-    (3407653888, 3407654143, 11),
-    (3407654144, 3407654399, 12),
-    (3407654912, 3407655423, 11),
-    (3407656192, 3407656207, 10),
-    (3407658496, 3407658751, 10),
-    (3407659264, 3407659519, 10),
-    (3407661056, 3407661311, 13),
-    (3407665920, 3407666175, 10),
-    (3407668224, 3407668479, 10),
-    (3407669760, 3407670015, 10),
-    (3407670784, 3407671039, 12),
-    (3407681536, 3407681791, 13),
-    (3407684864, 3407685119, 12),
-    (3407686656, 3407686911, 12),
-    (3407690240, 3407690495, 11),
-    (3407691264, 3407691519, 11),
-    (3407692800, 3407693055, 10),
-    (3407694848, 3407695103, 11),
-    (3407697664, 3407697919, 12),
-    (3407700224, 3407700479, 12),
-    (3407705856, 3407706111, 14),
-    (3407716352, 3407720447, 10),
-    (3407726080, 3407726335, 13),
-    (3407731200, 3407731455, 10),
-    (3407734784, 3407735039, 13),
-    (3407736320, 3407736575, 13),
-    (3407749888, 3407750143, 11),
-    (3407753728, 3407753983, 11),
-    (3407756800, 3407757055, 12),
-    (3407757312, 3407757567, 10),
-    (3407760128, 3407760383, 11),
-    (3407762688, 3407763455, 14),
-    (3407764480, 3407765503, 10),
-    (3407765504, 3407765759, 15),
-    (3407767552, 3407768063, 12),
-    (3407768832, 3407769087, 10),
-    (3407778816, 3407780863, 12),
-    (3407785984, 3407786239, 10),
-    (3407787264, 3407787519, 12),
-    (3407789056, 3407790079, 11),
-    (3407790848, 3407791103, 11),
-    (3407791360, 3407791615, 14),
-    (3407792128, 3407792383, 10),
-    (3407793408, 3407793663, 12),
-    (3407793664, 3407794175, 15),
-    (3407800064, 3407800319, 15),
-    (3407807488, 3407807999, 10),
-    (3407809792, 3407810047, 12),
-    (3407811072, 3407811583, 10),
-    (3407817216, 3407817983, 12),
-    (3407819776, 3407820287, 12),
-    (3407822336, 3407822847, 10),
-    (3407823616, 3407823871, 13),
-    (3407826176, 3407826431, 14),
-    (3407826688, 3407826943, 12),
-    (3407827200, 3407827455, 11),
-    (3407830016, 3407830271, 10),
-    (3407830784, 3407831039, 12),
-    (3407838464, 3407838719, 10),
-    (3407838720, 3407838975, 11),
-    (3407847680, 3407847935, 12),
-    (3407849216, 3407849471, 10),
-    (3407849984, 3407850239, 13),
-    (3407853056, 3407853311, 12),
-    (3407853568, 3407853823, 12),
-    (3407856896, 3407857151, 14),
-    (3407858944, 3407859199, 11),
-    (3407859712, 3407859967, 12),
-    (3407862528, 3407862783, 11),
-    (3407868160, 3407868415, 11),
-    (3407869440, 3407869695, 10),
-    (3407871744, 3407871999, 11),
-    (3407873536, 3407873791, 14),
-    (3407876096, 3407877119, 10),
-    (3407877376, 3407878143, 14),
-    (3407878656, 3407878911, 14),
-    (3407879168, 3407880447, 14),
-    (3407880704, 3407881983, 14),
-    (3407882240, 3407882751, 14),
-    (3407884800, 3407885055, 12),
-    (3407885056, 3407885311, 10),
-    (3407886592, 3407886847, 10),
-    (3407886848, 3407887103, 11),
-    (3407888384, 3407888639, 12),
-    (3407888640, 3407888895, 10),
-    (3407890944, 3407891199, 12),
-    (3407895040, 3407895295, 13),
-    (3407896064, 3407896319, 12),
-    (3407897856, 3407898111, 13),
-    (3407900160, 3407900671, 14),
-    (3407901952, 3407902207, 12),
-    (3407903232, 3407903487, 12),
-    (3407906816, 3407907071, 12),
-    (3407907072, 3407907327, 11),
-    (3407908352, 3407908607, 10),
-    (3407917568, 3407918335, 10),
-    (3407921408, 3407921663, 10),
-    (3407923456, 3407923711, 12),
-    (3407924992, 3407925247, 12),
-    (3407928320, 3407928575, 12),
-    (3407929088, 3407929343, 10),
-    (3407938304, 3407939327, 12),
-    (3407942144, 3407942655, 11),
-    (3407942656, 3407942911, 10),
-    (3407948288, 3407948543, 10),
-    (3407949312, 3407949567, 11),
-    (3407951616, 3407951871, 10),
-    (3407955968, 3407956223, 13),
-    (3407957248, 3407957503, 10),
-    (3407966208, 3407966463, 15),
-    (3407969792, 3407970047, 14),
-    (3407974144, 3407974399, 14),
-    (3407978496, 3407980799, 12),
-    (3407986176, 3407986431, 11),
-    (3407986944, 3407987199, 12),
-    (3407993856, 3407994367, 11),
-    (3407997440, 3407997695, 10),
-    (3407999232, 3407999487, 11),
-    (3408000512, 3408000767, 17),
-    (3408001024, 3408001279, 16),
-    (3408001792, 3408002047, 10),
-    (3408002816, 3408003071, 11),
-    (3408003584, 3408003839, 12),
-    (3408004608, 3408004863, 11),
-    (3408008704, 3408008959, 11),
-    (3408010496, 3408010751, 10),
-    (3408012288, 3408012543, 12),
-    (3408013312, 3408013567, 13),
-    (3408013568, 3408013823, 10),
-    (3408014336, 3408014591, 10),
-    (3408016128, 3408016383, 13),
-    (3408017920, 3408018175, 12),
-    (3408018944, 3408019199, 12),
-    (3408021504, 3408021759, 10),
-    (3408024832, 3408025087, 11),
-    (3408028672, 3408028927, 13),
-    (3408029696, 3408029951, 12),
-    (3408032256, 3408032511, 10),
-    (3408032512, 3408032767, 11),
-    (3408034816, 3408035071, 12),
-    (3408036096, 3408036351, 16),
-    (3408036608, 3408036863, 10),
-    (3408037120, 3408037375, 12),
-    (3408038144, 3408038399, 10),
-    (3408039680, 3408039935, 13),
-    (3408040192, 3408040447, 12),
-    (3408042752, 3408043007, 11),
-    (3408043008, 3408043775, 12),
-    (3408049408, 3408049663, 11),
-    (3408050432, 3408050687, 10),
-    (3408050688, 3408050943, 12),
-    (3408051968, 3408052223, 13),
-    (3408057344, 3408057599, 16),
-    (3408058880, 3408059135, 15),
-    (3408060160, 3408062975, 10),
-    (3408064256, 3408064511, 15),
-    (3408068352, 3408068607, 11),
-    (3408068608, 3409379327, 10),
-    (3409381632, 3409381887, 12),
-    (3409382912, 3409383423, 10),
-    (3409387776, 3409388031, 13),
-    (3409388032, 3409388287, 12),
-    (3409388288, 3409388799, 13),
-    (3409389568, 3409390847, 11),
-    (3409390848, 3409391103, 10),
-    (3409391104, 3409391615, 11),
-    (3409394688, 3409394943, 12),
-    (3409395200, 3409395711, 11),
-    (3409399552, 3409399807, 13),
-    (3409400320, 3409400575, 11),
-    (3409400576, 3409400831, 12),
-    (3409406464, 3409406719, 11),
-    (3409408512, 3409408767, 11),
-    (3409411072, 3409412863, 11),
-    (3409419520, 3409419775, 11),
-    (3409422080, 3409422335, 10),
-    (3409423104, 3409423615, 13),
-    (3409425152, 3409425663, 10),
-    (3409426688, 3409427199, 10),
-    (3409431296, 3409431551, 11),
-    (3409432832, 3409433087, 10),
-    (3409433856, 3409434111, 12),
-    (3409436416, 3409436671, 13),
-    (3409436928, 3409437183, 10),
-    (3409437696, 3409438719, 12),
-    (3409442816, 3409443327, 11),
-    (3409445376, 3409445631, 14),
-    (3409446144, 3409446399, 12),
-    (3409446400, 3409446655, 13),
-    (3409449216, 3409449471, 11),
-    (3409452544, 3409453055, 12),
-    (3409454080, 3409454335, 10),
-    (3409455616, 3409455871, 10),
-    (3409460992, 3409461247, 12),
-    (3409464832, 3409465087, 10),
-    (3409467136, 3409467391, 10),
-    (3409468416, 3409468671, 12),
-    (3409468928, 3409469183, 12),
-    (3409470208, 3409470463, 10),
-    (3409472000, 3409472255, 10),
-    (3409475328, 3409475583, 12),
-    (3409476864, 3409477119, 11),
-    (3409477376, 3409477631, 10),
-    (3409488384, 3409488639, 11),
-    (3409490176, 3409490431, 11),
-    (3409495040, 3409495295, 10),
-    (3409495808, 3409496063, 14),
-    (3409497088, 3409498111, 11),
-    (3409499392, 3409499647, 10),
-    (3409500416, 3409500671, 13),
-    (3409510912, 3409511167, 10),
-    (3409512704, 3409512959, 13),
-    (3409513216, 3409513471, 11),
-    (3409517312, 3409517567, 10),
-    (3409517824, 3409518079, 11),
-    (3409520128, 3409520383, 10),
-    (3409526272, 3409526527, 10),
-    (3409530176, 3409530179, 10),
-    (3409532928, 3409533183, 11),
-    (3409541120, 3409541375, 12),
-    (3409550336, 3409550591, 14),
-    (3409559552, 3409560063, 10),
-    (3409560576, 3409560831, 13),
-    (3409563648, 3409565695, 12),
-    (3409566464, 3409567743, 10),
-    (3409573888, 3409574143, 13),
-    (3409584128, 3409641471, 10),
-    (3409641472, 3409707007, 12),
-    (3409872384, 3409872639, 14),
-    (3409878272, 3409878527, 11),
-    (3409879040, 3409879295, 11),
-    (3409880320, 3409880575, 10),
-    (3409881600, 3409881855, 14),
-    (3409883392, 3409883647, 10),
-    (3409884928, 3409885183, 13),
-    (3409887232, 3409887487, 11),
-    (3409889792, 3409890815, 10),
-    (3409901568, 3409903615, 10),
-    (3409903616, 3409955839, 12),
-    (3409956352, 3409959679, 12),
-    (3409959936, 3409965055, 12),
-    (3409967104, 3409969151, 12),
-    (3410969600, 3410970111, 0),
-    (3410976256, 3410980863, 0),
-    (3410981888, 3410983935, 0),
-    (3411460096, 3411464191, 2),
-    (3411628032, 3411628287, 12),
-    (3411810816, 3411811071, 10),
-    (3411867648, 3411868927, 10),
-    (3411943424, 3411951615, 12),
-    (3412089856, 3412094975, 8),
-    (3412094976, 3412095231, 2),
-    (3412097536, 3412097791, 8),
-    (3412098304, 3412098559, 8),
-    (3412103168, 3412107263, 0),
-    (3412115456, 3412123647, 7),
-    (3412131840, 3412167935, 0),
-    (3412168192, 3412197631, 0),
-    (3412198400, 3412213759, 0),
-    (3412381696, 3412385791, 3),
-    (3412705280, 3412705535, 10),
-    (3412711424, 3412711679, 10),
-    (3412951040, 3412983807, 7),
-    (3413049344, 3413061119, 12),
-    (3413061376, 3413070847, 12),
-    (3413071872, 3413075455, 12),
-    (3413075712, 3413075967, 12),
-    (3413076224, 3413098495, 12),
-    (3413143296, 3413144063, 13),
-    (3413144064, 3413144319, 12),
-    (3413144576, 3413147647, 13),
-    (3413229568, 3413245951, 12),
-    (3413278720, 3413295103, 9),
-    (3413540864, 3413557247, 7),
-    (3413819392, 3413835775, 11),
-    (3413860352, 3413861631, 13),
-    (3413864448, 3413868543, 13),
-    (3414237184, 3414245375, 12),
-    (3414373376, 3414373631, 12),
-    (3414556672, 3414605823, 14),
-    (3415113728, 3415121919, 14),
-    (3415138048, 3415138303, 10),
-    (3416137728, 3416145919, 12),
-    (3416289280, 3416293375, 3),
-    (3416522752, 3416588287, 13),
-    (3416711168, 3416719359, 12),
-    (3416752128, 3416779519, 0),
-    (3416779776, 3416784895, 0),
-    (3417112576, 3417128959, 12),
-    (3417145344, 3417178111, 7),
-    (3417210880, 3417227263, 12),
-    (3417272320, 3417274367, 0),
-    (3417833472, 3417849855, 3),
-    (3417948160, 3417956351, 12),
-    (3417959424, 3417959679, 12),
-    (3417959936, 3417963263, 12),
-    (3417963520, 3417964543, 12),
-    (3418192896, 3418193407, 13),
-    (3419013632, 3419017471, 13),
-    (3419017728, 3419020543, 13),
-    (3419020800, 3419023359, 13),
-    (3419023616, 3419047423, 13),
-    (3419047936, 3419048703, 13),
-    (3419048960, 3419062271, 13),
-    (3419281408, 3419294719, 12),
-    (3419296768, 3419297023, 11),
-    (3419299584, 3419340799, 12),
-    (3419422720, 3419439103, 12),
-    (3419521536, 3419521791, 12),
-    (3419528192, 3419528447, 12),
-    (3419701248, 3419709439, 14),
-    (3419766784, 3419774975, 13),
-    (3419799808, 3419815935, 12),
-    (3419815936, 3419816191, 11),
-    (3419816192, 3419840511, 12),
-    (3419865088, 3419873023, 12),
-    (3419901696, 3419901951, 0),
-    (3419996160, 3420012543, 12),
-    (3420344064, 3420344319, 12),
-    (3432656384, 3432656639, 61),
-    (3435278080, 3435278335, 60),
-    (3437961216, 3437964287, 30),
-    (3451899904, 3451900159, 7),
-    (3453948672, 3453948927, 60),
-    (3455034880, 3455035135, 10),
-    (3456960256, 3456960511, 61),
-    (3465306112, 3465312255, 61),
-    (3465312768, 3465412095, 61),
-    (3480435456, 3480435711, 61),
-    (3487539200, 3487543295, 50),
-    (3490364928, 3490365439, 61),
-    (3490493952, 3490494463, 61),
-    (3490647040, 3490647551, 61),
-    (3490668544, 3490672639, 61),
-    (3490702080, 3490702335, 61),
-    (3490705408, 3490707455, 61),
-    (3490856960, 3490861055, 61),
-    (3491069952, 3491078143, 61),
-    (3507994624, 3507996159, 60),
-    (3507996672, 3507996927, 60),
-    (3507997184, 3507997695, 60),
-    (3507997952, 3507998463, 60),
-    (3507998720, 3507999231, 60),
-    (3508000256, 3508001023, 60),
-    (3508001280, 3508002559, 60),
-    (3508002816, 3508003071, 60),
-    (3508004096, 3508004863, 60),
-    (3508005888, 3508006655, 60),
-    (3508006912, 3508008191, 60),
-    (3508008448, 3508008703, 60),
-    (3508008960, 3508009215, 60),
-    (3508009984, 3508010239, 60),
-    (3508010496, 3508011007, 60),
-    (3508404224, 3508404479, 61),
-    (3511418880, 3511423999, 61),
-    (3511424256, 3511427583, 61),
-    (3511427840, 3511451135, 61),
-    (3511451648, 3511469823, 61),
-    (3511470080, 3511471615, 61),
-    (3511471872, 3511480319, 61),
-    (3511480576, 3511481343, 61),
-    (3511482368, 3511522303, 61),
-    (3511523328, 3511529983, 61),
-    (3511530240, 3511531775, 61),
-    (3511532032, 3511536639, 61),
-    (3511536896, 3511540735, 61),
-    (3511541760, 3511564799, 61),
-    (3511565056, 3511572479, 61),
-    (3511572736, 3511604735, 61),
-    (3511604992, 3511622143, 61),
-    (3511622656, 3511631871, 61),
-    (3511640064, 3511661311, 61),
-    (3511661568, 3511681023, 61),
-    (3512041472, 3512074239, 50),
-    (3523215360, 3523215615, 13),
-    (3523739648, 3523748351, 12),
-    (3523748864, 3523756031, 12),
-    (3523756288, 3523756543, 12),
-    (3523756800, 3523757311, 12),
-    (3523757312, 3523757567, 11),
-    (3523757568, 3523758847, 12),
-    (3523759104, 3523759615, 12),
-    (3523759872, 3523762943, 12),
-    (3523763200, 3523768575, 12),
-    (3523768832, 3523771391, 12),
-    (3523772416, 3523780095, 12),
-    (3523780352, 3523782655, 12),
-    (3523782912, 3523786239, 12),
-    (3523786496, 3523791871, 12),
-    (3523792384, 3523801087, 12),
-    (3523801600, 3523803135, 12),
-    (3523803392, 3523813887, 12),
-    (3523814144, 3523816447, 12),
-    (3523817472, 3523822591, 12),
-    (3523822592, 3523822847, 11),
-    (3523822848, 3523835903, 12),
-    (3523836928, 3523837951, 12),
-    (3523838464, 3523838975, 12),
-    (3523839744, 3523839999, 12),
-    (3523842048, 3523844095, 12),
-    (3523844608, 3523849727, 12),
-    (3523849984, 3523853567, 12),
-    (3523853824, 3523854847, 12),
-    (3523855360, 3523864063, 12),
-    (3523864576, 3523864831, 12),
-    (3523865088, 3523865343, 12),
-    (3523865600, 3523866111, 12),
-    (3523866368, 3523896319, 12),
-    (3523897344, 3523947519, 12),
-    (3523948544, 3523949567, 12),
-    (3523950592, 3523973119, 12),
-    (3523974144, 3523986175, 12),
-    (3523986432, 3524001791, 12),
-    (3524247552, 3524263935, 12),
-    (3526426624, 3526492159, 13),
-    (3526492160, 3526557695, 14),
-    (3526758400, 3526766079, 8),
-    (3526768640, 3526769151, 1),
-    (3526769408, 3526770687, 1),
-    (3526770688, 3526787071, 8),
-    (3526790400, 3526790655, 8),
-    (3526791936, 3526792191, 8),
-    (3526792192, 3526793215, 1),
-    (3526793216, 3526795263, 8),
-    (3526803456, 3526819839, 8),
-    (3526822400, 3526822911, 8),
-    (3526822912, 3526823935, 1),
-    (3526828032, 3526842879, 8),
-    (3526843136, 3526844415, 8),
-    (3526848512, 3526852607, 8),
-    (3526853632, 3526854655, 8),
-    (3526855680, 3526862847, 8),
-    (3526863360, 3526865919, 8),
-    (3526866944, 3526867455, 8),
-    (3526867968, 3526870527, 8),
-    (3526870784, 3526871039, 8),
-    (3526872320, 3526872575, 8),
-    (3526872576, 3526873087, 2),
-    (3526875136, 3526877439, 8),
-    (3526880000, 3526884607, 8),
-    (3528720384, 3528736767, 12),
-    (3528851456, 3528880127, 8),
-    (3528916992, 3528921855, 12),
-    (3528922112, 3528923391, 12),
-    (3528923648, 3528925183, 12),
-    (3528925440, 3528933375, 12),
-    (3539337216, 3539353599, 7),
-    (3541696512, 3541827583, 14),
-    (3541827584, 3542089727, 13),
-    (3585114112, 3585122303, 40),
-    (3587538944, 3587547135, 40),
-    (3587981312, 3587997695, 40),
-    (3626862592, 3626863103, 60),
-    (3626863616, 3626864383, 60),
-    (3627728896, 3627737087, 50),
-    (3630432256, 3630454783, 61),
-    (3630456832, 3630483455, 61),
-    (3630483712, 3630491903, 61),
-    (3630492160, 3630502143, 61),
-    (3630502400, 3630508031, 61),
-    (3630508544, 3630527231, 61),
-    (3630527488, 3630555135, 61),
-    (3630555648, 3630558207, 61),
-    (3630558720, 3630566399, 61),
-    (3630567424, 3630581759, 61),
-    (3630584832, 3630628863, 61),
-    (3630629376, 3630654463, 61),
-    (3630654976, 3630661375, 61),
-    (3630661632, 3630663167, 61),
-    (3630663424, 3630665471, 61),
-    (3630665728, 3630666495, 61),
-    (3630666752, 3630669055, 61),
-    (3630669312, 3630694399, 61),
-    (3635276800, 3635281919, 61),
-    (3639549952, 3639557119, 50),
-    (3639557376, 3639558143, 50),
-    (3641278464, 3641282559, 40),
-    (3650592768, 3650600959, 40),
-    (3651915776, 3651919871, 40),
-    (3664052224, 3664052735, 0),
-    (3664053504, 3664084991, 0),
-    (3679977472, 3680003839, 8),
-    (3680004096, 3680010239, 8),
-    (3680010240, 3680014335, 1),
-    (3680014336, 3680034815, 8),
-    (3680038912, 3680043007, 1),
-    (3680043008, 3680108543, 8),
-    (3680141312, 3680174079, 16),
-    (3697606656, 3697639423, 13),
-    (3706388480, 3706454015, 12),
-    (3706454016, 3706716159, 13),
-    (3707568128, 3707633663, 12),
-    (3734503424, 3734765567, 8),
-    (3758090496, 3758090751, 10)
-];
+import array
+
+ip_version = '202610140000'
+
+ip_starts = array.array ('L', [
+    16777216, 16843008, 16909056, 19398656, 24641536, 134743040, 134744064,
+    136499200, 136560640, 235012096, 386075648, 386089984, 386091776,
+    386100224, 386248704, 386318336, 386338816, 386354688, 386371584,
+    386383872, 386502656, 386523136, 386650112, 386670592, 386782208,
+    386907136, 386908672, 387448832, 387842048, 387980800, 388086272,
+    388239360, 388542464, 388562944, 388628480, 388898816, 389090304,
+    389095424, 389101568, 389222400, 389378048, 389963776, 389967616,
+    389997568, 390148096, 390275072, 390275584, 390279168, 390280192,
+    390282240, 390329856, 390332416, 391115520, 398566400, 398577664,
+    398581760, 399340288, 399343104, 399561728, 399564800, 399619840,
+    399639808, 399642112, 399650816, 399690240, 399699968, 399782912,
+    399869440, 401354752, 402358272, 402653184, 404619264, 404881408,
+    405274624, 406585344, 407603456, 408616960, 409075712, 409479168,
+    409480192, 409480960, 409481472, 409482240, 409483264, 409484032,
+    409484800, 409487872, 409488384, 409494528, 409495040, 409497600,
+    409498368, 409499904, 409500416, 409501184, 409503744, 409504768,
+    409505792, 409506560, 409507584, 409509376, 410386432, 410812416,
+    411172864, 412286976, 412696576, 416940032, 418709504, 459472896,
+    460224512, 469499904, 469565440, 691863552, 692899840, 692940544,
+    693024768, 693040128, 693084160, 693087488, 693381120, 693385216,
+    693518336, 693526528, 696516608, 697303040, 697755648, 697806848,
+    699465728, 699990016, 700414976, 700844544, 700858368, 702471168,
+    702482432, 703987712, 708755456, 720437248, 793247744, 833617920,
+    836763648, 836829184, 843644928, 843841536, 847249408, 851968512,
+    851970560, 851972608, 851978496, 851986176, 851989760, 851996928,
+    851999488, 852002304, 852009984, 852010752, 852011520, 852014336,
+    852018688, 852020992, 852027904, 852032768, 852035328, 852038400,
+    852039936, 852050688, 852052992, 852059904, 852061696, 852062208,
+    852068864, 852080640, 852082944, 852086784, 852093440, 852094208,
+    852095488, 852098048, 852102144, 852109568, 852112384, 852114432,
+    852114944, 852117248, 852118272, 852121088, 852123648, 852124928,
+    852128256, 852133376, 852135424, 852138496, 852140032, 852141312,
+    852143360, 852153344, 852155136, 852157184, 852160512, 852163072,
+    852165632, 852168704, 852169216, 852174080, 852174592, 852185856,
+    852192512, 852199936, 852202752, 852206592, 852207616, 852215296,
+    852222720, 852224000, 852225536, 852233472, 852237568, 852241408,
+    852245504, 852248576, 852251648, 852255232, 852256512, 852258560,
+    852267520, 852270080, 852270592, 852271104, 852275968, 852277504,
+    852280064, 973471744, 973475072, 973475328, 973477888, 973478912,
+    973483008, 973486080, 973490176, 973498368, 973499392, 973500416,
+    973504512, 973508608, 973512704, 973513216, 973514752, 973520896,
+    973521920, 973537280, 973545472, 974913536, 979894272, 982614016,
+    983564288, 984743936, 996409344, 996487680, 996489728, 999790592,
+    999948288, 1000800256, 1021313024, 1021968384, 1021987328, 1023315712,
+    1023316992, 1024032768, 1025297920, 1025310720, 1027866624, 1027933184,
+    1027934720, 1027939072, 1029177344, 1029188096, 1029192448, 1029235712,
+    1029241856, 1029636096, 1049722880, 1082867712, 1084227584, 1084253696,
+    1084264448, 1084292864, 1084342016, 1084366080, 1084388608, 1084415744,
+    1084417536, 1084424448, 1084459008, 1084517888, 1084619264, 1084653824,
+    1084659456, 1084707328, 1084876288, 1084985344, 1084988928, 1085004032,
+    1085040640, 1085072384, 1089052672, 1092780032, 1096810496, 1107951616,
+    1108016640, 1109262336, 1109983232, 1110966272, 1113980928, 1114611712,
+    1115160576, 1115168256, 1115191012, 1115239680, 1115295744, 1115333888,
+    1115562496, 1115566080, 1115602176, 1115656960, 1115659008, 1118830592,
+    1120976896, 1122304000, 1123631104, 1134559232, 1142947840, 1146093568,
+    1157228544, 1161774080, 1166540800, 1169424384, 1170212608, 1173356544,
+    1176535040, 1176537088, 1176539136, 1176539904, 1176542976, 1180172288,
+    1192755200, 1194852352, 1203765248, 1205862400, 1208926208, 1208927796,
+    1208927800, 1208933892, 1208933896, 1208933940, 1208933944, 1224087808,
+    1224091904, 1224092928, 1224098304, 1224157696, 1224736768, 1242562560,
+    1247543296, 1249705984, 1249718784, 1249718788, 1249744896, 1249769216,
+    1250951168, 1262485504, 1267728384, 1276116992, 1280201728, 1281359872,
+    1288699904, 1346920448, 1359937536, 1412806656, 1439023104, 1486159872,
+    1490885376, 1490939904, 1503690752, 1506795520, 1551526912, 1551608832,
+    1551619072, 1600481280, 1600496640, 1611017216, 1611026432, 1611085824,
+    1611661312, 1611687936, 1611744256, 1611744768, 1611754496, 1611755008,
+    1611763968, 1611764480, 1611768832, 1611771904, 1614807040, 1619001344,
+    1646264320, 1646948096, 1656750080, 1661992960, 1662003200, 1662444032,
+    1662714880, 1662920960, 1700921344, 1701249024, 1704984576, 1705500672,
+    1728173056, 1728232960, 1728309248, 1728354304, 1728438272, 1728455424,
+    1728721152, 1728854016, 1728901376, 1728983040, 1729419264, 1729616384,
+    1729822976, 1729870848, 1729980160, 1743795200, 1743971328, 1744039680,
+    1744218112, 1744270848, 1744273408, 1744331008, 1744429056, 1744489472,
+    1744590592, 1744663552, 1776877568, 1782841344, 1782972416, 1795163136,
+    1795163904, 1795164928, 1795166464, 1795168000, 1795169024, 1795170304,
+    1795173376, 1795174400, 1795175168, 1795177728, 1795179008, 1795180288,
+    1795180800, 1795181568, 1795182592, 1795183360, 1795187456, 1795188736,
+    1795189760, 1795191552, 1795192064, 1795193088, 1795193600, 1795194880,
+    1795195392, 1795196160, 1795197184, 1795197696, 1795198720, 1795200256,
+    1795200768, 1795201280, 1795203072, 1795203584, 1795205888, 1795206912,
+    1795207936, 1795209216, 1795211264, 1795212800, 1795214080, 1795215104,
+    1795217152, 1795217664, 1795218944, 1795219456, 1795220480, 1795222272,
+    1795223296, 1795224064, 1795225344, 1795225856, 1795226880, 1795228160,
+    1795228928, 1795229952, 1795231232, 1795231744, 1795232512, 1795234048,
+    1795235072, 1795235840, 1795237120, 1795237632, 1795238912, 1795239424,
+    1795240448, 1795240960, 1795241472, 1795241984, 1795242496, 1795243264,
+    1795244032, 1795244544, 1795245312, 1795250176, 1795250688, 1795252480,
+    1795254272, 1795255296, 1795256320, 1795256832, 1795257344, 1795259136,
+    1795259904, 1795261184, 1795262720, 1795264000, 1795265792, 1795266560,
+    1795269632, 1795270400, 1795271168, 1795274752, 1795275264, 1795276800,
+    1795277824, 1795278592, 1795279616, 1795280384, 1795281920, 1795282688,
+    1795283456, 1795284224, 1795284992, 1795285504, 1795288064, 1795289600,
+    1795290112, 1795291136, 1795292672, 1815826432, 1823129600, 1823539200,
+    1846804480, 1847590912, 1850519552, 1851527168, 1854668800, 1866792960,
+    1899290624, 1908763136, 1914126336, 1914593280, 1917321216, 1919819776,
+    1921089536, 1925578752, 1940258816, 1941700608, 1950543872, 1959251968,
+    1961885696, 1962622720, 1962882304, 1969790976, 1970807808, 1970928672,
+    1985609728, 1985740800, 1986760704, 1986762496, 1993342976, 1993778688,
+    1993779200, 1993785344, 1993830400, 1993850880, 1997177344, 1997472256,
+    2011168768, 2011203584, 2011234304, 2011272192, 2011290112, 2013049856,
+    2022703104, 2032926720, 2033501952, 2034761728, 2035269632, 2035941376,
+    2036465664, 2036533248, 2036703232, 2038415872, 2043674624, 2050064384,
+    2050509312, 2050539008, 2053296128, 2053324800, 2053509632, 2053636096,
+    2063344640, 2063374336, 2077229056, 2080309248, 2080817152, 2087452672,
+    2090074112, 2090079232, 2090139648, 2090143744, 2090145792, 2090146816,
+    2090205184, 2090207232, 2091384832, 2091909120, 2093285376, 2100867072,
+    2100874240, 2100883456, 2108182528, 2108190720, 2108198912, 2108207616,
+    2108212224, 2110881792, 2112651264, 2113716224, 2178899968, 2179088384,
+    2193817600, 2195259392, 2209939456, 2209955584, 2226454528, 2257602560,
+    2308112384, 2316505856, 2316828672, 2323775488, 2329477120, 2335506432,
+    2338844072, 2340552704, 2340814848, 2342715392, 2343043072, 2346188800,
+    2361919232, 2361970688, 2376597504, 2398748672, 2405171200, 2413297664,
+    2414739456, 2418278656, 2422276096, 2424438784, 2428272640, 2451042304,
+    2455359232, 2457075712, 2460680192, 2460684544, 2460685312, 2460893184,
+    2461142016, 2461162240, 2463956992, 2466906112, 2470772736, 2475298816,
+    2475315200, 2475319296, 2478768128, 2479360256, 2492542976, 2508652544,
+    2510749696, 2511382784, 2523201536, 2544107520, 2544170752, 2557149184,
+    2557345792, 2557411328, 2574188544, 2574286848, 2602565632, 2604399872,
+    2609905664, 2609912064, 2609914624, 2609915648, 2609916160, 2609917696,
+    2609918208, 2609933056, 2609939200, 2609942784, 2609970176, 2609970688,
+    2610888704, 2615803904, 2615962368, 2615963136, 2615973376, 2616000512,
+    2616131584, 2616197120, 2617769984, 2618687744, 2620548096, 2653749248,
+    2668367360, 2674088704, 2675245312, 2678901760, 2680422400, 2687559936,
+    2688548864, 2689804032, 2692415488, 2703966208, 2703972352, 2719023104,
+    2725306368, 2727608320, 2732102656, 2732503040, 2747596800, 2747732736,
+    2747858944, 2747990016, 2749956864, 2749957376, 2757230592, 2758543360,
+    2761162752, 2761621504, 2768502784, 2769879040, 2777219072, 2777677824,
+    2777947904, 2778003456, 2779054080, 2783182848, 2796748800, 2796751104,
+    2796751616, 2813576192, 2813869312, 2823815424, 2824404992, 2827354112,
+    2827795200, 2827878400, 2829320192, 2830761984, 2832269312, 2835087360,
+    2835112960, 2835113984, 2835115008, 2835120128, 2845310976, 2848587776,
+    2848589568, 2848590336, 2848624640, 2862415872, 2866953216, 2899902464,
+    2901671936, 2902982656, 2912944128, 2915172352, 2917052416, 2917056512,
+    2917098496, 2917100544, 2919198720, 2922381312, 2929721344, 2938109952,
+    2957225984, 3001920256, 3026125568, 3026127616, 3026135040, 3026156544,
+    3029714688, 3031580928, 3033038848, 3034447872, 3055005696, 3063545856,
+    3069149184, 3088642048, 3088711168, 3088724992, 3088726528, 3088735744,
+    3088750592, 3088787456, 3088797696, 3088809216, 3088838656, 3088843776,
+    3088846848, 3088847872, 3088848896, 3088859136, 3088860160, 3088861184,
+    3088862208, 3088897792, 3088908288, 3088908800, 3088934400, 3088935936,
+    3088936448, 3089088512, 3090363392, 3090368512, 3090370560, 3090376192,
+    3090389760, 3090390784, 3090402816, 3092516864, 3092554752, 3092558848,
+    3092559616, 3092569344, 3092569600, 3092602880, 3092632320, 3092672512,
+    3092700928, 3092706560, 3092708096, 3092717568, 3092738048, 3092744192,
+    3094085632, 3222988288, 3224373248, 3224651776, 3224797696, 3224798976,
+    3225506304, 3225857536, 3226110976, 3226635776, 3226656256, 3226695168,
+    3226724096, 3226725632, 3226786560, 3226994432, 3227236608, 3227396352,
+    3227447808, 3227448064, 3227517184, 3227519744, 3227522560, 3227525632,
+    3227526656, 3227527936, 3227528704, 3227539712, 3227547648, 3227555328,
+    3227581184, 3228266752, 3228281600, 3228526848, 3229814016, 3229817088,
+    3229900032, 3230832128, 3230954496, 3230981376, 3230995456, 3231506688,
+    3231587328, 3231632896, 3231754496, 3232890880, 3233573632, 3233584896,
+    3233625600, 3233694208, 3233730816, 3233732352, 3234008064, 3234016256,
+    3234055424, 3234574336, 3234821888, 3234830336, 3234833664, 3234839296,
+    3235877376, 3236407296, 3236416256, 3236623616, 3236713472, 3237155840,
+    3237728000, 3238264832, 3238280192, 3240539904, 3247340800, 3252496384,
+    3264217088, 3288408064, 3288418048, 3288419072, 3288421632, 3288426240,
+    3288429312, 3288469504, 3288476928, 3288498176, 3288557824, 3288559872,
+    3288562688, 3288570624, 3288570880, 3288572160, 3288572416, 3288596992,
+    3288614656, 3288616704, 3288617728, 3288621312, 3288637440, 3288637952,
+    3288638208, 3288641280, 3288641792, 3288761600, 3288763648, 3288763904,
+    3288781824, 3288784384, 3288788224, 3288788992, 3288789760, 3289016320,
+    3289019904, 3289021440, 3289022976, 3289028096, 3289041920, 3289047040,
+    3289048320, 3289055232, 3289070080, 3289083136, 3289086464, 3289092864,
+    3289093120, 3289107712, 3289114880, 3289124864, 3289194240, 3289220096,
+    3289228032, 3289233664, 3289240832, 3289243904, 3289245696, 3289250048,
+    3289250560, 3289350144, 3289736192, 3289737472, 3289761792, 3289776128,
+    3289784320, 3289817088, 3289837568, 3289841664, 3289972736, 3290038272,
+    3290171392, 3290172416, 3290173440, 3290185728, 3290236416, 3290242816,
+    3290497024, 3290690304, 3290742784, 3290760704, 3291045888, 3291054080,
+    3291152384, 3291202304, 3291203584, 3291204352, 3291211520, 3291267072,
+    3291301376, 3291308032, 3291327744, 3301965824, 3302760448, 3310354432,
+    3311403008, 3314913280, 3315277824, 3315283968, 3320578048, 3321888768,
+    3323539200, 3325284864, 3325432832, 3325444096, 3325445888, 3325449216,
+    3325465856, 3325467136, 3325467648, 3325469952, 3325471232, 3325474816,
+    3325479424, 3325483776, 3325486080, 3325491200, 3325492480, 3327333120,
+    3327815680, 3331194880, 3333556224, 3333680896, 3333871360, 3341891072,
+    3342468096, 3350216704, 3350246400, 3350247424, 3350251520, 3350260736,
+    3350262016, 3350275840, 3350277632, 3350344192, 3350347520, 3350383104,
+    3350386944, 3350388480, 3350394368, 3350455552, 3350458624, 3351277568,
+    3353339904, 3353780736, 3353781760, 3354499072, 3354578432, 3355022080,
+    3355275008, 3389005824, 3389022976, 3389023744, 3389029376, 3389063936,
+    3389123328, 3389128448, 3389196544, 3389204480, 3389216768, 3389229312,
+    3389306112, 3389349888, 3389410304, 3389410816, 3389419776, 3389423616,
+    3389493248, 3389651968, 3389654528, 3389801472, 3389806848, 3389807872,
+    3389810688, 3389811968, 3389814528, 3389816832, 3389939200, 3389939456,
+    3389942528, 3389943808, 3389960448, 3389968896, 3389978368, 3390324736,
+    3390327808, 3390332160, 3390337280, 3390375936, 3390408704, 3390770432,
+    3390770944, 3390777344, 3390798848, 3390799872, 3390807040, 3390812160,
+    3390814720, 3391358720, 3391360512, 3391365120, 3391368192, 3391385088,
+    3391385344, 3391392768, 3391398912, 3391402496, 3391411712, 3391412224,
+    3391412992, 3391417088, 3391428352, 3391437312, 3391442432, 3391443200,
+    3391445248, 3391447040, 3391448064, 3391463424, 3391470336, 3391482880,
+    3391484416, 3391485952, 3391525888, 3391971328, 3392098560, 3392099840,
+    3392217600, 3392225024, 3392238336, 3392239104, 3392239616, 3392241152,
+    3392247040, 3392250112, 3392254464, 3392260096, 3392268544, 3392272640,
+    3392273408, 3392294912, 3392301056, 3392302592, 3392304384, 3392309504,
+    3392316416, 3392317696, 3392317952, 3392322560, 3392333568, 3392337408,
+    3392479232, 3392638976, 3392640768, 3392641536, 3392856064, 3392856576,
+    3392857344, 3392888832, 3392995840, 3393404928, 3393691648, 3393692416,
+    3393692672, 3393748992, 3393750528, 3393750784, 3393830912, 3393891072,
+    3393892096, 3393911808, 3394142208, 3394219776, 3394700288, 3394905600,
+    3395043328, 3395138560, 3397148672, 3397322752, 3397468928, 3397507584,
+    3397935104, 3398033408, 3398041600, 3398090752, 3398107136, 3398118144,
+    3398149888, 3398291456, 3398572032, 3398613760, 3398653952, 3398852608,
+    3399414016, 3399450624, 3399515904, 3399548928, 3399633408, 3400271360,
+    3400271872, 3400272384, 3400272640, 3400273664, 3400368128, 3400370176,
+    3400372224, 3400376320, 3400380416, 3400458240, 3400810496, 3400820480,
+    3400851456, 3400854784, 3400859136, 3400963072, 3401424896, 3401526784,
+    3401539584, 3405775104, 3405778176, 3405781248, 3405782784, 3405783808,
+    3405784320, 3405794560, 3405799936, 3405807872, 3405810432, 3405811456,
+    3405819904, 3405820416, 3405832704, 3405835776, 3405840384, 3405845760,
+    3405846528, 3405867008, 3405887232, 3405893632, 3405895680, 3405896960,
+    3405897472, 3405904896, 3405925120, 3405925376, 3405926400, 3405937664,
+    3405937920, 3405939968, 3405940224, 3405942784, 3405953024, 3405956864,
+    3405965056, 3405967104, 3405981440, 3405989120, 3405989632, 3405991680,
+    3405993984, 3405998080, 3406006528, 3406006784, 3406078976, 3406081024,
+    3406086144, 3406095360, 3406105856, 3406109184, 3406110720, 3406111488,
+    3406112768, 3406117376, 3406123008, 3406129920, 3406134784, 3406147584,
+    3406149632, 3406156800, 3406157824, 3406158848, 3406160384, 3406168064,
+    3406171136, 3406188544, 3406201856, 3406203904, 3406204672, 3406205440,
+    3406224896, 3406230528, 3406230784, 3406233600, 3406273280, 3406277888,
+    3406278400, 3406283776, 3406284288, 3406286592, 3406291712, 3406299648,
+    3406301440, 3406322176, 3406326528, 3406328064, 3406330880, 3406340352,
+    3406344192, 3406348544, 3406348800, 3406350336, 3406352000, 3406373120,
+    3406373632, 3406380032, 3406395136, 3406397440, 3406399488, 3406402048,
+    3406403072, 3406404864, 3406425856, 3406430464, 3406439424, 3406445568,
+    3406446592, 3406449664, 3406456064, 3406458368, 3406458880, 3406462976,
+    3406486016, 3406490112, 3406490368, 3406512128, 3406513920, 3406514432,
+    3406516480, 3406516992, 3406518272, 3406520320, 3406524416, 3406546944,
+    3406569216, 3406574592, 3406578432, 3406589952, 3406590720, 3406594816,
+    3406596096, 3406596864, 3406614784, 3406617088, 3406620160, 3406620416,
+    3406624768, 3406632192, 3406636288, 3406643200, 3406645760, 3406646016,
+    3406646784, 3406651392, 3406663680, 3406669056, 3406688768, 3406692352,
+    3406705152, 3406716928, 3406718720, 3406722048, 3406724352, 3406724864,
+    3406729984, 3406732288, 3406733312, 3406733568, 3406738432, 3406744576,
+    3406748672, 3406761984, 3406775552, 3406779392, 3406781696, 3406782208,
+    3406785280, 3406786304, 3406791936, 3406802688, 3406811136, 3406819840,
+    3406821376, 3406822912, 3406829568, 3406831616, 3406832640, 3406835712,
+    3406840576, 3406857216, 3406859520, 3406866176, 3406866688, 3406868224,
+    3406876672, 3406882048, 3406885120, 3406889216, 3406892288, 3406902272,
+    3406904320, 3406905344, 3406912000, 3406913024, 3406913536, 3406918144,
+    3406918656, 3406920960, 3406924288, 3406927872, 3406937088, 3406938368,
+    3406941184, 3406949120, 3406949888, 3406953216, 3406953984, 3406956544,
+    3406957312, 3406957824, 3406958080, 3406960640, 3406961408, 3406962944,
+    3406968064, 3406974464, 3406976512, 3406977024, 3406983168, 3406987264,
+    3406991104, 3406999040, 3407002368, 3407004672, 3407013888, 3407021824,
+    3407025920, 3407037952, 3407038208, 3407047424, 3407052800, 3407053824,
+    3407054848, 3407057152, 3407060480, 3407062784, 3407079936, 3407080192,
+    3407081728, 3407084544, 3407085056, 3407090688, 3407096576, 3407100160,
+    3407103744, 3407105024, 3407107840, 3407109888, 3407110912, 3407113216,
+    3407114752, 3407119360, 3407123712, 3407124736, 3407134720, 3407143424,
+    3407143936, 3407146496, 3407148544, 3407152384, 3407153408, 3407154944,
+    3407156224, 3407161088, 3407163648, 3407168768, 3407171328, 3407173632,
+    3407175168, 3407177984, 3407178240, 3407183104, 3407183616, 3407187968,
+    3407197184, 3407202304, 3407221504, 3407222016, 3407223296, 3407223552,
+    3407233792, 3407235840, 3407237888, 3407249408, 3407250944, 3407252736,
+    3407264768, 3407268352, 3407268608, 3407271936, 3407275264, 3407281664,
+    3407283968, 3407284480, 3407284736, 3407287040, 3407287296, 3407287808,
+    3407288064, 3407288320, 3407289856, 3407292672, 3407296768, 3407297024,
+    3407301376, 3407303168, 3407304192, 3407306752, 3407310080, 3407312384,
+    3407314944, 3407317504, 3407325184, 3407326976, 3407330816, 3407332352,
+    3407333376, 3407339776, 3407344896, 3407345152, 3407351296, 3407354368,
+    3407356672, 3407356928, 3407363072, 3407363584, 3407366144, 3407367680,
+    3407376640, 3407377664, 3407379712, 3407379968, 3407381248, 3407384576,
+    3407391232, 3407393792, 3407396096, 3407396352, 3407397888, 3407399168,
+    3407400704, 3407400960, 3407401472, 3407408640, 3407410432, 3407411968,
+    3407418880, 3407433472, 3407434496, 3407438336, 3407441152, 3407442944,
+    3407444992, 3407449600, 3407451904, 3407453184, 3407454976, 3407456000,
+    3407456512, 3407465472, 3407470592, 3407471104, 3407472128, 3407474432,
+    3407475968, 3407482368, 3407486976, 3407490816, 3407492096, 3407493888,
+    3407496704, 3407499520, 3407500800, 3407501056, 3407502848, 3407503360,
+    3407505920, 3407507456, 3407509504, 3407512064, 3407512576, 3407513600,
+    3407515904, 3407524352, 3407531520, 3407538944, 3407541504, 3407545088,
+    3407551232, 3407552256, 3407555072, 3407559168, 3407562240, 3407565312,
+    3407567104, 3407569920, 3407572736, 3407574528, 3407577088, 3407593728,
+    3407595264, 3407595776, 3407596544, 3407596800, 3407601408, 3407601920,
+    3407604992, 3407605248, 3407606784, 3407609088, 3407615232, 3407615488,
+    3407617024, 3407621632, 3407623936, 3407629056, 3407630592, 3407632640,
+    3407636992, 3407639296, 3407639552, 3407641088, 3407642368, 3407649536,
+    3407649792, 3407650048, 3407650560, 3407651328, 3407652352, 3407652608,
+    3407653888, 3407654144, 3407654912, 3407656192, 3407658496, 3407659264,
+    3407661056, 3407665920, 3407668224, 3407669760, 3407670784, 3407681536,
+    3407684864, 3407686656, 3407690240, 3407691264, 3407692800, 3407694848,
+    3407697664, 3407700224, 3407705856, 3407716352, 3407726080, 3407731200,
+    3407734784, 3407736320, 3407749888, 3407753728, 3407756800, 3407757312,
+    3407760128, 3407762688, 3407764480, 3407765504, 3407767552, 3407768832,
+    3407778816, 3407785984, 3407787264, 3407789056, 3407790848, 3407791360,
+    3407792128, 3407793408, 3407793664, 3407800064, 3407807488, 3407809792,
+    3407811072, 3407817216, 3407819776, 3407822336, 3407823616, 3407826176,
+    3407826688, 3407827200, 3407830016, 3407830784, 3407838464, 3407838720,
+    3407847680, 3407849216, 3407849984, 3407853056, 3407853568, 3407856896,
+    3407858944, 3407859712, 3407862528, 3407868160, 3407869440, 3407871744,
+    3407873536, 3407876096, 3407877376, 3407878656, 3407879168, 3407880704,
+    3407882240, 3407884800, 3407885056, 3407886592, 3407886848, 3407888384,
+    3407888640, 3407890944, 3407895040, 3407896064, 3407897856, 3407900160,
+    3407901952, 3407903232, 3407906816, 3407907072, 3407908352, 3407917568,
+    3407921408, 3407923456, 3407924992, 3407928320, 3407929088, 3407938304,
+    3407942144, 3407942656, 3407948288, 3407949312, 3407951616, 3407955968,
+    3407957248, 3407966208, 3407969792, 3407974144, 3407978496, 3407986176,
+    3407986944, 3407993856, 3407997440, 3407999232, 3408000512, 3408001024,
+    3408001792, 3408002816, 3408003584, 3408004608, 3408008704, 3408010496,
+    3408012288, 3408013312, 3408013568, 3408014336, 3408016128, 3408017920,
+    3408018944, 3408021504, 3408024832, 3408028672, 3408029696, 3408032256,
+    3408032512, 3408034816, 3408036096, 3408036608, 3408037120, 3408038144,
+    3408039680, 3408040192, 3408042752, 3408043008, 3408049408, 3408050432,
+    3408050688, 3408051968, 3408057344, 3408058880, 3408060160, 3408064256,
+    3408068352, 3408068608, 3409381632, 3409382912, 3409387776, 3409388032,
+    3409388288, 3409389568, 3409390848, 3409391104, 3409394688, 3409395200,
+    3409399552, 3409400320, 3409400576, 3409406464, 3409408512, 3409411072,
+    3409419520, 3409422080, 3409423104, 3409425152, 3409426688, 3409431296,
+    3409432832, 3409433856, 3409436416, 3409436928, 3409437696, 3409442816,
+    3409445376, 3409446144, 3409446400, 3409449216, 3409452544, 3409454080,
+    3409455616, 3409460992, 3409464832, 3409467136, 3409468416, 3409468928,
+    3409470208, 3409472000, 3409475328, 3409476864, 3409477376, 3409488384,
+    3409490176, 3409495040, 3409495808, 3409497088, 3409499392, 3409500416,
+    3409510912, 3409512704, 3409513216, 3409517312, 3409517824, 3409520128,
+    3409526272, 3409530176, 3409532928, 3409541120, 3409550336, 3409559552,
+    3409560576, 3409563648, 3409566464, 3409573888, 3409584128, 3409641472,
+    3409872384, 3409878272, 3409879040, 3409880320, 3409881600, 3409883392,
+    3409884928, 3409887232, 3409889792, 3409901568, 3409903616, 3409956352,
+    3409959936, 3409967104, 3410969600, 3410976256, 3410981888, 3411460096,
+    3411628032, 3411810816, 3411867648, 3411943424, 3412089856, 3412094976,
+    3412097536, 3412098304, 3412103168, 3412115456, 3412131840, 3412168192,
+    3412198400, 3412381696, 3412705280, 3412711424, 3412951040, 3413049344,
+    3413061376, 3413071872, 3413075712, 3413076224, 3413143296, 3413144064,
+    3413144576, 3413229568, 3413278720, 3413540864, 3413819392, 3413860352,
+    3413864448, 3414237184, 3414373376, 3414556672, 3415113728, 3415138048,
+    3416137728, 3416289280, 3416522752, 3416711168, 3416752128, 3416779776,
+    3417112576, 3417145344, 3417210880, 3417272320, 3417833472, 3417948160,
+    3417959424, 3417959936, 3417963520, 3418192896, 3419013632, 3419017728,
+    3419020800, 3419023616, 3419047936, 3419048960, 3419281408, 3419296768,
+    3419299584, 3419422720, 3419521536, 3419528192, 3419701248, 3419766784,
+    3419799808, 3419815936, 3419816192, 3419865088, 3419901696, 3419996160,
+    3420344064, 3432656384, 3435278080, 3437961216, 3451899904, 3453948672,
+    3455034880, 3456960256, 3465306112, 3465312768, 3480435456, 3487539200,
+    3490364928, 3490493952, 3490647040, 3490668544, 3490702080, 3490705408,
+    3490856960, 3491069952, 3507994624, 3507996672, 3507997184, 3507997952,
+    3507998720, 3508000256, 3508001280, 3508002816, 3508004096, 3508005888,
+    3508006912, 3508008448, 3508008960, 3508009984, 3508010496, 3508404224,
+    3511418880, 3511424256, 3511427840, 3511451648, 3511470080, 3511471872,
+    3511480576, 3511482368, 3511523328, 3511530240, 3511532032, 3511536896,
+    3511541760, 3511565056, 3511572736, 3511604992, 3511622656, 3511640064,
+    3511661568, 3512041472, 3523215360, 3523739648, 3523748864, 3523756288,
+    3523756800, 3523757312, 3523757568, 3523759104, 3523759872, 3523763200,
+    3523768832, 3523772416, 3523780352, 3523782912, 3523786496, 3523792384,
+    3523801600, 3523803392, 3523814144, 3523817472, 3523822592, 3523822848,
+    3523836928, 3523838464, 3523839744, 3523842048, 3523844608, 3523849984,
+    3523853824, 3523855360, 3523864576, 3523865088, 3523865600, 3523866368,
+    3523897344, 3523948544, 3523950592, 3523974144, 3523986432, 3524247552,
+    3526426624, 3526492160, 3526758400, 3526768640, 3526769408, 3526770688,
+    3526790400, 3526791936, 3526792192, 3526793216, 3526803456, 3526822400,
+    3526822912, 3526828032, 3526843136, 3526848512, 3526853632, 3526855680,
+    3526863360, 3526866944, 3526867968, 3526870784, 3526872320, 3526872576,
+    3526875136, 3526880000, 3528720384, 3528851456, 3528916992, 3528922112,
+    3528923648, 3528925440, 3539337216, 3541696512, 3541827584, 3585114112,
+    3587538944, 3587981312, 3626862592, 3626863616, 3627728896, 3630432256,
+    3630456832, 3630483712, 3630492160, 3630502400, 3630508544, 3630527488,
+    3630555648, 3630558720, 3630567424, 3630584832, 3630629376, 3630654976,
+    3630661632, 3630663424, 3630665728, 3630666752, 3630669312, 3635276800,
+    3639549952, 3639557376, 3641278464, 3650592768, 3651915776, 3664052224,
+    3664053504, 3679977472, 3680004096, 3680010240, 3680014336, 3680038912,
+    3680043008, 3680141312, 3697606656, 3706388480, 3706454016, 3707568128,
+    3734503424, 3758090496
+])
+
+ip_ends = array.array ('L', [
+    16777471, 16843263, 16909311, 19726335, 27262975, 134743295, 134744319,
+    136503295, 136564735, 235077631, 386075903, 386090239, 386092031,
+    386100735, 386252799, 386322431, 386342911, 386359295, 386375679,
+    386387967, 386506751, 386527231, 386651135, 386674687, 386783231,
+    386907647, 386909183, 387579903, 387973119, 387981055, 388086527,
+    388247551, 388546559, 388567039, 388632575, 388907007, 389091327,
+    389100031, 389101823, 389226495, 389390335, 389964287, 389967871,
+    389997823, 390152191, 390275327, 390275839, 390279935, 390280447,
+    390282751, 390330367, 390594559, 391115775, 398566911, 398578687,
+    398589951, 399341055, 399343615, 399562751, 399572991, 399620095,
+    399640063, 399642623, 399660031, 399691775, 399708159, 399783167,
+    399869951, 401358847, 402366463, 404226047, 404652031, 404946943,
+    405295103, 406847487, 407603711, 408682495, 409206783, 409479423,
+    409480703, 409481215, 409481983, 409482751, 409483775, 409484287,
+    409487359, 409488127, 409489407, 409494783, 409495551, 409498111,
+    409499647, 409500159, 409500671, 409503231, 409503999, 409505535,
+    409506303, 409506815, 409509119, 409509887, 410451967, 411140095,
+    411303935, 412352511, 412704767, 417005567, 418725887, 459505663,
+    460226559, 469565439, 469598207, 691929087, 692901887, 692940799,
+    693025791, 693041151, 693085183, 693087743, 693383167, 693403647,
+    693526527, 693534719, 696778751, 697753599, 697802751, 697827327,
+    699531263, 700055551, 700415999, 700844799, 700862463, 702472191,
+    702483455, 704118783, 708771839, 720502783, 793313279, 835190783,
+    836812799, 837025791, 843710463, 844103679, 851968255, 851970303,
+    851972351, 851978239, 851985663, 851989503, 851996671, 851999231,
+    852002047, 852009727, 852010495, 852011263, 852014079, 852018431,
+    852020735, 852027647, 852032511, 852035071, 852038143, 852039679,
+    852050431, 852052479, 852059391, 852061439, 852061951, 852068607,
+    852080383, 852082687, 852086527, 852093183, 852093951, 852095231,
+    852097791, 852101631, 852109311, 852111871, 852114175, 852114687,
+    852116991, 852118015, 852120831, 852123391, 852124671, 852127743,
+    852133119, 852135167, 852138239, 852139775, 852141055, 852143103,
+    852153087, 852154879, 852156927, 852160255, 852162815, 852165375,
+    852168447, 852168959, 852173823, 852174335, 852185599, 852192255,
+    852199679, 852202495, 852206335, 852207103, 852215039, 852222463,
+    852223743, 852225279, 852233215, 852237311, 852241151, 852245247,
+    852248319, 852251391, 852254975, 852256255, 852258303, 852267263,
+    852269823, 852270335, 852270847, 852275711, 852277247, 852279807,
+    855638015, 973475071, 973475327, 973477887, 973478143, 973483007,
+    973486079, 973490175, 973498367, 973498623, 973500159, 973504511,
+    973508607, 973512703, 973513215, 973514751, 973520895, 973521919,
+    973537279, 973545471, 973602815, 974979071, 980418559, 982622207,
+    984612863, 984875007, 996487423, 996489471, 996573183, 999793663,
+    1000013823, 1000865791, 1021837311, 1021987071, 1022033919, 1023315967,
+    1023317247, 1024065535, 1025298175, 1025343487, 1027932159, 1027934207,
+    1027938303, 1027997695, 1029187583, 1029192191, 1029233663, 1029237759,
+    1029242879, 1029668863, 1049731071, 1082875903, 1084253183, 1084264191,
+    1084292607, 1084341759, 1084365823, 1084388351, 1084415487, 1084417279,
+    1084424191, 1084457983, 1084517631, 1084619007, 1084653567, 1084657663,
+    1084707071, 1084876031, 1084984831, 1084988671, 1085003775, 1085040383,
+    1085071359, 1085276159, 1089060863, 1092812799, 1096876031, 1107951871,
+    1108016895, 1109393407, 1110048767, 1110982655, 1113985023, 1114615807,
+    1115167999, 1115191007, 1115239423, 1115295231, 1115333631, 1115561983,
+    1115564031, 1115601919, 1115656703, 1115658751, 1115684863, 1118961663,
+    1120993279, 1122369535, 1123639295, 1136656383, 1145044991, 1146617855,
+    1157229567, 1161774335, 1167065087, 1169555455, 1170212863, 1174405119,
+    1176535551, 1176538111, 1176539647, 1176542719, 1176543231, 1180434431,
+    1193017343, 1195376639, 1204813823, 1206910975, 1208927795, 1208927799,
+    1208933891, 1208933895, 1208933939, 1208933943, 1208942591, 1224088063,
+    1224092415, 1224093183, 1224098815, 1224158207, 1241513983, 1243611135,
+    1247805439, 1249718783, 1249718787, 1249743871, 1249768447, 1249771519,
+    1251999743, 1263255551, 1268252671, 1277165567, 1280202751, 1285554175,
+    1289224191, 1346924543, 1359970303, 1412808703, 1439039487, 1486192639,
+    1490885631, 1490942975, 1503723519, 1506797567, 1551527935, 1551609855,
+    1551620095, 1600482303, 1600497663, 1611017471, 1611030527, 1611086335,
+    1611661823, 1611692031, 1611744511, 1611745279, 1611754751, 1611755519,
+    1611764223, 1611764991, 1611769599, 1611772159, 1618804735, 1625292799,
+    1646947839, 1648361471, 1660944383, 1662001151, 1662443519, 1662713855,
+    1662920703, 1663041535, 1700986879, 1701314559, 1705491455, 1707081727,
+    1728174079, 1728233215, 1728310271, 1728355327, 1728439295, 1728455679,
+    1728721407, 1728854527, 1728901631, 1728984063, 1729419519, 1729616639,
+    1729823231, 1729871871, 1729980415, 1743796223, 1743972351, 1744039935,
+    1744218367, 1744271359, 1744274431, 1744331263, 1744429567, 1744489727,
+    1744590847, 1744663807, 1776943103, 1782972415, 1783103487, 1795163647,
+    1795164671, 1795166207, 1795166719, 1795168767, 1795170047, 1795173119,
+    1795173887, 1795174911, 1795176703, 1795178495, 1795180031, 1795180543,
+    1795181311, 1795182079, 1795183103, 1795186687, 1795187967, 1795189503,
+    1795191039, 1795191807, 1795192575, 1795193343, 1795194111, 1795195135,
+    1795195647, 1795196671, 1795197439, 1795198463, 1795199231, 1795200511,
+    1795201023, 1795202815, 1795203327, 1795204351, 1795206399, 1795207679,
+    1795208703, 1795210751, 1795212287, 1795213567, 1795214591, 1795216383,
+    1795217407, 1795218431, 1795219199, 1795219711, 1795222015, 1795223039,
+    1795223807, 1795225087, 1795225599, 1795226623, 1795227903, 1795228671,
+    1795229183, 1795230719, 1795231487, 1795231999, 1795232767, 1795234559,
+    1795235583, 1795236095, 1795237375, 1795238655, 1795239167, 1795240191,
+    1795240703, 1795241215, 1795241727, 1795242239, 1795242751, 1795243775,
+    1795244287, 1795244799, 1795249663, 1795250431, 1795252223, 1795253503,
+    1795255039, 1795255807, 1795256575, 1795257087, 1795258879, 1795259647,
+    1795260927, 1795262463, 1795263743, 1795264511, 1795266047, 1795269119,
+    1795270143, 1795270911, 1795273471, 1795275007, 1795275775, 1795277055,
+    1795278079, 1795279103, 1795279871, 1795281663, 1795282431, 1795283199,
+    1795283967, 1795284479, 1795285247, 1795287039, 1795289343, 1795289855,
+    1795290879, 1795292159, 1795555327, 1815830527, 1823145983, 1823571967,
+    1847066623, 1847721983, 1850520575, 1851528191, 1855455231, 1866858495,
+    1899294719, 1908763391, 1914126591, 1914601471, 1917779967, 1919821823,
+    1921089791, 1925611519, 1940275199, 1941831679, 1950544383, 1959256063,
+    1961951231, 1962622975, 1962882559, 1969793023, 1970808319, 1970928675,
+    1985675263, 1985871871, 1986761215, 1986762751, 1993605119, 1993778943,
+    1993779711, 1993789439, 1993832447, 1993859071, 1997178879, 1997473023,
+    2011201535, 2011205631, 2011271167, 2011289855, 2011299839, 2013050879,
+    2023751679, 2033057791, 2033502207, 2035023871, 2035286015, 2036006911,
+    2036531199, 2036596735, 2036705279, 2038423551, 2044723199, 2050080767,
+    2050509823, 2051014655, 2053298175, 2053332991, 2053509887, 2054160383,
+    2063345663, 2063376383, 2077491199, 2080325631, 2080824319, 2087453695,
+    2090079231, 2090139647, 2090143743, 2090145791, 2090146815, 2090205183,
+    2090207231, 2090237951, 2091646975, 2092957695, 2093301759, 2100869119,
+    2100875263, 2100887551, 2108184575, 2108192767, 2108202495, 2108211199,
+    2108217855, 2110898175, 2112880639, 2113720319, 2178908159, 2179092479,
+    2193883135, 2195324927, 2209955327, 2210004991, 2226520063, 2257604863,
+    2308177919, 2316506111, 2316894207, 2323841023, 2329542655, 2335571967,
+    2338844075, 2340618239, 2340880383, 2342780927, 2343108607, 2346196991,
+    2361919487, 2361972223, 2376663039, 2398879743, 2405236735, 2413363199,
+    2414804991, 2418278911, 2422341631, 2425159679, 2428272895, 2451043327,
+    2455359487, 2457141247, 2460684287, 2460685055, 2460745727, 2460893439,
+    2461142271, 2461163519, 2464022527, 2466971647, 2470838271, 2475307007,
+    2475317247, 2475327487, 2478833663, 2479422463, 2492543231, 2508718079,
+    2510815231, 2511405055, 2523267071, 2544170495, 2544173055, 2557214719,
+    2557411327, 2557476863, 2574254079, 2574287103, 2602631167, 2604400127,
+    2609911807, 2609914367, 2609915391, 2609915903, 2609916415, 2609917951,
+    2609931263, 2609938943, 2609942527, 2609969919, 2609970431, 2609971199,
+    2610954239, 2615869439, 2615962623, 2615963647, 2615974143, 2616066047,
+    2616197119, 2616238079, 2617835519, 2618688255, 2620548607, 2653780223,
+    2668367615, 2674088959, 2675245567, 2678902015, 2680487935, 2687560191,
+    2688614399, 2689804287, 2692481023, 2703972095, 2704015359, 2719088639,
+    2725306623, 2727870463, 2732103679, 2732505087, 2747732479, 2747793407,
+    2747924479, 2748055551, 2749957119, 2749960191, 2757296127, 2758587903,
+    2761359359, 2761687039, 2768568319, 2769944575, 2777284607, 2777947647,
+    2777972735, 2778071039, 2779119615, 2783248383, 2796750847, 2796751359,
+    2796814335, 2813579775, 2813869567, 2823880703, 2824470527, 2827354367,
+    2827795455, 2827943935, 2829385727, 2830827519, 2832400383, 2835111935,
+    2835113983, 2835115007, 2835116031, 2835152895, 2845376511, 2848589311,
+    2848590079, 2848624383, 2848653311, 2862481407, 2866953471, 2899967999,
+    2901737471, 2903506943, 2913468415, 2915237887, 2917053439, 2917057535,
+    2917099519, 2917101567, 2919202815, 2923429887, 2931818495, 2938634239,
+    2957228031, 3001920511, 3026125823, 3026127871, 3026135295, 3026156799,
+    3029714943, 3031581183, 3033063423, 3034456063, 3055007743, 3063611391,
+    3069181951, 3088646143, 3088711423, 3088725503, 3088727039, 3088735999,
+    3088751615, 3088788479, 3088801791, 3088809471, 3088839679, 3088844799,
+    3088847103, 3088848383, 3088849407, 3088859647, 3088860671, 3088861695,
+    3088863231, 3088898047, 3088908799, 3088909311, 3088934911, 3088936447,
+    3088936959, 3089092607, 3090364415, 3090369535, 3090371583, 3090376447,
+    3090390015, 3090391039, 3090403327, 3092520959, 3092555775, 3092559103,
+    3092559871, 3092569599, 3092569855, 3092606975, 3092632575, 3092673535,
+    3092701183, 3092707583, 3092708351, 3092721663, 3092742143, 3092745215,
+    3095396351, 3222988543, 3224374015, 3224652287, 3224797951, 3224799231,
+    3225508863, 3225857791, 3226128383, 3226636031, 3226656511, 3226695423,
+    3226724351, 3226725887, 3226786815, 3226994687, 3227236863, 3227396607,
+    3227448063, 3227448575, 3227517439, 3227520255, 3227522815, 3227525887,
+    3227526911, 3227528191, 3227531775, 3227541503, 3227551487, 3227555583,
+    3227581439, 3228267007, 3228282111, 3228527103, 3229814271, 3229817343,
+    3229900287, 3230832383, 3230965759, 3230981631, 3230995711, 3231506943,
+    3231588351, 3231633151, 3231755007, 3233021951, 3233573887, 3233585151,
+    3233625855, 3233694463, 3233732351, 3233732607, 3234008575, 3234017791,
+    3234055679, 3234574591, 3234822399, 3234830591, 3234833919, 3234839551,
+    3235877631, 3236407551, 3236416511, 3236623871, 3236714495, 3237156863,
+    3237728255, 3238279679, 3238330367, 3240540159, 3247341055, 3252496639,
+    3264282623, 3288408319, 3288418303, 3288420351, 3288422143, 3288426495,
+    3288429567, 3288476671, 3288481791, 3288506367, 3288558079, 3288560639,
+    3288564735, 3288570879, 3288571903, 3288572415, 3288572927, 3288597247,
+    3288616191, 3288616959, 3288617983, 3288621567, 3288637951, 3288638207,
+    3288641279, 3288641791, 3288660991, 3288762623, 3288763903, 3288768767,
+    3288782591, 3288784895, 3288788479, 3288789503, 3288792063, 3289016575,
+    3289020159, 3289022463, 3289024511, 3289040895, 3289044479, 3289047295,
+    3289053695, 3289063167, 3289073919, 3289085183, 3289086719, 3289093119,
+    3289103615, 3289108991, 3289115135, 3289125119, 3289215487, 3289220351,
+    3289228799, 3289233919, 3289242111, 3289244671, 3289245951, 3289250303,
+    3289317375, 3289382911, 3289737215, 3289738239, 3289762047, 3289776639,
+    3289788415, 3289825279, 3289841663, 3289907199, 3290038271, 3290103807,
+    3290171647, 3290173183, 3290181631, 3290226687, 3290236671, 3290243071,
+    3290690047, 3290742527, 3290760447, 3290923007, 3291054079, 3291062271,
+    3291168767, 3291202559, 3291203839, 3291204607, 3291211775, 3291271167,
+    3291301631, 3291312127, 3291327999, 3302490111, 3302768639, 3310878719,
+    3311927295, 3314914303, 3315282943, 3315286015, 3320643583, 3321954303,
+    3323539455, 3325285119, 3325438719, 3325444351, 3325447167, 3325449471,
+    3325466111, 3325467391, 3325469695, 3325470207, 3325471487, 3325478143,
+    3325479679, 3325484031, 3325486335, 3325491455, 3325492735, 3327333375,
+    3327816703, 3331260415, 3333558271, 3333681151, 3333871615, 3341891583,
+    3342468351, 3350245631, 3350246655, 3350249471, 3350257663, 3350261759,
+    3350275583, 3350277375, 3350343935, 3350347263, 3350382079, 3350386687,
+    3350388223, 3350394111, 3350455295, 3350458367, 3350462463, 3351278591,
+    3353341951, 3353780991, 3353782015, 3354501119, 3354578943, 3355022335,
+    3355275263, 3389014015, 3389023231, 3389023999, 3389029631, 3389064191,
+    3389123583, 3389128703, 3389197567, 3389208319, 3389218815, 3389229567,
+    3389306367, 3389358079, 3389410559, 3389411071, 3389420031, 3389431807,
+    3389497087, 3389652223, 3389659135, 3389801727, 3389807103, 3389808127,
+    3389810943, 3389812223, 3389814783, 3389846271, 3389939455, 3389939711,
+    3389942783, 3389944063, 3389960703, 3389969151, 3389979391, 3390324991,
+    3390328063, 3390332415, 3390337535, 3390377983, 3390409215, 3390770687,
+    3390771199, 3390779391, 3390799103, 3390800383, 3390808063, 3390814719,
+    3390815231, 3391358975, 3391360767, 3391365375, 3391368447, 3391385343,
+    3391386111, 3391393023, 3391399935, 3391403007, 3391412223, 3391412735,
+    3391413759, 3391417343, 3391428607, 3391437567, 3391442687, 3391444223,
+    3391445503, 3391447295, 3391448575, 3391463679, 3391470591, 3391483903,
+    3391484671, 3391487487, 3391526143, 3391979519, 3392098815, 3392100095,
+    3392218111, 3392225279, 3392238591, 3392239615, 3392241151, 3392241407,
+    3392247295, 3392250367, 3392254719, 3392261887, 3392272383, 3392272895,
+    3392274431, 3392295935, 3392301311, 3392303103, 3392304639, 3392309759,
+    3392316671, 3392317951, 3392318207, 3392322815, 3392333823, 3392337663,
+    3392487423, 3392640511, 3392641279, 3392643071, 3392856319, 3392856831,
+    3392857599, 3392892927, 3392996351, 3393421311, 3393691903, 3393692671,
+    3393695743, 3393750527, 3393750783, 3393765375, 3393835007, 3393891327,
+    3393892351, 3393912063, 3394150399, 3394220031, 3394701311, 3394905855,
+    3395059711, 3395139071, 3397156863, 3397323775, 3397484287, 3397507839,
+    3397939199, 3398033663, 3398057983, 3398098943, 3398117887, 3398149631,
+    3398156287, 3398295551, 3398572799, 3398614015, 3398655999, 3398860799,
+    3399414271, 3399467007, 3399516159, 3399557119, 3399633663, 3400271615,
+    3400272383, 3400272639, 3400273663, 3400273919, 3400370175, 3400372223,
+    3400376319, 3400380415, 3400384511, 3400466431, 3400820223, 3400826879,
+    3400854527, 3400858879, 3400859391, 3400963327, 3401428991, 3401527039,
+    3401543679, 3405775359, 3405778431, 3405781503, 3405783039, 3405784063,
+    3405784575, 3405795071, 3405800191, 3405808127, 3405810687, 3405811711,
+    3405820159, 3405825279, 3405832959, 3405836031, 3405840639, 3405846271,
+    3405846783, 3405868031, 3405887487, 3405893759, 3405896703, 3405897215,
+    3405897727, 3405905151, 3405925375, 3405925887, 3405930495, 3405937919,
+    3405938175, 3405940223, 3405940479, 3405943039, 3405955071, 3405957119,
+    3405965311, 3405967359, 3405981695, 3405989375, 3405990655, 3405991935,
+    3405995007, 3405998335, 3406006783, 3406010367, 3406079999, 3406081535,
+    3406086911, 3406095615, 3406106111, 3406110463, 3406111231, 3406111743,
+    3406113791, 3406117887, 3406129407, 3406130175, 3406135039, 3406148095,
+    3406149887, 3406157055, 3406158079, 3406159871, 3406164991, 3406170111,
+    3406184447, 3406200831, 3406202111, 3406204159, 3406204927, 3406205951,
+    3406225407, 3406230783, 3406231039, 3406265855, 3406273535, 3406278143,
+    3406278655, 3406284287, 3406284543, 3406286847, 3406291967, 3406299903,
+    3406301695, 3406322431, 3406326783, 3406328319, 3406331135, 3406341119,
+    3406346239, 3406348799, 3406349055, 3406350591, 3406352007, 3406373375,
+    3406373887, 3406380543, 3406397439, 3406397951, 3406401279, 3406402559,
+    3406403327, 3406405119, 3406426111, 3406430719, 3406440191, 3406445823,
+    3406447871, 3406449919, 3406456831, 3406458623, 3406460927, 3406485759,
+    3406490111, 3406490367, 3406512127, 3406512383, 3406514175, 3406514687,
+    3406516735, 3406517247, 3406518527, 3406520831, 3406524671, 3406547199,
+    3406569471, 3406575103, 3406578943, 3406590463, 3406590975, 3406595071,
+    3406596351, 3406597375, 3406615039, 3406617343, 3406620415, 3406620671,
+    3406625023, 3406632447, 3406636543, 3406644223, 3406646015, 3406646783,
+    3406647295, 3406661375, 3406663935, 3406669311, 3406691071, 3406696447,
+    3406705407, 3406717439, 3406718975, 3406722559, 3406724607, 3406725119,
+    3406730239, 3406733311, 3406733567, 3406737407, 3406738687, 3406744831,
+    3406749695, 3406763007, 3406775807, 3406780159, 3406781951, 3406782463,
+    3406785535, 3406786559, 3406792191, 3406802943, 3406811647, 3406820095,
+    3406821631, 3406823167, 3406829823, 3406832127, 3406832895, 3406835967,
+    3406841855, 3406857471, 3406859775, 3406866431, 3406866943, 3406868479,
+    3406878719, 3406882303, 3406885887, 3406889471, 3406892543, 3406904319,
+    3406905343, 3406905599, 3406912255, 3406913279, 3406918143, 3406918399,
+    3406919167, 3406921215, 3406925055, 3406928127, 3406937343, 3406938623,
+    3406941951, 3406949375, 3406950143, 3406953471, 3406954239, 3406957055,
+    3406957567, 3406958079, 3406958591, 3406960895, 3406961663, 3406963711,
+    3406968319, 3406974719, 3406976767, 3406977279, 3406987263, 3406988031,
+    3406991359, 3406999295, 3407002623, 3407004927, 3407014399, 3407022079,
+    3407031295, 3407038207, 3407038463, 3407047679, 3407053055, 3407054079,
+    3407056127, 3407057407, 3407060735, 3407063039, 3407080191, 3407080447,
+    3407081983, 3407084799, 3407085311, 3407091711, 3407096831, 3407100415,
+    3407104255, 3407105279, 3407108095, 3407110143, 3407111167, 3407113727,
+    3407115007, 3407119615, 3407123967, 3407126527, 3407135743, 3407143935,
+    3407144447, 3407146751, 3407148799, 3407152639, 3407153663, 3407155199,
+    3407156479, 3407161343, 3407167487, 3407169279, 3407171583, 3407174143,
+    3407175423, 3407178239, 3407178495, 3407183359, 3407183871, 3407188223,
+    3407197439, 3407203327, 3407221759, 3407222271, 3407223551, 3407223807,
+    3407234047, 3407236095, 3407238143, 3407249919, 3407251455, 3407253247,
+    3407266815, 3407268607, 3407268863, 3407272191, 3407275519, 3407281919,
+    3407284223, 3407284735, 3407284991, 3407287295, 3407287807, 3407288063,
+    3407288319, 3407289343, 3407290111, 3407292927, 3407297023, 3407297279,
+    3407302143, 3407303423, 3407304447, 3407307007, 3407310335, 3407312639,
+    3407315199, 3407318015, 3407325439, 3407327231, 3407331071, 3407332607,
+    3407334399, 3407340031, 3407345151, 3407345407, 3407351807, 3407354623,
+    3407356927, 3407357183, 3407363327, 3407363839, 3407366399, 3407367935,
+    3407376895, 3407377919, 3407379967, 3407380223, 3407381503, 3407384831,
+    3407391487, 3407394815, 3407396351, 3407396607, 3407398655, 3407400191,
+    3407400959, 3407401215, 3407401727, 3407408895, 3407411199, 3407412735,
+    3407419135, 3407433727, 3407434751, 3407438591, 3407441407, 3407443199,
+    3407445247, 3407449855, 3407452159, 3407453695, 3407455231, 3407456255,
+    3407456767, 3407465727, 3407470847, 3407471359, 3407472639, 3407474687,
+    3407476735, 3407482623, 3407487231, 3407491071, 3407492351, 3407496703,
+    3407496959, 3407499775, 3407501055, 3407501311, 3407503359, 3407503615,
+    3407506175, 3407507711, 3407510527, 3407512319, 3407512831, 3407513855,
+    3407516415, 3407524607, 3407532287, 3407539199, 3407541759, 3407545343,
+    3407551487, 3407552511, 3407555583, 3407559423, 3407563007, 3407565823,
+    3407567359, 3407570175, 3407574015, 3407574783, 3407593471, 3407593983,
+    3407595519, 3407596031, 3407596799, 3407597055, 3407601663, 3407602175,
+    3407605247, 3407605759, 3407607807, 3407609343, 3407615487, 3407617023,
+    3407617279, 3407622143, 3407624191, 3407629311, 3407631871, 3407632895,
+    3407637247, 3407639551, 3407640063, 3407641343, 3407642623, 3407649791,
+    3407650047, 3407650303, 3407650815, 3407651583, 3407652607, 3407653119,
+    3407654143, 3407654399, 3407655423, 3407656207, 3407658751, 3407659519,
+    3407661311, 3407666175, 3407668479, 3407670015, 3407671039, 3407681791,
+    3407685119, 3407686911, 3407690495, 3407691519, 3407693055, 3407695103,
+    3407697919, 3407700479, 3407706111, 3407720447, 3407726335, 3407731455,
+    3407735039, 3407736575, 3407750143, 3407753983, 3407757055, 3407757567,
+    3407760383, 3407763455, 3407765503, 3407765759, 3407768063, 3407769087,
+    3407780863, 3407786239, 3407787519, 3407790079, 3407791103, 3407791615,
+    3407792383, 3407793663, 3407794175, 3407800319, 3407807999, 3407810047,
+    3407811583, 3407817983, 3407820287, 3407822847, 3407823871, 3407826431,
+    3407826943, 3407827455, 3407830271, 3407831039, 3407838719, 3407838975,
+    3407847935, 3407849471, 3407850239, 3407853311, 3407853823, 3407857151,
+    3407859199, 3407859967, 3407862783, 3407868415, 3407869695, 3407871999,
+    3407873791, 3407877119, 3407878143, 3407878911, 3407880447, 3407881983,
+    3407882751, 3407885055, 3407885311, 3407886847, 3407887103, 3407888639,
+    3407888895, 3407891199, 3407895295, 3407896319, 3407898111, 3407900671,
+    3407902207, 3407903487, 3407907071, 3407907327, 3407908607, 3407918335,
+    3407921663, 3407923711, 3407925247, 3407928575, 3407929343, 3407939327,
+    3407942655, 3407942911, 3407948543, 3407949567, 3407951871, 3407956223,
+    3407957503, 3407966463, 3407970047, 3407974399, 3407980799, 3407986431,
+    3407987199, 3407994367, 3407997695, 3407999487, 3408000767, 3408001279,
+    3408002047, 3408003071, 3408003839, 3408004863, 3408008959, 3408010751,
+    3408012543, 3408013567, 3408013823, 3408014591, 3408016383, 3408018175,
+    3408019199, 3408021759, 3408025087, 3408028927, 3408029951, 3408032511,
+    3408032767, 3408035071, 3408036351, 3408036863, 3408037375, 3408038399,
+    3408039935, 3408040447, 3408043007, 3408043775, 3408049663, 3408050687,
+    3408050943, 3408052223, 3408057599, 3408059135, 3408062975, 3408064511,
+    3408068607, 3409379327, 3409381887, 3409383423, 3409388031, 3409388287,
+    3409388799, 3409390847, 3409391103, 3409391615, 3409394943, 3409395711,
+    3409399807, 3409400575, 3409400831, 3409406719, 3409408767, 3409412863,
+    3409419775, 3409422335, 3409423615, 3409425663, 3409427199, 3409431551,
+    3409433087, 3409434111, 3409436671, 3409437183, 3409438719, 3409443327,
+    3409445631, 3409446399, 3409446655, 3409449471, 3409453055, 3409454335,
+    3409455871, 3409461247, 3409465087, 3409467391, 3409468671, 3409469183,
+    3409470463, 3409472255, 3409475583, 3409477119, 3409477631, 3409488639,
+    3409490431, 3409495295, 3409496063, 3409498111, 3409499647, 3409500671,
+    3409511167, 3409512959, 3409513471, 3409517567, 3409518079, 3409520383,
+    3409526527, 3409530179, 3409533183, 3409541375, 3409550591, 3409560063,
+    3409560831, 3409565695, 3409567743, 3409574143, 3409641471, 3409707007,
+    3409872639, 3409878527, 3409879295, 3409880575, 3409881855, 3409883647,
+    3409885183, 3409887487, 3409890815, 3409903615, 3409955839, 3409959679,
+    3409965055, 3409969151, 3410970111, 3410980863, 3410983935, 3411464191,
+    3411628287, 3411811071, 3411868927, 3411951615, 3412094975, 3412095231,
+    3412097791, 3412098559, 3412107263, 3412123647, 3412167935, 3412197631,
+    3412213759, 3412385791, 3412705535, 3412711679, 3412983807, 3413061119,
+    3413070847, 3413075455, 3413075967, 3413098495, 3413144063, 3413144319,
+    3413147647, 3413245951, 3413295103, 3413557247, 3413835775, 3413861631,
+    3413868543, 3414245375, 3414373631, 3414605823, 3415121919, 3415138303,
+    3416145919, 3416293375, 3416588287, 3416719359, 3416779519, 3416784895,
+    3417128959, 3417178111, 3417227263, 3417274367, 3417849855, 3417956351,
+    3417959679, 3417963263, 3417964543, 3418193407, 3419017471, 3419020543,
+    3419023359, 3419047423, 3419048703, 3419062271, 3419294719, 3419297023,
+    3419340799, 3419439103, 3419521791, 3419528447, 3419709439, 3419774975,
+    3419815935, 3419816191, 3419840511, 3419873023, 3419901951, 3420012543,
+    3420344319, 3432656639, 3435278335, 3437964287, 3451900159, 3453948927,
+    3455035135, 3456960511, 3465312255, 3465412095, 3480435711, 3487543295,
+    3490365439, 3490494463, 3490647551, 3490672639, 3490702335, 3490707455,
+    3490861055, 3491078143, 3507996159, 3507996927, 3507997695, 3507998463,
+    3507999231, 3508001023, 3508002559, 3508003071, 3508004863, 3508006655,
+    3508008191, 3508008703, 3508009215, 3508010239, 3508011007, 3508404479,
+    3511423999, 3511427583, 3511451135, 3511469823, 3511471615, 3511480319,
+    3511481343, 3511522303, 3511529983, 3511531775, 3511536639, 3511540735,
+    3511564799, 3511572479, 3511604735, 3511622143, 3511631871, 3511661311,
+    3511681023, 3512074239, 3523215615, 3523748351, 3523756031, 3523756543,
+    3523757311, 3523757567, 3523758847, 3523759615, 3523762943, 3523768575,
+    3523771391, 3523780095, 3523782655, 3523786239, 3523791871, 3523801087,
+    3523803135, 3523813887, 3523816447, 3523822591, 3523822847, 3523835903,
+    3523837951, 3523838975, 3523839999, 3523844095, 3523849727, 3523853567,
+    3523854847, 3523864063, 3523864831, 3523865343, 3523866111, 3523896319,
+    3523947519, 3523949567, 3523973119, 3523986175, 3524001791, 3524263935,
+    3526492159, 3526557695, 3526766079, 3526769151, 3526770687, 3526787071,
+    3526790655, 3526792191, 3526793215, 3526795263, 3526819839, 3526822911,
+    3526823935, 3526842879, 3526844415, 3526852607, 3526854655, 3526862847,
+    3526865919, 3526867455, 3526870527, 3526871039, 3526872575, 3526873087,
+    3526877439, 3526884607, 3528736767, 3528880127, 3528921855, 3528923391,
+    3528925183, 3528933375, 3539353599, 3541827583, 3542089727, 3585122303,
+    3587547135, 3587997695, 3626863103, 3626864383, 3627737087, 3630454783,
+    3630483455, 3630491903, 3630502143, 3630508031, 3630527231, 3630555135,
+    3630558207, 3630566399, 3630581759, 3630628863, 3630654463, 3630661375,
+    3630663167, 3630665471, 3630666495, 3630669055, 3630694399, 3635281919,
+    3639557119, 3639558143, 3641282559, 3650600959, 3651919871, 3664052735,
+    3664084991, 3680003839, 3680010239, 3680014335, 3680034815, 3680043007,
+    3680108543, 3680174079, 3697639423, 3706454015, 3706716159, 3707633663,
+    3734765567, 3758090751
+])
+
+ip_isps = array.array ('b', [
+    50, 50, 50, 13, 10, 50, 50, 50, 50, 11, 60, 60, 60, 60, 0, 12, 11, 60, 60,
+    60, 12, 11, 11, 60, 12, 11, 12, 60, 60, 60, 60, 12, 60, 60, 30, 13, 60, 60,
+    60, 32, 10, 60, 60, 60, 0, 13, 10, 60, 60, 60, 60, 60, 13, 60, 60, 60, 10,
+    60, 60, 60, 10, 60, 60, 60, 60, 60, 60, 60, 50, 50, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 13, 2, 7, 13, 31, 30,
+    30, 32, 32, 30, 34, 34, 34, 34, 33, 33, 32, 32, 32, 34, 31, 30, 32, 32, 30,
+    30, 32, 13, 13, 7, 13, 7, 7, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 15, 12, 15, 12, 15, 12, 15, 12, 15, 12, 15, 12, 15, 12, 15, 12, 15,
+    12, 15, 12, 5, 13, 13, 10, 14, 12, 12, 12, 11, 13, 11, 10, 1, 1, 10, 10,
+    10, 0, 12, 12, 12, 12, 12, 13, 13, 13, 13, 13, 12, 40, 60, 61, 61, 61, 61,
+    61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 50,
+    60, 60, 61, 61, 60, 60, 60, 50, 10, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61,
+    61, 60, 60, 60, 50, 60, 60, 60, 61, 32, 60, 60, 13, 60, 50, 50, 50, 50, 50,
+    60, 60, 60, 60, 60, 50, 10, 50, 10, 50, 10, 50, 60, 60, 60, 60, 60, 60, 60,
+    60, 50, 10, 50, 50, 50, 60, 60, 60, 60, 60, 60, 61, 32, 40, 32, 40, 40, 32,
+    30, 40, 50, 32, 30, 32, 32, 30, 60, 60, 0, 13, 60, 60, 60, 60, 60, 60, 60,
+    60, 13, 60, 60, 60, 60, 60, 61, 61, 61, 61, 61, 3, 10, 10, 10, 17, 12, 1,
+    2, 0, 12, 10, 10, 12, 10, 13, 10, 10, 16, 12, 2, 9, 12, 13, 10, 12, 11, 12,
+    10, 10, 0, 34, 12, 13, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60,
+    60, 60, 60, 60, 50, 50, 50, 13, 13, 10, 2, 10, 2, 12, 50, 1, 16, 13, 6, 13,
+    12, 16, 8, 0, 1, 14, 13, 12, 13, 0, 10, 5, 7, 12, 12, 11, 10, 10, 13, 10,
+    11, 10, 0, 3, 3, 13, 13, 13, 10, 10, 11, 12, 0, 9, 7, 1, 1, 12, 12, 10, 16,
+    8, 8, 13, 12, 10, 13, 11, 9, 10, 2, 7, 12, 15, 12, 15, 12, 15, 12, 15, 12,
+    12, 10, 3, 10, 13, 12, 14, 14, 14, 14, 14, 12, 8, 11, 0, 0, 2, 4, 13, 13,
+    2, 10, 10, 10, 12, 10, 10, 30, 10, 10, 10, 10, 10, 14, 2, 2, 10, 50, 11,
+    11, 10, 32, 13, 10, 50, 32, 10, 10, 8, 8, 8, 10, 12, 10, 13, 10, 10, 60,
+    60, 60, 60, 13, 12, 10, 10, 10, 11, 61, 61, 30, 30, 33, 2, 10, 2, 2, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 30, 30, 30, 30, 30, 30, 32, 30,
+    30, 10, 10, 10, 13, 10, 2, 2, 10, 30, 13, 30, 30, 13, 13, 60, 13, 60, 50,
+    50, 30, 30, 30, 30, 10, 10, 30, 13, 30, 30, 30, 30, 60, 32, 32, 32, 32, 10,
+    8, 8, 8, 0, 12, 30, 30, 10, 13, 30, 30, 10, 30, 13, 13, 10, 13, 13, 60, 30,
+    30, 30, 30, 13, 10, 50, 60, 60, 60, 50, 60, 10, 13, 0, 50, 60, 60, 13, 33,
+    10, 10, 10, 10, 10, 12, 13, 12, 12, 1, 5, 16, 13, 10, 10, 10, 10, 10, 13,
+    8, 10, 8, 12, 60, 13, 10, 60, 60, 60, 60, 10, 32, 13, 10, 30, 8, 10, 60,
+    60, 12, 60, 60, 60, 60, 12, 12, 60, 60, 13, 60, 60, 13, 60, 10, 60, 60, 8,
+    10, 10, 60, 11, 13, 11, 0, 11, 13, 10, 10, 32, 11, 11, 11, 12, 10, 10, 11,
+    12, 30, 11, 30, 32, 30, 33, 30, 32, 30, 30, 30, 30, 30, 6, 4, 10, 13, 10,
+    13, 0, 10, 2, 10, 2, 50, 60, 12, 50, 11, 10, 12, 10, 10, 13, 0, 13, 10, 13,
+    11, 15, 10, 11, 13, 13, 11, 13, 60, 10, 13, 40, 40, 13, 50, 0, 40, 30, 30,
+    32, 32, 30, 30, 33, 33, 33, 30, 32, 30, 32, 30, 32, 30, 30, 30, 32, 30, 30,
+    30, 33, 30, 32, 30, 30, 32, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    32, 30, 30, 30, 30, 30, 33, 30, 30, 30, 30, 30, 30, 30, 32, 30, 30, 30, 32,
+    30, 32, 32, 32, 32, 30, 30, 33, 34, 30, 32, 30, 33, 32, 33, 33, 30, 32, 30,
+    30, 30, 30, 34, 33, 32, 31, 34, 32, 32, 33, 32, 30, 30, 30, 31, 33, 30, 32,
+    30, 30, 32, 60, 14, 10, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 32, 30, 30,
+    32, 30, 61, 60, 13, 60, 61, 11, 13, 12, 61, 61, 61, 61, 61, 61, 61, 61, 61,
+    61, 61, 61, 61, 61, 61, 61, 50, 50, 10, 10, 12, 60, 61, 10, 0, 13, 10, 0,
+    12, 10, 13, 10, 14, 1, 10, 10, 13, 13, 11, 11, 16, 12, 12, 12, 10, 11, 13,
+    1, 10, 12, 10, 10, 11, 0, 11, 10, 14, 12, 0, 0, 0, 8, 12, 6, 10, 11, 0, 0,
+    0, 8, 8, 2, 8, 13, 0, 6, 9, 8, 8, 0, 2, 9, 0, 2, 0, 0, 8, 1, 8, 8, 2, 2, 0,
+    0, 8, 8, 8, 10, 12, 0, 10, 3, 7, 2, 8, 2, 8, 0, 8, 7, 0, 1, 6, 0, 8, 2, 2,
+    2, 0, 1, 2, 3, 7, 8, 1, 12, 12, 12, 12, 10, 10, 10, 12, 6, 14, 12, 15, 12,
+    15, 12, 15, 7, 12, 12, 12, 0, 10, 10, 10, 12, 12, 2, 1, 12, 10, 16, 0, 14,
+    12, 13, 13, 13, 14, 12, 10, 10, 1, 10, 12, 10, 12, 10, 12, 10, 12, 10, 12,
+    15, 12, 15, 12, 15, 14, 3, 3, 10, 10, 10, 12, 3, 1, 17, 10, 11, 13, 12, 10,
+    12, 13, 11, 11, 12, 11, 11, 12, 14, 12, 13, 13, 10, 13, 14, 10, 13, 13, 10,
+    11, 13, 10, 12, 16, 10, 10, 11, 12, 10, 12, 10, 14, 10, 12, 13, 16, 13, 10,
+    10, 13, 10, 12, 10, 12, 16, 14, 10, 10, 13, 10, 10, 10, 11, 10, 12, 10, 13,
+    13, 13, 13, 13, 13, 16, 13, 13, 11, 13, 10, 13, 12, 11, 12, 10, 12, 10, 10,
+    11, 11, 11, 10, 10, 10, 12, 12, 12, 12, 14, 12, 10, 11, 13, 14, 13, 12, 10,
+    13, 10, 14, 13, 15, 10, 11, 13, 12, 13, 12, 13, 13, 13, 10, 13, 10, 12, 10,
+    13, 12, 10, 13, 10, 13, 12, 12, 10, 14, 12, 14, 12, 13, 10, 10, 13, 10, 12,
+    10, 16, 13, 15, 10, 14, 13, 12, 14, 13, 10, 10, 10, 12, 10, 13, 13, 10, 11,
+    10, 12, 12, 10, 10, 13, 11, 13, 11, 12, 11, 12, 13, 11, 12, 12, 11, 10, 12,
+    13, 10, 12, 13, 10, 13, 12, 14, 13, 11, 12, 11, 10, 10, 10, 12, 11, 12, 13,
+    12, 14, 10, 12, 13, 10, 10, 11, 10, 12, 13, 12, 14, 15, 11, 12, 13, 14, 12,
+    10, 14, 12, 14, 13, 10, 11, 10, 12, 10, 13, 14, 12, 11, 12, 10, 11, 12, 16,
+    10, 10, 10, 13, 13, 10, 12, 12, 12, 10, 10, 13, 12, 11, 10, 12, 12, 10, 10,
+    12, 14, 10, 10, 16, 11, 10, 11, 12, 12, 11, 15, 13, 10, 11, 12, 12, 11, 12,
+    11, 12, 11, 10, 10, 10, 12, 11, 10, 11, 11, 11, 10, 10, 10, 13, 10, 12, 10,
+    11, 10, 14, 12, 15, 11, 13, 10, 11, 10, 11, 12, 10, 12, 10, 10, 14, 10, 10,
+    11, 10, 12, 11, 14, 10, 12, 14, 12, 15, 12, 11, 13, 12, 12, 10, 10, 12, 10,
+    13, 13, 14, 14, 10, 11, 12, 10, 10, 12, 10, 12, 13, 11, 12, 10, 10, 11, 14,
+    11, 12, 15, 10, 12, 13, 14, 11, 12, 10, 10, 10, 12, 11, 14, 11, 12, 11, 11,
+    11, 12, 13, 11, 10, 11, 14, 12, 11, 11, 12, 15, 10, 11, 10, 13, 11, 11, 10,
+    11, 10, 10, 11, 12, 10, 10, 11, 10, 13, 12, 14, 11, 10, 10, 11, 10, 12, 13,
+    14, 13, 10, 10, 13, 10, 10, 13, 12, 10, 11, 11, 11, 13, 10, 13, 10, 12, 12,
+    13, 14, 11, 12, 11, 12, 13, 11, 11, 12, 11, 10, 10, 10, 13, 10, 10, 10, 12,
+    13, 12, 12, 11, 11, 10, 11, 12, 12, 14, 10, 13, 10, 13, 13, 11, 11, 12, 10,
+    11, 14, 10, 15, 12, 10, 12, 10, 12, 11, 11, 14, 10, 12, 15, 15, 10, 12, 10,
+    12, 12, 10, 13, 14, 12, 11, 10, 12, 10, 11, 12, 10, 13, 12, 12, 14, 11, 12,
+    11, 11, 10, 11, 14, 10, 14, 14, 14, 14, 14, 12, 10, 10, 11, 12, 10, 12, 13,
+    12, 13, 14, 12, 12, 12, 11, 10, 10, 10, 12, 12, 12, 10, 12, 11, 10, 10, 11,
+    10, 13, 10, 15, 14, 14, 12, 11, 12, 11, 10, 11, 17, 16, 10, 11, 12, 11, 11,
+    10, 12, 13, 10, 10, 13, 12, 12, 10, 11, 13, 12, 10, 11, 12, 16, 10, 12, 10,
+    13, 12, 11, 12, 11, 10, 12, 13, 16, 15, 10, 15, 11, 10, 12, 10, 13, 12, 13,
+    11, 10, 11, 12, 11, 13, 11, 12, 11, 11, 11, 11, 10, 13, 10, 10, 11, 10, 12,
+    13, 10, 12, 11, 14, 12, 13, 11, 12, 10, 10, 12, 10, 10, 12, 12, 10, 10, 12,
+    11, 10, 11, 11, 10, 14, 11, 10, 13, 10, 13, 11, 10, 11, 10, 10, 10, 11, 12,
+    14, 10, 13, 12, 10, 13, 10, 12, 14, 11, 11, 10, 14, 10, 13, 11, 10, 10, 12,
+    12, 12, 12, 0, 0, 0, 2, 12, 10, 10, 12, 8, 2, 8, 8, 0, 7, 0, 0, 0, 3, 10,
+    10, 7, 12, 12, 12, 12, 12, 13, 12, 13, 12, 9, 7, 11, 13, 13, 12, 12, 14,
+    14, 10, 12, 3, 13, 12, 0, 0, 12, 7, 12, 0, 3, 12, 12, 12, 12, 13, 13, 13,
+    13, 13, 13, 13, 12, 11, 12, 12, 12, 12, 14, 13, 12, 11, 12, 12, 0, 12, 12,
+    61, 60, 30, 7, 60, 10, 61, 61, 61, 61, 50, 61, 61, 61, 61, 61, 61, 61, 61,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 61, 61, 61, 61,
+    61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 50, 13, 12,
+    12, 12, 12, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 11,
+    12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+    13, 14, 8, 1, 1, 8, 8, 8, 1, 8, 8, 8, 1, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 2,
+    8, 8, 12, 8, 12, 12, 12, 12, 7, 14, 13, 40, 40, 40, 60, 60, 50, 61, 61, 61,
+    61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 61, 50, 50, 40,
+    40, 40, 0, 0, 8, 8, 1, 8, 1, 8, 16, 13, 12, 13, 12, 8, 10
+])
@@ -234,13 +234,39 @@ new_isps = {
           'filter': '# No rules for AT&T, please suggest some!' }
 }
 
+# The revision of the rule data above, which goes out in every bundle so that
+# clients can ask for just what has changed since the copy they hold. When
+# editing the rules, bump the revision and record the netblocks whose rules
+# changed under the new revision number (using None if the defaults changed);
+# clients asking about revisions this history no longer covers just get sent
+# the whole bundle. So do clients that claim the current revision but whose
+# ETag doesn't match, which is what happens if the rules are edited and the
+# revision isn't bumped.
+
+rules_revision = 1
+rules_changes = {
+}
+
 # Simple utility cliches.
 
+# The version of the rule data a bundle is rendered from, for caching; the
+# deployed version changes with every upload, which covers the rules being
+# edited even if the revision number wasn't bumped.
+
+def rules_version (isps):
+    deployed = os.environ.get ('CURRENT_VERSION_ID', '')
+    if isps is new_isps:
+        return '%s:%d' % (deployed, rules_revision)
+    if isps is old_isps.isps:
+        return deployed + ':old'
+    return None
+
 def bundle (handler, isps = new_isps, defaults = new_defaults,
             source = None):
-    return app_common.bundle (handler, isps, defaults, source)
+    return app_common.bundle (handler, isps, defaults, source,
+                              rules_version (isps))
 
-def send (handler, data = None, key = None):
+def send (handler, data = None, key = None, tagged = False):
     isps = new_isps
     defaults = new_defaults
 
@@ -268,6 +294,16 @@ def send (handler, data = None, key = None):
 
     if key:
         data = data.get (key)
+
+    # Whole bundles for the current rules get tagged so that clients can
+    # revalidate them, or be sent only what changed; the old-style rules for
+    # down-level clients never change, so those just go out as they are.
+
+    if tagged and isps is new_isps:
+        app_common.send_bundle (handler, data, rules_revision, rules_changes,
+                                isps)
+        return
+
     app_common.send (handler, data)
 
 def expand (handler, name, context):
@@ -327,7 +363,7 @@ class AllowHostHandler (webapp2.RequestHandler):
 
 class BundleHandler (webapp2.RequestHandler):
     def get (self):
-        send (self)
+        send (self, tagged = True)
 
 # Feedback model for the feedback submission form to persist
 
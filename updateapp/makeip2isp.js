@@ -262,30 +262,73 @@ function readFile (file) {
 var file = fso.OpenTextFile (WScript.Arguments (0));
 var array = readFile (file);
 
-file = fso.CreateTextFile ("ip_match.py");
+/*
+ * Originally I checked that the netblock range was aligned on a class C
+ * boundary, but there's a *really* odd set of netblocks where Telstra and
+ * Google interleave at the level of 2-3 hosts around 1208927796
+ *
+ * The most likely cause of this is that these IPs are ones Google lease
+ * from Telstra, which have come under their ASN later on. Possibly this is
+ * Google's Sydney office.
+ *
+ * The lookup in the webservice is a bisect over the range starts, so make
+ * sure they really are in order even though the source data should be.
+ */
 
-file.WriteLine ("# This file is autogenerated by makeip2isp.js - do not edit");
-file.WriteLine ("ip_table = [");
-
-var key;
-for (key in array) {
-    var item = array [key];
-    if (key > 0)
-        file.WriteLine (",")
-
-    /*
-     * Originally I checked that the netblock range was aligned on a class C
-     * boundary, but there's a *really* odd set of netblocks where Telstra and
-     * Google interleave at the level of 2-3 hosts around 1208927796
-     *
-     * The most likely cause of this is that these IPs are ones Google lease
-     * from Telstra, which have come under their ASN later on. Possibly this is
-     * Google's Sydney office.
-     */
-
-    file.Write ("    (" + item.start + ", " + item.end + ", " + item.id + ")")
+array.sort (function (left, right) { return left.start - right.start; });
+
+/**
+ * Write one field of the ranges out as a packed array of integers; the table
+ * used to be a list of tuples, but parallel packed arrays are much smaller in
+ * memory and the starts can be searched directly with bisect.
+ */
+
+function writeColumn (file, name, type, field) {
+    file.WriteLine (name + " = array.array ('" + type + "', [");
+
+    var line = "   ";
+    var key;
+    for (key in array) {
+        var text = " " + array [key] [field];
+        if (key < array.length - 1)
+            text += ",";
+
+        if (line.length + text.length > 79) {
+            file.WriteLine (line);
+            line = "   ";
+        }
+
+        line += text;
+    }
+
+    file.WriteLine (line);
+    file.WriteLine ("])");
+}
+
+/**
+ * Stamp the output with when it was generated, so that it's possible to tell
+ * which data a deployed copy of the webservice has.
+ */
+
+function pad (value) {
+    return (value < 10 ? "0" : "") + value;
 }
 
+var now = new Date ();
+var version = "" + now.getFullYear () + pad (now.getMonth () + 1) +
+              pad (now.getDate ()) + pad (now.getHours ()) +
+              pad (now.getMinutes ());
+
+file = fso.CreateTextFile ("ip_match.py");
+
+file.WriteLine ("# This file is autogenerated by makeip2isp.js - do not edit");
+file.WriteLine ("import array");
+file.WriteLine ();
+file.WriteLine ("ip_version = '" + version + "'");
+file.WriteLine ();
+writeColumn (file, "ip_starts", "L", "start");
+file.WriteLine ();
+writeColumn (file, "ip_ends", "L", "end");
 file.WriteLine ();
-file.WriteLine ("];");
+writeColumn (file, "ip_isps", "b", "id");
 